@@ -0,0 +1,178 @@
+/**
+ * Weighted URL selection
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifdef  HAVE_CONFIG_H
+# include <config.h>
+#endif/*HAVE_CONFIG_H*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <alias.h>
+#include <memory.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+struct ALIAS_T
+{
+  int            length;
+  double        *prob;   /* chance a column picks its own index */
+  int           *alias;  /* and the index it picks otherwise    */
+  double        *share;  /* the weights, normalized             */
+  unsigned long *hits;
+};
+
+/**
+ * Returns NULL unless there's a weight to pick by
+ */
+ALIAS
+new_alias(const double *weights, int length)
+{
+  int     i;
+  int     s;
+  int     l;
+  int     small = 0;
+  int     large = 0;
+  int    *stack;
+  double  total = 0.0;
+  ALIAS   this;
+
+  for (i = 0; i < length; i++) {
+    if (weights[i] < 0) return NULL;
+    total += weights[i];
+  }
+  if (length < 1 || total <= 0) return NULL;
+
+  this = xcalloc(sizeof(struct ALIAS_T), 1);
+  this->length = length;
+  this->prob   = xcalloc(sizeof(double), length);
+  this->alias  = xcalloc(sizeof(int), length);
+  this->share  = xcalloc(sizeof(double), length);
+  this->hits   = xcalloc(sizeof(unsigned long), length);
+
+  /**
+   * Vose's version: the columns under the average go on the bottom
+   * of the stack and those over it on the top. Each small column
+   * is topped up from a large one, which goes back as small if
+   * that took it under.
+   */
+  stack = xcalloc(sizeof(int), length);
+  for (i = 0; i < length; i++) {
+    this->share[i] = weights[i] / total;
+    this->prob[i]  = this->share[i] * length;
+    if (this->prob[i] < 1.0) {
+      stack[small++] = i;
+    } else {
+      stack[length - ++large] = i;
+    }
+  }
+  while (small > 0 && large > 0) {
+    s = stack[--small];
+    l = stack[length - large];
+    this->alias[s] = l;
+    this->prob[l] -= 1.0 - this->prob[s];
+    if (this->prob[l] < 1.0) {
+      large--;
+      stack[small++] = l;
+    }
+  }
+  /* what's left is 1.0 give or take rounding */
+  while (large > 0) {
+    this->prob[stack[length - large--]] = 1.0;
+  }
+  while (small > 0) {
+    this->prob[stack[--small]] = 1.0;
+  }
+  xfree(stack);
+  return this;
+}
+
+/**
+ * The k-th URL gets a weight of 1/k^s
+ */
+ALIAS
+new_alias_zipf(double s, int length)
+{
+  int     i;
+  double *weights;
+  ALIAS   this;
+
+  if (length < 1) return NULL;
+
+  weights = xcalloc(sizeof(double), length);
+  for (i = 0; i < length; i++) {
+    weights[i] = 1.0 / pow((double)(i + 1), s);
+  }
+  this = new_alias(weights, length);
+  xfree(weights);
+  return this;
+}
+
+ALIAS
+alias_destroy(ALIAS this)
+{
+  if (this != NULL) {
+    xfree(this->prob);
+    xfree(this->alias);
+    xfree(this->share);
+    xfree(this->hits);
+    xfree(this);
+  }
+  return NULL;
+}
+
+/**
+ * The high half of random picks the column and the low half
+ * flips its coin
+ */
+int
+alias_pick(ALIAS this, unsigned long long random)
+{
+  int    column = (int)(((random >> 32) * (unsigned long long)this->length) >> 32);
+  double coin   = (double)(random & 0xFFFFFFFFULL) / 4294967296.0;
+
+  return (coin < this->prob[column]) ? column : this->alias[column];
+}
+
+void
+alias_hit(ALIAS this, int index)
+{
+  __sync_add_and_fetch(&this->hits[index], 1);
+}
+
+int
+alias_get_length(ALIAS this)
+{
+  return (this == NULL) ? 0 : this->length;
+}
+
+double
+alias_get_share(ALIAS this, int index)
+{
+  return this->share[index];
+}
+
+unsigned long
+alias_get_hits(ALIAS this, int index)
+{
+  return this->hits[index];
+}
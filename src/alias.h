@@ -0,0 +1,50 @@
+/**
+ * Weighted URL selection
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifndef __ALIAS_H
+#define __ALIAS_H
+
+#include <stdlib.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+/**
+ * Picks an index with the probability of its weight in constant
+ * time with Walker's alias method: every column of the table
+ * holds at most two indexes, its own and an alias, and a random
+ * number picks a column and then one of the two. The table is
+ * built once and read by every browser; each one brings its own
+ * random numbers. We count what they pick so the summary can
+ * show that the hits follow the weights.
+ */
+typedef struct ALIAS_T *ALIAS;
+
+ALIAS    new_alias(const double *weights, int length);
+ALIAS    new_alias_zipf(double s, int length);
+ALIAS    alias_destroy(ALIAS this);
+int      alias_pick(ALIAS this, unsigned long long random);
+void     alias_hit(ALIAS this, int index);
+int      alias_get_length(ALIAS this);
+double   alias_get_share(ALIAS this, int index);
+unsigned long alias_get_hits(ALIAS this, int index);
+
+#endif/*__ALIAS_H*/
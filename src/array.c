@@ -75,6 +75,7 @@ array_destroy(ARRAY this)
 ARRAY
 array_destroyer(ARRAY this, method m)
 {
+  if (this == NULL) return NULL;
   this->free = m;
   return array_destroy(this);
 }
@@ -200,36 +201,3 @@ array_print(ARRAY this)
 {
   printf("%s\n", array_to_string(this));
 }
-
-
-#if 0
-#include <unistd.h>
-int
-main (int argc, char *argv[])
-{
-  int   x;
-  int   i;
-  int   len;
-  ARRAY A = new_array();
-  void *v; 
-for (i = 0; i < 1000000; i++) {
-  array_push(A, "Zero");
-  array_push(A, "One");
-  array_push(A, "Two");
-  array_push(A, "Three");
-  array_push(A, "Four");
-  array_push(A, "Five");
-  array_push(A, "Six-six-six");
-
-  while ((v = array_pop(A)) != NULL) {
-    printf("popped: %s\n", (char*)v);
-    xfree(v);
-  } 
-
-}
-  A = array_destroy(A);
-  return 0;
-}
-#endif
-
-
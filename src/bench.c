@@ -0,0 +1,916 @@
+/**
+ * siege-bench: measures siege against a loopback target
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifdef  HAVE_CONFIG_H
+# include <config.h>
+#endif/*HAVE_CONFIG_H*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#ifdef  HAVE_LINUX_PERF_EVENT_H
+# include <sys/syscall.h>
+# include <linux/perf_event.h>
+#endif/*HAVE_LINUX_PERF_EVENT_H*/
+
+#ifdef  HAVE_SSL
+# include <openssl/ssl.h>
+# include <openssl/err.h>
+# include <openssl/evp.h>
+# include <openssl/x509.h>
+#endif/*HAVE_SSL*/
+
+#ifdef  HAVE_ZLIB
+# include <zlib.h>
+#endif/*HAVE_ZLIB*/
+
+#include <memory.h>
+#include <notify.h>
+#ifdef __CYGWIN__
+# include <getopt.h>
+#else
+# include <joedog/getopt.h>
+#endif
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+/**
+ * siege-bench answers one question: how much does siege itself
+ * cost per request? It forks a small HTTP/1.1 (and HTTPS) server
+ * on the loopback, runs the siege binary against it once for each
+ * scenario and reports what the client burned: requests per CPU
+ * second, which is requests/sec per core, and CPU cycles per
+ * request. The server runs in its own process so its work never
+ * shows up in siege's rusage.
+ *
+ * Cycles come from a hardware counter (perf_event_open) attached
+ * to the siege process. Where that's not allowed, and containers
+ * usually don't allow it, they're estimated from CPU time and the
+ * clock rate in /proc/cpuinfo and the report says so.
+ */
+#define BODYMAX   (4*1024*1024)
+#define CHUNKSIZE 4096
+#define READSIZE  16384
+#define RESOURCES 40
+#define GZCACHE   8
+
+typedef struct {
+  char    *name;
+  char    *desc;
+  char    *path;
+  BOOLEAN  tls;
+  BOOLEAN  close;
+  BOOLEAN  parser;
+  int      users;
+} SCENARIO;
+
+private SCENARIO scenarios[] = {
+  { "keepalive", "small GETs on persistent connections", "/fixed/128",     FALSE, FALSE, FALSE, 10 },
+  { "churn",     "a new connection for every GET",       "/fixed/128",     FALSE, TRUE,  FALSE, 10 },
+  { "large",     "1MB response bodies",                  "/fixed/1048576", FALSE, FALSE, FALSE,  4 },
+  { "chunked",   "64KB chunked response bodies",         "/chunked/65536", FALSE, FALSE, FALSE, 10 },
+  { "gzip",      "64KB gzip response bodies",            "/gzip/65536",    FALSE, FALSE, FALSE, 10 },
+  { "slow",      "50ms server think time",               "/slow/50/128",   FALSE, FALSE, FALSE, 50 },
+  { "tls",       "a TLS handshake for every GET",        "/fixed/128",     TRUE,  TRUE,  FALSE, 10 },
+  { "parser",    "HTML page with 40 resources",          "/page",          FALSE, FALSE, TRUE,   4 }
+};
+#define SCENARIOS (sizeof(scenarios)/sizeof(SCENARIO))
+
+typedef struct {
+  int     fd;
+#ifdef  HAVE_SSL
+  SSL    *ssl;
+#endif/*HAVE_SSL*/
+} CONN;
+
+typedef struct {
+  int     fd;
+  BOOLEAN tls;
+} LISTENER;
+
+typedef struct {
+  int     n;
+  char   *data;
+  size_t  len;
+} GZBODY;
+
+private char           *__body  = NULL;
+private char           *__page  = NULL;
+private GZBODY          __gz[GZCACHE];
+private pthread_mutex_t __gzlock = PTHREAD_MUTEX_INITIALIZER;
+#ifdef  HAVE_SSL
+private SSL_CTX        *__ctx   = NULL;
+#endif/*HAVE_SSL*/
+
+private void
+__usage(char *prog)
+{
+  size_t i;
+
+  printf("Usage: %s [options] [scenario...]\n", prog);
+  puts("Options:");
+  puts("  -s, --siege=PATH     siege binary to measure, default: siege next to this program");
+  puts("  -t, --time=SECS      seconds to run each scenario, default: 5");
+  puts("  -c, --concurrent=NUM users for every scenario, default: per scenario");
+  puts("  -v, --verbose        pass siege's stderr through");
+  puts("  -h, --help           this message");
+  puts("Scenarios:");
+  for (i = 0; i < SCENARIOS; i++) {
+    printf("  %-20s %s\n", scenarios[i].name, scenarios[i].desc);
+  }
+}
+
+/**
+ * loopback server
+ */
+private ssize_t
+__read(CONN *c, char *buf, size_t len)
+{
+  ssize_t n;
+#ifdef  HAVE_SSL
+  if (c->ssl != NULL) {
+    return SSL_read(c->ssl, buf, (int)len);
+  }
+#endif/*HAVE_SSL*/
+  do {
+    n = read(c->fd, buf, len);
+  } while (n < 0 && errno == EINTR);
+  return n;
+}
+
+private BOOLEAN
+__write(CONN *c, const char *buf, size_t len)
+{
+  ssize_t n;
+
+  while (len > 0) {
+#ifdef  HAVE_SSL
+    if (c->ssl != NULL) {
+      n = SSL_write(c->ssl, buf, (int)len);
+    } else
+#endif/*HAVE_SSL*/
+    n = send(c->fd, buf, len, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return FALSE;
+    buf += n;
+    len -= (size_t)n;
+  }
+  return TRUE;
+}
+
+private BOOLEAN
+__header(CONN *c, const char *type, const char *extra, int len, BOOLEAN closing)
+{
+  char  buf[512];
+  char  clen[64] = "";
+  int   n;
+
+  if (len >= 0) {
+    snprintf(clen, sizeof(clen), "Content-Length: %d\r\n", len);
+  }
+  n = snprintf(
+    buf, sizeof(buf),
+    "HTTP/1.1 200 OK\r\nServer: siege-bench\r\nContent-Type: %s\r\n%s%sConnection: %s\r\n\r\n",
+    type, extra, clen, closing ? "close" : "keep-alive"
+  );
+  return __write(c, buf, (size_t)n);
+}
+
+private char *
+__gzip(int n, size_t *len)
+{
+#ifdef  HAVE_ZLIB
+  int      i;
+  char    *out;
+  z_stream z;
+  uLong    max;
+
+  pthread_mutex_lock(&__gzlock);
+  for (i = 0; i < GZCACHE && __gz[i].data != NULL; i++) {
+    if (__gz[i].n == n) {
+      *len = __gz[i].len;
+      pthread_mutex_unlock(&__gzlock);
+      return __gz[i].data;
+    }
+  }
+  if (i == GZCACHE) i = GZCACHE-1;
+
+  /**
+   * __body is a single repeated byte which compresses to nothing;
+   * feed deflate the page text instead so it does some real work.
+   */
+  memset(&z, 0, sizeof(z));
+  deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 31, 8, Z_DEFAULT_STRATEGY);
+  max = deflateBound(&z, (uLong)n) + 64;
+  out = xmalloc(max);
+  z.next_out  = (Bytef*)out;
+  z.avail_out = (uInt)max;
+  do {
+    uInt chunk = (uInt)strlen(__page);
+    z.next_in  = (Bytef*)__page;
+    z.avail_in = ((uInt)n < chunk) ? (uInt)n : chunk;
+    n -= (int)z.avail_in;
+    deflate(&z, (n > 0) ? Z_NO_FLUSH : Z_FINISH);
+  } while (n > 0);
+  xfree(__gz[i].data);
+  __gz[i].n    = (int)z.total_in;
+  __gz[i].data = out;
+  __gz[i].len  = z.total_out;
+  deflateEnd(&z);
+  *len = __gz[i].len;
+  pthread_mutex_unlock(&__gzlock);
+  return out;
+#else
+  *len = (size_t)n;
+  return NULL;
+#endif/*HAVE_ZLIB*/
+}
+
+private BOOLEAN
+__respond(CONN *c, const char *path, BOOLEAN closing)
+{
+  int     n  = 0;
+  int     ms = 0;
+  size_t  len;
+  char   *buf;
+  char   *ptr;
+  BOOLEAN ok;
+
+  if (strncmp(path, "/fixed/", 7) == 0) {
+    n = atoi(path+7);
+    n = (n < 0) ? 0 : (n > BODYMAX) ? BODYMAX : n;
+    return __header(c, "text/plain", "", n, closing) && __write(c, __body, (size_t)n);
+  }
+  if (sscanf(path, "/slow/%d/%d", &ms, &n) == 2) {
+    n = (n < 0) ? 0 : (n > BODYMAX) ? BODYMAX : n;
+    if (ms > 0) usleep((useconds_t)ms * 1000);
+    return __header(c, "text/plain", "", n, closing) && __write(c, __body, (size_t)n);
+  }
+  if (strncmp(path, "/chunked/", 9) == 0) {
+    n   = atoi(path+9);
+    n   = (n < 0) ? 0 : (n > BODYMAX) ? BODYMAX : n;
+    buf = xmalloc((size_t)n + ((size_t)n/CHUNKSIZE+1)*16 + 8);
+    ptr = buf;
+    while (n > 0) {
+      int len = (n > CHUNKSIZE) ? CHUNKSIZE : n;
+      ptr += sprintf(ptr, "%x\r\n", len);
+      memcpy(ptr, __body, (size_t)len);
+      ptr += len;
+      *ptr++ = '\r';
+      *ptr++ = '\n';
+      n   -= len;
+    }
+    ptr += sprintf(ptr, "0\r\n\r\n");
+    ok   = __header(c, "text/plain", "Transfer-Encoding: chunked\r\n", -1, closing)
+        && __write(c, buf, (size_t)(ptr-buf));
+    xfree(buf);
+    return ok;
+  }
+  if (strncmp(path, "/gzip/", 6) == 0) {
+    n   = atoi(path+6);
+    n   = (n < 0) ? 0 : (n > BODYMAX) ? BODYMAX : n;
+    buf = __gzip(n, &len);
+    if (buf == NULL) {
+      return __header(c, "text/html", "", n, closing) && __write(c, __body, (size_t)n);
+    }
+    return __header(c, "text/html", "Content-Encoding: gzip\r\nVary: Accept-Encoding\r\n", (int)len, closing)
+        && __write(c, buf, len);
+  }
+  if (strncmp(path, "/page", 5) == 0) {
+    len = strlen(__page);
+    return __header(c, "text/html", "", (int)len, closing) && __write(c, __page, len);
+  }
+  buf = "HTTP/1.1 404 Not Found\r\nServer: siege-bench\r\nContent-Length: 0\r\n\r\n";
+  return __write(c, buf, strlen(buf));
+}
+
+/**
+ * Returns TRUE if header NAME appears with a value that starts
+ * with VALUE; both are compared without regard to case.
+ */
+private BOOLEAN
+__has(const char *head, const char *name, const char *value)
+{
+  const char *ptr = head;
+  size_t      nl  = strlen(name);
+  size_t      vl  = strlen(value);
+
+  while ((ptr = strstr(ptr, "\r\n")) != NULL) {
+    ptr += 2;
+    if (strncasecmp(ptr, name, nl) == 0 && ptr[nl] == ':') {
+      const char *val = ptr + nl + 1;
+      while (*val == ' ' || *val == '\t') val++;
+      return strncasecmp(val, value, vl) == 0;
+    }
+  }
+  return FALSE;
+}
+
+private void *
+__conn(void *arg)
+{
+  CONN   *c   = (CONN*)arg;
+  char   *buf = xmalloc(READSIZE+1);
+  size_t  len = 0;
+  ssize_t n;
+
+#ifdef  HAVE_SSL
+  if (c->ssl != NULL && SSL_accept(c->ssl) <= 0) {
+    goto done;
+  }
+#endif/*HAVE_SSL*/
+  for (;;) {
+    char    method[16];
+    char    path[1024];
+    char    proto[16];
+    char   *end;
+    char   *cl;
+    size_t  head;
+    long    body = 0;
+    BOOLEAN closing;
+
+    buf[len] = '\0';
+    while ((end = strstr(buf, "\r\n\r\n")) == NULL) {
+      if (len >= READSIZE) goto done;
+      n = __read(c, buf+len, READSIZE-len);
+      if (n <= 0) goto done;
+      len += (size_t)n;
+      buf[len] = '\0';
+    }
+    head   = (size_t)(end - buf) + 4;
+    end[2] = '\0';
+    if (sscanf(buf, "%15s %1023s %15s", method, path, proto) != 3) goto done;
+    if (strcmp(proto, "HTTP/1.0") == 0) {
+      closing = ! __has(buf, "connection", "keep-alive");
+    } else {
+      closing = __has(buf, "connection", "close");
+    }
+    if ((cl = strstr(buf, "\r\nContent-Length:")) != NULL) {
+      body = atol(cl+17);
+    }
+    if (! __respond(c, path, closing) || closing) goto done;
+
+    /* keep whatever followed the request, less any body it sent */
+    memmove(buf, buf+head, len-head);
+    len -= head;
+    while (body > 0) {
+      if (len > 0) {
+        size_t skip = ((size_t)body < len) ? (size_t)body : len;
+        memmove(buf, buf+skip, len-skip);
+        len  -= skip;
+        body -= (long)skip;
+        continue;
+      }
+      n = __read(c, buf, READSIZE);
+      if (n <= 0) goto done;
+      len = (size_t)n;
+    }
+  }
+
+done:
+#ifdef  HAVE_SSL
+  if (c->ssl != NULL) {
+    SSL_shutdown(c->ssl);
+    SSL_free(c->ssl);
+  }
+#endif/*HAVE_SSL*/
+  close(c->fd);
+  xfree(buf);
+  xfree(c);
+  return NULL;
+}
+
+private void *
+__accept(void *arg)
+{
+  LISTENER      *l = (LISTENER*)arg;
+  pthread_t      tid;
+  pthread_attr_t attr;
+  int            one = 1;
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  pthread_attr_setstacksize(&attr, 256*1024);
+  for (;;) {
+    CONN *c;
+    int   fd = accept(l->fd, NULL, NULL);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      if (errno == EMFILE || errno == ENFILE) { usleep(10000); continue; }
+      break;
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    c     = xcalloc(1, sizeof(CONN));
+    c->fd = fd;
+#ifdef  HAVE_SSL
+    if (l->tls) {
+      c->ssl = SSL_new(__ctx);
+      SSL_set_fd(c->ssl, fd);
+    }
+#endif/*HAVE_SSL*/
+    if (pthread_create(&tid, &attr, __conn, c) != 0) {
+#ifdef  HAVE_SSL
+      if (c->ssl != NULL) SSL_free(c->ssl);
+#endif/*HAVE_SSL*/
+      close(fd);
+      xfree(c);
+    }
+  }
+  pthread_attr_destroy(&attr);
+  return NULL;
+}
+
+#ifdef  HAVE_SSL
+/**
+ * A throwaway P-256 key and a self-signed certificate for
+ * localhost; siege doesn't verify peers, so that's enough.
+ */
+private SSL_CTX *
+__tls_context(void)
+{
+  SSL_CTX      *ctx  = NULL;
+  EVP_PKEY     *pkey = NULL;
+  EVP_PKEY_CTX *pctx = NULL;
+  X509         *x509 = NULL;
+  X509_NAME    *name;
+
+  SSL_library_init();
+  SSL_load_error_strings();
+  pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, NULL);
+  if (pctx == NULL
+      || EVP_PKEY_keygen_init(pctx) <= 0
+      || EVP_PKEY_CTX_set_ec_paramgen_curve_nid(pctx, NID_X9_62_prime256v1) <= 0
+      || EVP_PKEY_keygen(pctx, &pkey) <= 0) {
+    goto fail;
+  }
+  if ((x509 = X509_new()) == NULL) goto fail;
+  X509_set_version(x509, 2);
+  ASN1_INTEGER_set(X509_get_serialNumber(x509), 1);
+  X509_gmtime_adj(X509_getm_notBefore(x509), -3600);
+  X509_gmtime_adj(X509_getm_notAfter(x509),  86400);
+  X509_set_pubkey(x509, pkey);
+  name = X509_get_subject_name(x509);
+  X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"localhost", -1, -1, 0);
+  X509_set_issuer_name(x509, name);
+  if (X509_sign(x509, pkey, EVP_sha256()) <= 0) goto fail;
+
+  if ((ctx = SSL_CTX_new(SSLv23_server_method())) == NULL) goto fail;
+  if (SSL_CTX_use_certificate(ctx, x509) <= 0 || SSL_CTX_use_PrivateKey(ctx, pkey) <= 0) {
+    SSL_CTX_free(ctx);
+    ctx = NULL;
+  }
+
+fail:
+  if (x509 != NULL) X509_free(x509);
+  if (pkey != NULL) EVP_PKEY_free(pkey);
+  if (pctx != NULL) EVP_PKEY_CTX_free(pctx);
+  return ctx;
+}
+#endif/*HAVE_SSL*/
+
+private int
+__listen(int *port)
+{
+  struct sockaddr_in addr;
+  socklen_t          len = sizeof(addr);
+  int                one = 1;
+  int                fd;
+
+  if ((fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) return -1;
+  fcntl(fd, F_SETFD, FD_CLOEXEC);
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family      = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port        = 0;
+  if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0
+      || listen(fd, 1024) < 0
+      || getsockname(fd, (struct sockaddr*)&addr, &len) < 0) {
+    close(fd);
+    return -1;
+  }
+  *port = ntohs(addr.sin_port);
+  return fd;
+}
+
+private void
+__content(void)
+{
+  const char *text = "Siege is an http load tester and benchmarking utility. ";
+  size_t      tl   = strlen(text);
+  size_t      len  = 0;
+  size_t      max  = 64*1024;
+  int         i;
+
+  __body = xmalloc(BODYMAX);
+  memset(__body, 'x', BODYMAX);
+
+  __page = xmalloc(max);
+  len += snprintf(__page+len, max-len, "<html>\n<head>\n<title>siege-bench</title>\n");
+  for (i = 0; i < RESOURCES; i++) {
+    switch (i % 4) {
+      case 0:
+        len += snprintf(__page+len, max-len, "<link rel=\"stylesheet\" href=\"/fixed/512?css=%d\">\n", i);
+        break;
+      case 1:
+        len += snprintf(__page+len, max-len, "<script src=\"/fixed/512?js=%d\"></script>\n", i);
+        break;
+      default:
+        len += snprintf(__page+len, max-len, "<img src=\"/fixed/256?img=%d\" alt=\"%d\">\n", i, i);
+        break;
+    }
+  }
+  len += snprintf(__page+len, max-len, "</head>\n<body>\n");
+  while (len + tl + 32 < max) {
+    memcpy(__page+len, text, tl);
+    len += tl;
+  }
+  snprintf(__page+len, max-len, "\n</body>\n</html>\n");
+}
+
+/**
+ * Forks the server; it lives until the parent kills it.
+ */
+private pid_t
+__server(int http, int https)
+{
+  pid_t     pid;
+  pthread_t tid;
+  LISTENER  l[2];
+
+  if ((pid = fork()) != 0) {
+    return pid;
+  }
+  signal(SIGPIPE, SIG_IGN);
+  signal(SIGINT,  SIG_IGN);
+  l[0].fd  = http;
+  l[0].tls = FALSE;
+  l[1].fd  = https;
+  l[1].tls = TRUE;
+  if (https >= 0) {
+    pthread_create(&tid, NULL, __accept, &l[1]);
+  }
+  __accept(&l[0]);
+  _exit(0);
+}
+
+/**
+ * the client side
+ */
+private int
+__cycles_open(pid_t pid)
+{
+#ifdef  HAVE_LINUX_PERF_EVENT_H
+  struct perf_event_attr attr;
+  int    fd;
+
+  memset(&attr, 0, sizeof(attr));
+  attr.size           = sizeof(attr);
+  attr.type           = PERF_TYPE_HARDWARE;
+  attr.config         = PERF_COUNT_HW_CPU_CYCLES;
+  attr.disabled       = 1;
+  attr.enable_on_exec = 1;
+  attr.inherit        = 1;
+  attr.exclude_hv     = 1;
+  fd = (int)syscall(__NR_perf_event_open, &attr, pid, -1, -1, 0);
+  if (fd >= 0) fcntl(fd, F_SETFD, FD_CLOEXEC);
+  return fd;
+#else
+  (void)pid;
+  return -1;
+#endif/*HAVE_LINUX_PERF_EVENT_H*/
+}
+
+private double
+__mhz(void)
+{
+  FILE   *fp;
+  char    line[256];
+  double  mhz = 0.0;
+
+  if ((fp = fopen("/proc/cpuinfo", "r")) == NULL) return 0.0;
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    char *ptr;
+    if (strncmp(line, "cpu MHz", 7) == 0 && (ptr = strchr(line, ':')) != NULL) {
+      mhz = atof(ptr+1);
+      break;
+    }
+  }
+  fclose(fp);
+  return mhz;
+}
+
+private double
+__json(const char *json, const char *key)
+{
+  char  k[64];
+  char *ptr;
+
+  snprintf(k, sizeof(k), "\"%s\":", key);
+  if (json == NULL || (ptr = strstr(json, k)) == NULL) return -1.0;
+  return atof(ptr + strlen(k));
+}
+
+private char *
+__rcfile(SCENARIO *s)
+{
+  char  tmp[] = "/tmp/siege-bench.XXXXXX";
+  int   fd;
+  FILE *fp;
+
+  if ((fd = mkstemp(tmp)) < 0 || (fp = fdopen(fd, "w")) == NULL) {
+    NOTIFY(FATAL, "unable to write a temp file: %s", strerror(errno));
+  }
+  fprintf(fp, "verbose = false\n");
+  fprintf(fp, "logging = false\n");
+  fprintf(fp, "show-logfile = false\n");
+  fprintf(fp, "benchmark = true\n");
+  fprintf(fp, "protocol = HTTP/1.1\n");
+  fprintf(fp, "connection = %s\n", s->close ? "close" : "keep-alive");
+  fprintf(fp, "parser = %s\n", s->parser ? "true" : "false");
+  fprintf(fp, "chunked = true\n");
+  fprintf(fp, "accept-encoding = gzip\n");
+  fprintf(fp, "cache = false\n");
+  fprintf(fp, "timeout = 30\n");
+  fprintf(fp, "failures = 1048576\n");
+  fprintf(fp, "limit = 10000\n");
+  fclose(fp);
+  return xstrdup(tmp);
+}
+
+typedef struct {
+  double trans;
+  double elapsed;
+  double failed;
+  double cpu;
+  double cycles;
+  BOOLEAN counted;
+} RESULT;
+
+private BOOLEAN
+__run(char *siege, SCENARIO *s, int port, int tlsport, int secs, int users, BOOLEAN verbose, RESULT *r)
+{
+  char   url[256];
+  char   conc[32];
+  char   length[32];
+  char  *rc;
+  char  *out  = NULL;
+  size_t len  = 0;
+  size_t max  = 0;
+  int    pfd[2];
+  int    gate[2];
+  int    perf;
+  int    status;
+  char   go   = 0;
+  pid_t  pid;
+  ssize_t n;
+  struct rusage ru;
+
+  memset(r, 0, sizeof(RESULT));
+  snprintf(url,  sizeof(url), "%s://127.0.0.1:%d%s", s->tls ? "https" : "http", s->tls ? tlsport : port, s->path);
+  snprintf(conc, sizeof(conc), "%d", users);
+  snprintf(length, sizeof(length), "%dS", secs);
+  rc = __rcfile(s);
+
+  if (pipe(pfd) < 0 || pipe(gate) < 0) {
+    NOTIFY(FATAL, "unable to create a pipe: %s", strerror(errno));
+  }
+  if ((pid = fork()) < 0) {
+    NOTIFY(FATAL, "unable to fork: %s", strerror(errno));
+  }
+  if (pid == 0) {
+    char *argv[] = { siege, "-q", "-j", "-R", rc, "-c", conc, "-t", length, url, NULL };
+    close(pfd[0]);
+    close(gate[1]);
+    dup2(pfd[1], STDOUT_FILENO);
+    close(pfd[1]);
+    if (! verbose) {
+      int null = open("/dev/null", O_WRONLY);
+      if (null >= 0) dup2(null, STDERR_FILENO);
+    }
+    /* wait for the parent to attach its counter before we exec */
+    while (read(gate[0], &go, 1) < 0 && errno == EINTR) ;
+    close(gate[0]);
+    execv(siege, argv);
+    _exit(127);
+  }
+  close(pfd[1]);
+  close(gate[0]);
+  perf = __cycles_open(pid);
+  close(gate[1]);
+
+  for (;;) {
+    if (len + 4096 > max) {
+      max = max ? max * 2 : 16384;
+      out = xrealloc(out, max);
+    }
+    n = read(pfd[0], out+len, max-len-1);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    len += (size_t)n;
+  }
+  if (out != NULL) out[len] = '\0';
+  close(pfd[0]);
+  while (wait4(pid, &status, 0, &ru) < 0 && errno == EINTR) ;
+
+  r->cpu = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6
+         + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+  if (perf >= 0) {
+    unsigned long long cycles = 0;
+    if (read(perf, &cycles, sizeof(cycles)) == sizeof(cycles) && cycles > 0) {
+      r->cycles  = (double)cycles;
+      r->counted = TRUE;
+    }
+    close(perf);
+  }
+  r->trans   = __json(out, "transactions");
+  r->elapsed = __json(out, "elapsed_time");
+  r->failed  = __json(out, "failed_transactions");
+  unlink(rc);
+  xfree(rc);
+  xfree(out);
+  return (WIFEXITED(status) && r->trans > 0 && r->elapsed > 0);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int     c;
+  int     secs    = 5;
+  int     users   = 0;
+  int     port    = 0;
+  int     tlsport = 0;
+  int     http;
+  int     https   = -1;
+  int     ran     = 0;
+  BOOLEAN verbose = FALSE;
+  BOOLEAN counted = FALSE;
+  BOOLEAN estimated = FALSE;
+  char   *siege   = NULL;
+  double  mhz;
+  pid_t   server;
+  size_t  i;
+  static struct option opts[] = {
+    { "siege",      required_argument, NULL, 's' },
+    { "time",       required_argument, NULL, 't' },
+    { "concurrent", required_argument, NULL, 'c' },
+    { "verbose",    no_argument,       NULL, 'v' },
+    { "help",       no_argument,       NULL, 'h' },
+    { NULL, 0, NULL, 0 }
+  };
+
+  while ((c = getopt_long(argc, argv, "s:t:c:vh", opts, NULL)) != -1) {
+    switch (c) {
+      case 's':
+        siege = xstrdup(optarg);
+        break;
+      case 't':
+        secs = atoi(optarg);
+        break;
+      case 'c':
+        users = atoi(optarg);
+        break;
+      case 'v':
+        verbose = TRUE;
+        break;
+      case 'h':
+        __usage(argv[0]);
+        exit(EXIT_SUCCESS);
+      default:
+        __usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+  }
+  if (secs < 1) secs = 1;
+  if (siege == NULL) {
+    char *slash = strrchr(argv[0], '/');
+    if (slash == NULL) {
+      siege = xstrdup("siege");
+    } else {
+      siege = xmalloc((size_t)(slash - argv[0]) + 8);
+      sprintf(siege, "%.*s/siege", (int)(slash - argv[0]), argv[0]);
+    }
+  }
+  if (access(siege, X_OK) != 0) {
+    NOTIFY(FATAL, "%s: not executable; use --siege=PATH", siege);
+  }
+  for (c = optind; c < argc; c++) {
+    for (i = 0; i < SCENARIOS; i++) {
+      if (strcmp(argv[c], scenarios[i].name) == 0) break;
+    }
+    if (i == SCENARIOS) {
+      NOTIFY(FATAL, "%s: no such scenario; see %s --help", argv[c], argv[0]);
+    }
+  }
+
+  __content();
+  memset(__gz, 0, sizeof(__gz));
+  if ((http = __listen(&port)) < 0) {
+    NOTIFY(FATAL, "unable to listen on the loopback: %s", strerror(errno));
+  }
+#ifdef  HAVE_SSL
+  if ((__ctx = __tls_context()) != NULL) {
+    https = __listen(&tlsport);
+  } else {
+    NOTIFY(WARNING, "unable to create a TLS context; skipping TLS");
+  }
+#endif/*HAVE_SSL*/
+  server = __server(http, https);
+  if (server < 0) {
+    NOTIFY(FATAL, "unable to fork the server: %s", strerror(errno));
+  }
+  close(http);
+  if (https >= 0) close(https);
+
+  mhz = __mhz();
+  printf("siege-bench: %s, %ld cpu(s), %d seconds per scenario\n\n",
+    siege, sysconf(_SC_NPROCESSORS_ONLN), secs);
+  printf("%-10s %6s %11s %7s %12s %12s %8s\n",
+    "scenario", "users", "trans/sec", "cpu %", "req/cpu-sec", "cycles/req", "failed");
+  fflush(stdout);
+
+  for (i = 0; i < SCENARIOS; i++) {
+    SCENARIO *s = &scenarios[i];
+    RESULT    r;
+    char      cyc[32];
+    int       u = (users > 0) ? users : s->users;
+
+    if (optind < argc) {
+      for (c = optind; c < argc && strcmp(argv[c], s->name) != 0; c++) ;
+      if (c == argc) continue;
+    }
+    if (s->tls && https < 0) {
+      printf("%-10s %6d %11s\n", s->name, u, "skipped: no TLS");
+      continue;
+    }
+    if (! __run(siege, s, port, tlsport, secs, u, verbose, &r)) {
+      printf("%-10s %6d %11s\n", s->name, u, "failed to run");
+      fflush(stdout);
+      continue;
+    }
+    if (r.counted) {
+      snprintf(cyc, sizeof(cyc), "%.0f", r.cycles / r.trans);
+      counted = TRUE;
+    } else if (mhz > 0) {
+      snprintf(cyc, sizeof(cyc), "~%.0f", r.cpu * mhz * 1e6 / r.trans);
+      estimated = TRUE;
+    } else {
+      snprintf(cyc, sizeof(cyc), "-");
+    }
+    printf("%-10s %6d %11.2f %7.1f %12.1f %12s %8.0f\n",
+      s->name, u, r.trans / r.elapsed, 100.0 * r.cpu / r.elapsed,
+      (r.cpu > 0) ? r.trans / r.cpu : 0.0, cyc, r.failed
+    );
+    fflush(stdout);
+    ran++;
+  }
+
+  kill(server, SIGTERM);
+  waitpid(server, NULL, 0);
+
+  puts("");
+  puts("req/cpu-sec is siege's requests per second of its own CPU time (user + system),");
+  puts("i.e. what one core would sustain; the server runs in a separate process.");
+  if (counted) {
+    puts("cycles/req counts CPU cycles in siege with a hardware counter.");
+  }
+  if (estimated) {
+    printf("~cycles/req is estimated from CPU time at %.0f MHz; hardware counters were unavailable.\n", mhz);
+  }
+  xfree(siege);
+  exit((ran > 0) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
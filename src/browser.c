@@ -40,6 +40,17 @@
 #include <response.h>
 #include <memory.h>
 #include <notify.h>
+#include <pcache.h>
+#include <edge.h>
+#include <hist.h>
+#include <writer.h>
+#include <urlstats.h>
+#include <fault.h>
+#include <timer.h>
+#include <replay.h>
+#include <har.h>
+#include <alias.h>
+#include <class.h>
 #include <browser.h>
 
 #if defined(hpux) || defined(__hpux) || defined(WINDOWS)
@@ -50,9 +61,6 @@
 static pthread_once_t once = PTHREAD_ONCE_INIT;
 #endif/*SIGNAL_CLIENT_PLATFORM*/
 
-float __himark = 0;
-float __lomark = -1;
-
 struct BROWSER_T
 {
   int      id;
@@ -60,6 +68,23 @@ struct BROWSER_T
   char     uuid[37];
   ARRAY    urls;
   ARRAY    parts;
+  PCACHE   pcache;
+  PARTS    page;
+  EDGE     edge;
+  PROFILE  profile;
+  REPLAY   replay;
+  HAR      har;
+  ALIAS    alias;    /* picks the URLs by weight */
+  CLASS    uclass;   /* our user class with --scenario */
+  BOOLEAN  keepalive;
+  BOOLEAN  internet;
+  double   due;      /* when our last request was due, with a rate */
+  URLSTATS urlstats;
+  int      slot;     /* the ID of the URL we're working on */
+  BOOLEAN  answered; /* whether its last request got a response */
+  BOOLEAN  counting; /* whether it started in the window we count */
+  BOOLEAN  busy;     /* a request is in flight */
+  BOOLEAN  edged;
   HASH     cookies;
   FACTS    facts;
   CONN *   conn;
@@ -77,6 +102,7 @@ struct BROWSER_T
   float    time;
   float    himark;
   float    lomark;
+  HIST     hist;
   clock_t  start;
   clock_t  stop;
   struct   tms  t_start;
@@ -101,19 +127,38 @@ struct BROWSER_T
   unsigned int  count;
   unsigned int  okay;
   unsigned int  fail;
+  unsigned int  cached;
   unsigned long hits;
+  unsigned long failed;  /* our share of my.failed */
   unsigned long long bytes;
   unsigned int  rseed;
+  unsigned long long rng[4];
 };
 
 size_t BROWSERSIZE = sizeof(struct BROWSER_T);
 
+private int __inflight = 0;
+
 private BOOLEAN __init_connection(BROWSER this, URL U);
+private BOOLEAN __transact(BROWSER this, URL U);
+private BOOLEAN __edge_hit(BROWSER this, URL U);
+private void    __landed(void *arg);
+private void    __from_cache(BROWSER this, URL U);
 private BOOLEAN __request(BROWSER this, URL U); 
 private BOOLEAN __http(BROWSER this, URL U);
 private BOOLEAN __ftp(BROWSER this, URL U);
 private BOOLEAN __no_follow(const char *hostname);
+private char *  __parse(ARRAY parts, URL U, char *html);
+private void    __request_part(BROWSER this, URL U);
+private void    __replay(BROWSER this);
+private void    __page(BROWSER this, int page);
+private void    __think(BROWSER this);
+private void    __nap(double secs);
 private void    __increment_failures();
+private BOOLEAN __refused(int code);
+private void    __failure(BROWSER this);
+private void    __answered(BROWSER this, int code, unsigned long bytes, float etime);
+private void    __mark(BROWSER this, float etime);
 private int     __select_color(int code);
 private void    __display_result(BROWSER this, RESPONSE resp, URL U, unsigned long bytes, float etime);
 
@@ -138,13 +183,28 @@ new_browser(int id, char *file)
   this->count     = 0.0;
   this->okay      = 0;
   this->fail      = 0;
+  this->failed    = 0;
   this->lowest    =  -1;
   this->highest   = 0.0;
   this->elapsed   = 0.0;
   this->bytes     = 0.0;
   this->urls      = NULL;
   this->parts     = new_array();
+  this->pcache    = NULL;
+  this->page      = NULL;
+  this->edge      = NULL;
+  this->edged     = FALSE;
+  this->cached    = 0;
+  this->himark    = 0.0;
+  this->lomark    = -1;
+  this->hist      = new_hist();
+  this->urlstats  = NULL;
+  this->slot      = -1;
+  this->keepalive = my.keepalive;
+  this->internet  = my.internet;
+  this->due       = 0.0;
   this->rseed     = urandom();
+  xoshiro_seed(this->rng, ((unsigned long long)(unsigned int)urandom() << 32) ^ (unsigned int)this->id);
   generate_uuid(this->uuid, this->id);
   return this;
 }
@@ -169,6 +229,9 @@ browser_destroy(BROWSER this)
       }
       this->parts = array_destroy(this->parts);
     }
+    this->page = parts_release(this->page);
+    this->hist = hist_destroy(this->hist);
+    this->urlstats = urlstats_destroy(this->urlstats);
     xfree(this);
   }
   this = NULL;
@@ -217,6 +280,37 @@ browser_get_fail(BROWSER this)
   return this->fail;
 }
 
+unsigned long
+browser_get_failed(BROWSER this)
+{
+  return this->failed;
+}
+
+/**
+ * 1 if the run ended while this browser had a request in
+ * flight that we'd have counted, that is it was cancelled.
+ */
+unsigned int
+browser_get_aborted(BROWSER this)
+{
+  return (this->busy && this->counting) ? 1 : 0;
+}
+
+/**
+ * The number of requests in flight across all browsers
+ */
+int
+browser_get_inflight()
+{
+  return __sync_add_and_fetch(&__inflight, 0);
+}
+
+unsigned int
+browser_get_cached(BROWSER this)
+{
+  return this->cached;
+}
+
 float
 browser_get_himark(BROWSER this)
 {
@@ -229,6 +323,18 @@ browser_get_lomark(BROWSER this)
   return this->lomark;
 }
 
+HIST
+browser_get_hist(BROWSER this)
+{
+  return this->hist;
+}
+
+URLSTATS
+browser_get_urlstats(BROWSER this)
+{
+  return this->urlstats;
+}
+
 void *
 start(BROWSER this)
 {
@@ -237,6 +343,7 @@ start(BROWSER this)
   int max_y;
   int ret;
   int len; 
+  int n;
   this->conn  = NULL;
   this->conn = xcalloc(sizeof(CONN), 1);
   this->conn->sock       = -1;
@@ -264,26 +371,56 @@ start(BROWSER this)
   pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &this->state);
 #endif/*SIGNAL_CLIENT_PLATFORM*/
 
+  /**
+   * With --profile we may not be needed yet
+   */
+  profile_gate(this->profile, this->id - 1);
+
   if (my.login == TRUE) {
     URL tmp = new_url(array_next(my.lurl));
     if (tmp == NULL) {
       NOTIFY (ERROR, "Malformed login url: %s\nCheck $HOME/.siege/siege.conf for 'login-url'\n", my.lurl);  
     } else {
       url_set_ID(tmp, 0);
-      __request(this, tmp);
+      this->slot     = -1;
+      this->counting = timer_steady();
+      __transact(this, tmp);
     }
   }
 
-  len = (my.reps == -1) ? (int)array_length(this->urls) : my.reps;
+  /**
+   * With --replay the log is our list of URLs
+   */
+  max_y = (this->har != NULL) ? har_get_pages(this->har) : (int)array_length(this->urls);
+  if (this->replay != NULL) {
+    __replay(this);
+    len = 0;
+  } else {
+    len = (my.reps == -1) ? max_y : my.reps;
+  }
   y   = (my.reps == -1) ? 0 : this->id * (my.length / my.cusers);
-  max_y = (int)array_length(this->urls);
+
+  /**
+   * Users paced to a rate start at random so they don't arrive
+   * together
+   */
+  if (this->uclass != NULL && class_get_rate(this->uclass) > 0) {
+    __think(this);
+  }
   for (x = 0; x < len; x++, y++) {
     x = ((my.secs > 0) && ((my.reps <= 0)||(my.reps == MAXREPS))) ? 0 : x;
-    if (my.internet == TRUE) {
-      y = (unsigned int) (((double)pthread_rand_np(&(this->rseed)) /
-                          ((double)RAND_MAX + 1) * my.length ) + .5);
-      y = (y >= my.length)?my.length-1:y;
-      y = (y < 0)?0:y;
+    profile_gate(this->profile, this->id - 1);
+    if (timer_stopping()) {
+      break;
+    }
+    if (this->alias != NULL) {
+      y = alias_pick(this->alias, xoshiro_next(this->rng));
+      if (timer_steady()) {
+        alias_hit(this->alias, y);
+      }
+    } else if (this->internet == TRUE) {
+      n = (this->har != NULL || this->uclass != NULL) ? max_y : my.length;
+      y = (int)(xoshiro_double(this->rng) * n);
     } else {
       /**
        * URLs accessed sequentially; when reaching the end, start over
@@ -305,40 +442,41 @@ start(BROWSER this)
     /**
      * This is the initial request from the command line
      * or urls.txt file. If it is text/html then it will
-     * be parsed in __http request function.
+     * be parsed in __http request function. With --har
+     * it's a page and all of its requests.
      */
     URL tmp = array_get(this->urls, y);
-    if (tmp != NULL && url_get_hostname(tmp) != NULL) {
+    if (this->har != NULL) {
+      __page(this, y);
+    } else if (tmp != NULL && url_get_hostname(tmp) != NULL) {
       this->auth.bids.www = 0; /* reset */
-      if ((ret = __request(this, tmp))==FALSE) {
-        __increment_failures();
+      this->slot        = url_get_ID(tmp);
+      this->answered    = FALSE;
+      this->counting    = timer_steady();
+      this->conn->fault = FAULT_NONE;
+      if ((ret = __transact(this, tmp))==FALSE) {
+        __failure(this);
       }
     }
 
     /**
      * If we parsed http resources, we'll request them here
      */
+    if (my.parser == TRUE && this->page != NULL) {
+      /**
+       * Shared with other browsers; we walk it back to front
+       * to request in the same order as array_pop below
+       */
+      int i;
+      for (i = parts_length(this->page) - 1; i >= 0; i--) {
+        __request_part(this, parts_get(this->page, i));
+      }
+      this->page = parts_release(this->page);
+    }
     if (my.parser == TRUE && this->parts != NULL) {
       URL  u;
       while ((u = (URL)array_pop(this->parts)) != NULL) {
-        if (url_get_scheme(u) == UNSUPPORTED) {
-          ;;
-        } else if (my.cache && is_cached(this->conn->cache, u)) {
-          RESPONSE r = new_response();
-          response_set_code(r, "HTTP/1.1 200 OK");
-          response_set_from_cache(r, TRUE);
-          __display_result(this, r, u, 0, 0.00);
-          r = response_destroy(r);
-          ;;
-        } else {
-          this->auth.bids.www = 0;
-          // We'll only request files on the same host as the page
-          if (! __no_follow(url_get_hostname(u))) {
-            if ((ret = __request(this, u))==FALSE) {
-              __increment_failures();
-            }
-          }
-        }
+        __request_part(this, u);
         u = url_destroy(u);
       }
     }
@@ -349,17 +487,18 @@ start(BROWSER this)
     pthread_testcancel(); 
 
     /**
-     * Delay between interactions -D num /--delay=num
+     * Delay between interactions -D num /--delay=num; a user class
+     * has its own think time or arrival rate
      */
-    if (my.delay >= 1) {
+    if (this->uclass != NULL) {
+      __think(this);
+    } else if (my.delay >= 1) {
       pthread_sleep_np(
-       (unsigned int) (((double)pthread_rand_np(&(this->rseed)) /
-                       ((double)RAND_MAX + 1) * my.delay ) + .5)
+       (unsigned int) ((xoshiro_double(this->rng) * my.delay) + .5)
       );
     } else if (my.delay >= .001) {
       pthread_usleep_np(
-       (unsigned int) (((double)pthread_rand_np(&(this->rseed)) /
-                       ((double)RAND_MAX + 1) * my.delay * 1000000 ) + .0005)
+       (unsigned int) ((xoshiro_double(this->rng) * my.delay * 1000000) + .0005)
       );
     }
 
@@ -398,6 +537,71 @@ browser_set_cookies(BROWSER this, HASH cookies)
   this->cookies = cookies;
 }
 
+void
+browser_set_pcache(BROWSER this, PCACHE pcache)
+{
+  this->pcache = pcache;
+}
+
+void
+browser_set_edge(BROWSER this, EDGE edge)
+{
+  this->edge = edge;
+}
+
+/**
+ * The browser owns urlstats; it should be a fork of main's
+ */
+void
+browser_set_urlstats(BROWSER this, URLSTATS urlstats)
+{
+  this->urlstats = urlstats;
+}
+
+void
+browser_set_profile(BROWSER this, PROFILE profile)
+{
+  this->profile = profile;
+}
+
+void
+browser_set_replay(BROWSER this, REPLAY replay)
+{
+  this->replay = replay;
+}
+
+void
+browser_set_har(BROWSER this, HAR har)
+{
+  this->har = har;
+}
+
+void
+browser_set_alias(BROWSER this, ALIAS alias)
+{
+  this->alias = alias;
+}
+
+/**
+ * A user class brings its URLs and connection settings
+ */
+void
+browser_set_class(BROWSER this, CLASS uclass)
+{
+  this->uclass = uclass;
+  if (uclass != NULL) {
+    this->urls      = class_get_urls(uclass);
+    this->keepalive = class_get_keepalive(uclass);
+    this->internet  = class_get_internet(uclass);
+  }
+}
+
+CLASS
+browser_get_class(BROWSER this)
+{
+  return this->uclass;
+}
+
 private BOOLEAN
 __request(BROWSER this, URL U) {
   this->conn->scheme = url_get_scheme(U);
@@ -428,36 +632,12 @@ __http(BROWSER this, URL U)
   clock_t  start, stop;
   struct   tms t_start, t_stop;
   RESPONSE resp;
+  PARTS    page = NULL;
   char     *meta = NULL;
-#ifdef  HAVE_LOCALTIME_R
-  struct   tm keepsake;
-#endif/*HAVE_LOCALTIME_R*/
-  time_t   now;
-  struct   tm *tmp;
-  size_t   len;
-  char     fmtime[65];
   URL      redirect_url = NULL;
 
   page_clear(this->conn->page);
 
-  if (my.csv) {
-    now = time(NULL);
-    #ifdef HAVE_LOCALTIME_R
-    tmp = (struct tm *)localtime_r(&now, &keepsake);
-    #else
-    tmp = localtime(&now);
-    #endif/*HAVE_LOCALTIME_R*/
-    if (tmp) {
-      len = strftime(fmtime, 64, "%Y-%m-%d %H:%M:%S", tmp);
-      if (len == 0) {
-        memset(fmtime, '\0', 64);
-        snprintf(fmtime, 64, "n/a");
-      }
-    } else {
-      snprintf(fmtime, 64, "n/a");
-    }
-  }
-
   if (url_get_scheme(U) == UNSUPPORTED) {
     if (my.verbose && !my.get && !my.print) {
       NOTIFY (
@@ -512,9 +692,7 @@ __http(BROWSER this, URL U)
     socket_close(this->conn);
     stop  =  times(&t_stop);
     etime =  elapsed_time(stop - start);
-    this->hits ++;
-    this->time += etime;
-    this->fail += 1;
+    __answered(this, code, 0, etime);
 
     __display_result(this, resp, U, 0, etime);
     resp = response_destroy(resp);
@@ -528,20 +706,39 @@ __http(BROWSER this, URL U)
 
   if (my.parser == TRUE) {
     if (strmatch(response_get_content_type(resp), "text/html") && code < 300) {
-      int   i;
-      html_parser(this->parts, U, page_value(this->conn->page));
-      for (i = 0; i < (int)array_length(this->parts); i++) {
-        URL url  = (URL)array_get(this->parts, i);
-        if (url_is_redirect(url)) {
-          URL tmp = (URL)array_remove(this->parts, i);
-          meta    = xstrdup(url_get_absolute(tmp));
-          tmp     = url_destroy(tmp);
+      if ((this->pcache != NULL || this->edged) && this->page == NULL) {
+        /**
+         * Identical pages parse to identical resources so we
+         * share the result with every browser and the edge.
+         * A nested parse (meta refresh, html parts) falls
+         * through to this->parts
+         */
+        char  *html = page_value(this->conn->page);
+        size_t hlen = page_length(this->conn->page);
+        this->page  = pcache_get(this->pcache, U, response_get_etag(resp), html, hlen);
+        if (this->page == NULL) {
+          ARRAY tmp  = new_array();
+          char *redir = __parse(tmp, U, html);
+          this->page = pcache_put(this->pcache, U, response_get_etag(resp), html, hlen, tmp, redir);
+          tmp = array_destroy(tmp);
+          xfree(redir);
         }
+        page = this->page;
+        if (parts_get_meta(this->page) != NULL) {
+          meta = xstrdup(parts_get_meta(this->page));
+        }
+      } else {
+        meta = __parse(this->parts, U, page_value(this->conn->page));
       }
     }
   }
 
+  if (this->edged == TRUE && code == 200) {
+    edge_store(this->edge, U, this->id, resp, bytes, page);
+  }
+
   if (!my.zero_ok && (bytes < 1)) {
+    socket_fault(this->conn, FAULT_EMPTY);
     this->conn->connection.reuse = 0;
     socket_close(this->conn);
     resp = response_destroy(resp);
@@ -555,25 +752,21 @@ __http(BROWSER this, URL U)
   /**
    * quantify the statistics for this client.
    */
-  this->bytes += bytes;
-  this->time  += etime;
-  this->code  += okay;
-  this->fail  += fail;
-  if (code == 200) {
-    this->okay++;
+  if (this->counting) {
+    this->bytes += bytes;
+    this->time  += etime;
+    this->code  += okay;
+    this->fail  += (__refused(code)) ? 0 : fail;
+    if (code == 200) {
+      this->okay++;
+    }
   }
  
   /**
    * check to see if this transaction is the longest or shortest
    */
-  if (etime > __himark) {
-    __himark = etime;
-  }
-  if ((__lomark < 0) || (etime < __lomark)) {
-    __lomark = etime;
-  }
-  this->himark = __himark;
-  this->lomark = __lomark;
+  __mark(this, etime);
+  __answered(this, code, bytes, etime);
 
   /**
    * verbose output, print statistics to stdout
@@ -583,7 +776,7 @@ __http(BROWSER this, URL U)
   /**
    * close the socket and free memory.
    */
-  if (!my.keepalive) {
+  if (!this->keepalive) {
     socket_close(this->conn);
   }
 
@@ -600,7 +793,13 @@ __http(BROWSER this, URL U)
         if (empty(url_get_hostname(redirect_url))) {
           url_set_hostname(redirect_url, url_get_hostname(U));
         }
-        url_set_redirect(U, FALSE);
+        if (url_is_redirect(U)) {
+          /**
+           * Parsed parts are shared read-only; they never
+           * have this set, see __parse
+           */
+          url_set_redirect(U, FALSE);
+        }
         url_set_redirect(redirect_url, FALSE);
         if ((__request(this, redirect_url)) == FALSE) {
           redirect_url = url_destroy(redirect_url);
@@ -807,7 +1006,9 @@ __http(BROWSER this, URL U)
       break;
   }
 
-  this->hits++;
+  if (this->counting) {
+    this->hits++;
+  }
   resp = response_destroy(resp);
 
   return TRUE;
@@ -826,6 +1027,8 @@ __ftp(BROWSER this, URL U)
   int     fail;
   int     code = 0;      // capture the relevant return code
   float   etime;         // elapsed time
+  char    *user;         // login credentials
+  char    *pw;
   CONN    *D    = NULL;  // FTP data connection
   size_t  bytes = 0;     // bytes from server
   clock_t start, stop;
@@ -854,23 +1057,27 @@ __ftp(BROWSER this, URL U)
     return FALSE;
   }
 
-  if (url_get_username(U) == NULL || strlen(url_get_username(U)) < 1) {
-    url_set_username(U, auth_get_ftp_username(my.auth, url_get_hostname(U)));
+  /**
+   * U may be shared with other browsers so we don't fill
+   * in its credentials; the ones from .siegerc are ours
+   */
+  user = url_get_username(U);
+  if (user == NULL || strlen(user) < 1) {
+    user = auth_get_ftp_username(my.auth, url_get_hostname(U));
   }
-
-  if (url_get_password(U) == NULL || strlen(url_get_password(U)) < 1) {
-    url_set_password(U, auth_get_ftp_password(my.auth, url_get_hostname(U)));
+  pw = url_get_password(U);
+  if (pw == NULL || strlen(pw) < 1) {
+    pw = auth_get_ftp_password(my.auth, url_get_hostname(U));
   }
-  if (ftp_login(this->conn, U) == FALSE) {
-    if (my.verbose) {
+  if (ftp_login(this->conn, user, pw) == FALSE) {
+    if (my.verbose || my.vfile != NULL) {
       int  color = __select_color(this->conn->ftp.code);
-      DISPLAY (
+      writer_print(
         color, "FTP/%d %6.2f secs: %7lu bytes ==> %-6s %s",
         this->conn->ftp.code, 0.0, bytes, url_get_method_name(U), url_get_request(U)
       );
     }
     xfree(D);
-    this->fail += 1;
     return FALSE;
   }
 
@@ -882,7 +1089,6 @@ __ftp(BROWSER this, URL U)
       debug (
         "%s:%d connection failed. error %d(%s)",__FILE__, __LINE__, errno,strerror(errno)
       );
-      this->fail += 1;
       socket_close(D);
       xfree(D);
       return FALSE;
@@ -908,31 +1114,29 @@ __ftp(BROWSER this, URL U)
   fail  = (pass  == 0) ? 1 : 0;
   stop  =  times(&t_stop);
   etime =  elapsed_time(stop - start);
-  this->bytes += bytes;
-  this->time  += etime;
-  this->code  += pass;
-  this->fail  += fail;
+  if (this->counting) {
+    this->bytes += bytes;
+    this->time  += etime;
+    this->code  += pass;
+    this->fail  += fail;
+  }
 
   /**
    * check to see if this transaction is the longest or shortest
    */
-  if (etime > __himark) {
-    __himark = etime;
-  }
-  if ((__lomark < 0) || (etime < __lomark)) {
-    __lomark = etime;
-  }
-  this->himark = __himark;
-  this->lomark = __lomark;
+  __mark(this, etime);
+  __answered(this, code, bytes, etime);
 
-  if (my.verbose) {
+  if (my.verbose || my.vfile != NULL) {
     int  color = (my.color == TRUE) ? __select_color(code) : -1;
-    DISPLAY (
+    writer_print(
       color, "FTP/%d %6.2f secs: %7lu bytes ==> %-6s %s",
       code, etime, bytes, url_get_method_name(U), url_get_request(U)
     );
   }
-  this->hits++;
+  if (this->counting) {
+    this->hits++;
+  }
   xfree(D);
   return TRUE;
 }
@@ -944,8 +1148,8 @@ __init_connection(BROWSER this, URL U)
   this->conn->inbuffer             = 0;
   this->conn->content.transfer     = NONE;
   this->conn->content.length       = (size_t)~0L;// VL - issue #2, 0 is a legit.value
-  this->conn->connection.keepalive = (this->conn->connection.max==1)?0:my.keepalive;
-  this->conn->connection.reuse     = (this->conn->connection.max==1)?0:my.keepalive;
+  this->conn->connection.keepalive = (this->conn->connection.max==1)?0:this->keepalive;
+  this->conn->connection.reuse     = (this->conn->connection.max==1)?0:this->keepalive;
   this->conn->connection.tested    = (this->conn->connection.tested==0)?1:this->conn->connection.tested;
   this->conn->auth.www             = this->auth.www;
   this->conn->auth.wchlg           = this->auth.wchlg;
@@ -980,7 +1184,7 @@ __init_connection(BROWSER this, URL U)
     }
   }
 
-  if (my.keepalive) {
+  if (this->keepalive) {
     this->conn->connection.reuse = TRUE;
   }
 
@@ -1020,40 +1224,13 @@ __init_connection(BROWSER this, URL U)
 private void
 __display_result(BROWSER this, RESPONSE resp, URL U, unsigned long bytes, float etime)
 {
-  char   fmtime[65];
-  #ifdef  HAVE_LOCALTIME_R
-  struct tm keepsake;
-  #endif/*HAVE_LOCALTIME_R*/
-  time_t now;
-  struct tm * tmp;
-  size_t len;
-
-
-  if (my.csv) {
-    now = time(NULL);
-    #ifdef HAVE_LOCALTIME_R
-    tmp = (struct tm *)localtime_r(&now, &keepsake);
-    #else
-    tmp = localtime(&now);
-    #endif/*HAVE_LOCALTIME_R*/
-    if (tmp) {
-      len = strftime(fmtime, 64, "%Y-%m-%d %H:%M:%S", tmp);
-      if (len == 0) {
-        memset(fmtime, '\0', 64);
-        snprintf(fmtime, 64, "n/a");
-      }
-    } else {
-      snprintf(fmtime, 64, "n/a");
-    }
-  }
-
   /**
-   * verbose output, print statistics to stdout
+   * verbose output, print statistics to stdout or --verbose-file
    */
-  if ((my.verbose && !my.get && !my.print) && (!my.debug)) {
+  if (((my.verbose || my.vfile != NULL) && !my.get && !my.print) && (!my.debug)) {
     int  color   = (my.color == TRUE) ? __select_color(response_get_code(resp)) : -1;
-    DATE date    = new_date(NULL);
-    char *stamp  = (my.timestamp)?date_stamp(date):"";
+    const char *stamp  = (my.timestamp)?writer_stamp():"";
+    const char *fmtime = (my.csv)?writer_clock():"";
     char *cached = response_get_from_cache(resp) ? "(C)":"   ";
     if (my.color && response_get_from_cache(resp) == TRUE) {
       color = GREEN;
@@ -1061,34 +1238,254 @@ __display_result(BROWSER this, RESPONSE resp, URL U, unsigned long bytes, float
 
     if (my.csv) {
       if (my.display)
-        DISPLAY(color, "%s%s%s%4d,%s,%d,%6.2f,%7lu,%s,%d,%s",
+        writer_print(color, "%s%s%s%4d,%s,%d,%6.2f,%7lu,%s,%d,%s",
         stamp, (my.mark)?my.markstr:"", (my.mark)?",":"", this->id, response_get_protocol(resp),
         response_get_code(resp), etime, bytes, url_get_display(U), url_get_ID(U), fmtime
       );
       else
-        DISPLAY(color, "%s%s%s%s,%d,%6.2f,%7lu,%s,%d,%s",
+        writer_print(color, "%s%s%s%s,%d,%6.2f,%7lu,%s,%d,%s",
           stamp, (my.mark)?my.markstr:"", (my.mark)?",":"", response_get_protocol(resp),
           response_get_code(resp), etime, bytes, url_get_display(U), url_get_ID(U), fmtime
         );
     } else {
       if (my.display)
-        DISPLAY(
+        writer_print(
           color, "%4d) %s %d %6.2f secs: %7lu bytes ==> %-4s %s",
           this->id, response_get_protocol(resp), response_get_code(resp),
           etime, bytes, url_get_method_name(U), url_get_display(U)
         );
       else
-        DISPLAY (
+        writer_print(
           color, "%s%s %d%s %5.2f secs: %7lu bytes ==> %-4s %s",
           stamp, response_get_protocol(resp), response_get_code(resp), cached,
           etime, bytes, url_get_method_name(U), url_get_display(U)
         );
     } /* else not my.csv */
-    date = date_destroy(date);
   }
   return;
 }
 
+/**
+ * A request from the loop in start or a page part; the handler
+ * gives the ones in flight a grace period at the end of a run.
+ * If it cancels us in here we're still busy: that's an abort,
+ * but we're no longer in flight.
+ * A fresh immutable GET comes from the browser cache without
+ * asking and with --edge-cache every other GET asks the edge.
+ */
+private BOOLEAN
+__transact(BROWSER this, URL U)
+{
+  BOOLEAN ret;
+
+  if (my.cache && url_get_method(U) == GET && is_immutable(this->conn->cache, U)) {
+    __from_cache(this, U);
+    return TRUE;
+  }
+  if (this->edge != NULL && url_get_method(U) == GET) {
+    if (__edge_hit(this, U)) {
+      return TRUE;
+    }
+    this->edged = TRUE;
+  }
+  this->busy = TRUE;
+  __sync_add_and_fetch(&__inflight, 1);
+  pthread_cleanup_push(__landed, NULL);
+  ret = __request(this, U);
+  pthread_cleanup_pop(1);
+  if (this->counting && timer_stopping()) {
+    timer_land();
+  }
+  this->busy  = FALSE;
+  this->edged = FALSE;
+  return ret;
+}
+
+/**
+ * The browser cache answers U; it's a cache hit rather than
+ * a transaction
+ */
+private void
+__from_cache(BROWSER this, URL U)
+{
+  RESPONSE resp = new_response();
+
+  response_set_code(resp, "HTTP/1.1 200 OK");
+  response_set_from_cache(resp, TRUE);
+  __display_result(this, resp, U, 0, 0.00);
+  resp = response_destroy(resp);
+  this->cached += (this->counting) ? 1 : 0;
+}
+
+/**
+ * Takes a request out of flight whether it finished or
+ * we were cancelled in the middle of it
+ */
+private void
+__landed(void *arg)
+{
+  (void)arg;
+  __sync_sub_and_fetch(&__inflight, 1);
+}
+
+/**
+ * The edge would have answered this one; the origin never
+ * sees the request. A page still has to load, so with the
+ * parser on we request what it parsed to when it was stored.
+ */
+private BOOLEAN
+__edge_hit(BROWSER this, URL U)
+{
+  PARTS    page = NULL;
+  RESPONSE resp;
+
+  if (! edge_lookup(this->edge, U, this->id, &page)) {
+    return FALSE;
+  }
+  resp = new_response();
+  response_set_code(resp, "HTTP/1.1 200 OK");
+  response_set_from_cache(resp, TRUE);
+  __display_result(this, resp, U, 0, 0.00);
+  resp = response_destroy(resp);
+  if (my.parser == TRUE && this->page == NULL) {
+    this->page = page;
+  } else {
+    page = parts_release(page);
+  }
+  return TRUE;
+}
+
+/**
+ * Takes requests from the log until it runs out or the run ends;
+ * each one goes out when it's due and none of them have a slot.
+ */
+private void
+__replay(BROWSER this)
+{
+  URL    U;
+  double due;
+
+  while (! timer_stopping() && (U = replay_next(this->replay, &due)) != NULL) {
+    replay_wait(this->replay, due);
+    if (timer_stopping()) {
+      url_destroy(U);
+      break;
+    }
+    this->auth.bids.www = 0;
+    this->slot          = -1;
+    this->answered      = FALSE;
+    this->counting      = timer_steady();
+    this->conn->fault   = FAULT_NONE;
+    if (__transact(this, U) == FALSE) {
+      __failure(this);
+    }
+    url_destroy(U);
+    pthread_testcancel();
+    if (my.failures > 0 && my.failed >= my.failures) {
+      break;
+    }
+  }
+}
+
+/**
+ * Loads a page from --har: its requests go out one at a time on
+ * our connection, in wave order, and the load takes from the
+ * first to the end of the last. That's a serial load; a browser
+ * would send each wave's requests together. Without the first
+ * wave, the document, there's no page to load.
+ */
+private void
+__page(BROWSER this, int page)
+{
+  int     i;
+  int     wave;
+  URL     U;
+  BOOLEAN okay = TRUE;
+  struct  timeval begin;
+  struct  timeval end;
+
+  this->counting = timer_steady();
+  gettimeofday(&begin, NULL);
+  for (i = 0; i < har_get_length(this->har, page) && ! timer_stopping(); i++) {
+    U = array_get(this->urls, har_get_entry(this->har, page, i, &wave));
+    this->auth.bids.www = 0;
+    this->slot          = url_get_ID(U);
+    this->answered      = FALSE;
+    this->conn->fault   = FAULT_NONE;
+    if (__transact(this, U) == FALSE) {
+      __failure(this);
+      okay = FALSE;
+      if (wave == 0) break;
+    }
+  }
+  gettimeofday(&end, NULL);
+  if (this->counting && ! timer_stopping()) {
+    har_record(this->har, page, (end.tv_sec - begin.tv_sec) + (end.tv_usec - begin.tv_usec) / 1000000.0, okay);
+  }
+}
+
+/**
+ * usleep may not take a second or more
+ */
+private void
+__nap(double secs)
+{
+  if (secs >= 1) {
+    pthread_sleep_np((unsigned int)secs);
+    secs -= (unsigned int)secs;
+  }
+  if (secs >= .000001) {
+    pthread_usleep_np((unsigned long)(secs * 1000000));
+  }
+}
+
+/**
+ * A user class's think time, or with a rate the wait until our
+ * next request is due. If we're behind we go now rather than let
+ * the requests bunch up.
+ */
+private void
+__think(BROWSER this)
+{
+  double now;
+  float  secs = class_think(this->uclass, this->rng);
+  struct timeval tv;
+
+  if (class_get_rate(this->uclass) <= 0) {
+    __nap(secs);
+    return;
+  }
+  gettimeofday(&tv, NULL);
+  now = tv.tv_sec + tv.tv_usec / 1000000.0;
+  if (this->due <= 0) {
+    this->due = now;
+  }
+  this->due += secs;
+  if (this->due > now) {
+    __nap(this->due - now);
+  } else {
+    this->due = now;
+  }
+}
+
+/**
+ * Each browser keeps its own marks and histogram; main merges
+ * them when the threads are done so there's nothing to lock.
+ */
+private void
+__mark(BROWSER this, float etime)
+{
+  if (! this->counting) return;
+
+  if (etime > this->himark) {
+    this->himark = etime;
+  }
+  if ((this->lomark < 0) || (etime < this->lomark)) {
+    this->lomark = etime;
+  }
+  hist_record(this->hist, etime);
+}
+
 private void
 __increment_failures()
 {
@@ -1098,6 +1495,97 @@ __increment_failures()
   pthread_testcancel();
 }
 
+/**
+ * The request failed; unless it got a response, which we've
+ * already counted by its code, we count why the connection
+ * says it failed. Outside the --warmup/--cooldown window we
+ * don't count it at all.
+ */
+private void
+__failure(BROWSER this)
+{
+  FAULT fault;
+
+  if (! this->counting) {
+    pthread_testcancel();
+    return;
+  }
+  if (! this->answered) {
+    fault = (this->conn->fault != FAULT_NONE) ? this->conn->fault : FAULT_OTHER;
+    fault_count(fault);
+    urlstats_fail(this->urlstats, this->slot, fault);
+  }
+  this->failed++;
+  __increment_failures();
+}
+
+/**
+ * The codes __http returns FALSE for. Those are failed
+ * transactions, my.failed, so they don't go in this->fail,
+ * which is for failed responses that count as transactions;
+ * an error rate adds the two and counts each one once.
+ */
+private BOOLEAN
+__refused(int code)
+{
+  return code == 403 || code == 408 || code == 418 || (code >= 500 && code <= 509);
+}
+
+private void
+__answered(BROWSER this, int code, unsigned long bytes, float etime)
+{
+  this->answered = TRUE;
+  if (! this->counting) return;
+
+  urlstats_record(this->urlstats, this->slot, code, bytes, etime);
+  fault_count(fault_from_code(code));
+}
+
+/**
+ * Parses html into parts and returns a copy of the meta
+ * refresh location if the page has one; the caller frees it.
+ */
+private char *
+__parse(ARRAY parts, URL U, char *html)
+{
+  int   i;
+  char *meta = NULL;
+
+  html_parser(parts, U, html);
+  for (i = 0; i < (int)array_length(parts); i++) {
+    URL url  = (URL)array_get(parts, i);
+    if (url_is_redirect(url)) {
+      URL tmp = (URL)array_remove(parts, i);
+      xfree(meta);
+      meta    = xstrdup(url_get_absolute(tmp));
+      tmp     = url_destroy(tmp);
+    }
+  }
+  return meta;
+}
+
+private void
+__request_part(BROWSER this, URL u)
+{
+  if (u == NULL || url_get_scheme(u) == UNSUPPORTED || timer_stopping()) {
+    return;
+  }
+  this->counting = timer_steady();
+  if (my.cache && is_cached(this->conn->cache, u)) {
+    __from_cache(this, u);
+  } else {
+    this->auth.bids.www = 0;
+    // We'll only request files on the same host as the page
+    if (! __no_follow(url_get_hostname(u))) {
+      this->answered    = FALSE;
+      this->conn->fault = FAULT_NONE;
+      if (__transact(this, u) == FALSE) {
+        __failure(this);
+      }
+    }
+  }
+}
+
 private BOOLEAN
 __no_follow(const char *hostname)
 {
@@ -24,6 +24,15 @@
 #define __BROWSER_H
 
 #include <hash.h>
+#include <pcache.h>
+#include <edge.h>
+#include <profile.h>
+#include <replay.h>
+#include <har.h>
+#include <alias.h>
+#include <class.h>
+#include <hist.h>
+#include <urlstats.h>
 #include <joedog/defs.h>
 #include <joedog/boolean.h>
 
@@ -36,6 +45,15 @@ void *   start(BROWSER this);
 char *   browser_get_uuid(BROWSER this);
 void     browser_set_urls(BROWSER this, ARRAY urls);
 void     browser_set_cookies(BROWSER this, HASH cookies);
+void     browser_set_pcache(BROWSER this, PCACHE pcache);
+void     browser_set_edge(BROWSER this, EDGE edge);
+void     browser_set_profile(BROWSER this, PROFILE profile);
+void     browser_set_replay(BROWSER this, REPLAY replay);
+void     browser_set_har(BROWSER this, HAR har);
+void     browser_set_alias(BROWSER this, ALIAS alias);
+void     browser_set_class(BROWSER this, CLASS uclass);
+CLASS    browser_get_class(BROWSER this);
+void     browser_set_urlstats(BROWSER this, URLSTATS urlstats);
 char *   browser_get_cookies(BROWSER this);
 unsigned long browser_get_hits(BROWSER this);
 unsigned long long browser_get_bytes(BROWSER this);
@@ -43,7 +61,13 @@ float    browser_get_time(BROWSER this);
 unsigned int browser_get_code(BROWSER this);
 unsigned int browser_get_okay(BROWSER this);
 unsigned int browser_get_fail(BROWSER this);
+unsigned long browser_get_failed(BROWSER this);
+unsigned int browser_get_cached(BROWSER this);
+unsigned int browser_get_aborted(BROWSER this);
+int      browser_get_inflight();
 float    browser_get_himark(BROWSER this);
 float    browser_get_lomark(BROWSER this);
+HIST     browser_get_hist(BROWSER this);
+URLSTATS browser_get_urlstats(BROWSER this);
 
 #endif/*__BROWSER_H*/
@@ -24,46 +24,72 @@
  */
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <setup.h>
 #include <util.h>
-#include <hash.h>
 #include <cache.h>
 #include <memory.h>
 #include <perl.h>
 #include <joedog/boolean.h>
 #include <joedog/defs.h>
 
-#define xfree(x) free(x)
-#define xmalloc(x) malloc(x)
-#define xstrdup(x) strdup(x)
+/**
+ * Entries are keyed by interned URL key (see url_get_key) in a
+ * table that grows with the URLs this browser has seen. The
+ * validators are DATEs, freshness is either an absolute deadline
+ * from max-age or the Expires date.
+ */
+typedef struct CENTRY_T
+{
+  int     key;
+  DATE    etag;
+  DATE    last;
+  DATE    expires;
+  time_t  fresh;
+  BOOLEAN immutable;
+  BOOLEAN revalidate;
+  struct CENTRY_T *chain;
+} CENTRY;
 
 struct CACHE_T
 {
-  HASH   cache;
-  int    hlen;
-  char * header;
+  CENTRY **table;
+  int      size;
+  int      count;
 };
 
-private const char* keys[] = { "ET_", "LM_", "EX_", NULL };
-private char * __build_key(CTYPE type, URL U);
+private CENTRY * __entry(CACHE this, URL U, BOOLEAN create);
+private void     __grow(CACHE this);
+private void     __clear(CENTRY *E);
 
 size_t CACHESIZE = sizeof(struct CACHE_T);
 
 CACHE
 new_cache()
 {
-  CACHE this   = calloc(CACHESIZE, 1);
-  this->cache  = new_hash();
-  this->header = NULL;
-  hash_set_destroyer(this->cache, (void*)date_destroy);
+  CACHE this   = xcalloc(CACHESIZE, 1);
+  this->table  = NULL;
+  this->size   = 0;
+  this->count  = 0;
   return this;
 }
 
 CACHE
 cache_destroy(CACHE this)
 {
+  int     i;
+  CENTRY *E;
+
   if (this != NULL) {
-    this->cache = hash_destroy(this->cache);
+    for (i = 0; i < this->size; i++) {
+      while ((E = this->table[i]) != NULL) {
+        this->table[i] = E->chain;
+        __clear(E);
+        xfree(E);
+      }
+    }
+    xfree(this->table);
     xfree(this);
     this        = NULL;
   }
@@ -73,99 +99,142 @@ cache_destroy(CACHE this)
 BOOLEAN
 cache_contains(CACHE this, CTYPE type, URL U)
 {
-  char   *key;
-  BOOLEAN found = FALSE;
-
   if (!my.cache) return FALSE;
 
-  key = __build_key(type, U);
-  if (key == NULL) {
-    return FALSE;
-  }
-  found = hash_contains(this->cache, key);
-
-  xfree(key);
-  return found;
+  return (cache_get(this, type, U) != NULL) ? TRUE : FALSE;
 }
 
 BOOLEAN
 is_cached(CACHE this, URL U)
 {
-  DATE  day = NULL;
-  char *key = __build_key(C_EXPIRES, U);
+  CENTRY *E = __entry(this, U, FALSE);
 
-  if (hash_contains(this->cache, key)) {
-    day = (DATE)hash_get(this->cache, key);
-    if (date_expired(day) == FALSE) {
+  if (E == NULL || E->revalidate == TRUE) {
+    return FALSE;
+  }
+  if (E->fresh > 0) {
+    return (time(NULL) < E->fresh) ? TRUE : FALSE;
+  }
+  if (E->expires != NULL) {
+    if (date_expired(E->expires) == FALSE) {
       return TRUE;
-    } else {
-      hash_remove(this->cache, key);
-      return FALSE;
-    }
+    } 
+    E->expires = date_destroy(E->expires);
+    return FALSE;
   }
   return FALSE;
 }
 
+/**
+ * TRUE while U is fresh and the origin said it won't change
+ * in that time; we don't revalidate it, not even on a page
+ * we'd otherwise ask for again. Without a lifetime immutable
+ * means nothing.
+ */
+BOOLEAN
+is_immutable(CACHE this, URL U)
+{
+  CENTRY *E = __entry(this, U, FALSE);
+
+  if (E == NULL || E->immutable == FALSE) {
+    return FALSE;
+  }
+  return is_cached(this, U);
+}
+
 void
 cache_add(CACHE this, CTYPE type, URL U, char *date)
 {
-  char *key = __build_key(type, U);
+  CENTRY *E = __entry(this, U, TRUE);
   
-  if (key == NULL) return;
-
-  if (type != C_EXPIRES && hash_contains(this->cache, key)) {
-    // NOTE: hash destroyer was set in the constructor
-    hash_remove(this->cache, key);
-  }
+  if (E == NULL) return;
 
   switch (type) {
     case C_ETAG:
-      hash_nadd(this->cache, key, new_etag(date), DATESIZE); 
+      date_destroy(E->etag);
+      E->etag = new_etag(date); 
       break; 
     case C_EXPIRES:
-      if (hash_contains(this->cache, key) == TRUE) {
-        break; 
-      }
-      hash_nadd(this->cache, key, new_date(date), DATESIZE); 
+      date_destroy(E->expires);
+      E->expires = new_date(date); 
       break;
     default:
-      hash_nadd(this->cache, key, new_date(date), DATESIZE); 
+      date_destroy(E->last);
+      E->last = new_date(date); 
       break; 
   }
-  xfree(key);
-  
   return;
 }
 
+/**
+ * Applies the response's caching policy to U once all the
+ * headers are in. no-store and Vary: * drop what we have; 
+ * max-age trumps Expires; no-cache forces revalidation.
+ */
+void
+cache_update(CACHE this, URL U, RESPONSE resp)
+{
+  int     age;
+  char   *vary;
+  CENTRY *E;
+
+  if (resp == NULL) return;
+
+  vary = response_get_vary(resp);
+  if (response_get_no_store(resp) || (vary != NULL && strchr(vary, '*') != NULL)) {
+    cache_remove(this, U);
+    return;
+  }
+  if ((E = __entry(this, U, TRUE)) == NULL) return;
+
+  E->expires    = date_destroy(E->expires);
+  E->fresh      = 0;
+  E->revalidate = response_get_no_cache(resp);
+  E->immutable  = response_get_immutable(resp);
+  if ((age = response_get_max_age(resp)) >= 0) {
+    E->fresh = time(NULL) + age;
+  } else if (response_get_expires(resp) != NULL) {
+    E->expires = new_date(response_get_expires(resp));
+  }
+  return;
+}
+
+void
+cache_remove(CACHE this, URL U)
+{
+  CENTRY *E = __entry(this, U, FALSE);
+
+  if (E != NULL) {
+    __clear(E);
+  }
+}
+
 DATE
 cache_get(CACHE this, CTYPE type, URL U)
 {
-  DATE  date;
-  char  *key = __build_key(type, U);
+  CENTRY *E = __entry(this, U, FALSE);
 
-  if (key == NULL) return NULL;
-  
-  date = (DATE)hash_get(this->cache, key);
-  xfree(key);
+  if (E == NULL) return NULL;
 
-  return date;
+  switch (type) {
+    case C_ETAG:
+      return E->etag;
+    case C_EXPIRES:
+      return E->expires;
+    default:
+      return E->last;
+  }
+  return NULL;
 }
 
 /**
- * Yeah, this function is kind of kludgy. We have to 
- * localize everything in order to fit it into our OO
- * architecture but the benefits out-weigh the negatives
- *
- * From an API perspective, we don't want to worry about
- * managing memory outside of the object.
+ * Returns a conditional request header for U which the
+ * caller must free or NULL if we don't have a validator.
  */
 char *
 cache_get_header(CACHE this, CTYPE type, URL U)
 {
   DATE  d   = NULL;
-  DATE  e   = NULL;
-  char *key = NULL;
-  char *exp = NULL;
   char *ptr = NULL;
   char  tmp[256];
 
@@ -177,68 +246,82 @@ cache_get_header(CACHE this, CTYPE type, URL U)
     return NULL;
   }
 
-  /**
-   * Check it's freshness
-   */
-  exp = __build_key(C_EXPIRES, U);
-  if (exp) {
-    e = (DATE)hash_get(this->cache, exp);
-    xfree(exp);
-    if (date_expired(e)) {
-      // remove entries
-      return NULL;
-    }
-  }
-
-  /**
-   * If we can't build a key, we better bail...
-   */
-  key = __build_key(type, U);
-  if (key == NULL) {
-    return NULL;
-  } 
-
-  /**
-   * At this point we should be able to grab
-   * a date but we'll test and bail on failure
-   */
-  d = (DATE)hash_get(this->cache, key);
-  if (d == NULL) {
-    return NULL;
-  }
+  d = cache_get(this, type, U);
 
   memset(tmp, '\0', 256);
   switch (type) {
     case C_ETAG:
-      ptr = strdup(date_get_etag(d)); // need a local copy 
-      if (empty(ptr)) return "";      // should never happen
+      ptr = date_get_etag(d);
+      if (empty(ptr)) return NULL;
       snprintf(tmp, 256, "If-None-Match: %s\015\012", ptr);
-      this->header = strdup(tmp);
-      xfree(ptr);
-      return this->header;
+      return xstrdup(tmp);
     default:
-      ptr = strdup(date_get_rfc850(d));
-      if (empty(ptr)) return "";
+      ptr = date_get_rfc850(d);
+      if (empty(ptr)) return NULL;
       snprintf(tmp, 256, "If-Modified-Since: %s\015\012", ptr);
-      this->header = strdup(tmp);
-      xfree(ptr);
-      return this->header;
+      return xstrdup(tmp);
   }
   return NULL; // Unsupported header or a WTF?
 }
 
-private char *
-__build_key(CTYPE type, URL U)
+private CENTRY *
+__entry(CACHE this, URL U, BOOLEAN create)
 {
-  int   len = 0; 
-  char *key = NULL;
+  int     key;
+  CENTRY *E;
 
-  if (U == NULL || url_get_request(U) == NULL || strlen(url_get_request(U)) < 1) {
+  if (this == NULL || (key = url_get_key(U)) < 1) {
     return NULL;
   }
-  len = strlen(url_get_request(U)) + strlen(keys[type])+1;
-  key = (char *)xmalloc(len+1);
-  memset(key, '\0', len+1);
-  snprintf(key, len, "%s%s", keys[type], url_get_request(U));
-  return key;  
+  if (this->size > 0) {
+    for (E = this->table[key & (this->size - 1)]; E != NULL; E = E->chain) {
+      if (E->key == key) return E;
+    }
+  }
+  if (create == FALSE) return NULL;
+
+  if (this->count >= this->size) {
+    __grow(this);
+  }
+  E = xcalloc(sizeof(CENTRY), 1);
+  E->key   = key;
+  E->chain = this->table[key & (this->size - 1)];
+  this->table[key & (this->size - 1)] = E;
+  this->count += 1;
+  return E;
+}
+
+/**
+ * Doubles the table and rehashes; we keep it at no
+ * more than one entry per bucket on average
+ */
+private void
+__grow(CACHE this)
+{
+  int      i;
+  int      size = (this->size < 16) ? 16 : this->size * 2;
+  CENTRY **table = xcalloc(size, sizeof(CENTRY *));
+  CENTRY  *E;
+
+  for (i = 0; i < this->size; i++) {
+    while ((E = this->table[i]) != NULL) {
+      this->table[i] = E->chain;
+      E->chain = table[E->key & (size - 1)];
+      table[E->key & (size - 1)] = E;
+    }
+  }
+  xfree(this->table);
+  this->table = table;
+  this->size  = size;
+}
+
+private void
+__clear(CENTRY *E)
+{
+  E->etag       = date_destroy(E->etag);
+  E->last       = date_destroy(E->last);
+  E->expires    = date_destroy(E->expires);
+  E->fresh      = 0;
+  E->immutable  = FALSE;
+  E->revalidate = FALSE;
 }
@@ -26,6 +26,7 @@
 #include <stdlib.h>
 #include <date.h>
 #include <url.h>
+#include <response.h>
 #include <joedog/defs.h>
 #include <joedog/boolean.h>
 
@@ -43,9 +44,12 @@ CACHE   new_cache();
 CACHE   cache_destroy(CACHE this);
 BOOLEAN cache_contains(CACHE this, CTYPE type, URL U);
 void    cache_add(CACHE this, CTYPE type, URL U, char *date);
+void    cache_update(CACHE this, URL U, RESPONSE resp);
+void    cache_remove(CACHE this, URL U);
 DATE    cache_get(CACHE this, CTYPE type, URL U);
 char *  cache_get_header(CACHE this, CTYPE type, URL U);
 BOOLEAN is_cached(CACHE this, URL U);
+BOOLEAN is_immutable(CACHE this, URL U);
 
 
 #endif/*__CACHE_H*/
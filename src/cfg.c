@@ -212,7 +212,11 @@ is_variable_line(char *line)
   /**
    * check for variable assignment; make sure that on the left side 
    * of the = is nothing but letters, numbers, and/or underscores.
+   * weight= is the prefix that weighs a URL, not a variable.
    */
+  if (strncasecmp(line, "weight=", 7) == 0) {
+    return FALSE;
+  }
   pos = strstr(line, "=");
   if (pos != NULL) {
     for (x = line; x < pos; x++) {
@@ -0,0 +1,372 @@
+/**
+ * User classes
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifdef  HAVE_CONFIG_H
+# include <config.h>
+#endif/*HAVE_CONFIG_H*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <setup.h>
+#include <class.h>
+#include <cfg.h>
+#include <url.h>
+#include <perl.h>
+#include <util.h>
+#include <memory.h>
+#include <notify.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+typedef enum {
+  THINK_UNIFORM     = 0,  /* between 0 and delay, like -d  */
+  THINK_CONSTANT    = 1,  /* delay every time              */
+  THINK_EXPONENTIAL = 2   /* delay on average, memoryless  */
+} THINK;
+
+struct CLASS_T
+{
+  char    *name;
+  char    *file;
+  int      users;
+  float    rate;      /* requests/sec between its users, 0 == off */
+  float    delay;     /* think time in secs                       */
+  THINK    think;
+  BOOLEAN  keepalive;
+  BOOLEAN  internet;
+  char    *headers;   /* "Name: value\r\n" each                   */
+  ARRAY    urls;
+  DATA     data;
+};
+
+size_t CLASSSIZE = sizeof(struct CLASS_T);
+
+private CLASS   __class(const char *name);
+private BOOLEAN __option(CLASS this, const char *option, char *value);
+private BOOLEAN __load(CLASS this, const char *path, ARRAY urls);
+private char *  __path(const char *scenario, const char *file);
+
+/**
+ * Returns an ARRAY of CLASS or NULL if the file is no good; we
+ * say why
+ */
+ARRAY
+new_classes(const char *file, ARRAY urls)
+{
+  FILE   *fp;
+  char   *line = NULL;
+  char   *option;
+  char   *value;
+  char   *path;
+  size_t  size = 0;
+  int     num  = 0;
+  int     i;
+  CLASS   C    = NULL;
+  ARRAY   this;
+
+  if ((fp = fopen(file, "r")) == NULL) {
+    NOTIFY(ERROR, "scenario: unable to open %s", file);
+    return NULL;
+  }
+
+  this = new_array();
+  while (getline(&line, &size, fp) != -1) {
+    num++;
+    option = trim(line);
+    if (*option == '#' || *option == '\0') {
+      continue;
+    }
+    if (*option == '[') {
+      option++;
+      if ((value = strchr(option, ']')) == NULL || value == option) {
+        errno = 0;
+        NOTIFY(ERROR, "scenario: %s:%d: a class is named like this: [browsers]", file, num);
+        goto error;
+      }
+      *value = '\0';
+      C = __class(option);
+      array_npush(this, C, CLASSSIZE);
+      xfree(C);
+      C = (CLASS)array_get(this, array_length(this) - 1);
+      continue;
+    }
+    value = option;
+    while (*value && !ISSPACE(*value) && !ISSEPARATOR(*value)) {
+      value++;
+    }
+    if (*value != '\0') {
+      *value++ = '\0';
+    }
+    while (ISSPACE(*value) || ISSEPARATOR(*value)) {
+      value++;
+    }
+    if (C == NULL) {
+      errno = 0;
+      NOTIFY(ERROR, "scenario: %s:%d: %s comes before the first [class]", file, num, option);
+      goto error;
+    }
+    if (__option(C, option, value) == FALSE) {
+      errno = 0;
+      NOTIFY(ERROR, "scenario: %s:%d: bad option or value: %s %s", file, num, option, value);
+      goto error;
+    }
+  }
+
+  if (array_length(this) == 0) {
+    errno = 0;
+    NOTIFY(ERROR, "scenario: %s has no [class]", file);
+    goto error;
+  }
+  for (i = 0; i < (int)array_length(this); i++) {
+    C = (CLASS)array_get(this, i);
+    if (C->file == NULL || C->users < 1) {
+      errno = 0;
+      NOTIFY(ERROR, "scenario: class %s needs a file and users", C->name);
+      goto error;
+    }
+    path = __path(file, C->file);
+    if (__load(C, path, urls) == FALSE) {
+      xfree(path);
+      goto error;
+    }
+    xfree(path);
+  }
+  xfree(line);
+  fclose(fp);
+  return this;
+
+error:
+  xfree(line);
+  fclose(fp);
+  return array_destroyer(this, (void*)class_destroy);
+}
+
+CLASS
+class_destroy(CLASS this)
+{
+  if (this != NULL) {
+    xfree(this->name);
+    xfree(this->file);
+    xfree(this->headers);
+    this->urls = array_destroy(this->urls);
+    this->data = data_destroy(this->data);
+    xfree(this);
+  }
+  return NULL;
+}
+
+char *
+class_get_name(CLASS this)
+{
+  return this->name;
+}
+
+int
+class_get_users(CLASS this)
+{
+  return this->users;
+}
+
+ARRAY
+class_get_urls(CLASS this)
+{
+  return this->urls;
+}
+
+float
+class_get_rate(CLASS this)
+{
+  return this->rate;
+}
+
+BOOLEAN
+class_get_keepalive(CLASS this)
+{
+  return this->keepalive;
+}
+
+BOOLEAN
+class_get_internet(CLASS this)
+{
+  return this->internet;
+}
+
+DATA
+class_get_data(CLASS this)
+{
+  return this->data;
+}
+
+/**
+ * Secs a user waits before its next request. With a rate it's the
+ * time between one user's requests, exponential so that all of
+ * them together arrive like a Poisson process; otherwise it's the
+ * think time after a response.
+ */
+float
+class_think(CLASS this, unsigned long long *rng)
+{
+  double u = xoshiro_double(rng);
+
+  if (this->rate > 0) {
+    return (float)(-log(1.0 - u) * this->users / this->rate);
+  }
+  switch (this->think) {
+    case THINK_CONSTANT:
+      return this->delay;
+    case THINK_EXPONENTIAL:
+      return (float)(-log(1.0 - u) * this->delay);
+    default:
+      return (float)(u * this->delay);
+  }
+}
+
+/**
+ * A class starts out with the settings of the run
+ */
+private CLASS
+__class(const char *name)
+{
+  CLASS this = xcalloc(sizeof(struct CLASS_T), 1);
+
+  this->name      = xstrdup(name);
+  this->file      = NULL;
+  this->users     = 0;
+  this->rate      = 0.0;
+  this->delay     = my.delay;
+  this->think     = THINK_UNIFORM;
+  this->keepalive = my.keepalive;
+  this->internet  = my.internet;
+  this->headers   = xstrdup("");
+  this->urls      = new_array();
+  this->data      = new_data();
+  return this;
+}
+
+private BOOLEAN
+__option(CLASS this, const char *option, char *value)
+{
+  size_t len;
+
+  if (strmatch(option, "file") && strlen(value) > 0) {
+    xfree(this->file);
+    this->file = xstrdup(value);
+  } else if (strmatch(option, "users") || strmatch(option, "concurrent")) {
+    this->users = atoi(value);
+  } else if (strmatch(option, "rate")) {
+    this->rate = atof(value);
+    return (this->rate >= 0) ? TRUE : FALSE;
+  } else if (strmatch(option, "delay")) {
+    this->delay = atof(value);
+    return (this->delay >= 0) ? TRUE : FALSE;
+  } else if (strmatch(option, "think")) {
+    if (strmatch(value, "uniform")) {
+      this->think = THINK_UNIFORM;
+    } else if (strmatch(value, "constant")) {
+      this->think = THINK_CONSTANT;
+    } else if (strmatch(value, "exponential")) {
+      this->think = THINK_EXPONENTIAL;
+    } else {
+      return FALSE;
+    }
+  } else if (strmatch(option, "connection") || strmatch(option, "keepalive")) {
+    this->keepalive = (strmatch(value, "keep-alive") || strmatch(value, "true")) ? TRUE : FALSE;
+  } else if (strmatch(option, "internet")) {
+    this->internet = strmatch(value, "true") ? TRUE : FALSE;
+  } else if (strmatch(option, "header")) {
+    if (strchr(value, ':') == NULL) {
+      return FALSE;
+    }
+    len = strlen(this->headers) + strlen(value) + 3;
+    this->headers = xrealloc(this->headers, len);
+    strcat(this->headers, value);
+    strcat(this->headers, "\015\012");
+  } else {
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/**
+ * Reads the class's URLs file like -f; its URLs go on the run's
+ * array and a copy of each on our own, both with our headers.
+ */
+private BOOLEAN
+__load(CLASS this, const char *path, ARRAY urls)
+{
+  int    i;
+  LINES *lines;
+
+  if (access(path, R_OK) != 0) {
+    NOTIFY(ERROR, "scenario: class %s: unable to open %s", this->name, path);
+    return FALSE;
+  }
+  lines = xcalloc(1, sizeof(LINES));
+  lines->index = 0;
+  lines->line  = NULL;
+  read_cfg_file(lines, (char*)path);
+
+  for (i = 0; i < lines->index; i++) {
+    URL tmp = new_url(lines->line[i]);
+    if (tmp != NULL) {
+      url_set_ID(tmp, array_length(urls));
+      if (strlen(this->headers) > 0) {
+        url_set_headers(tmp, this->headers);
+      }
+      array_npush(urls, tmp, URLSIZE);
+      array_npush(this->urls, array_get(urls, array_length(urls) - 1), URLSIZE);
+      xfree(tmp);
+    }
+    xfree(lines->line[i]);
+  }
+  xfree(lines->line);
+  xfree(lines);
+
+  if (array_length(this->urls) == 0) {
+    errno = 0;
+    NOTIFY(ERROR, "scenario: class %s: no URLs in %s", this->name, path);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/**
+ * A file named in a scenario is relative to the scenario
+ */
+private char *
+__path(const char *scenario, const char *file)
+{
+  char  *path;
+  char  *end;
+  size_t len;
+
+  if (file[0] == '/' || (end = strrchr(scenario, '/')) == NULL) {
+    return xstrdup(file);
+  }
+  len  = (end - scenario) + strlen(file) + 2;
+  path = xmalloc(len);
+  snprintf(path, len, "%.*s/%s", (int)(end - scenario), scenario, file);
+  return path;
+}
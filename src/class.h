@@ -0,0 +1,53 @@
+/**
+ * User classes
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifndef __CLASS_H
+#define __CLASS_H
+
+#include <stdlib.h>
+#include <array.h>
+#include <data.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+/**
+ * The user classes in a --scenario file. Each one is a group of
+ * users with its own URLs file, head count, think time or arrival
+ * rate, keep-alive and headers, and its own DATA for the summary.
+ * The classes' URLs are appended to the URL array and each class
+ * keeps a list of its own.
+ */
+typedef struct CLASS_T *CLASS;
+extern size_t CLASSSIZE;
+
+ARRAY    new_classes(const char *file, ARRAY urls);
+CLASS    class_destroy(CLASS this);
+char *   class_get_name(CLASS this);
+int      class_get_users(CLASS this);
+ARRAY    class_get_urls(CLASS this);
+float    class_get_rate(CLASS this);
+BOOLEAN  class_get_keepalive(CLASS this);
+BOOLEAN  class_get_internet(CLASS this);
+DATA     class_get_data(CLASS this);
+float    class_think(CLASS this, unsigned long long *rng);
+
+#endif/*__CLASS_H*/
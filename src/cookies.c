@@ -193,11 +193,11 @@ cookies_header(FACTS facts, URL url, char *buf)
   NODE    *next;
   char    *host = url_get_hostname(url);
   COOKIES this  = facts->jar;
-  char    oreo[MAX_COOKIES_SIZE];
-  char    seen[MAX_COOKIES_SIZE]; // store as ;name;name; format
+  char    *oreo;  // heap, not stack; browsers may run on small stacks
+  char    *seen;  // store as ;name;name; format
 
-  memset(oreo, 0, sizeof oreo);
-  memset(seen, 0, sizeof seen);
+  oreo = xcalloc(MAX_COOKIES_SIZE, 1);
+  seen = xcalloc(MAX_COOKIES_SIZE, 1);
 
   time_t now = time(NULL);
 
@@ -229,16 +229,16 @@ cookies_header(FACTS facts, URL url, char *buf)
     }
 
     /* Mark as seen */
-    xstrncat(seen, needle, sizeof(seen) - strlen(seen) - 1);
+    xstrncat(seen, needle, MAX_COOKIES_SIZE - strlen(seen) - 1);
 
     /* Append to Cookie header string */
     if (strlen(oreo) > 0) {
-      xstrncat(oreo, "; ", sizeof(oreo) - strlen(oreo) - 1);
+      xstrncat(oreo, "; ", MAX_COOKIES_SIZE - strlen(oreo) - 1);
     }
 
-    xstrncat(oreo, name,  sizeof(oreo) - strlen(oreo) - 1);
-    xstrncat(oreo, "=",   sizeof(oreo) - strlen(oreo) - 1);
-    xstrncat(oreo, value, sizeof(oreo) - strlen(oreo) - 1);
+    xstrncat(oreo, name,  MAX_COOKIES_SIZE - strlen(oreo) - 1);
+    xstrncat(oreo, "=",   MAX_COOKIES_SIZE - strlen(oreo) - 1);
+    xstrncat(oreo, value, MAX_COOKIES_SIZE - strlen(oreo) - 1);
   }
 
   if (strlen(oreo) > 0) {
@@ -248,7 +248,8 @@ cookies_header(FACTS facts, URL url, char *buf)
     xstrncat(buf, oreo, MAX_COOKIE_SIZE - strlen(buf) - 1);
     xstrncat(buf, "\r\n", MAX_COOKIE_SIZE - strlen(buf) - 1);
   }
-  
+  xfree(oreo);
+  xfree(seen);
   return buf;
 }
 
@@ -0,0 +1,426 @@
+/**
+ * CPU placement and utilization
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifdef  HAVE_CONFIG_H
+# include <config.h>
+#endif/*HAVE_CONFIG_H*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <cpu.h>
+#include <util.h>
+#include <notify.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+#ifdef  HAVE_SCHED_H
+# include <sched.h>
+#endif/*HAVE_SCHED_H*/
+
+#ifdef  HAVE_UNISTD_H
+# include <unistd.h>
+#endif/*HAVE_UNISTD_H*/
+
+#ifdef  __linux__
+# include <sys/syscall.h>
+#endif/*__linux__*/
+
+#ifndef MPOL_INTERLEAVE
+# define MPOL_INTERLEAVE 3
+#endif/*MPOL_INTERLEAVE*/
+#ifndef MPOL_LOCAL
+# define MPOL_LOCAL      4
+#endif/*MPOL_LOCAL*/
+
+#define MAX_CPUS   1024
+#define MAX_NODES  1024
+
+typedef struct
+{
+  BOOLEAN            seen;
+  unsigned long long busy;
+  unsigned long long total;
+} TICKS;
+
+private const char *__numanames[] = { "none", "local", "interleave", NULL };
+
+private int            __cpus[MAX_CPUS];
+private int            __ncpus    = 0;
+private int            __base     = 0;
+private NUMA           __numa     = NUMA_NONE;
+private unsigned long  __nodes[MAX_NODES / (8 * sizeof(unsigned long))];
+private pthread_once_t __once     = PTHREAD_ONCE_INIT;
+private unsigned int   __warned   = 0;
+private TICKS          __first[MAX_CPUS];
+private TICKS          __last[MAX_CPUS];
+private int            __samples  = 0;
+
+private void    __nodemask();
+private int     __node(int cpu);
+private BOOLEAN __allowed(int cpu);
+private void    __policy();
+private void    __read_stat(TICKS *ticks);
+
+/**
+ * Parses a CPU list like the kernel's: "0-31", "2,4,6-11". We
+ * refuse CPUs that aren't online or that we're not allowed to
+ * run on (taskset, cgroups) rather than let the threads pile
+ * onto whatever is left.
+ */
+BOOLEAN
+cpu_set_list(const char *spec)
+{
+  int   i;
+  int   lo;
+  int   hi;
+  char *end;
+  const char *ptr = spec;
+  BOOLEAN set[MAX_CPUS];
+
+  memset(set, '\0', sizeof(set));
+  while (ptr != NULL && *ptr != '\0') {
+    while (isspace((unsigned char)*ptr) || *ptr == ',') ptr++;
+    if (*ptr == '\0') break;
+    lo = hi = (int)strtol(ptr, &end, 10);
+    if (end == ptr) {
+      NOTIFY(ERROR, "cpus: unable to parse '%s'", spec);
+      return FALSE;
+    }
+    ptr = end;
+    if (*ptr == '-') {
+      hi  = (int)strtol(ptr+1, &end, 10);
+      if (end == ptr+1) {
+        NOTIFY(ERROR, "cpus: unable to parse '%s'", spec);
+        return FALSE;
+      }
+      ptr = end;
+    }
+    if (lo < 0 || hi >= MAX_CPUS || lo > hi) {
+      NOTIFY(ERROR, "cpus: invalid range %d-%d", lo, hi);
+      return FALSE;
+    }
+    for (i = lo; i <= hi; i++) {
+      if (! __allowed(i)) {
+        NOTIFY(ERROR, "cpus: CPU %d is offline or outside our affinity mask", i);
+        return FALSE;
+      }
+      set[i] = TRUE;
+    }
+    while (isspace((unsigned char)*ptr)) ptr++;
+    if (*ptr != '\0' && *ptr != ',') {
+      NOTIFY(ERROR, "cpus: unable to parse '%s'", spec);
+      return FALSE;
+    }
+  }
+
+  for (i = 0, __ncpus = 0; i < MAX_CPUS; i++) {
+    if (set[i]) __cpus[__ncpus++] = i;
+  }
+  return TRUE;
+}
+
+BOOLEAN
+cpu_set_numa(const char *mode)
+{
+  int i;
+
+  for (i = 0; __numanames[i] != NULL; i++) {
+    if (strmatch(mode, __numanames[i])) {
+      __numa = (NUMA)i;
+      return TRUE;
+    }
+  }
+  NOTIFY(ERROR, "numa: unknown policy '%s'; try local or interleave", mode);
+  return FALSE;
+}
+
+/**
+ * Writes the CPU set back out in ranges; NULL if we
+ * aren't pinning.
+ */
+char *
+cpu_get_list(char *buf, size_t len)
+{
+  int    i;
+  int    j;
+  size_t n = 0;
+
+  if (__ncpus == 0 || len == 0) return NULL;
+
+  buf[0] = '\0';
+  for (i = 0; i < __ncpus && n < len; i = j + 1) {
+    for (j = i; j + 1 < __ncpus && __cpus[j+1] == __cpus[j] + 1; j++) ;
+    if (j == i) {
+      n += snprintf(buf+n, len-n, "%s%d", (i > 0) ? "," : "", __cpus[i]);
+    } else {
+      n += snprintf(buf+n, len-n, "%s%d-%d", (i > 0) ? "," : "", __cpus[i], __cpus[j]);
+    }
+  }
+  return buf;
+}
+
+char *
+cpu_get_numa()
+{
+  return (char *)__numanames[__numa];
+}
+
+BOOLEAN
+cpu_configured()
+{
+  return (__ncpus > 0 || __numa != NUMA_NONE) ? TRUE : FALSE;
+}
+
+/**
+ * Called by each crew thread before it takes any work. index
+ * is the thread's number; thread n runs on the n-th CPU of the
+ * set, wrapping around.
+ */
+void
+cpu_bind(int index)
+{
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) && defined(CPU_SET)
+  int       res;
+  cpu_set_t set;
+
+  if (__ncpus > 0) {
+    CPU_ZERO(&set);
+    CPU_SET(__cpus[(__base + index) % __ncpus], &set);
+    if ((res = pthread_setaffinity_np(pthread_self(), sizeof(set), &set)) != 0) {
+      if ((__sync_fetch_and_or(&__warned, 1) & 1) == 0) {
+        NOTIFY(WARNING, "cpus: unable to pin threads: %s", strerror(res));
+      }
+    }
+  }
+#else
+  if (__ncpus > 0 && (__sync_fetch_and_or(&__warned, 1) & 1) == 0) {
+    NOTIFY(WARNING, "cpus: thread affinity is not supported on this platform");
+  }
+#endif/*HAVE_PTHREAD_SETAFFINITY_NP*/
+  __policy();
+}
+
+/**
+ * A worker process runs users base and up; its threads take
+ * the CPUs those users would have had in a single process.
+ */
+void
+cpu_set_base(int base)
+{
+  __base = (base < 0) ? 0 : base;
+}
+
+/**
+ * Takes a snapshot of /proc/stat. The first call marks the
+ * start of the run, every call after that moves the end.
+ */
+void
+cpu_sample()
+{
+  __read_stat((__samples == 0) ? __first : __last);
+  __samples += 1;
+}
+
+/**
+ * The number of cores we can report on: the pinned set or,
+ * if we're not pinning, every core in /proc/stat
+ */
+int
+cpu_get_cores()
+{
+  int i;
+  int n = 0;
+
+  if (__samples < 2) return 0;
+  if (__ncpus > 0)   return __ncpus;
+
+  for (i = 0; i < MAX_CPUS; i++) {
+    if (__first[i].seen && __last[i].seen) n++;
+  }
+  return n;
+}
+
+/**
+ * Returns the busy percentage of the index-th reported core
+ * between the first and last samples; its number goes in cpu
+ */
+double
+cpu_get_usage(int index, int *cpu)
+{
+  int i;
+  int n = -1;
+  unsigned long long busy;
+  unsigned long long total;
+
+  if (__ncpus > 0) {
+    n = (index < __ncpus) ? __cpus[index] : -1;
+  } else {
+    for (i = 0; i < MAX_CPUS; i++) {
+      if (__first[i].seen && __last[i].seen && index-- == 0) {
+        n = i;
+        break;
+      }
+    }
+  }
+  if (cpu != NULL) *cpu = n;
+  if (n < 0 || !__first[n].seen || !__last[n].seen) return 0.0;
+
+  busy  = __last[n].busy  - __first[n].busy;
+  total = __last[n].total - __first[n].total;
+  return (total == 0) ? 0.0 : (double)busy / total * 100.0;
+}
+
+private BOOLEAN
+__allowed(int cpu)
+{
+#if defined(CPU_ISSET) && defined(__linux__)
+  cpu_set_t set;
+
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    return (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &set)) ? TRUE : FALSE;
+  }
+#endif/*CPU_ISSET*/
+#if defined(_SC_NPROCESSORS_ONLN)
+  return (cpu < sysconf(_SC_NPROCESSORS_ONLN)) ? TRUE : FALSE;
+#else
+  return TRUE;
+#endif
+}
+
+/**
+ * Sets the calling thread's memory policy. local is what the
+ * kernel does by default but a parent started under numactl
+ * may have handed us something else.
+ */
+private void
+__policy()
+{
+#if defined(SYS_set_mempolicy)
+  long res = 0;
+
+  switch (__numa) {
+    case NUMA_LOCAL:
+      res = syscall(SYS_set_mempolicy, MPOL_LOCAL, NULL, 0);
+      break;
+    case NUMA_INTERLEAVE:
+      pthread_once(&__once, __nodemask);
+      res = syscall(SYS_set_mempolicy, MPOL_INTERLEAVE, __nodes, MAX_NODES + 1);
+      break;
+    default:
+      return;
+  }
+  if (res < 0 && (__sync_fetch_and_or(&__warned, 2) & 2) == 0) {
+    NOTIFY(WARNING, "numa: unable to set the %s policy: %s", __numanames[__numa], strerror(errno));
+  }
+#else
+  if (__numa != NUMA_NONE && (__sync_fetch_and_or(&__warned, 2) & 2) == 0) {
+    NOTIFY(WARNING, "numa: memory policies are not supported on this platform");
+  }
+#endif/*SYS_set_mempolicy*/
+}
+
+/**
+ * Interleave across the nodes that own our CPUs; if we're not
+ * pinned, across every node with a CPU we're allowed to use.
+ */
+private void
+__nodemask()
+{
+  int i;
+  int node;
+  int bits = 8 * sizeof(unsigned long);
+
+  memset(__nodes, '\0', sizeof(__nodes));
+  for (i = 0; i < ((__ncpus > 0) ? __ncpus : MAX_CPUS); i++) {
+    int cpu = (__ncpus > 0) ? __cpus[i] : i;
+    if (__ncpus == 0 && ! __allowed(cpu)) continue;
+    if ((node = __node(cpu)) >= 0 && node < MAX_NODES) {
+      __nodes[node / bits] |= 1UL << (node % bits);
+    }
+  }
+  if (__nodes[0] == 0) {
+    __nodes[0] = 1; /* no sysfs; node 0 is always there */
+  }
+}
+
+/**
+ * sysfs links each CPU to its node: /sys/devices/system/cpu/cpuN/nodeM
+ */
+private int
+__node(int cpu)
+{
+  int   node = -1;
+  char  path[64];
+  DIR  *dir;
+  struct dirent *ent;
+
+  snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+  if ((dir = opendir(path)) == NULL) {
+    return -1;
+  }
+  while ((ent = readdir(dir)) != NULL) {
+    if (strncmp(ent->d_name, "node", 4) == 0 && isdigit((unsigned char)ent->d_name[4])) {
+      node = atoi(ent->d_name + 4);
+      break;
+    }
+  }
+  closedir(dir);
+  return node;
+}
+
+/**
+ * cpuN user nice system idle iowait irq softirq steal ...
+ * Guest time is already in user so we stop at steal.
+ */
+private void
+__read_stat(TICKS *ticks)
+{
+  int   cpu;
+  FILE *fp;
+  char  line[512];
+  unsigned long long v[8];
+
+  memset(ticks, '\0', sizeof(TICKS) * MAX_CPUS);
+  if ((fp = fopen("/proc/stat", "r")) == NULL) {
+    return;
+  }
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    if (strncmp(line, "cpu", 3) != 0 || !isdigit((unsigned char)line[3])) {
+      continue;
+    }
+    memset(v, '\0', sizeof(v));
+    if (sscanf(line+3, "%d %llu %llu %llu %llu %llu %llu %llu %llu",
+        &cpu, &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]) < 5) {
+      continue;
+    }
+    if (cpu < 0 || cpu >= MAX_CPUS) continue;
+    ticks[cpu].seen  = TRUE;
+    ticks[cpu].total = v[0]+v[1]+v[2]+v[3]+v[4]+v[5]+v[6]+v[7];
+    ticks[cpu].busy  = ticks[cpu].total - v[3] - v[4];
+  }
+  fclose(fp);
+}
@@ -0,0 +1,56 @@
+/**
+ * CPU placement and utilization
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifndef __CPU_H
+#define __CPU_H
+
+#include <stdlib.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+/**
+ * Pins the browser threads to a set of CPUs (--cpus) and sets
+ * their NUMA memory policy (--numa). Each thread takes the next
+ * CPU in the set, round robin, and sets its policy before it
+ * allocates its connection so its buffers land on its node.
+ * We also sample /proc/stat at the start and end of the run
+ * so the summary can show how busy each of those cores was.
+ */
+typedef enum
+{
+  NUMA_NONE       = 0,
+  NUMA_LOCAL      = 1,
+  NUMA_INTERLEAVE = 2
+} NUMA;
+
+BOOLEAN cpu_set_list(const char *spec);
+BOOLEAN cpu_set_numa(const char *mode);
+char *  cpu_get_list(char *buf, size_t len);
+char *  cpu_get_numa();
+BOOLEAN cpu_configured();
+void    cpu_bind(int index);
+void    cpu_set_base(int base);
+void    cpu_sample();
+int     cpu_get_cores();
+double  cpu_get_usage(int index, int *cpu);
+
+#endif/*__CPU_H*/
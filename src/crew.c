@@ -23,6 +23,7 @@
 #include <setup.h>
 #include <pthread.h>
 #include <crew.h>
+#include <cpu.h>
 #include <memory.h>
 #include <notify.h>
 #include <joedog/defs.h>
@@ -30,12 +31,23 @@
 
 private void *crew_thread(void *);
 
+/**
+ * What each thread is up to; crew_cancel only cancels the busy
+ * ones, a thread that's done may already have been joined.
+ */
+#define CREW_IDLE  0
+#define CREW_BUSY  1
+#define CREW_DONE  2
+
 struct CREW_T
 {
   int              size;
   int              maxsize;
   int              cursize;
   int              total;
+  int              started;
+  int              active;
+  int              *state;
   WORK             *head;
   WORK             *tail;
   BOOLEAN          block;
@@ -49,22 +61,27 @@ struct CREW_T
 };
 
 CREW
-new_crew(int size, int maxsize, BOOLEAN block)
+new_crew(int size, int maxsize, BOOLEAN block, size_t stack)
 {
   int    x;
   int    c;
   CREW this;
+  pthread_attr_t attr;
   
   if ((this = calloc(sizeof(*this),1)) == NULL)
     return NULL;
   
   if ((this->threads = (pthread_t *)malloc(sizeof(pthread_t)*size)) == NULL)
     return NULL;
+  if ((this->state = (int *)calloc(sizeof(int), size)) == NULL)
+    return NULL;
 
   this->size     = size;
   this->maxsize  = maxsize;
   this->cursize  = 0;
   this->total    = 0;
+  this->started  = 0;
+  this->active   = 0;
   this->block    = block;
   this->head     = NULL; 
   this->tail     = NULL;
@@ -80,9 +97,25 @@ new_crew(int size, int maxsize, BOOLEAN block)
   if ((c = pthread_cond_init(&(this->empty), NULL)) != 0)
     return NULL;
 
+  /**
+   * A browser needs far less than the default 8MB stack; at a
+   * few thousand users that default is what runs us out of room
+   */
+  pthread_attr_init(&attr);
+  if (stack > 0 && (c = pthread_attr_setstacksize(&attr, stack)) != 0) {
+    NOTIFY(WARNING, "unable to set a %lu KB thread stack; using the default", (unsigned long)(stack/1024));
+  }
+
+  /**
+   * The threads wait on the lock until we've filled in
+   * this->threads; they look themselves up in it.
+   */
+  pthread_mutex_lock(&(this->lock));
   for (x = 0; x != size; x++) {
-    if ((c = pthread_create(&(this->threads[x]), NULL, crew_thread, (void *)this)) != 0) {
-      switch (errno) {
+    if ((c = pthread_create(&(this->threads[x]), &attr, crew_thread, (void *)this)) != 0) {
+      pthread_attr_destroy(&attr);
+      pthread_mutex_unlock(&(this->lock));
+      switch (c) {
         case EINVAL: { NOTIFY(ERROR, "Error creating additional threads %s:%d",     __FILE__, __LINE__);  break; }
         case EPERM:  { NOTIFY(ERROR, "Inadequate permission to create pool %s:%d",  __FILE__, __LINE__);  break; }
         case EAGAIN: { NOTIFY(ERROR, "Inadequate resources to create pool %s:%d",   __FILE__, __LINE__);  break; }
@@ -91,6 +124,8 @@ new_crew(int size, int maxsize, BOOLEAN block)
       } return NULL;
     } 
   }
+  pthread_attr_destroy(&attr);
+  pthread_mutex_unlock(&(this->lock));
   return this;
 }
 
@@ -98,9 +133,20 @@ private void
 *crew_thread(void *crew)
 {
   int  c;
+  int  me;
   WORK *workptr;
   CREW this = (CREW)crew;
 
+  /**
+   * Pin and set the memory policy before we take any work;
+   * the browser allocates its connection in this thread.
+   */
+  cpu_bind(__sync_fetch_and_add(&this->started, 1));
+
+  pthread_mutex_lock(&(this->lock));
+  for (me = 0; me < this->size && ! pthread_equal(this->threads[me], pthread_self()); me++) ;
+  pthread_mutex_unlock(&(this->lock));
+
   while (TRUE) {
     if ((c = pthread_mutex_lock(&(this->lock))) != 0) {
       NOTIFY(FATAL, "mutex lock"); 
@@ -111,12 +157,15 @@ private void
     }
 
     if (this->shutdown == TRUE) {
+      this->state[me] = CREW_DONE;
       if ((c = pthread_mutex_unlock(&(this->lock))) != 0) {
         NOTIFY(FATAL, "mutex unlock");
       }
       pthread_exit(NULL);
     }
     workptr = this->head;
+    this->state[me] = CREW_BUSY;
+    this->active++;
 
     this->cursize--;
     if (this->cursize == 0) {
@@ -141,6 +190,12 @@ private void
     (*(workptr->routine))(workptr->arg);
 
     xfree(workptr);
+    pthread_mutex_lock(&(this->lock));
+    if (this->state[me] == CREW_BUSY) {
+      this->state[me] = CREW_IDLE;
+    }
+    this->active--;
+    pthread_mutex_unlock(&(this->lock));
   }
  
   return(NULL);
@@ -199,6 +254,11 @@ crew_add(CREW crew, void (*routine)(void *), void *arg)
   return TRUE;
 }
 
+/**
+ * Idle threads see the shutdown and leave on their own; we
+ * cancel the ones still running a routine, once each. The
+ * ones that are done may have been joined, so we leave them.
+ */
 BOOLEAN
 crew_cancel(CREW this)
 {
@@ -211,13 +271,17 @@ crew_cancel(CREW this)
   size = this->size;
 
   crew_set_shutdown(this, TRUE);
+  pthread_mutex_lock(&this->lock);
   for (x = 0; x < size; x++) {
+    if (this->state[x] != CREW_BUSY) continue;
 #if defined(hpux) || defined(__hpux)
     pthread_kill(this->threads[x], SIGUSR1); 
 #else
     pthread_cancel(this->threads[x]); 
 #endif
+    this->state[x] = CREW_DONE;
   }
+  pthread_mutex_unlock(&this->lock);
   return TRUE;
 }
 
@@ -288,6 +352,7 @@ void crew_destroy(CREW crew) {
   WORK  *workptr;
 
   xfree(crew->threads);
+  xfree(crew->state);
   while (crew->head != NULL) {
     workptr  = crew->head; 
     crew->head = crew->head->next;
@@ -338,6 +403,20 @@ crew_get_total(CREW this)
   return this->total;
 }
 
+/**
+ * The number of threads running a routine right now
+ */
+public int
+crew_get_active(CREW this)
+{
+  int active;
+
+  pthread_mutex_lock(&this->lock);
+  active = this->active;
+  pthread_mutex_unlock(&this->lock);
+  return active;
+}
+
 public BOOLEAN 
 crew_get_shutdown(CREW this)
 {
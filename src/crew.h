@@ -35,7 +35,7 @@ typedef struct work
 
 typedef struct CREW_T *CREW;
 
-CREW    new_crew(int size, int maxsize, BOOLEAN block);
+CREW    new_crew(int size, int maxsize, BOOLEAN block, size_t stack);
 BOOLEAN crew_add(CREW this, void (*routine)(void *), void *arg); 
 BOOLEAN crew_cancel(CREW this);
 BOOLEAN crew_join(CREW this, BOOLEAN finish, void **payload);
@@ -45,6 +45,7 @@ void    crew_set_shutdown(CREW this, BOOLEAN shutdown);
 
 int     crew_get_size(CREW this);
 int     crew_get_total(CREW this);
+int     crew_get_active(CREW this);
 BOOLEAN crew_get_shutdown(CREW this);
 
 #endif/*__CREW_H*/
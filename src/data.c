@@ -25,6 +25,7 @@
 #endif/*HAVE_CONFIG_H*/
 
 #include <data.h>
+#include <hist.h>
 #include <memory.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -48,6 +49,8 @@ struct DATA_T
   float    lowest;
   float    highest;
   float    elapsed;
+  float    begin;   /* the window we count in, secs from start */
+  float    end;     /* 0 if it runs to stop */
   clock_t  start;   
   clock_t  stop;      
   struct   tms  t_start; 
@@ -56,9 +59,12 @@ struct DATA_T
   unsigned int  count;
   unsigned int  okay;
   unsigned int  fail;
+  unsigned int  cached;
+  unsigned int  aborted;
   unsigned long long bytes;
   size_t   len;
   char     *cookies;
+  HIST     hist;
 };
 
 DATA
@@ -72,6 +78,7 @@ new_data()
   this->count      = 0.0;
   this->okay       = 0;
   this->fail       = 0.0;
+  this->cached     = 0;
   this->lowest     =  -1;
   this->highest    = 0.0;
   this->elapsed    = 0.0;
@@ -79,12 +86,16 @@ new_data()
   this->len        = 8096;
   this->cookies    = xmalloc(this->len);
   this->cookies[0] = '\0';
+  this->hist       = new_hist();
   return this;
 }
 
 DATA
 data_destroy(DATA this)
 {
+  if (this == NULL) return NULL;
+  this->hist = hist_destroy(this->hist);
+  xfree(this->cookies);
   xfree(this);
   return NULL;
 } 
@@ -131,6 +142,20 @@ data_increment_okay(DATA this, int okay)
   return;
 }
 
+void
+data_increment_cached(DATA this, int cached)
+{
+  this->cached += cached;
+  return;
+}
+
+void
+data_increment_aborted(DATA this, int aborted)
+{
+  this->aborted += aborted;
+  return;
+}
+
 void
 data_set_start(DATA this)
 {
@@ -145,6 +170,18 @@ data_set_stop(DATA this)
   return;
 }
 
+/**
+ * With --warmup and --cooldown only part of the run counts;
+ * elapsed is the part between begin and end (0 for the end).
+ */
+void
+data_set_window(DATA this, float begin, float end)
+{
+  this->begin = begin;
+  this->end   = end;
+  return;
+}
+
 void
 data_set_highest(DATA this, float highest)
 {
@@ -157,7 +194,10 @@ data_set_highest(DATA this, float highest)
 void
 data_set_lowest(DATA this, float lowest)
 {
-  if((this->lowest <= 0)||(this->lowest > lowest)){
+  if (lowest < 0) {
+    return; /* it never ran */
+  }
+  if((this->lowest < 0)||(this->lowest > lowest)){
     this->lowest = lowest;
   }
   return;
@@ -187,6 +227,12 @@ data_increment_cookies(DATA this, const char *str)
   //strcat(this->cookies, "\n");
 }
 
+void
+data_increment_hist(DATA this, HIST hist)
+{
+  hist_merge(this->hist, hist);
+}
+
 unsigned int
 data_get_count(DATA this)
 {
@@ -211,16 +257,28 @@ data_get_okay(DATA this)
   return this->okay;
 }
 
+unsigned int
+data_get_aborted(DATA this)
+{
+  return this->aborted;
+}
+
+unsigned int
+data_get_cached(DATA this)
+{
+  return this->cached;
+}
+
 float
 data_get_total(DATA this)
 {
   return this->total;
 }
 
-float
+unsigned long long
 data_get_bytes(DATA this)
 {
-  return (float)this->bytes;
+  return this->bytes;
 }
 
 float
@@ -254,6 +312,13 @@ data_get_elapsed(DATA this)
   time = this->stop - this->start;
   tps  = sysconf(_SC_CLK_TCK);
   this->elapsed = (float)time/tps;
+  if (this->end > 0 && this->elapsed > this->end) {
+    this->elapsed = this->end;
+  }
+  this->elapsed -= this->begin;
+  if (this->elapsed < 0) {
+    this->elapsed = 0.0;
+  }
   return this->elapsed;
 }
 
@@ -303,3 +368,18 @@ data_get_cookies(DATA this)
   return this->cookies;
 }
 
+HIST
+data_get_hist(DATA this)
+{
+  return this->hist;
+}
+
+/**
+ * Response time at percentile pct (0-100) in seconds
+ */
+float
+data_get_percentile(DATA this, float pct)
+{
+  return hist_get_percentile(this->hist, pct);
+}
+
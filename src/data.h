@@ -31,6 +31,7 @@
 #endif/*HAVE_SYS_TIMES_H*/
 
 #include <time.h>
+#include <hist.h>
 
 #ifdef HAVE_SYS_TIME_H
 # include <sys/time.h>
@@ -45,6 +46,7 @@ DATA  data_destroy(DATA this);
 /* setters */
 void  data_set_start        (DATA this);
 void  data_set_stop         (DATA this);
+void  data_set_window       (DATA this, float begin, float end);
 void  data_set_highest      (DATA this, float highest);
 void  data_set_lowest       (DATA this, float lowest);
 void  data_increment_bytes  (DATA this, unsigned long bytes);
@@ -53,11 +55,14 @@ void  data_increment_total  (DATA this, float total);
 void  data_increment_code   (DATA this, int code);
 void  data_increment_fail   (DATA this, int fail);
 void  data_increment_okay   (DATA this, int ok200);
+void  data_increment_cached (DATA this, int cached);
+void  data_increment_aborted(DATA this, int aborted);
 void  data_increment_cookies(DATA this, const char *str);
+void  data_increment_hist   (DATA this, HIST hist);
 
 /* getters */
 float    data_get_total(DATA this);
-float    data_get_bytes(DATA this);
+unsigned long long data_get_bytes(DATA this);
 float    data_get_megabytes(DATA this);
 float    data_get_highest(DATA this);
 float    data_get_lowest(DATA this);
@@ -72,5 +77,9 @@ unsigned int data_get_count(DATA this);
 unsigned int data_get_code (DATA this);
 unsigned int data_get_fail (DATA this);
 unsigned int data_get_okay (DATA this);
+unsigned int data_get_cached(DATA this);
+unsigned int data_get_aborted(DATA this);
+HIST     data_get_hist(DATA this);
+float    data_get_percentile(DATA this, float pct);
 
 #endif/*__DATA_H*/
@@ -124,6 +124,7 @@ private int    __checkday(char *check, size_t len);
 private int    __checkmonth(char *check);
 private int    __checktz(char *check);
 private time_t __strtotime(const char *string);
+private long   __days(int y, int m, int d);
 
 struct DATE_T
 {
@@ -572,14 +573,73 @@ __strtotime(const char *string)
   return t;
 }
 
-#if 0
-int main()
+/**
+ * Secs since the epoch with the fraction for an ISO 8601 time
+ * like 2000-10-10T13:55:36.123Z or with an offset, +02:00, or
+ * -1 if it isn't one. HAR files and JSON logs use these.
+ */
+double
+isototime(const char *string)
+{
+  int    year, mon, day, hour, min;
+  int    zh = 0;
+  int    zm = 0;
+  int    n  = 0;
+  double sec;
+  const char *z;
+
+  if (string == NULL) return -1;
+  if (sscanf(string, "%d-%d-%d%*1[T ]%d:%d:%lf%n", &year, &mon, &day, &hour, &min, &sec, &n) < 6) {
+    return -1;
+  }
+  z = string + n;
+  if (*z == '+' || *z == '-') {
+    if (sscanf(z+1, "%2d:%2d", &zh, &zm) < 1) return -1;
+    if (*z == '-') {
+      zh = -zh;
+      zm = -zm;
+    }
+  }
+  return __days(year, mon, day) * 86400.0 + hour * 3600 + min * 60 + sec - (zh * 3600 + zm * 60);
+}
+
+/**
+ * The access log time, 10/Oct/2000:13:55:36 -0700, in secs
+ * since the epoch or -1 if it isn't one
+ */
+double
+clftotime(const char *string)
 {
-  const char date[] = "Tue, 20-Mar-2007 14:31:38 GMT";
-  time_t t          = strtotime(date);
-  time_t n = time(NULL);
+  int   day, year, hour, min, sec;
+  int   zone = 0;
+  char  name[4];
+  char *m;
+  const char *months = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+  if (string == NULL) return -1;
+  if (sscanf(string, "%d/%3s/%d:%d:%d:%d %d", &day, name, &year, &hour, &min, &sec, &zone) < 6) {
+    return -1;
+  }
+  if ((m = strstr(months, name)) == NULL || (m - months) % 3 != 0) {
+    return -1;
+  }
+  zone = (zone < 0) ? -((-zone / 100) * 3600 + (-zone % 100) * 60) : (zone / 100) * 3600 + (zone % 100) * 60;
+  return __days(year, (m - months) / 3 + 1, day) * 86400.0 + hour * 3600 + min * 60 + sec - zone;
+}
 
-  printf("%ld => %ld\n", t, n);
-  return 0;
+/**
+ * Days since 1970-01-01 in the proleptic Gregorian calendar;
+ * unlike mktime it doesn't care what zone we're in.
+ */
+private long
+__days(int y, int m, int d)
+{
+  long era, yoe, doy, doe;
+
+  y  -= (m <= 2);
+  era = (y >= 0 ? y : y - 399) / 400;
+  yoe = y - era * 400;
+  doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
 }
-#endif
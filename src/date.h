@@ -40,6 +40,8 @@ DATE   new_etag(char *etag);
 DATE    date_destroy(DATE this);
 time_t  adjust(time_t tvalue, int secs);
 time_t  strtotime(const char *string);
+double  isototime(const char *string);
+double  clftotime(const char *string);
 BOOLEAN date_expired(DATE this);
 char *  timetostr(const time_t *T);
 char *  date_get_etag(DATE this);
@@ -0,0 +1,1167 @@
+/**
+ * Distributed load: coordinator and agents
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifdef  HAVE_CONFIG_H
+# include <config.h>
+#endif/*HAVE_CONFIG_H*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <poll.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <setup.h>
+#include <dist.h>
+#include <tally.h>
+#include <util.h>
+#include <memory.h>
+#include <notify.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+#ifdef  HAVE_UNISTD_H
+# include <unistd.h>
+#endif/*HAVE_UNISTD_H*/
+
+#ifndef MSG_NOSIGNAL
+# define MSG_NOSIGNAL 0
+#endif
+
+#define AGENT_PROTOCOL "SIEGE/1"
+#define LINESIZE       8192
+
+/**
+ * An agent as the coordinator sees it
+ */
+#define STARTING 0
+#define READY    1
+#define RUNNING  2
+#define STOPPED  3
+#define DONE     4
+#define LOST     5
+
+typedef struct
+{
+  char *       name;
+  int          sock;
+  int          users;
+  int          state;
+  char *       buf;
+  size_t       len;
+  size_t       pos;
+  size_t       size;
+  unsigned int count;
+  unsigned int failed;
+  BOOLEAN      result;
+  TALLY        tally;
+  char *       cookies;
+  size_t       clen;
+} AGENT;
+
+struct DIST_T
+{
+  int             count;
+  int             users;
+  int             first;
+  int             total;
+  AGENT *         agents;
+  BOOLEAN         stopping;
+  pthread_mutex_t lock;
+  unsigned int *  ticks;
+  int             nticks;
+  int             tsize;
+  unsigned int    last;
+};
+
+private char *__listen = NULL;
+private char *__agents = NULL;
+private int   __jobfd  = -1;
+private int   __first  = 0;
+private int   __total  = 0;
+
+private BOOLEAN __split(const char *spec, char **host, char **port);
+private int     __connect(const char *spec);
+private void    __job(char *prog, int sock, int server);
+private BOOLEAN __forward(const char *arg, const char *next, int *skip);
+private BOOLEAN __send(int sock, const char *fmt, ...);
+private BOOLEAN __write(int sock, const char *buf, size_t len);
+private void    __put(char **buf, size_t *len, size_t *size, const char *fmt, ...);
+private char *  __line(AGENT *A);
+private int     __fill(AGENT *A);
+private char *  __expect(AGENT *A, int msecs);
+private void    __handle(AGENT *A, char *line, BOOLEAN *lifted);
+private void    __broadcast(DIST this, const char *msg);
+private void    __tick(DIST this, double elapsed);
+private double  __now(void);
+private void    __lift(BOOLEAN *lifted);
+
+/**
+ * --listen=[ADDR:]PORT for --agent
+ */
+BOOLEAN
+dist_set_listen(const char *spec)
+{
+  char *host;
+  char *port;
+
+  if (spec == NULL || __split(spec, &host, &port) == FALSE) {
+    NOTIFY(ERROR, "--listen requires [ADDR:]PORT, ex: 7070 or 10.0.0.5:7070");
+    return FALSE;
+  }
+  xfree(host);
+  xfree(port);
+  xfree(__listen);
+  __listen = xstrdup(spec);
+  return TRUE;
+}
+
+/**
+ * --agents=HOST:PORT[,HOST:PORT...] for --coordinator
+ */
+BOOLEAN
+dist_set_agents(const char *list)
+{
+  char *tmp;
+  char *tok;
+  char *save = NULL;
+  char *host;
+  char *port;
+  BOOLEAN okay = TRUE;
+
+  if (list == NULL || *list == '\0') {
+    okay = FALSE;
+  } else {
+    tmp = xstrdup(list);
+    for (tok = strtok_r(tmp, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save)) {
+      if (strchr(tok, ':') == NULL || __split(tok, &host, &port) == FALSE) {
+        okay = FALSE;
+        break;
+      }
+      xfree(host);
+      xfree(port);
+    }
+    xfree(tmp);
+  }
+  if (! okay) {
+    NOTIFY(ERROR, "--agents requires a list of HOST:PORT, ex: 10.0.0.5:7070,10.0.0.6:7070");
+    return FALSE;
+  }
+  xfree(__agents);
+  __agents = xstrdup(list);
+  return TRUE;
+}
+
+/**
+ * The agent passes --agent-job=FD,FIRST,TOTAL to the siege
+ * it starts for a job; it's not for people.
+ */
+BOOLEAN
+dist_set_job(const char *spec)
+{
+  if (spec == NULL || sscanf(spec, "%d,%d,%d", &__jobfd, &__first, &__total) != 3 || __jobfd < 0) {
+    NOTIFY(ERROR, "--agent-job is for siege --agent");
+    __jobfd = -1;
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/**
+ * TRUE if an agent started us; our -c is our share of the
+ * coordinator's users
+ */
+BOOLEAN
+dist_is_job(void)
+{
+  return (__jobfd >= 0);
+}
+
+/**
+ * siege --agent: takes jobs until we're told to quit. Each one
+ * runs in its own process so a job can't leave anything behind
+ * for the next one. Never returns.
+ */
+void
+dist_serve(char *prog)
+{
+  int      sock;
+  int      server = -1;
+  int      opt    = 1;
+  int      res;
+  char    *host   = NULL;
+  char    *port   = NULL;
+  pid_t    pid;
+  sigset_t pend;
+  struct pollfd   pfd;
+  struct addrinfo hints;
+  struct addrinfo *ai;
+  struct addrinfo *r;
+
+  if (__listen == NULL) {
+    NOTIFY(FATAL, "--agent requires --listen=[ADDR:]PORT");
+  }
+  __split(__listen, &host, &port);
+
+  memset(&hints, '\0', sizeof(hints));
+  hints.ai_family   = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags    = AI_PASSIVE;
+  if ((res = getaddrinfo(host, port, &hints, &ai)) != 0) {
+    NOTIFY(FATAL, "agent: unable to resolve %s: %s", __listen, gai_strerror(res));
+  }
+  for (r = ai; r != NULL; r = r->ai_next) {
+    if ((server = socket(r->ai_family, r->ai_socktype, r->ai_protocol)) < 0) continue;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (bind(server, r->ai_addr, r->ai_addrlen) == 0 && listen(server, 16) == 0) break;
+    close(server);
+    server = -1;
+  }
+  freeaddrinfo(ai);
+  xfree(host);
+  xfree(port);
+  if (server < 0) {
+    NOTIFY(FATAL, "agent: unable to listen on %s", __listen);
+  }
+
+  if (! my.quiet) {
+    fprintf(stderr, "** ");
+    display_version(FALSE);
+    fprintf(stderr, "** Agent listening on %s\n", __listen);
+  }
+
+  pfd.fd     = server;
+  pfd.events = POLLIN;
+  while (TRUE) {
+    while (waitpid(-1, NULL, WNOHANG) > 0);
+
+    if (sigpending(&pend) == 0 &&
+        (sigismember(&pend, SIGHUP) || sigismember(&pend, SIGINT) || sigismember(&pend, SIGTERM))) {
+      break;
+    }
+    if (poll(&pfd, 1, 1000) <= 0 || ! (pfd.revents & POLLIN)) {
+      continue;
+    }
+    if ((sock = accept(server, NULL, NULL)) < 0) {
+      continue;
+    }
+    fflush(stdout);
+    fflush(stderr);
+    if ((pid = fork()) == 0) {
+      __job(prog, sock, server);
+    }
+    if (pid < 0) {
+      NOTIFY(ERROR, "agent: unable to fork a job");
+    }
+    close(sock);
+  }
+  close(server);
+  exit(EXIT_SUCCESS);
+}
+
+/**
+ * The coordinator: connects to every agent on the list. Users
+ * are dealt out as --procs does; agents we don't need for that
+ * few users are left alone.
+ */
+DIST
+new_dist(int users)
+{
+  int   i;
+  char *tmp;
+  char *tok;
+  char *save = NULL;
+  DIST  this;
+
+  if (__agents == NULL) {
+    NOTIFY(ERROR, "--coordinator requires --agents=HOST:PORT[,HOST:PORT...]");
+    return NULL;
+  }
+
+  this = xcalloc(sizeof(struct DIST_T), 1);
+  this->users = users;
+  pthread_mutex_init(&this->lock, NULL);
+
+  tmp = xstrdup(__agents);
+  for (tok = strtok_r(tmp, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save)) {
+    this->agents = xrealloc(this->agents, sizeof(AGENT) * (this->count + 1));
+    memset(&this->agents[this->count], '\0', sizeof(AGENT));
+    this->agents[this->count].name = xstrdup(tok);
+    this->agents[this->count].sock = -1;
+    this->count++;
+  }
+  xfree(tmp);
+
+  if (this->count > users) {
+    NOTIFY(WARNING, "%d users only need %d of the %d agents", users, users, this->count);
+    for (i = users; i < this->count; i++) {
+      xfree(this->agents[i].name);
+    }
+    this->count = users;
+  }
+
+  for (i = 0; i < this->count; i++) {
+    AGENT *A = &this->agents[i];
+    A->users = users / this->count + ((i < users % this->count) ? 1 : 0);
+    if ((A->sock = __connect(A->name)) < 0) {
+      NOTIFY(ERROR, "agent %s: unable to connect", A->name);
+      return dist_destroy(this);
+    }
+  }
+  return this;
+}
+
+DIST
+dist_destroy(DIST this)
+{
+  int i;
+
+  if (this == NULL) return NULL;
+
+  for (i = 0; i < this->count; i++) {
+    if (this->agents[i].sock >= 0) {
+      close(this->agents[i].sock);
+    }
+    xfree(this->agents[i].name);
+    xfree(this->agents[i].buf);
+    xfree(this->agents[i].cookies);
+  }
+  pthread_mutex_destroy(&this->lock);
+  xfree(this->agents);
+  xfree(this->ticks);
+  xfree(this);
+  return NULL;
+}
+
+/**
+ * Sends every agent its job: our siegerc as it stands, the
+ * URLs we read, its share of the users and the rest of our
+ * command line. Then waits until they've all set up. If one
+ * of them can't, nobody runs.
+ */
+BOOLEAN
+dist_start(DIST this, int argc, char *argv[], LINES *lines)
+{
+  int     i;
+  int     n;
+  int     skip;
+  int     first = 0;
+  char *  buf   = NULL;
+  char *  line;
+  size_t  len   = 0;
+  size_t  size  = 0;
+  size_t  head;
+  FILE *  fp;
+  char    tmp[LINESIZE];
+  BOOLEAN okay  = TRUE;
+
+  __put(&buf, &len, &size, "%s\n", AGENT_PROTOCOL);
+  __put(&buf, &len, &size, "USERS 0 0 %d\n", this->users);
+  head = len;
+
+  if ((fp = fopen(my.rc, "r")) != NULL) {
+    while (fgets(tmp, sizeof(tmp), fp) != NULL) {
+      tmp[strcspn(tmp, "\r\n")] = '\0';
+      __put(&buf, &len, &size, "RC %s\n", tmp);
+    }
+    fclose(fp);
+  }
+  if (my.url == NULL) {
+    for (i = 0; i < my.length; i++) {
+      __put(&buf, &len, &size, "URL %s\n", lines->line[i]);
+    }
+  }
+  for (i = 1; i < argc; i += 1 + skip) {
+    skip = 0;
+    if (__forward(argv[i], (i+1 < argc) ? argv[i+1] : NULL, &skip)) {
+      __put(&buf, &len, &size, "ARG %s\n", argv[i]);
+    }
+  }
+  __put(&buf, &len, &size, "RUN\n");
+
+  for (i = 0; i < this->count; i++) {
+    AGENT *A = &this->agents[i];
+    n = snprintf(tmp, sizeof(tmp), "%s\nUSERS %d %d %d\n", AGENT_PROTOCOL, first, A->users, this->users);
+    if (! __write(A->sock, tmp, n) || ! __write(A->sock, buf+head, len-head)) {
+      NOTIFY(ERROR, "agent %s: unable to send the job", A->name);
+      okay = FALSE;
+      break;
+    }
+    first += A->users;
+  }
+  xfree(buf);
+
+  for (i = 0; okay && i < this->count; i++) {
+    AGENT *A = &this->agents[i];
+    if ((line = __expect(A, -1)) != NULL && strcmp(line, "READY") == 0) {
+      A->state = READY;
+      continue;
+    }
+    errno = 0;
+    if (line != NULL && strncmp(line, "ERROR ", 6) == 0) {
+      NOTIFY(ERROR, "agent %s: %s", A->name, line+6);
+    } else {
+      NOTIFY(ERROR, "agent %s: the job failed to start", A->name);
+    }
+    okay = FALSE;
+  }
+  if (! okay) {
+    __broadcast(this, "STOP\n");
+  }
+  return okay;
+}
+
+/**
+ * Starts the agents and waits for them. While they run we
+ * keep their per second counts, forward HUP, INT and TERM as
+ * a STOP, and stop them all if their failures add up to
+ * my.failures. Then we merge what they report into data and
+ * our own pcache, edge and socket counters. It stops data's
+ * clock. Returns FALSE if we lost an agent before it reported.
+ */
+BOOLEAN
+dist_wait(DIST this, DATA data, PCACHE pcache, EDGE edge)
+{
+  int      i;
+  int      n;
+  int      sig;
+  int      alive;
+  char    *line;
+  double   start;
+  BOOLEAN  okay     = TRUE;
+  BOOLEAN  lifted   = FALSE;
+  BOOLEAN  stopping = FALSE;
+  BOOLEAN  stopped  = FALSE;
+  unsigned int failed;
+  struct pollfd *pfd;
+  sigset_t sigs;
+  sigset_t pend;
+
+  sigemptyset(&sigs);
+  sigaddset(&sigs, SIGHUP);
+  sigaddset(&sigs, SIGINT);
+  sigaddset(&sigs, SIGTERM);
+
+  for (i = 0; i < this->count; i++) {
+    this->agents[i].state = RUNNING;
+  }
+  __broadcast(this, "GO\n");
+  start = __now();
+  pfd   = xcalloc(this->count, sizeof(struct pollfd));
+
+  while (TRUE) {
+    alive  = 0;
+    failed = 0;
+    for (i = 0; i < this->count; i++) {
+      AGENT *A = &this->agents[i];
+      pfd[i].fd      = (A->state == DONE || A->state == LOST) ? -1 : A->sock;
+      pfd[i].events  = POLLIN;
+      pfd[i].revents = 0;
+      failed += A->failed;
+      if (pfd[i].fd >= 0) alive++;
+    }
+    if (alive == 0) break;
+
+    if (! stopped) {
+      for (i = 0; i < this->count && this->agents[i].state != RUNNING; i++);
+      if (i == this->count) {
+        data_set_stop(data);
+        stopped = TRUE;
+      } else {
+        __tick(this, __now() - start);
+      }
+    }
+
+    if (sigpending(&pend) == 0 &&
+        (sigismember(&pend, SIGHUP) || sigismember(&pend, SIGINT) || sigismember(&pend, SIGTERM))) {
+      sigwait(&sigs, &sig);
+      __lift(&lifted);
+      __broadcast(this, "STOP\n");
+      stopping = TRUE;
+    }
+    if (! stopping && my.failures > 0 && failed >= (unsigned)my.failures) {
+      __broadcast(this, "STOP\n");
+      stopping = TRUE;
+    }
+
+    if (poll(pfd, this->count, 10) <= 0) continue;
+
+    for (i = 0; i < this->count; i++) {
+      AGENT *A = &this->agents[i];
+      if (pfd[i].fd < 0 || pfd[i].revents == 0) continue;
+      if ((n = __fill(A)) <= 0) {
+        errno = 0;
+        NOTIFY(WARNING, "agent %s: lost the connection before it reported", A->name);
+        A->state = LOST;
+        okay     = FALSE;
+        continue;
+      }
+      while (A->state != DONE && (line = __line(A)) != NULL) {
+        __handle(A, line, &lifted);
+      }
+    }
+  }
+  xfree(pfd);
+
+  if (! stopped) {
+    data_set_stop(data);
+  }
+
+  my.failed = 0;
+  for (i = 0; i < this->count; i++) {
+    AGENT *A = &this->agents[i];
+    if (A->state != DONE) continue;
+    tally_merge(&A->tally, data, pcache, edge);
+    if (A->cookies != NULL) {
+      data_increment_cookies(data, A->cookies);
+    }
+  }
+  if (! okay) {
+    errno = 0;
+    NOTIFY(WARNING, "the results don't include the agents we lost");
+  }
+  return okay;
+}
+
+int
+dist_get_count(DIST this)
+{
+  return (this == NULL) ? 0 : this->count;
+}
+
+/**
+ * An agent's name and hits: what it reported, or the last
+ * count we had from it if we lost it
+ */
+char *
+dist_get_agent(DIST this, int index, unsigned int *hits)
+{
+  AGENT *A;
+
+  if (this == NULL || index < 0 || index >= this->count) return NULL;
+
+  A = &this->agents[index];
+  if (hits != NULL) {
+    *hits = (A->state == DONE) ? A->tally.count : A->count;
+  }
+  return A->name;
+}
+
+/**
+ * Transactions the agents finished in each whole second of
+ * the run, as near as their per second counts can tell us
+ */
+int
+dist_get_ticks(DIST this)
+{
+  return (this == NULL) ? 0 : this->nticks;
+}
+
+unsigned int
+dist_get_tick(DIST this, int index)
+{
+  if (this == NULL || index < 0 || index >= this->nticks) return 0;
+  return this->ticks[index];
+}
+
+/**
+ * Called by the siege an agent started for a job; returns
+ * NULL unless that's what we are.
+ */
+DIST
+dist_join(void)
+{
+  DIST this;
+
+  if (__jobfd < 0) return NULL;
+
+  this = xcalloc(sizeof(struct DIST_T), 1);
+  this->count  = 1;
+  this->first  = __first;
+  this->total  = __total;
+  this->agents = xcalloc(1, sizeof(AGENT));
+  this->agents[0].sock = __jobfd;
+  this->agents[0].name = xstrdup("coordinator");
+  pthread_mutex_init(&this->lock, NULL);
+  return this;
+}
+
+int
+dist_get_first(DIST this)
+{
+  return (this == NULL) ? 0 : this->first;
+}
+
+int
+dist_get_total(DIST this)
+{
+  return (this == NULL) ? 0 : this->total;
+}
+
+/**
+ * Tells the coordinator we're set up and waits for it to
+ * start us. Returns FALSE if it won't.
+ */
+BOOLEAN
+dist_ready(DIST this)
+{
+  char *line;
+
+  if (this == NULL) return TRUE;
+
+  if (! __send(this->agents[0].sock, "READY\n")) {
+    return FALSE;
+  }
+  while ((line = __expect(&this->agents[0], -1)) != NULL) {
+    if (strcmp(line, "GO") == 0)   return TRUE;
+    if (strcmp(line, "STOP") == 0) return FALSE;
+  }
+  return FALSE;
+}
+
+/**
+ * The publisher's nap; we listen for a STOP while we're at
+ * it. A coordinator that goes away stops us too.
+ */
+void
+dist_sleep(DIST this, unsigned int seconds)
+{
+  int     n;
+  char   *line;
+  AGENT  *A;
+  BOOLEAN stop = FALSE;
+  struct pollfd pfd;
+
+  if (this == NULL || this->stopping) {
+    pthread_sleep_np(seconds);
+    return;
+  }
+
+  A = &this->agents[0];
+  pfd.fd     = A->sock;
+  pfd.events = POLLIN;
+  if (poll(&pfd, 1, seconds * 1000) <= 0) {
+    return;
+  }
+  if ((n = __fill(A)) <= 0) {
+    stop = TRUE;
+  }
+  while (! stop && (line = __line(A)) != NULL) {
+    if (strcmp(line, "STOP") == 0) stop = TRUE;
+  }
+  if (stop) {
+    this->stopping = TRUE;
+    kill(getpid(), SIGINT);
+  }
+}
+
+/**
+ * Sends our running count, or on the final call everything
+ * tally has and the cookies.
+ */
+void
+dist_publish(DIST this, DATA data, PCACHE pcache, EDGE edge, BOOLEAN final)
+{
+  char *text;
+  char *cookies;
+  char *tok;
+  char *save = NULL;
+  TALLY T;
+
+  if (this == NULL) return;
+
+  pthread_mutex_lock(&this->lock);
+  if (! final) {
+    __send(this->agents[0].sock, "TICK %u %u\n", data_get_count(data), my.failed);
+  } else {
+    tally_collect(&T, data, pcache, edge);
+    text = tally_encode(&T);
+    __send(this->agents[0].sock, "RESULT\n%s", text);
+    xfree(text);
+    cookies = xstrdup(data_get_cookies(data));
+    for (tok = strtok_r(cookies, "\n", &save); tok != NULL; tok = strtok_r(NULL, "\n", &save)) {
+      __send(this->agents[0].sock, "COOKIE %s\n", tok);
+    }
+    xfree(cookies);
+    __send(this->agents[0].sock, "END\n");
+  }
+  pthread_mutex_unlock(&this->lock);
+}
+
+/**
+ * Called the moment our run ends; the coordinator stops its
+ * clock when they all have.
+ */
+void
+dist_stopped(DIST this)
+{
+  if (this == NULL) return;
+
+  pthread_mutex_lock(&this->lock);
+  __send(this->agents[0].sock, "STOPPED\n");
+  pthread_mutex_unlock(&this->lock);
+}
+
+/**
+ * [ADDR:]PORT or [ADDR]:PORT for IPv6; host is NULL if the
+ * spec has none
+ */
+private BOOLEAN
+__split(const char *spec, char **host, char **port)
+{
+  int         n;
+  const char *p;
+  const char *colon;
+
+  *host = NULL;
+  *port = NULL;
+  if (*spec == '[') {
+    if ((p = strchr(spec, ']')) == NULL || p[1] != ':') return FALSE;
+    *host = substring((char *)spec, 1, p - spec - 1);
+    colon = p + 1;
+  } else if ((colon = strrchr(spec, ':')) != NULL) {
+    *host = substring((char *)spec, 0, colon - spec);
+  }
+  p = (colon == NULL) ? spec : colon + 1;
+  if ((*host != NULL && **host == '\0') || (n = atoi(p)) < 1 || n > 65535 || strspn(p, "0123456789") != strlen(p)) {
+    xfree(*host);
+    *host = NULL;
+    return FALSE;
+  }
+  *port = xstrdup(p);
+  return TRUE;
+}
+
+private int
+__connect(const char *spec)
+{
+  int   sock = -1;
+  char *host;
+  char *port;
+  struct addrinfo hints;
+  struct addrinfo *ai;
+  struct addrinfo *r;
+
+  if (__split(spec, &host, &port) == FALSE) return -1;
+
+  memset(&hints, '\0', sizeof(hints));
+  hints.ai_family   = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host, port, &hints, &ai) == 0) {
+    for (r = ai; r != NULL; r = r->ai_next) {
+      if ((sock = socket(r->ai_family, r->ai_socktype, r->ai_protocol)) < 0) continue;
+      if (connect(sock, r->ai_addr, r->ai_addrlen) == 0) break;
+      close(sock);
+      sock = -1;
+    }
+    freeaddrinfo(ai);
+  }
+  xfree(host);
+  xfree(port);
+  return sock;
+}
+
+/**
+ * In the agent's child: reads the job, puts its siegerc and
+ * URLs in temp files and runs siege on them with the socket
+ * still open. We wait for it so we can clean up after it.
+ */
+private void
+__job(char *prog, int sock, int server)
+{
+  int     n;
+  int     fd;
+  int     argn    = 0;
+  int     first   = 0;
+  int     users   = 0;
+  int     total   = 0;
+  int     status  = 0;
+  char  **argv    = NULL;
+  char   *line;
+  char    rc[256];
+  char    urls[256];
+  char    tmp[64];
+  FILE   *rfp     = NULL;
+  FILE   *ufp     = NULL;
+  pid_t   pid;
+  AGENT   A;
+  const char *dir = (getenv("TMPDIR") != NULL) ? getenv("TMPDIR") : "/tmp";
+
+  close(server);
+  memset(&A, '\0', sizeof(AGENT));
+  A.sock = sock;
+  urls[0] = '\0';
+
+  if ((line = __expect(&A, 30000)) == NULL || strcmp(line, AGENT_PROTOCOL) != 0) {
+    __send(sock, "ERROR expected %s\n", AGENT_PROTOCOL);
+    _exit(EXIT_FAILURE);
+  }
+
+  snprintf(rc, sizeof(rc), "%s/siege-rc.XXXXXX", dir);
+  if ((fd = mkstemp(rc)) < 0 || (rfp = fdopen(fd, "w")) == NULL) {
+    __send(sock, "ERROR unable to create a temp file in %s\n", dir);
+    _exit(EXIT_FAILURE);
+  }
+
+  argv = xcalloc(9, sizeof(char *));
+  while ((line = __expect(&A, 30000)) != NULL && strcmp(line, "RUN") != 0) {
+    if (strncmp(line, "USERS ", 6) == 0) {
+      sscanf(line+6, "%d %d %d", &first, &users, &total);
+    } else if (strncmp(line, "RC ", 3) == 0) {
+      fprintf(rfp, "%s\n", line+3);
+    } else if (strncmp(line, "URL ", 4) == 0) {
+      if (ufp == NULL) {
+        snprintf(urls, sizeof(urls), "%s/siege-urls.XXXXXX", dir);
+        if ((fd = mkstemp(urls)) < 0 || (ufp = fdopen(fd, "w")) == NULL) {
+          __send(sock, "ERROR unable to create a temp file in %s\n", dir);
+          unlink(rc);
+          _exit(EXIT_FAILURE);
+        }
+      }
+      fprintf(ufp, "%s\n", line+4);
+    } else if (strncmp(line, "ARG ", 4) == 0) {
+      argv = xrealloc(argv, sizeof(char *) * (argn + 9));
+      argv[8 + argn++] = xstrdup(line+4);
+    }
+  }
+  fclose(rfp);
+  if (ufp != NULL) fclose(ufp);
+
+  if (line == NULL || users < 1) {
+    unlink(rc);
+    if (ufp != NULL) unlink(urls);
+    _exit(EXIT_FAILURE);
+  }
+
+  /**
+   * argv is prog, --agent-job, -R rc, -f urls, -c users then
+   * the coordinator's arguments; we left room for ours.
+   */
+  n = 0;
+  snprintf(tmp, sizeof(tmp), "--agent-job=%d,%d,%d", sock, first, total);
+  argv[n++] = prog;
+  argv[n++] = xstrdup(tmp);
+  argv[n++] = "-R";
+  argv[n++] = rc;
+  if (ufp != NULL) {
+    argv[n++] = "-f";
+    argv[n++] = urls;
+  }
+  snprintf(tmp, sizeof(tmp), "%d", users);
+  argv[n++] = "-c";
+  argv[n++] = xstrdup(tmp);
+  memmove(&argv[n], &argv[8], sizeof(char *) * argn);
+  argv[n + argn] = NULL;
+
+  if (! my.quiet) {
+    fprintf(stderr, "agent: starting a job for %d of %d users\n", users, total);
+  }
+
+  if ((pid = fork()) == 0) {
+    signal(SIGINT, SIG_DFL);
+    execv("/proc/self/exe", argv);
+    execvp(prog, argv);
+    __send(sock, "ERROR unable to run %s: %s\n", prog, strerror(errno));
+    _exit(127);
+  }
+  close(sock);
+  if (pid > 0) {
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR);
+  }
+  unlink(rc);
+  if (ufp != NULL) unlink(urls);
+  _exit(EXIT_SUCCESS);
+}
+
+/**
+ * The coordinator's arguments that agents shouldn't see: ours,
+ * the ones we send some other way and the ones that only make
+ * sense where the summary is. skip is how many more argv
+ * entries the option takes.
+ */
+private BOOLEAN
+__forward(const char *arg, const char *next, int *skip)
+{
+  int i;
+  size_t len;
+  const char *valued[] = {
+    "-c", "--concurrent", "-f", "--file", "-R", "--rc", "-m", "--mark",
+    "--agents", "--listen", "--agent-job", "--procs", NULL
+  };
+  const char *flags[]  = {
+    "--coordinator", "--agent", "-j", "--json-output", "-C", "--config", "-l", "--log", NULL
+  };
+
+  *skip = 0;
+  for (i = 0; valued[i] != NULL; i++) {
+    len = strlen(valued[i]);
+    if (strcmp(arg, valued[i]) == 0) {
+      *skip = (next != NULL) ? 1 : 0;
+      return FALSE;
+    }
+    if (strncmp(arg, valued[i], len) == 0 && (len == 2 || arg[len] == '=')) {
+      return FALSE;
+    }
+  }
+  for (i = 0; flags[i] != NULL; i++) {
+    if (strcmp(arg, flags[i]) == 0) return FALSE;
+  }
+  if (strncmp(arg, "-l", 2) == 0 || strncmp(arg, "--log=", 6) == 0) {
+    return FALSE;
+  }
+  return TRUE;
+}
+
+private BOOLEAN
+__send(int sock, const char *fmt, ...)
+{
+  int     n;
+  char    buf[LINESIZE];
+  va_list ap;
+
+  va_start(ap, fmt);
+  n = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  if (n < 0) return FALSE;
+  if ((size_t)n < sizeof(buf)) {
+    return __write(sock, buf, n);
+  } else {
+    BOOLEAN okay;
+    char   *big = xmalloc(n + 1);
+    va_start(ap, fmt);
+    vsnprintf(big, n + 1, fmt, ap);
+    va_end(ap);
+    okay = __write(sock, big, n);
+    xfree(big);
+    return okay;
+  }
+}
+
+private BOOLEAN
+__write(int sock, const char *buf, size_t len)
+{
+  ssize_t n;
+
+  while (len > 0) {
+    if ((n = send(sock, buf, len, MSG_NOSIGNAL)) < 0) {
+      if (errno == EINTR) continue;
+      return FALSE;
+    }
+    buf += n;
+    len -= n;
+  }
+  return TRUE;
+}
+
+private void
+__put(char **buf, size_t *len, size_t *size, const char *fmt, ...)
+{
+  int     n;
+  va_list ap;
+
+  for (;;) {
+    va_start(ap, fmt);
+    n = vsnprintf(*buf + *len, *size - *len, fmt, ap);
+    va_end(ap);
+    if (n >= 0 && (size_t)n < *size - *len) {
+      *len += n;
+      return;
+    }
+    *size = (*size == 0) ? 8192 : *size * 2;
+    *buf  = xrealloc(*buf, *size);
+  }
+}
+
+/**
+ * The next whole line in A's buffer or NULL; it's good until
+ * the next call
+ */
+private char *
+__line(AGENT *A)
+{
+  char *nl;
+
+  if (A->pos > 0) {
+    memmove(A->buf, A->buf + A->pos, A->len - A->pos);
+    A->len -= A->pos;
+    A->pos  = 0;
+  }
+  if (A->len == 0 || (nl = memchr(A->buf, '\n', A->len)) == NULL) {
+    return NULL;
+  }
+  *nl    = '\0';
+  A->pos = nl - A->buf + 1;
+  if (nl > A->buf && nl[-1] == '\r') nl[-1] = '\0';
+  return A->buf;
+}
+
+/**
+ * One read into A's buffer; what read returned
+ */
+private int
+__fill(AGENT *A)
+{
+  ssize_t n;
+
+  if (A->pos > 0) {
+    memmove(A->buf, A->buf + A->pos, A->len - A->pos);
+    A->len -= A->pos;
+    A->pos  = 0;
+  }
+  if (A->size - A->len < 4096) {
+    A->size = (A->size == 0) ? 16384 : A->size * 2;
+    A->buf  = xrealloc(A->buf, A->size);
+  }
+  do {
+    n = read(A->sock, A->buf + A->len, A->size - A->len);
+  } while (n < 0 && errno == EINTR);
+  if (n > 0) A->len += n;
+  return (int)n;
+}
+
+/**
+ * Waits up to msecs (forever if it's negative) for the next
+ * line; NULL if it doesn't come or the other end goes away
+ */
+private char *
+__expect(AGENT *A, int msecs)
+{
+  int   n;
+  char *line;
+  struct pollfd pfd;
+
+  pfd.fd     = A->sock;
+  pfd.events = POLLIN;
+  while ((line = __line(A)) == NULL) {
+    if ((n = poll(&pfd, 1, msecs)) < 0 && errno == EINTR) continue;
+    if (n <= 0 || __fill(A) <= 0) return NULL;
+  }
+  return line;
+}
+
+private void
+__handle(AGENT *A, char *line, BOOLEAN *lifted)
+{
+  size_t len;
+
+  if (A->result) {
+    if (strcmp(line, "END") == 0) {
+      A->result = FALSE;
+      A->state  = DONE;
+    } else if (strncmp(line, "COOKIE ", 7) == 0) {
+      len = strlen(line+7);
+      A->cookies = xrealloc(A->cookies, A->clen + len + 2);
+      memcpy(A->cookies + A->clen, line+7, len);
+      A->clen += len;
+      A->cookies[A->clen++] = '\n';
+      A->cookies[A->clen]   = '\0';
+    } else if (tally_decode(&A->tally, line) == FALSE) {
+      errno = 0;
+      NOTIFY(WARNING, "agent %s: unexpected result: %s", A->name, line);
+    }
+    return;
+  }
+
+  if (strncmp(line, "TICK ", 5) == 0) {
+    sscanf(line+5, "%u %u", &A->count, &A->failed);
+  } else if (strcmp(line, "STOPPED") == 0) {
+    A->state = STOPPED;
+    if (my.secs > 0) {
+      __lift(lifted);
+    }
+  } else if (strcmp(line, "RESULT") == 0) {
+    memset(&A->tally, '\0', sizeof(TALLY));
+    A->result = TRUE;
+    if (A->state == RUNNING) A->state = STOPPED;
+  } else if (strncmp(line, "ERROR ", 6) == 0) {
+    errno = 0;
+    NOTIFY(WARNING, "agent %s: %s", A->name, line+6);
+  }
+}
+
+private void
+__broadcast(DIST this, const char *msg)
+{
+  int i;
+
+  for (i = 0; i < this->count; i++) {
+    AGENT *A = &this->agents[i];
+    if (A->sock >= 0 && A->state != DONE && A->state != LOST) {
+      __write(A->sock, msg, strlen(msg));
+    }
+  }
+}
+
+/**
+ * Closes out every whole second that's gone by with what the
+ * agents have counted since the last one
+ */
+private void
+__tick(DIST this, double elapsed)
+{
+  int          i;
+  unsigned int sum = 0;
+
+  if ((int)elapsed <= this->nticks) return;
+
+  for (i = 0; i < this->count; i++) {
+    sum += (this->agents[i].state == DONE) ? this->agents[i].tally.count : this->agents[i].count;
+  }
+  while (this->nticks < (int)elapsed) {
+    if (this->nticks == this->tsize) {
+      this->tsize = (this->tsize == 0) ? 64 : this->tsize * 2;
+      this->ticks = xrealloc(this->ticks, sizeof(unsigned int) * this->tsize);
+    }
+    this->ticks[this->nticks++] = sum - this->last;
+    this->last = sum;
+  }
+}
+
+private double
+__now(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/**
+ * The agents keep quiet; we tell the user once
+ */
+private void
+__lift(BOOLEAN *lifted)
+{
+  if (*lifted) return;
+
+  *lifted = TRUE;
+  if (! my.quiet) {
+    fprintf(stderr, "\nLifting the server siege...");
+  }
+}
@@ -0,0 +1,75 @@
+/**
+ * Distributed load: coordinator and agents
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifndef __DIST_H
+#define __DIST_H
+
+#include <stdlib.h>
+#include <setup.h>
+#include <data.h>
+#include <pcache.h>
+#include <edge.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+/**
+ * siege --agent --listen=PORT waits for a coordinator. For
+ * each job it gets, it starts a fresh siege with the job's
+ * siegerc, URLs and options and hands it the connection.
+ *
+ * siege --coordinator --agents=h1:p,h2:p deals the users out
+ * to the agents, sends them the job, starts them together,
+ * watches their per second counts, then adds up what they
+ * report into one summary as --procs does with its workers.
+ *
+ * It's a plain text protocol with no authentication: anyone
+ * who can reach an agent can point it at any server. Keep
+ * agents on a network you trust.
+ */
+typedef struct DIST_T *DIST;
+
+BOOLEAN dist_set_listen(const char *spec);
+BOOLEAN dist_set_agents(const char *list);
+BOOLEAN dist_set_job(const char *spec);
+BOOLEAN dist_is_job(void);
+void    dist_serve(char *prog);
+
+/* coordinator */
+DIST    new_dist(int users);
+DIST    dist_destroy(DIST this);
+BOOLEAN dist_start(DIST this, int argc, char *argv[], LINES *lines);
+BOOLEAN dist_wait(DIST this, DATA data, PCACHE pcache, EDGE edge);
+int     dist_get_count(DIST this);
+char *  dist_get_agent(DIST this, int index, unsigned int *hits);
+int     dist_get_ticks(DIST this);
+unsigned int dist_get_tick(DIST this, int index);
+
+/* agent job */
+DIST    dist_join(void);
+int     dist_get_first(DIST this);
+int     dist_get_total(DIST this);
+BOOLEAN dist_ready(DIST this);
+void    dist_sleep(DIST this, unsigned int seconds);
+void    dist_publish(DIST this, DATA data, PCACHE pcache, EDGE edge, BOOLEAN final);
+void    dist_stopped(DIST this);
+
+#endif/*__DIST_H*/
@@ -0,0 +1,316 @@
+/**
+ * Shared edge cache
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifdef  HAVE_CONFIG_H
+# include <config.h>
+#endif/*HAVE_CONFIG_H*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <edge.h>
+#include <date.h>
+#include <util.h>
+#include <memory.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+typedef struct ENODE_T
+{
+  int       key;
+  int       user;
+  time_t    fresh;
+  DATE      expires;
+  unsigned long bytes;
+  PARTS     page;
+  struct ENODE_T *prev;
+  struct ENODE_T *next;
+  struct ENODE_T *chain;
+} ENODE;
+
+struct EDGE_T
+{
+  int       max;
+  int       count;
+  int       size;
+  ENODE **  table;
+  ENODE *   head;
+  ENODE *   tail;
+  unsigned long hits;
+  unsigned long misses;
+  unsigned long evictions;
+  unsigned long long bytes;
+  pthread_mutex_t lock;
+};
+
+private ENODE * __find(EDGE this, int key, int user);
+private BOOLEAN __fresh(ENODE *N);
+private void    __touch(EDGE this, ENODE *N);
+private void    __remove(EDGE this, ENODE *N);
+
+EDGE
+new_edge(int entries)
+{
+  EDGE this;
+
+  this = xcalloc(sizeof(struct EDGE_T), 1);
+  this->max   = (entries > 0) ? entries : 1;
+  this->size  = 16;
+  while (this->size < this->max) {
+    this->size <<= 1;
+  }
+  this->table = xcalloc(this->size, sizeof(ENODE *));
+  this->head  = NULL;
+  this->tail  = NULL;
+  pthread_mutex_init(&this->lock, NULL);
+  return this;
+}
+
+EDGE
+edge_destroy(EDGE this)
+{
+  if (this == NULL) return NULL;
+
+  while (this->head != NULL) {
+    __remove(this, this->head);
+  }
+  pthread_mutex_destroy(&this->lock);
+  xfree(this->table);
+  xfree(this);
+  return NULL;
+}
+
+/**
+ * Returns TRUE if the edge would have served U without going
+ * back to the origin. user is the browser id; it only matters
+ * for responses that vary on the user's credentials. On a hit,
+ * page gets a reference to the resources the page parsed to,
+ * or NULL; the caller hands it back with parts_release()
+ */
+BOOLEAN
+edge_lookup(EDGE this, URL U, int user, PARTS *page)
+{
+  ENODE  *N;
+  BOOLEAN hit = FALSE;
+
+  if (page != NULL) *page = NULL;
+  if (this == NULL || url_get_key(U) < 1) return FALSE;
+
+  pthread_mutex_lock(&this->lock);
+  N = __find(this, url_get_key(U), user);
+  if (N != NULL && __fresh(N)) {
+    __touch(this, N);
+    this->hits  += 1;
+    this->bytes += N->bytes;
+    if (page != NULL) *page = parts_retain(N->page);
+    hit = TRUE;
+  } else {
+    if (N != NULL) {
+      __remove(this, N);
+    }
+    this->misses += 1;
+  }
+  pthread_mutex_unlock(&this->lock);
+  return hit;
+}
+
+/**
+ * Stores the origin's response to U if a shared cache is
+ * allowed to keep it. s-maxage wins over max-age which wins
+ * over Expires. We don't do heuristic freshness; if the origin
+ * didn't give us a lifetime, the edge doesn't keep it. page is
+ * what the browser parsed the response to, if anything.
+ */
+void
+edge_store(EDGE this, URL U, int user, RESPONSE resp, unsigned long bytes, PARTS page)
+{
+  int     age;
+  int     key;
+  char   *vary;
+  ENODE  *N;
+  time_t  fresh   = 0;
+  DATE    expires = NULL;
+
+  if (this == NULL || resp == NULL || (key = url_get_key(U)) < 1) return;
+
+  if (response_get_no_store(resp) || response_get_private(resp) || response_get_no_cache(resp)) {
+    return;
+  }
+
+  vary = response_get_vary(resp);
+  if (vary != NULL && strchr(vary, '*') != NULL) {
+    return;
+  }
+  if (vary == NULL || (stristr(vary, "cookie") == NULL && stristr(vary, "authorization") == NULL)) {
+    /**
+     * Every browser sends the same agent, encoding and accept
+     * headers so any other Vary collapses into one variant
+     */
+    user = 0;
+  }
+
+  if ((age = response_get_s_maxage(resp)) < 0) {
+    age = response_get_max_age(resp);
+  }
+  if (age > 0) {
+    fresh = time(NULL) + age;
+  } else if (age == 0) {
+    return;
+  } else if (response_get_expires(resp) != NULL) {
+    expires = new_date(response_get_expires(resp));
+  } else {
+    return;
+  }
+
+  pthread_mutex_lock(&this->lock);
+  if ((N = __find(this, key, user)) != NULL && N->user == user) {
+    N->expires = date_destroy(N->expires);
+    N->page    = parts_release(N->page);
+  } else {
+    while (this->count >= this->max && this->tail != NULL) {
+      __remove(this, this->tail);
+      this->evictions += 1;
+    }
+    N = xcalloc(sizeof(ENODE), 1);
+    N->key   = key;
+    N->user  = user;
+    N->chain = this->table[key & (this->size - 1)];
+    this->table[key & (this->size - 1)] = N;
+    this->count += 1;
+  }
+  N->fresh   = fresh;
+  N->expires = expires;
+  N->bytes   = bytes;
+  N->page    = parts_retain(page);
+  __touch(this, N);
+  pthread_mutex_unlock(&this->lock);
+  return;
+}
+
+unsigned long
+edge_get_hits(EDGE this)
+{
+  return (this == NULL) ? 0 : this->hits;
+}
+
+unsigned long
+edge_get_misses(EDGE this)
+{
+  return (this == NULL) ? 0 : this->misses;
+}
+
+unsigned long
+edge_get_evictions(EDGE this)
+{
+  return (this == NULL) ? 0 : this->evictions;
+}
+
+unsigned long long
+edge_get_bytes(EDGE this)
+{
+  return (this == NULL) ? 0 : this->bytes;
+}
+
+/**
+ * Adds a worker process's counts to ours; each worker runs
+ * its own edge so this is the sum of several smaller caches.
+ */
+void
+edge_add_stats(EDGE this, unsigned long hits, unsigned long misses, unsigned long evictions, unsigned long long bytes)
+{
+  if (this == NULL) return;
+
+  pthread_mutex_lock(&this->lock);
+  this->hits      += hits;
+  this->misses    += misses;
+  this->evictions += evictions;
+  this->bytes     += bytes;
+  pthread_mutex_unlock(&this->lock);
+}
+
+/**
+ * A shared variant (user 0) satisfies everyone; otherwise
+ * we need the one that was stored for this user.
+ */
+private ENODE *
+__find(EDGE this, int key, int user)
+{
+  ENODE *N;
+
+  for (N = this->table[key & (this->size - 1)]; N != NULL; N = N->chain) {
+    if (N->key == key && (N->user == 0 || N->user == user)) {
+      return N;
+    }
+  }
+  return NULL;
+}
+
+private BOOLEAN
+__fresh(ENODE *N)
+{
+  if (N->fresh > 0) {
+    return (time(NULL) < N->fresh) ? TRUE : FALSE;
+  }
+  return (date_expired(N->expires) == FALSE) ? TRUE : FALSE;
+}
+
+/**
+ * Moves N to the head of the LRU list
+ */
+private void
+__touch(EDGE this, ENODE *N)
+{
+  if (this->head == N) return;
+
+  if (N->prev != NULL) N->prev->next = N->next;
+  if (N->next != NULL) N->next->prev = N->prev;
+  if (this->tail == N) this->tail = N->prev;
+
+  N->prev = NULL;
+  N->next = this->head;
+  if (this->head != NULL) this->head->prev = N;
+  this->head = N;
+  if (this->tail == NULL) this->tail = N;
+}
+
+private void
+__remove(EDGE this, ENODE *N)
+{
+  ENODE **ptr = &this->table[N->key & (this->size - 1)];
+
+  while (*ptr != NULL && *ptr != N) {
+    ptr = &(*ptr)->chain;
+  }
+  if (*ptr == N) *ptr = N->chain;
+
+  if (N->prev != NULL) N->prev->next = N->next;
+  if (N->next != NULL) N->next->prev = N->prev;
+  if (this->head == N) this->head = N->next;
+  if (this->tail == N) this->tail = N->prev;
+
+  this->count -= 1;
+  N->expires = date_destroy(N->expires);
+  N->page    = parts_release(N->page);
+  xfree(N);
+}
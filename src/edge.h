@@ -0,0 +1,55 @@
+/**
+ * Shared edge cache
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifndef __EDGE_H
+#define __EDGE_H
+
+#include <stdlib.h>
+#include <url.h>
+#include <response.h>
+#include <pcache.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+/**
+ * Simulates a CDN that sits in front of the origin and is
+ * shared by all the browsers. Like cache.c, it doesn't keep
+ * content, just what a shared cache would know about it: how
+ * long it's fresh and how many bytes it would have served.
+ * A page keeps the resources it parsed to so a browser that
+ * gets it from the edge can still request them.
+ * Capacity is a number of objects; we evict the least recently
+ * used when it's full.
+ */
+typedef struct EDGE_T *EDGE;
+
+EDGE     new_edge(int entries);
+EDGE     edge_destroy(EDGE this);
+BOOLEAN  edge_lookup(EDGE this, URL U, int user, PARTS *page);
+void     edge_store(EDGE this, URL U, int user, RESPONSE resp, unsigned long bytes, PARTS page);
+unsigned long      edge_get_hits(EDGE this);
+unsigned long      edge_get_misses(EDGE this);
+unsigned long      edge_get_evictions(EDGE this);
+unsigned long long edge_get_bytes(EDGE this);
+void     edge_add_stats(EDGE this, unsigned long hits, unsigned long misses, unsigned long evictions, unsigned long long bytes);
+
+#endif/*__EDGE_H*/
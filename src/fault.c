@@ -0,0 +1,122 @@
+/**
+ * Failure classes
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifdef  HAVE_CONFIG_H
+# include <config.h>
+#endif/*HAVE_CONFIG_H*/
+
+#include <stdlib.h>
+#include <errno.h>
+#include <fault.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+private unsigned long __counts[FAULTS];
+
+private const char *__names[FAULTS] = {
+  "none", "dns", "refused", "unreachable", "local", "timeout",
+  "reset", "tls", "empty", "http-4xx", "http-5xx", "other"
+};
+
+void
+fault_count(FAULT fault)
+{
+  if (fault <= FAULT_NONE || fault >= FAULTS) return;
+
+  __sync_fetch_and_add(&__counts[fault], 1);
+}
+
+unsigned long
+fault_get_count(FAULT fault)
+{
+  if (fault <= FAULT_NONE || fault >= FAULTS) return 0;
+
+  return __sync_add_and_fetch(&__counts[fault], 0);
+}
+
+/**
+ * Copies the counts into counts, which must hold FAULTS
+ */
+void
+fault_get_counts(unsigned long *counts)
+{
+  int i;
+
+  for (i = 0; i < FAULTS; i++) {
+    counts[i] = __sync_add_and_fetch(&__counts[i], 0);
+  }
+}
+
+/**
+ * Adds a worker's or an agent's counts to ours
+ */
+void
+fault_add_counts(const unsigned long *counts)
+{
+  int i;
+
+  for (i = 0; i < FAULTS; i++) {
+    __sync_fetch_and_add(&__counts[i], counts[i]);
+  }
+}
+
+const char *
+fault_name(FAULT fault)
+{
+  return (fault < FAULT_NONE || fault >= FAULTS) ? "other" : __names[fault];
+}
+
+FAULT
+fault_from_errno(int err)
+{
+  switch (err) {
+    case ECONNREFUSED:
+      return FAULT_REFUSED;
+    case ENETUNREACH:
+    case EHOSTUNREACH:
+    case ENETDOWN:
+    case EHOSTDOWN:
+      return FAULT_UNREACH;
+    case EADDRNOTAVAIL:
+    case EADDRINUSE:
+    case EMFILE:
+    case ENFILE:
+    case ENOBUFS:
+      return FAULT_LOCAL;
+    case ETIMEDOUT:
+      return FAULT_TIMEOUT;
+    case ECONNRESET:
+    case ECONNABORTED:
+    case EPIPE:
+      return FAULT_RESET;
+    default:
+      return FAULT_OTHER;
+  }
+}
+
+FAULT
+fault_from_code(int code)
+{
+  if (code >= 500) return FAULT_HTTP5XX;
+  if (code >= 400) return FAULT_HTTP4XX;
+  return FAULT_NONE;
+}
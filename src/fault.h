@@ -0,0 +1,62 @@
+/**
+ * Failure classes
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifndef __FAULT_H
+#define __FAULT_H
+
+#include <stdlib.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+/**
+ * Why a transaction failed. The socket, SSL and HTTP layers mark
+ * the first thing that went wrong on the connection (socket_fault)
+ * and the browser counts it once, when it gives up on the request,
+ * along with responses of 400 and up. The counts are process-wide
+ * and lock free; history.c snapshots them every second and
+ * urlstats.c keeps them per URL.
+ */
+typedef enum {
+  FAULT_NONE = 0,
+  FAULT_DNS,        /* the name didn't resolve                      */
+  FAULT_REFUSED,    /* nothing listening, or its accept queue full  */
+  FAULT_UNREACH,    /* no route to the network or host              */
+  FAULT_LOCAL,      /* out of local ports, addresses or descriptors */
+  FAULT_TIMEOUT,    /* connect, read or write took too long         */
+  FAULT_RESET,      /* reset or closed in the middle of a request   */
+  FAULT_TLS,        /* the handshake or an SSL read or write        */
+  FAULT_EMPTY,      /* closed without a response, or an empty one   */
+  FAULT_HTTP4XX,
+  FAULT_HTTP5XX,
+  FAULT_OTHER,
+  FAULTS
+} FAULT;
+
+void          fault_count(FAULT fault);
+unsigned long fault_get_count(FAULT fault);
+void          fault_get_counts(unsigned long *counts);
+void          fault_add_counts(const unsigned long *counts);
+const char *  fault_name(FAULT fault);
+FAULT         fault_from_errno(int err);
+FAULT         fault_from_code(int code);
+
+#endif/*__FAULT_H*/
@@ -36,8 +36,12 @@ private int     __response(CONN *C);
 private int     __response_code(const char *buf);
 private BOOLEAN __in_range(int code, int lower, int upper);
 
+/**
+ * Logs in as user with pass; NULL for either one means the
+ * anonymous defaults
+ */
 BOOLEAN
-ftp_login(CONN *C, URL U)
+ftp_login(CONN *C, const char *user, const char *pass)
 {
   int  code = 120;
   char tmp[128]; 
@@ -53,14 +57,14 @@ ftp_login(CONN *C, URL U)
     return FALSE;
   }
 
-  snprintf(tmp, sizeof(tmp), "%s", (url_get_username(U)==NULL)?"anonymous":url_get_username(U));
+  snprintf(tmp, sizeof(tmp), "%s", (user==NULL)?"anonymous":user);
   code = __request(C, "USER %s", tmp); 
   if (code != 331) {
     if (okay(code)) return TRUE; 
   }
 
   memset(tmp, '\0', sizeof(tmp));
-  snprintf(tmp, sizeof(tmp), "%s", (url_get_password(U)==NULL)?"siege@joedog.org":url_get_password(U));
+  snprintf(tmp, sizeof(tmp), "%s", (pass==NULL)?"siege@joedog.org":pass);
   code = __request(C, "PASS %s", tmp);
   return __in_range(code, 200, 299);
 }
@@ -26,7 +26,7 @@
 #include <sock.h>
 #include <url.h>
 
-BOOLEAN ftp_login(CONN *C, URL U);
+BOOLEAN ftp_login(CONN *C, const char *user, const char *pass);
 BOOLEAN ftp_ascii(CONN *C);
 BOOLEAN ftp_binary(CONN *C);
 BOOLEAN ftp_size(CONN *C, URL U);
@@ -0,0 +1,437 @@
+/**
+ * Performance gates
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifdef  HAVE_CONFIG_H
+# include <config.h>
+#endif/*HAVE_CONFIG_H*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <setup.h>
+#include <gate.h>
+#include <hist.h>
+#include <timer.h>
+#include <util.h>
+#include <memory.h>
+#include <notify.h>
+#include <perl.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+#ifdef  HAVE_UNISTD_H
+# include <unistd.h>
+#endif/*HAVE_UNISTD_H*/
+
+typedef enum {
+  GATE_PCT,
+  GATE_RT,
+  GATE_RPS,
+  GATE_ERR,
+  GATE_AVAIL,
+  GATE_REGRESS
+} METRIC;
+
+typedef struct
+{
+  char    *text;
+  METRIC   metric;
+  float    pct;       /* for pNN                            */
+  BOOLEAN  less;      /* < or <=, else > or >=              */
+  BOOLEAN  equal;     /* <= or >=                           */
+  double   limit;     /* secs, trans/sec, percent or count  */
+  double   value;
+  BOOLEAN  passed;
+  char     shown[32];
+} TERM;
+
+struct GATE_T
+{
+  TERM     *terms;
+  int       count;
+  int       window;
+  HISTORY   history;
+  HIST      hist;
+  BOOLEAN   running;
+  pthread_t thread;
+  int       tripped;  /* the term that ended the run, or -1 */
+  double    seen;     /* its value over the window          */
+  char      shown[32];
+};
+
+private BOOLEAN __term(TERM *T, const char *str);
+private BOOLEAN __passes(TERM *T, double value);
+private int     __code(TERM *T);
+private void    __show(TERM *T, double value, char *buf, size_t len);
+private void *  __watcher(void *arg);
+private double  __error_rate(unsigned long hits, unsigned long errors, unsigned long failed);
+
+GATE
+new_gate(ARRAY terms, int window)
+{
+  int  i;
+  GATE this;
+
+  this = xcalloc(sizeof(struct GATE_T), 1);
+  this->window  = (window < 0) ? 0 : window;
+  this->tripped = -1;
+  this->hist    = new_hist();
+  this->terms   = xcalloc(sizeof(TERM), (array_length(terms) > 0) ? array_length(terms) : 1);
+  for (i = 0; i < (int)array_length(terms); i++) {
+    char *str = (char *)array_get(terms, i);
+    if (__term(&this->terms[i], str) == FALSE) {
+      NOTIFY(ERROR, "assert: unable to parse '%s', ex: --assert=\"p95<200ms\"", str);
+      this->count = i;
+      return gate_destroy(this);
+    }
+    this->count = i + 1;
+  }
+  return this;
+}
+
+GATE
+gate_destroy(GATE this)
+{
+  int i;
+
+  if (this == NULL) return NULL;
+
+  gate_stop(this);
+  for (i = 0; i < this->count; i++) {
+    xfree(this->terms[i].text);
+  }
+  xfree(this->terms);
+  this->hist = hist_destroy(this->hist);
+  xfree(this);
+  return NULL;
+}
+
+/**
+ * Watches HISTORY's last window seconds until gate_stop; without
+ * a window there's nothing to watch.
+ */
+void
+gate_start(GATE this, HISTORY history)
+{
+  int res;
+
+  if (this == NULL || this->window < 1 || history == NULL) return;
+
+  this->history = history;
+  if ((res = pthread_create(&this->thread, NULL, __watcher, this)) != 0) {
+    NOTIFY(FATAL, "assert: failed to create its thread: %d", res);
+  }
+  this->running = TRUE;
+}
+
+void
+gate_stop(GATE this)
+{
+  if (this == NULL || ! this->running) return;
+
+  pthread_cancel(this->thread);
+  pthread_join(this->thread, NULL);
+  this->running = FALSE;
+}
+
+/**
+ * Checks every term against the whole run; returns GATE_PASSED
+ * or the code of the first term that failed. A run that ended
+ * early failed on the term that ended it, whatever its total.
+ */
+int
+gate_check(GATE this, DATA data, int regressions)
+{
+  int           i;
+  int           code     = GATE_PASSED;
+  unsigned long count    = data_get_count(data);
+  unsigned long attempts = count + my.failed;
+  double        value    = 0;
+  TERM         *T;
+
+  if (this == NULL) return GATE_PASSED;
+
+  data_get_elapsed(data); /* the rate is from the last elapsed */
+  for (i = 0; i < this->count; i++) {
+    T = &this->terms[i];
+    switch (T->metric) {
+      case GATE_PCT:
+        value = data_get_percentile(data, T->pct);
+        break;
+      case GATE_RT:
+        value = data_get_response_time(data);
+        break;
+      case GATE_RPS:
+        value = data_get_transaction_rate(data);
+        break;
+      case GATE_ERR:
+        value = __error_rate(count, data_get_fail(data) + my.failed, my.failed);
+        break;
+      case GATE_AVAIL:
+        value = (attempts == 0) ? 0 : 100.0 * count / attempts;
+        break;
+      case GATE_REGRESS:
+        value = regressions;
+        break;
+    }
+    T->value  = value;
+    T->passed = __passes(T, value) && i != this->tripped;
+    __show(T, value, T->shown, sizeof(T->shown));
+    if (! T->passed && code == GATE_PASSED) {
+      code = __code(T);
+    }
+  }
+  if (this->tripped >= 0) {
+    code = __code(&this->terms[this->tripped]);
+  }
+  return code;
+}
+
+int
+gate_get_terms(GATE this)
+{
+  return (this == NULL) ? 0 : this->count;
+}
+
+/**
+ * The term as it was given; VALUE is the run's in secs, trans/sec,
+ * percent or a count and SHOWN is the same for people.
+ */
+char *
+gate_get_term(GATE this, int index, double *value, char **shown, BOOLEAN *passed)
+{
+  TERM *T;
+
+  if (this == NULL || index < 0 || index >= this->count) return NULL;
+
+  T = &this->terms[index];
+  if (value  != NULL) *value  = T->value;
+  if (shown  != NULL) *shown  = T->shown;
+  if (passed != NULL) *passed = T->passed;
+  return T->text;
+}
+
+/**
+ * The term that ended the run early, or NULL; SECS is the window
+ * and SHOWN what it measured over it.
+ */
+char *
+gate_get_abort(GATE this, int *secs, char **shown)
+{
+  if (this == NULL || this->tripped < 0) return NULL;
+
+  if (secs  != NULL) *secs  = this->window;
+  if (shown != NULL) *shown = this->shown;
+  return this->terms[this->tripped].text;
+}
+
+/**
+ * metric op limit: pNN, rt, rps, errors, availability or regressions;
+ * <, <=, > or >=; then a number and, for times, ms or s
+ */
+private BOOLEAN
+__term(TERM *T, const char *str)
+{
+  char  *tmp;
+  char  *name;
+  char  *p;
+  char  *end;
+  double n;
+  BOOLEAN okay = TRUE;
+
+  memset(T, '\0', sizeof(TERM));
+  T->text = xstrdup(str);
+  tmp     = xstrdup(str);
+  if ((p = strpbrk(tmp, "<>")) == NULL) {
+    xfree(tmp);
+    return FALSE;
+  }
+  T->less  = (*p == '<');
+  T->equal = (p[1] == '=');
+  n = strtod(p + (T->equal ? 2 : 1), &end);
+  if (end == p + (T->equal ? 2 : 1) || n < 0) {
+    xfree(tmp);
+    return FALSE;
+  }
+  end  = trim(end);
+  *p   = '\0';
+  name = trim(tmp);
+
+  if (strmatch(name, "rt") || name[0] == 'p' || name[0] == 'P') {
+    if (strmatch(name, "rt")) {
+      T->metric = GATE_RT;
+    } else {
+      T->metric = GATE_PCT;
+      T->pct    = strtod(name + 1, &p);
+      okay      = (T->pct > 0 && T->pct <= 100 && *p == '\0');
+    }
+    if (*end == '\0' || strmatch(end, "ms")) {
+      T->limit = n / 1000;
+    } else if (strmatch(end, "s")) {
+      T->limit = n;
+    } else {
+      okay = FALSE;
+    }
+  } else if (strmatch(name, "rps") || strmatch(name, "rate")) {
+    T->metric = GATE_RPS;
+    T->limit  = n;
+    okay      = (*end == '\0');
+  } else if (strmatch(name, "errors") || strmatch(name, "availability")) {
+    T->metric = (strmatch(name, "errors")) ? GATE_ERR : GATE_AVAIL;
+    T->limit  = n;
+    okay      = (*end == '\0' || strcmp(end, "%") == 0);
+  } else if (strmatch(name, "regressions")) {
+    T->metric = GATE_REGRESS;
+    T->limit  = n;
+    okay      = (*end == '\0');
+  } else {
+    okay = FALSE;
+  }
+  xfree(tmp);
+  return okay;
+}
+
+/**
+ * Errors are the failed transactions (failed) and the responses
+ * that failed but count as transactions (hits); each attempt is
+ * one or the other, so it's counted once.
+ */
+private double
+__error_rate(unsigned long hits, unsigned long errors, unsigned long failed)
+{
+  return (hits + failed == 0) ? 0 : 100.0 * errors / (hits + failed);
+}
+
+private BOOLEAN
+__passes(TERM *T, double value)
+{
+  if (T->less) {
+    return (T->equal) ? value <= T->limit : value < T->limit;
+  }
+  return (T->equal) ? value >= T->limit : value > T->limit;
+}
+
+private int
+__code(TERM *T)
+{
+  switch (T->metric) {
+    case GATE_PCT:
+    case GATE_RT:
+      return GATE_LATENCY;
+    case GATE_RPS:
+      return GATE_THROUGHPUT;
+    case GATE_REGRESS:
+      return GATE_REGRESSION;
+    default:
+      return GATE_ERRORS;
+  }
+}
+
+private void
+__show(TERM *T, double value, char *buf, size_t len)
+{
+  switch (T->metric) {
+    case GATE_PCT:
+    case GATE_RT:
+      snprintf(buf, len, "%.2f ms", value * 1000);
+      break;
+    case GATE_RPS:
+      snprintf(buf, len, "%.2f trans/sec", value);
+      break;
+    case GATE_ERR:
+    case GATE_AVAIL:
+      snprintf(buf, len, "%.2f %%", value);
+      break;
+    case GATE_REGRESS:
+      snprintf(buf, len, "%.0f", value);
+      break;
+  }
+}
+
+/**
+ * Once a second, once there's a window's worth: the first term
+ * the window fails ends the run the way -t does. Cancel is only
+ * enabled while we sleep.
+ */
+private void *
+__watcher(void *arg)
+{
+  int           i;
+  float         secs;
+  unsigned long hits;
+  unsigned long errors;
+  unsigned long failed;
+  double        value;
+  TERM         *T;
+  GATE          this = (GATE)arg;
+
+  pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+  while (TRUE) {
+    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+    pthread_sleep_np(1);
+    pthread_testcancel();
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+    /**
+     * Nothing's counted in the warm-up or the cool-down; we
+     * wait for a whole window of the part that is.
+     */
+    if (! timer_steady() || timer_elapsed() < my.warmup + this->window) {
+      continue;
+    }
+    if (! history_get_window(this->history, this->window, &secs, &hits, &errors, &failed, this->hist)) {
+      continue;
+    }
+    for (i = 0; i < this->count; i++) {
+      T = &this->terms[i];
+      switch (T->metric) {
+        case GATE_PCT:
+          if (hist_get_count(this->hist) == 0) continue;
+          value = hist_get_percentile(this->hist, T->pct);
+          break;
+        case GATE_RPS:
+          value = (secs > 0) ? hits / secs : 0;
+          break;
+        case GATE_ERR:
+          value = __error_rate(hits, errors, failed);
+          break;
+        case GATE_AVAIL:
+          value = (hits + failed == 0) ? 0 : 100.0 * hits / (hits + failed);
+          break;
+        default:
+          continue;
+      }
+      if (__passes(T, value)) continue;
+
+      this->tripped = i;
+      this->seen    = value;
+      __show(T, value, this->shown, sizeof(this->shown));
+      errno = 0;
+      NOTIFY(WARNING, "assert: %s failed for %d seconds (%s); ending the run", T->text, this->window, this->shown);
+      kill(getpid(), SIGTERM);
+      return NULL;
+    }
+  }
+  return NULL;
+}
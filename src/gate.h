@@ -0,0 +1,65 @@
+/**
+ * Performance gates
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifndef __GATE_H
+#define __GATE_H
+
+#include <stdlib.h>
+#include <array.h>
+#include <data.h>
+#include <history.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+/**
+ * --assert="p95<200ms" --assert="rps>1500" --assert="errors<0.5%"
+ *
+ * Pass or fail for CI. A term is a metric, <, <=, > or >= and a
+ * limit: pNN and rt (the mean) are in ms unless they end in s,
+ * rps is trans/sec, errors and availability are percent and
+ * regressions counts what --compare flagged. When the run is
+ * over we check each term against it and siege exits with the
+ * code of the first one that failed (GATE_* below).
+ *
+ * With a window we also check them once a second against the
+ * last window seconds (see history_get_window) and end the run
+ * the first time one fails, so a broken build doesn't take all
+ * of -t to say so. rt and regressions are only checked at the end.
+ */
+#define GATE_PASSED      0
+#define GATE_ERRORS      2   /* errors or availability */
+#define GATE_LATENCY     3   /* pNN or rt              */
+#define GATE_THROUGHPUT  4   /* rps                    */
+#define GATE_REGRESSION  5   /* regressions            */
+
+typedef struct GATE_T *GATE;
+
+GATE    new_gate(ARRAY terms, int window);
+GATE    gate_destroy(GATE this);
+void    gate_start(GATE this, HISTORY history);
+void    gate_stop(GATE this);
+int     gate_check(GATE this, DATA data, int regressions);
+int     gate_get_terms(GATE this);
+char *  gate_get_term(GATE this, int index, double *value, char **shown, BOOLEAN *passed);
+char *  gate_get_abort(GATE this, int *secs, char **shown);
+
+#endif/*__GATE_H*/
@@ -32,6 +32,8 @@
 #include <handler.h> 
 #include <util.h>
 #include <crew.h>
+#include <timer.h>
+#include <browser.h>
 #include <joedog/boolean.h>
 
 void
@@ -58,6 +60,7 @@ void
 {
   CREW crew = (CREW)arg;
   int gotsig = 0; 
+  int x;
   sigset_t  sigs;
  
   sigemptyset(&sigs);
@@ -71,21 +74,29 @@ void
    */
   sigwait(&sigs, &gotsig);
   
-  if (gotsig == SIGTERM && my.secs <= 0 && crew_get_shutdown(crew) == TRUE) {
+  /**
+   * main stops the timer and signals us after crew_join;
+   * the users are done
+   */
+  if (timer_stopping()) {
     return NULL;
   }
 
-  if (!my.quiet) {
+  if (!my.quiet && my.worker < 0) {
     fprintf(stderr, "\nLifting the server siege...");
   }
-  crew_cancel(crew);
 
   /**
-   * The signal consistently arrives early,
-   * so we artificially extend the life of
-   * the siege to make up the discrepancy. 
+   * The users stop between requests. The ones with a request in
+   * flight get my.grace seconds to finish it; after that we cancel
+   * them and they're counted as aborted at the deadline.
    */
-  pthread_usleep_np(501125); 
+  timer_stop();
+  crew_set_shutdown(crew, TRUE);
+  for (x = 0; x < my.grace * 100 && crew_get_active(crew) > 0 && browser_get_inflight() > 0; x++) {
+    pthread_usleep_np(10000);
+  }
+  crew_cancel(crew);
   return NULL;
 }
 
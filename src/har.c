@@ -0,0 +1,821 @@
+/**
+ * HAR import
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifdef  HAVE_CONFIG_H
+# include <config.h>
+#endif/*HAVE_CONFIG_H*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <setup.h>
+#include <har.h>
+#include <hist.h>
+#include <date.h>
+#include <util.h>
+#include <memory.h>
+#include <notify.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+#ifdef  HAVE_UNISTD_H
+# include <unistd.h>
+#endif/*HAVE_UNISTD_H*/
+
+typedef struct
+{
+  int    index;   /* in the URL array */
+  int    wave;
+  double start;
+  double end;
+} REQUEST;
+
+typedef struct
+{
+  char         *id;
+  char         *name;    /* the URL of its first request */
+  REQUEST      *reqs;
+  int           length;
+  int           size;
+  int           waves;
+  unsigned long loads;
+  unsigned long failed;
+  float         highest;
+  HIST          hist;    /* the loads that didn't fail */
+} PAGE;
+
+struct HAR_T
+{
+  PAGE           *pages;
+  int             length;
+  int             size;
+  unsigned long   skipped;
+  pthread_mutex_t lock;
+};
+
+typedef struct
+{
+  const char *base;
+  const char *p;
+  const char *end;
+  size_t      done;  /* what we've given back of the map */
+  BOOLEAN     bad;
+} CURSOR;
+
+#define HAR_RELEASE (8 * 1024 * 1024)
+
+/**
+ * What we keep of an entry while we walk it
+ */
+typedef struct
+{
+  char   *page;
+  char   *url;
+  char   *method;
+  char   *headers;
+  size_t  hlen;
+  char   *mime;
+  char   *body;
+  size_t  blen;
+  double  start;
+  double  time;
+} ENTRY;
+
+/**
+ * Headers we send ourselves or that belong to the session that
+ * was recorded; siege's cookie jar and cache take care of those.
+ */
+private const char *__dropped[] = {
+  "host", "connection", "keep-alive", "proxy-connection", "te", "upgrade",
+  "transfer-encoding", "content-length", "content-type", "user-agent",
+  "accept-encoding", "cookie", "if-modified-since", "if-none-match", NULL
+};
+
+private void    __log(HAR this, CURSOR *c, ARRAY urls);
+private void    __entry(HAR this, CURSOR *c, ARRAY urls);
+private void    __request(CURSOR *c, ENTRY *E);
+private void    __headers(CURSOR *c, ENTRY *E);
+private void    __post(CURSOR *c, ENTRY *E);
+private void    __add(HAR this, ENTRY *E, ARRAY urls);
+private PAGE *  __page(HAR this, const char *id);
+private void    __waves(PAGE *P);
+private METHOD  __method(const char *name);
+private BOOLEAN __member(CURSOR *c, char *key, size_t len);
+private BOOLEAN __element(CURSOR *c);
+private void    __value(CURSOR *c);
+private char *  __text(CURSOR *c, size_t *len);
+private double  __number(CURSOR *c);
+private int     __utf8(char *q, unsigned int u);
+private void    __ws(CURSOR *c);
+private void    __release(CURSOR *c);
+private int     __by_start(const void *a, const void *b);
+private int     __by_wave(const void *a, const void *b);
+
+HAR
+new_har(const char *file, ARRAY urls)
+{
+  int         i;
+  int         fd;
+  long        at;
+  char       *map;
+  size_t      size;
+  struct stat st;
+  CURSOR      c;
+  HAR         this;
+
+  if ((fd = open(file, O_RDONLY)) < 0) {
+    NOTIFY(ERROR, "har: unable to open %s", file);
+    return NULL;
+  }
+  if (fstat(fd, &st) < 0 || st.st_size == 0) {
+    errno = 0;
+    NOTIFY(ERROR, "har: %s is empty", file);
+    close(fd);
+    return NULL;
+  }
+  size = (size_t)st.st_size;
+  map  = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    NOTIFY(ERROR, "har: unable to map %s", file);
+    return NULL;
+  }
+#ifdef  MADV_SEQUENTIAL
+  madvise(map, size, MADV_SEQUENTIAL);
+#endif/*MADV_SEQUENTIAL*/
+
+  this = xcalloc(sizeof(struct HAR_T), 1);
+  pthread_mutex_init(&this->lock, NULL);
+  c.base = map;
+  c.p    = map;
+  c.end  = map + size;
+  c.done = 0;
+  c.bad  = FALSE;
+  __log(this, &c, urls);
+  at = (long)(c.p - map);
+  munmap(map, size);
+
+  if (c.bad) {
+    errno = 0;
+    NOTIFY(ERROR, "har: %s isn't a HAR file (at byte %ld)", file, at);
+    return har_destroy(this);
+  }
+  if (this->length == 0) {
+    errno = 0;
+    NOTIFY(ERROR, "har: %s has no HTTP requests", file);
+    return har_destroy(this);
+  }
+  for (i = 0; i < this->length; i++) {
+    __waves(&this->pages[i]);
+  }
+  return this;
+}
+
+HAR
+har_destroy(HAR this)
+{
+  int i;
+
+  if (this == NULL) return NULL;
+
+  for (i = 0; i < this->length; i++) {
+    xfree(this->pages[i].id);
+    xfree(this->pages[i].name);
+    xfree(this->pages[i].reqs);
+    hist_destroy(this->pages[i].hist);
+  }
+  xfree(this->pages);
+  pthread_mutex_destroy(&this->lock);
+  xfree(this);
+  return NULL;
+}
+
+int
+har_get_pages(HAR this)
+{
+  return (this == NULL) ? 0 : this->length;
+}
+
+int
+har_get_length(HAR this, int page)
+{
+  return this->pages[page].length;
+}
+
+int
+har_get_waves(HAR this, int page)
+{
+  return this->pages[page].waves;
+}
+
+/**
+ * The index in the URL array of a page's request, in the order
+ * we send them, and its wave
+ */
+int
+har_get_entry(HAR this, int page, int index, int *wave)
+{
+  REQUEST *R = &this->pages[page].reqs[index];
+
+  if (wave != NULL) {
+    *wave = R->wave;
+  }
+  return R->index;
+}
+
+unsigned long
+har_get_skipped(HAR this)
+{
+  return (this == NULL) ? 0 : this->skipped;
+}
+
+/**
+ * A page load took secs; it failed if any of its requests did
+ */
+void
+har_record(HAR this, int page, float secs, BOOLEAN okay)
+{
+  PAGE *P = &this->pages[page];
+
+  pthread_mutex_lock(&this->lock);
+  P->loads++;
+  if (! okay) {
+    P->failed++;
+  } else {
+    hist_record(P->hist, secs);
+    if (secs > P->highest) {
+      P->highest = secs;
+    }
+  }
+  pthread_mutex_unlock(&this->lock);
+}
+
+/**
+ * Returns the page's name and its load times in secs
+ */
+char *
+har_get_page(HAR this, int page, unsigned long *loads, unsigned long *failed, float *p50, float *p90, float *highest)
+{
+  PAGE *P = &this->pages[page];
+
+  *loads   = P->loads;
+  *failed  = P->failed;
+  *highest = P->highest;
+  *p50     = hist_get_percentile(P->hist, 50);
+  *p90     = hist_get_percentile(P->hist, 90);
+  /* the histogram's buckets are a few percent wide */
+  *p50     = (*p50 > *highest) ? *highest : *p50;
+  *p90     = (*p90 > *highest) ? *highest : *p90;
+  return P->name;
+}
+
+/**
+ * { "log": { ..., "entries": [ ... ] } }; we don't need "pages"
+ * since each entry names its own
+ */
+private void
+__log(HAR this, CURSOR *c, ARRAY urls)
+{
+  char key[32];
+
+  while (__member(c, key, sizeof(key))) {
+    if (strmatch(key, "log")) {
+      while (__member(c, key, sizeof(key))) {
+        if (strmatch(key, "entries")) {
+          while (__element(c)) {
+            __entry(this, c, urls);
+            __release(c);
+          }
+        } else {
+          __value(c);
+        }
+      }
+    } else {
+      __value(c);
+    }
+  }
+}
+
+private void
+__entry(HAR this, CURSOR *c, ARRAY urls)
+{
+  char  key[32];
+  char *str;
+  ENTRY E;
+
+  memset(&E, '\0', sizeof(ENTRY));
+  E.start = -1;
+  while (__member(c, key, sizeof(key))) {
+    if (strmatch(key, "pageref") && *c->p == '"') {
+      E.page = __text(c, NULL);
+    } else if (strmatch(key, "startedDateTime") && *c->p == '"') {
+      str     = __text(c, NULL);
+      E.start = isototime(str);
+      xfree(str);
+    } else if (strmatch(key, "time")) {
+      E.time  = __number(c);
+    } else if (strmatch(key, "request") && *c->p == '{') {
+      __request(c, &E);
+    } else {
+      __value(c);
+    }
+  }
+  if (! c->bad) {
+    __add(this, &E, urls);
+  }
+  xfree(E.page);
+  xfree(E.url);
+  xfree(E.method);
+  xfree(E.headers);
+  xfree(E.mime);
+  xfree(E.body);
+}
+
+private void
+__request(CURSOR *c, ENTRY *E)
+{
+  char key[32];
+
+  while (__member(c, key, sizeof(key))) {
+    if (strmatch(key, "method") && *c->p == '"') {
+      E->method = __text(c, NULL);
+    } else if (strmatch(key, "url") && *c->p == '"') {
+      E->url = __text(c, NULL);
+    } else if (strmatch(key, "headers") && *c->p == '[') {
+      __headers(c, E);
+    } else if (strmatch(key, "postData") && *c->p == '{') {
+      __post(c, E);
+    } else {
+      __value(c);
+    }
+  }
+}
+
+/**
+ * [{"name": "Accept", "value": "text/html"}, ...] becomes the
+ * lines we add to the request
+ */
+private void
+__headers(CURSOR *c, ENTRY *E)
+{
+  int    i;
+  char   key[32];
+  char  *name;
+  char  *value;
+  size_t len;
+  BOOLEAN keep;
+
+  while (__element(c)) {
+    name  = NULL;
+    value = NULL;
+    while (__member(c, key, sizeof(key))) {
+      if (strmatch(key, "name") && *c->p == '"') {
+        name  = __text(c, NULL);
+      } else if (strmatch(key, "value") && *c->p == '"') {
+        value = __text(c, NULL);
+      } else {
+        __value(c);
+      }
+    }
+    keep = (name != NULL && value != NULL && name[0] != ':' && strpbrk(value, "\r\n") == NULL);
+    for (i = 0; keep && __dropped[i] != NULL; i++) {
+      keep = ! strmatch(name, __dropped[i]);
+    }
+    if (keep) {
+      len = strlen(name) + strlen(value) + 5;
+      E->headers = xrealloc(E->headers, E->hlen + len);
+      snprintf(E->headers + E->hlen, len, "%s: %s\015\012", name, value);
+      E->hlen += len - 1;
+    }
+    xfree(name);
+    xfree(value);
+  }
+}
+
+/**
+ * The body is in "text"; "params" is the same thing, parsed
+ */
+private void
+__post(CURSOR *c, ENTRY *E)
+{
+  char key[32];
+
+  while (__member(c, key, sizeof(key))) {
+    if (strmatch(key, "mimeType") && *c->p == '"') {
+      E->mime = __text(c, NULL);
+    } else if (strmatch(key, "text") && *c->p == '"') {
+      E->body = __text(c, &E->blen);
+    } else {
+      __value(c);
+    }
+  }
+}
+
+/**
+ * The entry becomes a URL at the end of the array and a request
+ * of its page. We skip what we can't send: data: and ws: URLs,
+ * CONNECT and the like.
+ */
+private void
+__add(HAR this, ENTRY *E, ARRAY urls)
+{
+  URL      U;
+  PAGE    *P;
+  REQUEST *R;
+  METHOD   method = (E->method == NULL) ? GET : __method(E->method);
+
+  if (E->url == NULL || E->start < 0 || method == NOMETHOD ||
+      (strncasecmp(E->url, "http://", 7) != 0 && strncasecmp(E->url, "https://", 8) != 0)) {
+    this->skipped++;
+    return;
+  }
+  if ((U = new_url(E->url)) == NULL || url_get_hostname(U) == NULL) {
+    url_destroy(U);
+    this->skipped++;
+    return;
+  }
+  url_set_ID(U, array_length(urls));
+  url_set_method(U, method);
+  if (E->headers != NULL) {
+    url_set_headers(U, E->headers);
+  }
+  if (E->body != NULL) {
+    url_set_postdata(U, E->body, E->blen);
+    if (E->mime != NULL && E->mime[0] != '\0') {
+      url_set_conttype(U, E->mime);
+    }
+  }
+  /* the array keeps a copy of the URL; its strings are still ours */
+  array_npush(urls, U, URLSIZE);
+  xfree(U);
+
+  P = __page(this, (E->page == NULL) ? "" : E->page);
+  if (P->name == NULL) {
+    P->name = xstrdup(E->url);
+  }
+  if (P->length == P->size) {
+    P->size = (P->size == 0) ? 16 : P->size * 2;
+    P->reqs = xrealloc(P->reqs, P->size * sizeof(REQUEST));
+  }
+  R = &P->reqs[P->length++];
+  R->index = array_length(urls) - 1;
+  R->wave  = 0;
+  R->start = E->start;
+  R->end   = E->start + ((E->time > 0) ? E->time / 1000 : 0);
+}
+
+/**
+ * Entries come in page by page, so we look from the end
+ */
+private PAGE *
+__page(HAR this, const char *id)
+{
+  int   i;
+  PAGE *P;
+
+  for (i = this->length - 1; i >= 0; i--) {
+    if (strcmp(this->pages[i].id, id) == 0) {
+      return &this->pages[i];
+    }
+  }
+  if (this->length == this->size) {
+    this->size  = (this->size == 0) ? 8 : this->size * 2;
+    this->pages = xrealloc(this->pages, this->size * sizeof(PAGE));
+  }
+  P = &this->pages[this->length++];
+  memset(P, '\0', sizeof(PAGE));
+  P->id   = xstrdup(id);
+  P->hist = new_hist();
+  return P;
+}
+
+/**
+ * A request goes in the wave after the latest of the ones that
+ * finished before it started; the ones that hadn't finished it
+ * can't have been waiting for. Then we sort them by wave.
+ */
+private void
+__waves(PAGE *P)
+{
+  int i;
+  int j;
+
+  qsort(P->reqs, P->length, sizeof(REQUEST), __by_start);
+  P->waves = 0;
+  for (i = 0; i < P->length; i++) {
+    for (j = 0; j < i; j++) {
+      if (P->reqs[j].end <= P->reqs[i].start && P->reqs[j].wave >= P->reqs[i].wave) {
+        P->reqs[i].wave = P->reqs[j].wave + 1;
+      }
+    }
+    if (P->reqs[i].wave >= P->waves) {
+      P->waves = P->reqs[i].wave + 1;
+    }
+  }
+  qsort(P->reqs, P->length, sizeof(REQUEST), __by_wave);
+}
+
+private METHOD
+__method(const char *name)
+{
+  int i;
+  static const struct {
+    const char *name;
+    METHOD      method;
+  } methods[] = {
+    {"GET", GET}, {"HEAD", HEAD}, {"POST", POST}, {"PUT", PUT},
+    {"DELETE", DELETE}, {"OPTIONS", OPTIONS}, {"PATCH", PATCH}
+  };
+
+  for (i = 0; i < (int)(sizeof(methods) / sizeof(methods[0])); i++) {
+    if (strmatch(name, methods[i].name)) {
+      return methods[i].method;
+    }
+  }
+  return NOMETHOD;
+}
+
+/**
+ * Steps into an object or on to its next member, copies its
+ * key (cut to len) and leaves us at the value, which the caller
+ * has to read or skip. FALSE at the end of the object; on an
+ * error it sets bad.
+ */
+private BOOLEAN
+__member(CURSOR *c, char *key, size_t len)
+{
+  char *str;
+
+  __ws(c);
+  if (c->bad || c->p >= c->end || (*c->p != '{' && *c->p != ',' && *c->p != '}')) {
+    c->bad = TRUE;
+    return FALSE;
+  }
+  if (*c->p++ == '}') return FALSE;
+  __ws(c);
+  if (c->p < c->end && *c->p == '}') {
+    c->p++;
+    return FALSE;
+  }
+  if ((str = __text(c, NULL)) == NULL) return FALSE;
+  snprintf(key, len, "%s", str);
+  xfree(str);
+  __ws(c);
+  if (c->p >= c->end || *c->p != ':') {
+    c->bad = TRUE;
+    return FALSE;
+  }
+  c->p++;
+  __ws(c);
+  if (c->p >= c->end) {
+    c->bad = TRUE;
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/**
+ * Like __member for the elements of an array
+ */
+private BOOLEAN
+__element(CURSOR *c)
+{
+  __ws(c);
+  if (c->bad || c->p >= c->end || (*c->p != '[' && *c->p != ',' && *c->p != ']')) {
+    c->bad = TRUE;
+    return FALSE;
+  }
+  if (*c->p++ == ']') return FALSE;
+  __ws(c);
+  if (c->p >= c->end) {
+    c->bad = TRUE;
+    return FALSE;
+  }
+  if (*c->p == ']') {
+    c->p++;
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/**
+ * Skips a value; this is where the responses go
+ */
+private void
+__value(CURSOR *c)
+{
+  int depth = 0;
+
+  if (c->p >= c->end) {
+    c->bad = TRUE;
+    return;
+  }
+  if (*c->p != '{' && *c->p != '[' && *c->p != '"') {
+    while (c->p < c->end && strchr(",}] \t\r\n", *c->p) == NULL) c->p++;
+    return;
+  }
+  do {
+    switch (*c->p) {
+      case '{':
+      case '[':
+        depth++;
+        break;
+      case '}':
+      case ']':
+        depth--;
+        break;
+      case '"':
+        for (c->p++; c->p < c->end && *c->p != '"'; c->p++) {
+          if (*c->p == '\\' && c->p + 1 < c->end) c->p++;
+        }
+        break;
+    }
+    c->p++;
+  } while (depth > 0 && c->p < c->end);
+  if (depth > 0 || c->p > c->end) {
+    c->bad = TRUE;
+  }
+}
+
+/**
+ * Decodes the string we're at into an allocated copy; it's no
+ * longer than it was with its escapes
+ */
+private char *
+__text(CURSOR *c, size_t *len)
+{
+  const char  *p;
+  char        *str;
+  char        *q;
+  unsigned int u;
+  unsigned int v;
+
+  if (c->p >= c->end || *c->p != '"') {
+    c->bad = TRUE;
+    return NULL;
+  }
+  for (p = c->p + 1; p < c->end && *p != '"'; p++) {
+    if (*p == '\\') p++;
+  }
+  if (p >= c->end) {
+    c->bad = TRUE;
+    return NULL;
+  }
+
+  str = xmalloc(p - c->p);
+  for (q = str, c->p++; c->p < p; c->p++) {
+    if (*c->p != '\\') {
+      *q++ = *c->p;
+      continue;
+    }
+    switch (*++c->p) {
+      case 'b': *q++ = '\b'; break;
+      case 'f': *q++ = '\f'; break;
+      case 'n': *q++ = '\n'; break;
+      case 'r': *q++ = '\r'; break;
+      case 't': *q++ = '\t'; break;
+      case 'u':
+        if (p - c->p < 5 || sscanf(c->p + 1, "%4x", &u) != 1) {
+          *q++ = '?';
+          break;
+        }
+        c->p += 4;
+        if (u >= 0xD800 && u < 0xDC00 && p - c->p >= 7 && c->p[1] == '\\' && c->p[2] == 'u' &&
+            sscanf(c->p + 3, "%4x", &v) == 1 && v >= 0xDC00 && v < 0xE000) {
+          u = 0x10000 + ((u - 0xD800) << 10) + (v - 0xDC00);
+          c->p += 6;
+        }
+        q += __utf8(q, u);
+        break;
+      default:  *q++ = *c->p; break;
+    }
+  }
+  c->p = p + 1;
+  *q   = '\0';
+  if (len != NULL) {
+    *len = q - str;
+  }
+  return str;
+}
+
+/**
+ * A number, or -1 if it's null or something else
+ */
+private double
+__number(CURSOR *c)
+{
+  char   buf[32];
+  char  *end;
+  size_t len = 0;
+  double num;
+
+  while (c->p + len < c->end && len < sizeof(buf) - 1 &&
+         c->p[len] != '\0' && strchr("+-.0123456789eE", c->p[len]) != NULL) {
+    len++;
+  }
+  memcpy(buf, c->p, len);
+  buf[len] = '\0';
+  num = strtod(buf, &end);
+  if (end == buf) {
+    __value(c);
+    return -1;
+  }
+  c->p += len;
+  return num;
+}
+
+private int
+__utf8(char *q, unsigned int u)
+{
+  if (u < 0x80) {
+    q[0] = (char)u;
+    return 1;
+  }
+  if (u < 0x800) {
+    q[0] = (char)(0xC0 | (u >> 6));
+    q[1] = (char)(0x80 | (u & 0x3F));
+    return 2;
+  }
+  if (u < 0x10000) {
+    q[0] = (char)(0xE0 | (u >> 12));
+    q[1] = (char)(0x80 | ((u >> 6) & 0x3F));
+    q[2] = (char)(0x80 | (u & 0x3F));
+    return 3;
+  }
+  q[0] = (char)(0xF0 | (u >> 18));
+  q[1] = (char)(0x80 | ((u >> 12) & 0x3F));
+  q[2] = (char)(0x80 | ((u >> 6) & 0x3F));
+  q[3] = (char)(0x80 | (u & 0x3F));
+  return 4;
+}
+
+private void
+__ws(CURSOR *c)
+{
+  while (c->p < c->end && (*c->p == ' ' || *c->p == '\t' || *c->p == '\r' || *c->p == '\n')) {
+    c->p++;
+  }
+}
+
+/**
+ * Gives back the pages we've walked past so a big file doesn't
+ * stay in memory; they're still in the file if we need them.
+ */
+private void
+__release(CURSOR *c)
+{
+#ifdef  MADV_DONTNEED
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  size_t done = ((size_t)(c->p - c->base) / page) * page;
+
+  if (done - c->done >= HAR_RELEASE) {
+    madvise((void *)(c->base + c->done), done - c->done, MADV_DONTNEED);
+    c->done = done;
+  }
+#endif/*MADV_DONTNEED*/
+}
+
+private int
+__by_start(const void *a, const void *b)
+{
+  const REQUEST *x = (const REQUEST *)a;
+  const REQUEST *y = (const REQUEST *)b;
+
+  if (x->start != y->start) return (x->start < y->start) ? -1 : 1;
+  return x->index - y->index;
+}
+
+private int
+__by_wave(const void *a, const void *b)
+{
+  const REQUEST *x = (const REQUEST *)a;
+  const REQUEST *y = (const REQUEST *)b;
+
+  if (x->wave != y->wave) return x->wave - y->wave;
+  return __by_start(a, b);
+}
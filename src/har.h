@@ -0,0 +1,54 @@
+/**
+ * HAR import
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifndef __HAR_H
+#define __HAR_H
+
+#include <stdlib.h>
+#include <array.h>
+#include <url.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+/**
+ * Page loads from a HAR file. Its requests (the method, URL,
+ * headers and body of each entry) are added to the URL array
+ * and each page keeps the ones it made, split into waves: a
+ * request is in the wave after the latest one that finished
+ * before the browser sent it, so it may depend on it, and the
+ * requests in a wave were sent together. The file is mapped and
+ * walked once; the responses, which are most of it, are never
+ * copied.
+ */
+typedef struct HAR_T *HAR;
+
+HAR      new_har(const char *file, ARRAY urls);
+HAR      har_destroy(HAR this);
+int      har_get_pages(HAR this);
+int      har_get_length(HAR this, int page);
+int      har_get_waves(HAR this, int page);
+int      har_get_entry(HAR this, int page, int index, int *wave);
+unsigned long har_get_skipped(HAR this);
+void     har_record(HAR this, int page, float secs, BOOLEAN okay);
+char *   har_get_page(HAR this, int page, unsigned long *loads, unsigned long *failed, float *p50, float *p90, float *highest);
+
+#endif/*__HAR_H*/
@@ -433,57 +433,3 @@ __lookup(HASH this, char *key)
   }
   return FALSE;
 }
-
-#if 0
-int
-main()
-{
-  HASH H = new_hash();
-  int  i = 0;
-  int  j;
-  char **keys;
-  int  len = 24;
-  char *simpsons[][2] = {
-    {"Homer",          "D'oh!!!"},
-    {"Homey",          "Whoo hoo!"},
-    {"Homer J.",       "Why, you little!"},
-    {"Marge",          "Hrrrrmph"},
-    {"Bart",           "Aye Caramba!"},
-    {"Lisa",           "I'll be in my room"},
-    {"Maggie",         "(pacifier suck)"},
-    {"Ned",            "Okily Dokily!"},
-    {"Moe",            "WhaaaAAAAT?!"},
-    {"Comic Book Guy", "Worst. Episode. Ever!"},
-    {"Waylon",         "That's Homer Simpson from sector 7G"},
-    {"Barnie",         "Brrraaarrp!"},
-    {"Krusty",         "Hey! Hey! Kids!"},
-    {"Frink",          "Glavin!"},
-    {"Burns",          "Release the hounds!"},
-    {"Nelson",         "Hah! Haw!"},
-    {"Dr. Nick",       "Hi, everybody!"},
-    {"Edna",           "Hah!"},
-    {"Helen",          "Think of the children!"},
-    {"Snake",          "Dude!"},
-    {"Chalmers",       "SKINNER!"},
-    {"Agnes",          "SEYMOUR!"},
-    {"Sea Cap'n",      "Yargh!"},
-    {"Sideshow Bob",   "Hello, Bart!"},
-  };
-
-  for (i = 0; i < len; i++) {
-    hash_add(H, simpsons[i][0], simpsons[i][1]);
-  }
-
-  keys = hash_get_keys(H);
-  for (j = 0; j < 100000; j++) {
-    for (i = 0; i < hash_get_entries(H); i ++){
-      char *tmp = (char*)hash_get(H, keys[i]);
-      printf("%16s => %s\n", keys[i], (tmp==NULL)?"NULL":tmp);
-    }
-  }
-  hash_free_keys(H, keys);
-  hash_destroy(H);
-  exit(0); 
-}
-#endif
-
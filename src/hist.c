@@ -0,0 +1,201 @@
+/**
+ * Latency histogram
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifdef  HAVE_CONFIG_H
+# include <config.h>
+#endif/*HAVE_CONFIG_H*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <hist.h>
+#include <memory.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+#define SUB_BITS  4
+#define SUB_COUNT (1 << SUB_BITS)
+
+struct HIST_T
+{
+  unsigned long count;
+  unsigned int  buckets[HIST_BUCKETS];
+};
+
+private int    __index(unsigned long long usecs);
+private double __value(int index);
+
+HIST
+new_hist()
+{
+  HIST this;
+
+  this = xcalloc(sizeof(struct HIST_T), 1);
+  return this;
+}
+
+HIST
+hist_destroy(HIST this)
+{
+  xfree(this);
+  return NULL;
+}
+
+/**
+ * Not locked; each browser records into its own and
+ * we merge them when the threads are done.
+ */
+void
+hist_record(HIST this, float secs)
+{
+  if (this == NULL || secs < 0) return;
+
+  this->buckets[__index((unsigned long long)(secs * 1000000.0 + 0.5))] += 1;
+  this->count += 1;
+}
+
+void
+hist_merge(HIST this, HIST that)
+{
+  if (this == NULL || that == NULL) return;
+
+  hist_add_buckets(this, that->buckets);
+}
+
+void
+hist_reset(HIST this)
+{
+  if (this == NULL) return;
+
+  memset(this, '\0', sizeof(struct HIST_T));
+}
+
+unsigned long
+hist_get_count(HIST this)
+{
+  return (this == NULL) ? 0 : this->count;
+}
+
+/**
+ * Returns the value at percentile pct (0-100) in seconds; it's
+ * the middle of the bucket that holds the pct-th transaction.
+ */
+float
+hist_get_percentile(HIST this, float pct)
+{
+  int           i;
+  double        want;
+  unsigned long rank;
+  unsigned long seen = 0;
+
+  if (this == NULL || this->count == 0) return 0.0;
+
+  if (pct <= 0)   pct = 0;
+  if (pct >= 100) pct = 100;
+  want = (double)pct / 100.0 * this->count;
+  rank = (unsigned long)want;
+  if ((double)rank < want) rank++;
+  if (rank < 1) rank = 1;
+
+  for (i = 0; i < HIST_BUCKETS; i++) {
+    seen += this->buckets[i];
+    if (seen >= rank) {
+      return (float)(__value(i) / 1000000.0);
+    }
+  }
+  return (float)(__value(HIST_BUCKETS - 1) / 1000000.0);
+}
+
+/**
+ * Copies the raw counts into buckets, which must hold
+ * HIST_BUCKETS; that's the form we ship between processes
+ */
+void
+hist_get_buckets(HIST this, unsigned int *buckets)
+{
+  if (this == NULL || buckets == NULL) return;
+
+  memcpy(buckets, this->buckets, sizeof(this->buckets));
+}
+
+void
+hist_add_buckets(HIST this, const unsigned int *buckets)
+{
+  int i;
+
+  if (this == NULL || buckets == NULL) return;
+
+  for (i = 0; i < HIST_BUCKETS; i++) {
+    this->buckets[i] += buckets[i];
+    this->count      += buckets[i];
+  }
+}
+
+/**
+ * The bucket secs falls in, for whoever keeps the raw counts
+ * themselves (see urlstats.c)
+ */
+int
+hist_bucket(float secs)
+{
+  if (secs < 0) secs = 0;
+  return __index((unsigned long long)(secs * 1000000.0 + 0.5));
+}
+
+/**
+ * Values under 16us get a bucket each; above that, every power
+ * of two gets SUB_COUNT buckets of equal width. Anything past
+ * the last bucket (about 12 days) is counted in it.
+ */
+private int
+__index(unsigned long long usecs)
+{
+  int msb = 0;
+  int index;
+  unsigned long long v = usecs;
+
+  if (usecs < SUB_COUNT) {
+    return (int)usecs;
+  }
+  while (v >>= 1) msb++;
+
+  index = SUB_COUNT * (msb - SUB_BITS + 1) + (int)((usecs >> (msb - SUB_BITS)) & (SUB_COUNT - 1));
+  return (index < HIST_BUCKETS) ? index : HIST_BUCKETS - 1;
+}
+
+private double
+__value(int index)
+{
+  int    msb;
+  int    sub;
+  double low;
+  double width;
+
+  if (index < SUB_COUNT) {
+    return (double)index;
+  }
+  msb   = index / SUB_COUNT + SUB_BITS - 1;
+  sub   = index % SUB_COUNT;
+  width = (double)(1ULL << (msb - SUB_BITS));
+  low   = (SUB_COUNT + sub) * width;
+  return low + width / 2;
+}
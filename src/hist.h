@@ -0,0 +1,54 @@
+/**
+ * Latency histogram
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifndef __HIST_H
+#define __HIST_H
+
+#include <stdlib.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+/**
+ * A log-linear latency histogram: every power of two is split
+ * into 16 buckets, so any value lands within ~6% of the truth.
+ * The buckets have fixed bounds, which makes two histograms
+ * mergeable by adding them up; that's what lets each browser,
+ * worker process or agent keep its own and us combine them
+ * into percentiles at the end. Values are kept in microseconds
+ * and we take and return seconds.
+ */
+#define HIST_BUCKETS 592
+
+typedef struct HIST_T *HIST;
+
+HIST          new_hist();
+HIST          hist_destroy(HIST this);
+void          hist_record(HIST this, float secs);
+void          hist_merge(HIST this, HIST that);
+void          hist_reset(HIST this);
+unsigned long hist_get_count(HIST this);
+float         hist_get_percentile(HIST this, float pct);
+void          hist_get_buckets(HIST this, unsigned int *buckets);
+void          hist_add_buckets(HIST this, const unsigned int *buckets);
+int           hist_bucket(float secs);
+
+#endif/*__HIST_H*/
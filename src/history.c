@@ -0,0 +1,847 @@
+/**
+ * Run history and comparison
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifdef  HAVE_CONFIG_H
+# include <config.h>
+#endif/*HAVE_CONFIG_H*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <setup.h>
+#include <history.h>
+#include <browser.h>
+#include <hist.h>
+#include <fault.h>
+#include <sock.h>
+#include <util.h>
+#include <memory.h>
+#include <notify.h>
+#include <version.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+#ifdef  HAVE_UNISTD_H
+# include <unistd.h>
+#endif/*HAVE_UNISTD_H*/
+
+#define PERIOD        1.0      /* seconds per interval */
+#define RESAMPLES     1000     /* bootstrap resamples */
+#define MIN_INTERVALS 5        /* fewer and we don't resample */
+#define METRICS       5        /* rate, p50, p90, p95, p99 */
+
+typedef struct
+{
+  unsigned int  index;
+  unsigned int  count;
+} BUCKET;
+
+typedef struct
+{
+  float         secs;
+  unsigned long hits;
+  unsigned long errors;      /* HTTP errors and failures */
+  unsigned long failed;      /* failures, no response    */
+  unsigned long faults[FAULTS];
+  int           nbuckets;
+  BUCKET       *buckets;
+} INTERVAL;
+
+typedef struct
+{
+  double        base;
+  double        current;
+  float         change;
+  float         low;
+  float         high;
+  char         *verdict;
+} ROW;
+
+struct HISTORY_T
+{
+  ARRAY         browsers;
+  BOOLEAN       running;
+  pthread_t     thread;
+  pthread_mutex_t lock;                /* for the intervals  */
+  double        when;                  /* the last snapshot  */
+  unsigned long hits;
+  unsigned long errors;
+  unsigned long failures;
+  unsigned long faults[FAULTS];
+  unsigned int  last[HIST_BUCKETS];
+  INTERVAL     *intervals;
+  int           count;
+  int           size;
+  unsigned long trans;                 /* the totals         */
+  unsigned long failed;
+  double        elapsed;
+  double        throughput;
+  double        response;
+  double        metric[METRICS];
+  unsigned int  hist[HIST_BUCKETS];
+  ROW           rows[METRICS];
+  int           nrows;
+};
+
+private char *__names[METRICS] = { "rate", "p50", "p90", "p95", "p99" };
+private float __pcts[METRICS]  = { 0, 50, 90, 95, 99 };
+
+private void    __snap(HISTORY this, unsigned long *hits, unsigned long *errors, unsigned long *failed, unsigned int *hist);
+private void    __interval(HISTORY this);
+private void *  __sampler(void *arg);
+private void    __totals(HISTORY this, DATA data);
+private void    __write(HISTORY this, FILE *fp, const char *date);
+private void    __string(FILE *fp, const char *str);
+private void    __pairs(FILE *fp, const unsigned int *hist);
+private char *  __value(char *line, const char *key, BOOLEAN first);
+private void    __buckets(char *str, unsigned int *hist);
+private void    __append(HISTORY this, float secs, unsigned long hits, unsigned long errors, unsigned long failed, const unsigned long *faults, const unsigned int *diff);
+private void    __bootstrap(HISTORY this, HISTORY base);
+private void    __resample(HISTORY this, HIST H, unsigned int *dense, unsigned long long *seed, double *out);
+private unsigned int __random(unsigned long long *seed);
+private int     __compare(const void *a, const void *b);
+private double  __now(void);
+
+HISTORY
+new_history()
+{
+  HISTORY this = xcalloc(sizeof(struct HISTORY_T), 1);
+  pthread_mutex_init(&this->lock, NULL);
+  return this;
+}
+
+HISTORY
+history_destroy(HISTORY this)
+{
+  int i;
+
+  if (this == NULL) return NULL;
+
+  history_stop(this);
+  for (i = 0; i < this->count; i++) {
+    xfree(this->intervals[i].buckets);
+  }
+  xfree(this->intervals);
+  pthread_mutex_destroy(&this->lock);
+  xfree(this);
+  return NULL;
+}
+
+/**
+ * Reads a record written by history_save. We only read our own
+ * files, so rather than parse JSON in general we look for the
+ * keys we wrote, one to a line.
+ */
+HISTORY
+history_load(const char *file)
+{
+  FILE        *fp;
+  HISTORY      this;
+  char        *line = NULL;
+  char        *val;
+  size_t       size = 0;
+  int          buckets = -1;
+  BOOLEAN      okay = FALSE;
+  unsigned int hist[HIST_BUCKETS];
+
+  if ((fp = fopen(file, "r")) == NULL) {
+    NOTIFY(ERROR, "compare: unable to open %s", file);
+    return NULL;
+  }
+
+  this = new_history();
+  while (getline(&line, &size, fp) != -1) {
+    if ((val = __value(line, "second", TRUE)) != NULL) {
+      float         secs   = 0;
+      unsigned long hits   = 0;
+      unsigned long errors = 0;
+      unsigned long failed = 0;
+      if ((val = __value(line, "seconds", FALSE)) != NULL)      secs   = atof(val);
+      if ((val = __value(line, "transactions", FALSE)) != NULL) hits   = strtoul(val, NULL, 10);
+      if ((val = __value(line, "errors", FALSE)) != NULL)       errors = strtoul(val, NULL, 10);
+      if ((val = __value(line, "failed", FALSE)) != NULL)       failed = strtoul(val, NULL, 10);
+      memset(hist, '\0', sizeof(hist));
+      if ((val = __value(line, "histogram", FALSE)) != NULL)    __buckets(val, hist);
+      __append(this, secs, hits, errors, failed, NULL, hist);
+    } else if ((val = __value(line, "buckets", TRUE)) != NULL) {
+      buckets = atoi(val);
+    } else if ((val = __value(line, "transactions", TRUE)) != NULL) {
+      this->trans = strtoul(val, NULL, 10);
+      okay = TRUE;
+    } else if ((val = __value(line, "failed_transactions", TRUE)) != NULL) {
+      this->failed = strtoul(val, NULL, 10);
+    } else if ((val = __value(line, "elapsed_time", TRUE)) != NULL) {
+      this->elapsed = atof(val);
+    } else if ((val = __value(line, "transaction_rate", TRUE)) != NULL) {
+      this->metric[0] = atof(val);
+    } else if ((val = __value(line, "throughput", TRUE)) != NULL) {
+      this->throughput = atof(val);
+    } else if ((val = __value(line, "response_time", TRUE)) != NULL) {
+      this->response = atof(val);
+    } else if ((val = __value(line, "response_time_p50", TRUE)) != NULL) {
+      this->metric[1] = atof(val);
+    } else if ((val = __value(line, "response_time_p90", TRUE)) != NULL) {
+      this->metric[2] = atof(val);
+    } else if ((val = __value(line, "response_time_p95", TRUE)) != NULL) {
+      this->metric[3] = atof(val);
+    } else if ((val = __value(line, "response_time_p99", TRUE)) != NULL) {
+      this->metric[4] = atof(val);
+    } else if ((val = __value(line, "histogram", TRUE)) != NULL) {
+      __buckets(val, this->hist);
+    }
+  }
+  xfree(line);
+  fclose(fp);
+
+  if (! okay) {
+    NOTIFY(ERROR, "compare: %s isn't a siege run record", file);
+    return history_destroy(this);
+  }
+  if (buckets != HIST_BUCKETS) {
+    NOTIFY(ERROR, "compare: %s was written by a siege with a different histogram", file);
+    return history_destroy(this);
+  }
+  return this;
+}
+
+/**
+ * Starts the intervals; the browsers haven't started yet so
+ * the first snapshot is where they begin.
+ */
+void
+history_start(HISTORY this, ARRAY browsers)
+{
+  int res;
+
+  if (this == NULL) return;
+
+  this->browsers = browsers;
+  this->when     = __now();
+  __snap(this, &this->hits, &this->errors, &this->failures, this->last);
+  fault_get_counts(this->faults);
+  if ((res = pthread_create(&this->thread, NULL, __sampler, this)) != 0) {
+    NOTIFY(FATAL, "history: failed to create its thread: %d", res);
+  }
+  this->running = TRUE;
+}
+
+/**
+ * Called after the browsers are done; what they did since the
+ * last whole second is the last interval if it's worth keeping.
+ */
+void
+history_stop(HISTORY this)
+{
+  if (this == NULL || ! this->running) return;
+
+  pthread_cancel(this->thread);
+  pthread_join(this->thread, NULL);
+  this->running = FALSE;
+  if (__now() - this->when >= PERIOD / 10) {
+    __interval(this);
+  }
+}
+
+/**
+ * Writes the record to DIR/YYYYmmdd-HHMMSS-PID.json and puts
+ * the name in PATH. The file appears whole or not at all.
+ */
+BOOLEAN
+history_save(HISTORY this, DATA data, const char *dir, char *path, size_t len)
+{
+  int        fd;
+  FILE      *fp;
+  time_t     now;
+  struct tm *tmp;
+#ifdef  HAVE_LOCALTIME_R
+  struct tm  keepsake;
+#endif/*HAVE_LOCALTIME_R*/
+  char       stamp[32];
+  char       date[32];
+  char       temp[4096];
+  BOOLEAN    okay;
+
+  if (this == NULL || dir == NULL) return FALSE;
+
+  __totals(this, data);
+  if (mkdir(dir, 0755) < 0 && errno != EEXIST) {
+    NOTIFY(ERROR, "history: unable to create %s", dir);
+    return FALSE;
+  }
+
+  now = time(NULL);
+#ifdef  HAVE_LOCALTIME_R
+  tmp = (struct tm *)localtime_r(&now, &keepsake);
+#else
+  tmp = localtime(&now);
+#endif/*HAVE_LOCALTIME_R*/
+  if (tmp == NULL || strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", tmp) == 0 ||
+      strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", tmp) == 0) {
+    snprintf(stamp, sizeof(stamp), "%ld", (long)now);
+    snprintf(date,  sizeof(date),  "%ld", (long)now);
+  }
+  snprintf(path, len, "%s/%s-%d.json", dir, stamp, (int)getpid());
+  snprintf(temp, sizeof(temp), "%s/.%s-%d.XXXXXX", dir, stamp, (int)getpid());
+
+  if ((fd = mkstemp(temp)) < 0) {
+    NOTIFY(ERROR, "history: unable to write to %s", dir);
+    return FALSE;
+  }
+  if ((fp = fdopen(fd, "w")) == NULL) {
+    NOTIFY(ERROR, "history: unable to write to %s", dir);
+    close(fd);
+    unlink(temp);
+    return FALSE;
+  }
+  fchmod(fd, 0644);
+  __write(this, fp, date);
+  okay = (fflush(fp) == 0 && fsync(fd) == 0);
+  okay = (fclose(fp) == 0) && okay;
+  if (! okay || rename(temp, path) < 0) {
+    NOTIFY(ERROR, "history: unable to write %s", path);
+    unlink(temp);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/**
+ * Compares this run to BASE; returns the number of metrics that
+ * regressed. Rows are in history_get_row.
+ */
+int
+history_compare(HISTORY this, DATA data, HISTORY base)
+{
+  int  i;
+  int  worse = 0;
+  ROW *R;
+
+  if (this == NULL || base == NULL) return 0;
+
+  __totals(this, data);
+  this->nrows = METRICS;
+  for (i = 0; i < METRICS; i++) {
+    R = &this->rows[i];
+    R->base    = base->metric[i];
+    R->current = this->metric[i];
+    R->change  = (R->base > 0) ? (float)(R->current / R->base - 1.0) * 100 : 0;
+    if (R->change > -0.005 && R->change < 0.005) {
+      R->change = 0;
+    }
+    R->low     = R->change;
+    R->high    = R->change;
+    R->verdict = "n/a";
+  }
+  if (this->count < MIN_INTERVALS || base->count < MIN_INTERVALS) {
+    return 0;
+  }
+
+  __bootstrap(this, base);
+  for (i = 0; i < METRICS; i++) {
+    R = &this->rows[i];
+    if ((i == 0) ? R->high < 0 : R->low > 0) {
+      R->verdict = "regressed";
+      worse++;
+    } else if ((i == 0) ? R->low > 0 : R->high < 0) {
+      R->verdict = "improved";
+    } else {
+      R->verdict = "same";
+    }
+  }
+  return worse;
+}
+
+/**
+ * Adds up the last SECS intervals; FALSE until there are that
+ * many. ERRORS are HTTP errors and failures; FAILED are the
+ * failures alone, the requests that got no response.
+ */
+BOOLEAN
+history_get_window(HISTORY this, int secs, float *elapsed, unsigned long *hits, unsigned long *errors, unsigned long *failed, HIST hist)
+{
+  int          i;
+  int          j;
+  unsigned int dense[HIST_BUCKETS];
+  INTERVAL    *I;
+
+  if (this == NULL || secs < 1) return FALSE;
+
+  pthread_mutex_lock(&this->lock);
+  if (this->count < secs) {
+    pthread_mutex_unlock(&this->lock);
+    return FALSE;
+  }
+  *elapsed = 0;
+  *hits    = 0;
+  *errors  = 0;
+  *failed  = 0;
+  memset(dense, '\0', sizeof(dense));
+  for (i = this->count - secs; i < this->count; i++) {
+    I = &this->intervals[i];
+    *elapsed += I->secs;
+    *hits    += I->hits;
+    *errors  += I->errors;
+    *failed  += I->failed;
+    for (j = 0; j < I->nbuckets; j++) {
+      dense[I->buckets[j].index] += I->buckets[j].count;
+    }
+  }
+  pthread_mutex_unlock(&this->lock);
+  hist_reset(hist);
+  hist_add_buckets(hist, dense);
+  return TRUE;
+}
+
+int
+history_get_rows(HISTORY this)
+{
+  return (this == NULL) ? 0 : this->nrows;
+}
+
+/**
+ * The metric's name; the rate is in trans/sec, the rest in secs.
+ * CHANGE, LOW and HIGH are percent.
+ */
+char *
+history_get_row(HISTORY this, int index, double *base, double *current, float *change, float *low, float *high, char **verdict)
+{
+  ROW *R;
+
+  if (this == NULL || index < 0 || index >= this->nrows) return NULL;
+
+  R = &this->rows[index];
+  *base    = R->base;
+  *current = R->current;
+  *change  = R->change;
+  *low     = R->low;
+  *high    = R->high;
+  *verdict = R->verdict;
+  return __names[index];
+}
+
+/**
+ * What the browsers have done so far; they're busy while we
+ * read so a count may be off by the request in flight
+ */
+private void
+__snap(HISTORY this, unsigned long *hits, unsigned long *errors, unsigned long *failed, unsigned int *hist)
+{
+  int          i;
+  int          j;
+  unsigned int tmp[HIST_BUCKETS];
+
+  *hits   = 0;
+  *failed = my.failed;
+  *errors = my.failed;
+  memset(hist, '\0', sizeof(unsigned int) * HIST_BUCKETS);
+  for (i = 0; i < (int)array_length(this->browsers); i++) {
+    BROWSER B = (BROWSER)array_get(this->browsers, i);
+    *hits   += browser_get_hits(B);
+    *errors += browser_get_fail(B);
+    hist_get_buckets(browser_get_hist(B), tmp);
+    for (j = 0; j < HIST_BUCKETS; j++) {
+      hist[j] += tmp[j];
+    }
+  }
+}
+
+private void
+__interval(HISTORY this)
+{
+  int           i;
+  double        when = __now();
+  unsigned long hits;
+  unsigned long errors;
+  unsigned long failed;
+  unsigned int  now[HIST_BUCKETS];
+  unsigned int  diff[HIST_BUCKETS];
+  unsigned long faults[FAULTS];
+  unsigned long delta[FAULTS];
+
+  __snap(this, &hits, &errors, &failed, now);
+  for (i = 0; i < HIST_BUCKETS; i++) {
+    diff[i] = (now[i] > this->last[i]) ? now[i] - this->last[i] : 0;
+  }
+  fault_get_counts(faults);
+  for (i = 0; i < FAULTS; i++) {
+    delta[i] = (faults[i] > this->faults[i]) ? faults[i] - this->faults[i] : 0;
+  }
+  __append(
+    this, (float)(when - this->when),
+    (hits > this->hits) ? hits - this->hits : 0,
+    (errors > this->errors) ? errors - this->errors : 0,
+    (failed > this->failures) ? failed - this->failures : 0, delta, diff
+  );
+  memcpy(this->faults, faults, sizeof(faults));
+  this->when     = when;
+  this->hits     = hits;
+  this->errors   = errors;
+  this->failures = failed;
+  memcpy(this->last, now, sizeof(now));
+}
+
+/**
+ * Samples on the second from the start so the intervals don't
+ * drift; cancel is only enabled while we sleep.
+ */
+private void *
+__sampler(void *arg)
+{
+  HISTORY this = (HISTORY)arg;
+  double  next = this->when;
+  double  wait;
+
+  while (TRUE) {
+    next += PERIOD;
+    if ((wait = next - __now()) > 0) {
+      pthread_usleep_np((unsigned long)(wait * 1000000));
+    }
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+    __interval(this);
+    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+    pthread_testcancel();
+  }
+  return NULL;
+}
+
+private void
+__totals(HISTORY this, DATA data)
+{
+  int i;
+
+  this->trans      = data_get_count(data);
+  this->failed     = my.failed;
+  this->elapsed    = data_get_elapsed(data);
+  this->throughput = data_get_throughput(data);
+  this->response   = data_get_response_time(data);
+  this->metric[0]  = data_get_transaction_rate(data);
+  for (i = 1; i < METRICS; i++) {
+    this->metric[i] = data_get_percentile(data, __pcts[i]);
+  }
+  hist_get_buckets(data_get_hist(data), this->hist);
+}
+
+private void
+__write(HISTORY this, FILE *fp, const char *date)
+{
+  int           i;
+  int           n;
+  unsigned long faults[FAULTS];
+
+  fprintf(fp, "{\n");
+  fprintf(fp, "  \"siege\": ");  __string(fp, version_string); fprintf(fp, ",\n");
+  fprintf(fp, "  \"date\": ");   __string(fp, date);           fprintf(fp, ",\n");
+  fprintf(fp, "  \"buckets\": %d,\n", HIST_BUCKETS);
+  fprintf(fp, "  \"config\": {\n");
+  fprintf(fp, "    \"url\": ");     __string(fp, my.url);     fprintf(fp, ",\n");
+  fprintf(fp, "    \"file\": ");    __string(fp, (my.url == NULL) ? my.file : NULL); fprintf(fp, ",\n");
+  fprintf(fp, "    \"users\": %d,\n",        my.cusers);
+  fprintf(fp, "    \"time\": %d,\n",         my.secs);
+  fprintf(fp, "    \"reps\": %d,\n",         (my.secs > 0) ? -1 : my.reps);
+  fprintf(fp, "    \"delay\": %.3f,\n",      my.delay);
+  fprintf(fp, "    \"benchmark\": %s,\n",    my.bench    ? "true" : "false");
+  fprintf(fp, "    \"internet\": %s,\n",     my.internet ? "true" : "false");
+  fprintf(fp, "    \"protocol\": \"%s\",\n", my.protocol ? "HTTP/1.1" : "HTTP/1.0");
+  fprintf(fp, "    \"keepalive\": %s,\n",    my.keepalive ? "true" : "false");
+  fprintf(fp, "    \"parser\": %s,\n",       my.parser   ? "true" : "false");
+  fprintf(fp, "    \"chunked\": %s,\n",      my.chunked  ? "true" : "false");
+  fprintf(fp, "    \"cache\": %s,\n",        my.cache    ? "true" : "false");
+  fprintf(fp, "    \"procs\": %d,\n",        my.procs);
+  fprintf(fp, "    \"io_backend\": \"%s\",\n", socket_get_backend());
+  fprintf(fp, "    \"profile\": ");  __string(fp, my.profile); fprintf(fp, ",\n");
+  fprintf(fp, "    \"mark\": ");     __string(fp, (my.mark) ? my.markstr : NULL); fprintf(fp, "\n");
+  fprintf(fp, "  },\n");
+  fprintf(fp, "  \"summary\": {\n");
+  fprintf(fp, "    \"transactions\": %lu,\n",        this->trans);
+  fprintf(fp, "    \"failed_transactions\": %lu,\n", this->failed);
+  fprintf(fp, "    \"faults\": {");
+  fault_get_counts(faults);
+  for (i = FAULT_NONE + 1, n = 0; i < FAULTS; i++) {
+    if (faults[i] == 0) continue;
+    fprintf(fp, "%s\"%s\": %lu", (n++ > 0) ? ", " : "", fault_name((FAULT)i), faults[i]);
+  }
+  fprintf(fp, "},\n");
+  fprintf(fp, "    \"elapsed_time\": %.3f,\n",       this->elapsed);
+  fprintf(fp, "    \"transaction_rate\": %.3f,\n",   this->metric[0]);
+  fprintf(fp, "    \"throughput\": %.3f,\n",         this->throughput);
+  fprintf(fp, "    \"response_time\": %.6f,\n",      this->response);
+  fprintf(fp, "    \"response_time_p50\": %.6f,\n",  this->metric[1]);
+  fprintf(fp, "    \"response_time_p90\": %.6f,\n",  this->metric[2]);
+  fprintf(fp, "    \"response_time_p95\": %.6f,\n",  this->metric[3]);
+  fprintf(fp, "    \"response_time_p99\": %.6f\n",   this->metric[4]);
+  fprintf(fp, "  },\n");
+  fprintf(fp, "  \"histogram\": ");
+  __pairs(fp, this->hist);
+  fprintf(fp, ",\n");
+  fprintf(fp, "  \"intervals\": [");
+  for (i = 0; i < this->count; i++) {
+    INTERVAL    *I = &this->intervals[i];
+    unsigned int hist[HIST_BUCKETS];
+    int          j;
+    int          n;
+    memset(hist, '\0', sizeof(hist));
+    for (j = 0; j < I->nbuckets; j++) {
+      hist[I->buckets[j].index] = I->buckets[j].count;
+    }
+    fprintf(fp, "%s\n    {\"second\": %d, \"seconds\": %.3f, \"transactions\": %lu, \"errors\": %lu, \"failed\": %lu, \"faults\": {",
+      (i > 0) ? "," : "", i+1, I->secs, I->hits, I->errors, I->failed
+    );
+    for (j = FAULT_NONE + 1, n = 0; j < FAULTS; j++) {
+      if (I->faults[j] == 0) continue;
+      fprintf(fp, "%s\"%s\": %lu", (n++ > 0) ? ", " : "", fault_name((FAULT)j), I->faults[j]);
+    }
+    fprintf(fp, "}, \"histogram\": ");
+    __pairs(fp, hist);
+    fprintf(fp, "}");
+  }
+  fprintf(fp, "\n  ]\n}\n");
+}
+
+private void
+__string(FILE *fp, const char *str)
+{
+  if (str == NULL) {
+    fputs("null", fp);
+    return;
+  }
+  fputc('"', fp);
+  for (; *str != '\0'; str++) {
+    if (*str == '"' || *str == '\\') {
+      fprintf(fp, "\\%c", *str);
+    } else if ((unsigned char)*str < 0x20) {
+      fprintf(fp, "\\u%04x", (unsigned char)*str);
+    } else {
+      fputc(*str, fp);
+    }
+  }
+  fputc('"', fp);
+}
+
+/**
+ * A histogram as [[bucket, count], ...], empty buckets left out
+ */
+private void
+__pairs(FILE *fp, const unsigned int *hist)
+{
+  int     i;
+  BOOLEAN first = TRUE;
+
+  fputc('[', fp);
+  for (i = 0; i < HIST_BUCKETS; i++) {
+    if (hist[i] == 0) continue;
+    fprintf(fp, "%s[%d, %u]", (first) ? "" : ", ", i, hist[i]);
+    first = FALSE;
+  }
+  fputc(']', fp);
+}
+
+/**
+ * Where KEY's value starts in LINE, or NULL. With FIRST the key
+ * has to be the first thing on the line.
+ */
+private char *
+__value(char *line, const char *key, BOOLEAN first)
+{
+  char   *p;
+  size_t  len = strlen(key);
+
+  if (first) {
+    for (p = line; *p == ' ' || *p == '\t' || *p == '{'; p++) ;
+    if (*p != '"' || strncmp(p+1, key, len) != 0 || p[len+1] != '"' || p[len+2] != ':') {
+      return NULL;
+    }
+  } else {
+    for (p = strchr(line, '"'); p != NULL; p = strchr(p+1, '"')) {
+      if (strncmp(p+1, key, len) == 0 && p[len+1] == '"' && p[len+2] == ':') break;
+    }
+    if (p == NULL) return NULL;
+  }
+  for (p += len+3; *p == ' ' || *p == '\t'; p++) ;
+  return p;
+}
+
+/**
+ * Adds up [[bucket, count], ...] into HIST
+ */
+private void
+__buckets(char *str, unsigned int *hist)
+{
+  char         *p = str;
+  char         *end;
+  unsigned long index;
+  unsigned long count;
+
+  if (*p != '[') return;
+  for (p++; (p = strchr(p, '[')) != NULL; p = end) {
+    index = strtoul(p+1, &end, 10);
+    while (*end == ',' || *end == ' ') end++;
+    count = strtoul(end, &end, 10);
+    if (index < HIST_BUCKETS) {
+      hist[index] += (unsigned int)count;
+    }
+    if (*end == ']') end++;
+    if (*end == ']') break;
+  }
+}
+
+/**
+ * Keeps an interval; only its non-empty buckets are stored
+ */
+private void
+__append(HISTORY this, float secs, unsigned long hits, unsigned long errors, unsigned long failed, const unsigned long *faults, const unsigned int *diff)
+{
+  int       i;
+  int       n = 0;
+  BUCKET   *buckets = NULL;
+  INTERVAL *I;
+
+  for (i = 0; i < HIST_BUCKETS; i++) {
+    if (diff[i] > 0) n++;
+  }
+  if (n > 0) {
+    buckets = xmalloc(sizeof(BUCKET) * n);
+  }
+  for (i = 0, n = 0; i < HIST_BUCKETS; i++) {
+    if (diff[i] == 0) continue;
+    buckets[n].index = i;
+    buckets[n].count = diff[i];
+    n++;
+  }
+
+  pthread_mutex_lock(&this->lock);
+  if (this->count == this->size) {
+    this->size      = (this->size == 0) ? 64 : this->size * 2;
+    this->intervals = xrealloc(this->intervals, sizeof(INTERVAL) * this->size);
+  }
+  I = &this->intervals[this->count++];
+  I->secs     = secs;
+  I->hits     = hits;
+  I->errors   = errors;
+  I->failed   = failed;
+  if (faults != NULL) {
+    memcpy(I->faults, faults, sizeof(I->faults));
+  } else {
+    memset(I->faults, '\0', sizeof(I->faults));
+  }
+  I->nbuckets = n;
+  I->buckets  = buckets;
+  pthread_mutex_unlock(&this->lock);
+}
+
+/**
+ * Draws each run's intervals with replacement RESAMPLES times and
+ * takes the middle 95% of the changes as each metric's interval.
+ * The seed is fixed so the same two runs always compare the same.
+ */
+private void
+__bootstrap(HISTORY this, HISTORY base)
+{
+  int                i;
+  int                m;
+  double             a[METRICS];
+  double             b[METRICS];
+  float             *changes;
+  unsigned int      *dense;
+  unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+  HIST               H    = new_hist();
+
+  changes = xmalloc(sizeof(float) * METRICS * RESAMPLES);
+  dense   = xmalloc(sizeof(unsigned int) * HIST_BUCKETS);
+  for (i = 0; i < RESAMPLES; i++) {
+    __resample(this, H, dense, &seed, a);
+    __resample(base, H, dense, &seed, b);
+    for (m = 0; m < METRICS; m++) {
+      changes[m * RESAMPLES + i] = (b[m] > 0) ? (float)(a[m] / b[m] - 1.0) * 100 : 0;
+    }
+  }
+  for (m = 0; m < METRICS; m++) {
+    float *C = &changes[m * RESAMPLES];
+    qsort(C, RESAMPLES, sizeof(float), __compare);
+    this->rows[m].low  = C[(int)(RESAMPLES * 0.025)];
+    this->rows[m].high = C[(int)(RESAMPLES * 0.975) - 1];
+  }
+  xfree(changes);
+  xfree(dense);
+  H = hist_destroy(H);
+}
+
+private void
+__resample(HISTORY this, HIST H, unsigned int *dense, unsigned long long *seed, double *out)
+{
+  int           i;
+  int           j;
+  double        secs = 0;
+  unsigned long hits = 0;
+  INTERVAL     *I;
+
+  memset(dense, '\0', sizeof(unsigned int) * HIST_BUCKETS);
+  for (i = 0; i < this->count; i++) {
+    I     = &this->intervals[__random(seed) % this->count];
+    secs += I->secs;
+    hits += I->hits;
+    for (j = 0; j < I->nbuckets; j++) {
+      dense[I->buckets[j].index] += I->buckets[j].count;
+    }
+  }
+  hist_reset(H);
+  hist_add_buckets(H, dense);
+  out[0] = (secs > 0) ? hits / secs : 0;
+  for (i = 1; i < METRICS; i++) {
+    out[i] = hist_get_percentile(H, __pcts[i]);
+  }
+}
+
+/**
+ * xorshift64*; plenty for picking intervals
+ */
+private unsigned int
+__random(unsigned long long *seed)
+{
+  *seed ^= *seed >> 12;
+  *seed ^= *seed << 25;
+  *seed ^= *seed >> 27;
+  return (unsigned int)((*seed * 2685821657736338717ULL) >> 32);
+}
+
+private int
+__compare(const void *a, const void *b)
+{
+  float x = *(const float *)a;
+  float y = *(const float *)b;
+  return (x > y) - (x < y);
+}
+
+private double
+__now(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
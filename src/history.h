@@ -0,0 +1,63 @@
+/**
+ * Run history and comparison
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifndef __HISTORY_H
+#define __HISTORY_H
+
+#include <stdlib.h>
+#include <array.h>
+#include <data.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+/**
+ * The record of a run. Once a second we add up what the browsers
+ * did since the last second: transactions, errors by cause (see
+ * fault.h) and a latency histogram. At the end the configuration, the totals, the whole
+ * run's histogram and those intervals go to one JSON file per run
+ * (--history=DIR); it's written to a temp file and renamed so
+ * nobody reads half a run.
+ *
+ * --compare=FILE reads a record back and compares this run to it:
+ * the transaction rate and the p50, p90, p95 and p99 response
+ * times. We resample each run's intervals to get a 95% confidence
+ * interval for every change; when it doesn't include zero the
+ * change is real and, if it's for the worse, a regression. Runs
+ * with fewer than 5 intervals only get the point changes.
+ *
+ * While the run goes, history_get_window adds up its last few
+ * seconds for anyone watching them (see gate.c).
+ */
+typedef struct HISTORY_T *HISTORY;
+
+HISTORY new_history();
+HISTORY history_destroy(HISTORY this);
+HISTORY history_load(const char *file);
+void    history_start(HISTORY this, ARRAY browsers);
+void    history_stop(HISTORY this);
+BOOLEAN history_save(HISTORY this, DATA data, const char *dir, char *path, size_t len);
+int     history_compare(HISTORY this, DATA data, HISTORY base);
+BOOLEAN history_get_window(HISTORY this, int secs, float *elapsed, unsigned long *hits, unsigned long *errors, unsigned long *failed, HIST hist);
+int     history_get_rows(HISTORY this);
+char *  history_get_row(HISTORY this, int index, double *base, double *current, float *change, float *low, float *high, char **verdict);
+
+#endif/*__HISTORY_H*/
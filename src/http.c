@@ -47,6 +47,8 @@ pthread_mutex_t __mutex = PTHREAD_MUTEX_INITIALIZER;
 pthread_cond_t  __cond  = PTHREAD_COND_INITIALIZER;
 
 private int     __gzip_inflate(int window, const char *src, int srcLen, const char *dst, int dstLen);
+private void    __cache_update(CONN *C, URL U, RESPONSE resp);
+private BOOLEAN __accepts(URL U);
 
 /**
  * HTTPS tunnel; set up a secure tunnel with the
@@ -207,10 +209,11 @@ http_get(CONN *C, URL U, FACTS facts)
          strlen(cookie) +
          strlen((ifmod!=NULL)?ifmod:"") +
          strlen((ifnon!=NULL)?ifnon:"") +
-         strlen((strncasecmp(my.extra, "Accept:", 7)==0) ? "" : accept) +
+         strlen(__accepts(U) ? "" : accept) +
          sizeof(encoding) +
          strlen(my.uagent) +
          strlen(my.extra) +
+         strlen(url_get_headers(U)) +
          strlen(keepalive) +
          128; 
    request = (char*)xmalloc(mlen);
@@ -236,6 +239,7 @@ http_get(CONN *C, URL U, FACTS facts)
     "%s"                                   /* encoding */
     "User-Agent: %s\015\012"               /* my uagent   */
     "%s"                                   /* my.extra    */
+    "%s"                                   /* the URL's   */
     "Connection: %s\015\012\015\012",      /* keepalive   */
     url_get_method_name(U), fullpath, protocol, hoststr,
     (C->auth.www==TRUE)?authwww:"",
@@ -243,8 +247,8 @@ http_get(CONN *C, URL U, FACTS facts)
     (strlen(cookie) > 8)?cookie:"", 
     (ifmod!=NULL)?ifmod:"",
     (ifnon!=NULL)?ifnon:"",
-    (strncasecmp(my.extra, "Accept:", 7)==0) ? "" : accept,
-    encoding, my.uagent, my.extra, keepalive 
+    __accepts(U) ? "" : accept,
+    encoding, my.uagent, my.extra, url_get_headers(U), keepalive 
   );
 
   /**
@@ -366,11 +370,12 @@ http_post(CONN *C, URL U, FACTS facts)
          strlen((C->auth.www==TRUE)?authwww:"") +
          strlen((C->auth.proxy==TRUE)?authpxy:"") +
          strlen(cookie) +
-         strlen((strncasecmp(my.extra, "Accept:", 7)==0) ? "" : accept) +
+         strlen(__accepts(U) ? "" : accept) +
          sizeof(encoding) +
          strlen(my.uagent) +
          strlen(url_get_conttype(U)) +
          strlen(my.extra) +
+         strlen(url_get_headers(U)) +
          strlen(keepalive) + 
          url_get_postlen(U) +
          128; 
@@ -394,7 +399,7 @@ http_post(CONN *C, URL U, FACTS facts)
     "%s"
     "%s"
     "%s"
-    "User-Agent: %s\015\012%s"
+    "User-Agent: %s\015\012%s%s"
     "Connection: %s\015\012"
     "Content-Type: %s\015\012"
     "Content-Length: %ld\015\012\015\012",
@@ -402,8 +407,8 @@ http_post(CONN *C, URL U, FACTS facts)
     (C->auth.www==TRUE)?authwww:"",
     (C->auth.proxy==TRUE)?authpxy:"",
     (strlen(cookie) > 8)?cookie:"", 
-    (strncasecmp(my.extra, "Accept:", 7)==0) ? "" : accept,
-    encoding, my.uagent, my.extra, keepalive, url_get_conttype(U), (long)url_get_postlen(U)
+    __accepts(U) ? "" : accept,
+    encoding, my.uagent, my.extra, url_get_headers(U), keepalive, url_get_conttype(U), (long)url_get_postlen(U)
   );
 
   if (rlen < mlen) {
@@ -450,6 +455,9 @@ http_read_headers(CONN *C, URL U, FACTS facts)
         line[x] = '\n';
       echo("%c", c);
       if (x <= 1 && line[x] == '\n') { //VL issue #4, changed from (line[0] == '\n' || line[1] == '\n')
+        if (my.cache) {
+          __cache_update(C, U, resp);
+        }
 			return resp; 
       }
       if (line[x] == '\n') break;
@@ -508,6 +516,7 @@ http_read_headers(CONN *C, URL U, FACTS facts)
     if (strncasecmp(line, ETAG, strlen(ETAG)) == 0) {
       char   *etag;
       size_t len = strlen(line);
+      response_set_etag(resp, line);
       if (my.cache) {
         etag = (char *)xmalloc(len);
         memset(etag, '\0', len);
@@ -526,20 +535,16 @@ http_read_headers(CONN *C, URL U, FACTS facts)
       response_set_transfer_encoding(resp, line);
     }
     if (strncasecmp(line, EXPIRES, strlen(EXPIRES)) == 0) {
-      char   *expires;
-      size_t  len = strlen(line); 
-      if (my.cache) {
-        expires = (char *)xmalloc(len);
-        memset(expires, '\0', len);
-        memcpy(expires, line+9, len-8);
-        cache_add(C->cache, C_EXPIRES, U, expires);
-        xfree(expires);
-      }
+      response_set_expires(resp, line);
     }
-    if (strncasecmp(line, "cache-control: ", 15) == 0) {
-      /* printf("%s\n", line+15); */
+    if (strncasecmp(line, CACHE_CONTROL, strlen(CACHE_CONTROL)) == 0) {
+      response_set_cache_control(resp, line);
+    }
+    if (strncasecmp(line, VARY, strlen(VARY)) == 0) {
+      response_set_vary(resp, line);
     }
     if (n <=  0) { 
+      socket_fault(C, FAULT_EMPTY);
       echo ("read error: %s:%d", __FILE__, __LINE__);
       resp = response_destroy(resp);
       return resp; 
@@ -586,7 +591,7 @@ http_read(CONN *C, RESPONSE resp)
   int    chunk  = 0;
   size_t bytes  = 0;
   size_t length = 0;
-  char   dest[MAXFILE*6];
+  char   *dest  = NULL;
   char   *ptr = NULL;
   char   *tmp = NULL;
   size_t size = MAXFILE; 
@@ -601,8 +606,6 @@ http_read(CONN *C, RESPONSE resp)
   else if (C->content.length == (size_t)~0L)
 	  C->content.length = 0; //not to break code below...
   
-  memset(dest, '\0', sizeof dest);
-
   //pthread_mutex_lock(&__mutex);  //VL - moved
   
   if (C->content.length > 0) {
@@ -668,23 +671,49 @@ http_read(CONN *C, RESPONSE resp)
     } while (TRUE);
   }
 
+  /**
+   * The inflate buffer is too big for a small thread stack
+   * so we only allocate it when the response is compressed
+   */
   if (response_get_content_encoding(resp) == GZIP) {
-    __gzip_inflate(MAX_WBITS+32, ptr, bytes, dest, sizeof(dest));
+    dest = xcalloc(MAXFILE*6+1, 1);
+    __gzip_inflate(MAX_WBITS+32, ptr, bytes, dest, MAXFILE*6);
   }
   if (response_get_content_encoding(resp) == DEFLATE) {
-    __gzip_inflate(-MAX_WBITS, ptr, bytes, dest, sizeof(dest));
+    dest = xcalloc(MAXFILE*6+1, 1);
+    __gzip_inflate(-MAX_WBITS, ptr, bytes, dest, MAXFILE*6);
   }
-  if (strlen(dest) > 0) {
+  if (dest != NULL && strlen(dest) > 0) {
     page_concat(C->page, dest, strlen(dest));
   } else {
     page_concat(C->page, ptr, strlen(ptr));
   }
+  xfree(dest);
   xfree(ptr);
   echo ("\n");
   //pthread_mutex_unlock(&__mutex);
   return bytes;
 }
 
+/**
+ * Only responses we're allowed to reuse update the cache; an
+ * error page shouldn't clobber what we already know about U
+ */
+private void
+__cache_update(CONN *C, URL U, RESPONSE resp)
+{
+  switch (response_get_code(resp)) {
+    case 200:
+    case 203:
+    case 301:
+    case 304:
+      cache_update(C->cache, U, resp);
+      break;
+    default:
+      break;
+  }
+}
+
 private int
 __gzip_inflate(int window, const char *src, int srcLen, const char *dst, int dstLen)
 {
@@ -726,3 +755,15 @@ __gzip_inflate(int window, const char *src, int srcLen, const char *dst, int dst
 #endif/*HAVE_ZLIB*/
 }
 
+
+/**
+ * We send our own Accept header unless the config or the URL has one
+ */
+private BOOLEAN
+__accepts(URL U)
+{
+  char *headers = url_get_headers(U);
+
+  return strncasecmp(my.extra, "Accept:", 7) == 0 ||
+         strncasecmp(headers, "Accept:", 7) == 0 || stristr(headers, "\nAccept:") != NULL;
+}
@@ -28,6 +28,8 @@
 #include <perl.h>
 #include <memory.h>
 #include <notify.h>
+#include <sock.h>
+#include <cpu.h>
 #include <fcntl.h>
 #include <stralloc.h>
 #include <version.h>
@@ -105,11 +107,41 @@ init_config(void)
   my.internet       = FALSE;
   my.config         = FALSE;
   my.csv            = FALSE;
+  my.vfile          = NULL;
   my.fullurl        = FALSE;
   my.escape         = TRUE;
   my.parser         = FALSE;
+  my.pcache         = 256;
+  my.pcache_size    = 16;
+  my.edge           = 0;
   my.secs           = -1;
   my.limit          = 255;
+  my.stack          = 0;
+  my.procs          = 1;
+  my.worker         = -1;
+  my.agent          = FALSE;
+  my.coordinator    = FALSE;
+  my.profile        = NULL;
+  my.capacity       = 0;
+  my.slo            = NULL;
+  my.history        = NULL;
+  my.compare        = NULL;
+  my.asserts        = new_array();
+  my.window         = 0;
+  my.urlstats       = 0;
+  my.warmup         = 0;
+  my.cooldown       = 0;
+  my.stagger        = 0;
+  my.grace          = 5;
+  my.replay         = NULL;
+  my.format         = NULL;
+  my.speed          = 1.0;
+  my.har            = NULL;
+  my.zipf           = 0.0;
+  my.scenario       = NULL;
+  my.saturation.cpu  = 90;
+  my.saturation.runq = 5.0;
+  my.saturation.lag  = 50.0;
   my.reps           = MAXREPS; 
   my.bids           = 5;
   my.login          = FALSE;
@@ -202,11 +234,15 @@ show_config(int EXIT)
   printf("----------------------------------------------\n");
   printf("version:                        %s\n", version_string);
   printf("verbose:                        %s\n", my.verbose  ? "true"     : "false");
+  printf("verbose file:                   %s\n", (my.vfile == NULL) ? "stdout" : my.vfile);
   printf("color:                          %s\n", my.color  ? "true"     : "false");
   printf("quiet:                          %s\n", my.quiet    ? "true"     : "false");
   printf("debug:                          %s\n", my.debug    ? "true"     : "false");
   printf("protocol:                       %s\n", my.protocol ? "HTTP/1.1" : "HTTP/1.0");
   printf("HTML parser:                    %s\n", my.parser   ? "enabled"  : "disabled");
+  if (my.parser) {
+    printf("parser cache:                   %d entries, %d MB\n", my.pcache, my.pcache_size);
+  }
   printf("get method:                     %s\n", method);
   if (auth_get_proxy_required(my.auth)){
     printf("proxy-host:                     %s\n", auth_get_proxy_host(my.auth));
@@ -222,18 +258,85 @@ show_config(int EXIT)
     printf( "repetitions:                    %d\n", my.reps);
   else
     printf("repetitions:                    n/a\n" );
+  if (my.warmup > 0 || my.cooldown > 0)
+    printf("warm-up, cool-down:             %d, %d seconds\n", my.warmup, my.cooldown);
+  if (my.stagger > 0)
+    printf("staggered start:                %d seconds\n", my.stagger);
+  printf("grace period:                   %d seconds\n", my.grace);
   printf("socket timeout:                 %d\n", my.timeout);
+  {
+    char opts[128];
+    printf("socket options:                 %s\n", 
+      socket_get_options(opts, sizeof(opts), SOCKOPT_CONFIGURED) ? opts : "none"
+    );
+  }
+  if (socket_get_sources() > 0) {
+    printf("bind addresses:                 %d (%s...)\n", socket_get_sources(), socket_get_source(0, NULL));
+  } else {
+    printf("bind addresses:                 none\n");
+  }
+  printf("I/O backend:                    %s\n", socket_get_backend());
+  {
+    char cpus[256];
+    printf("CPU affinity:                   %s\n", cpu_get_list(cpus, sizeof(cpus)) ? cpus : "none");
+    printf("NUMA policy:                    %s\n", cpu_get_numa());
+  }
   printf("cache enabled:                  %s\n", my.cache==TRUE ? "true" : "false");
+  if (my.edge > 0) {
+    printf("edge cache:                     %d entries\n", my.edge);
+  } else {
+    printf("edge cache:                     disabled\n");
+  }
   printf("accept-encoding:                %s\n", my.encoding);
   printf("delay:                          %.3f sec%s\n", my.delay, (my.delay > 1) ? "s" : "");
   printf("internet simulation:            %s\n", my.internet?"true":"false");
+  if (my.zipf > 0) {
+    printf("zipf exponent:                  %.2f\n", my.zipf);
+  }
   printf("benchmark mode:                 %s\n", my.bench?"true":"false");
   printf("failures until abort:           %d\n", my.failures);
   printf("named URL:                      %s\n", my.url==NULL||strlen(my.url) < 2 ? "none" : my.url);
   printf("URLs file:                      %s\n", strlen(my.file) > 1 ? my.file : URL_FILE);
   printf("thread limit:                   %d\n", (my.limit < 1) ? 255 : my.limit);
+  printf("worker processes:               %d\n", (my.procs < 1) ? 1 : my.procs);
+  printf("load profile:                   %s\n", (my.profile == NULL) ? "none" : my.profile);
+  if (my.scenario != NULL) {
+    printf("scenario file:                  %s\n", my.scenario);
+  }
+  if (my.har != NULL) {
+    printf("HAR file:                       %s\n", my.har);
+  }
+  if (my.replay != NULL) {
+    printf("replay log:                     %s (%s, %.2fx)\n", my.replay, (my.format == NULL) ? "combined" : my.format, my.speed);
+  }
+  printf("saturation thresholds:          cpu %d%%, run queue %.2f ms, lag %.2f ms\n",
+    my.saturation.cpu, my.saturation.runq, my.saturation.lag
+  );
+  if (my.stack > 0) {
+    printf("thread stack:                   %d KB\n", my.stack);
+  } else {
+    printf("thread stack:                   system default\n");
+  }
   printf("logging:                        %s\n", my.logging ? "true" : "false");
   printf("log file:                       %s\n", (my.logfile == NULL) ? LOG_FILE : my.logfile);
+  printf("run history:                    %s\n", (my.history == NULL) ? "none" : my.history);
+  if (my.urlstats > 0) {
+    printf("url statistics:                 top %d\n", my.urlstats);
+  } else {
+    printf("url statistics:                 false\n");
+  }
+  if (array_length(my.asserts) > 0) {
+    int i;
+    printf("assertions:                     %s\n", (char *)array_get(my.asserts, 0));
+    for (i = 1; i < (int)array_length(my.asserts); i++) {
+      printf("                                %s\n", (char *)array_get(my.asserts, i));
+    }
+    if (my.window > 0) {
+      printf("assert window:                  %d sec\n", my.window);
+    }
+  } else {
+    printf("assertions:                     none\n");
+  }
   printf("resource file:                  %s\n", my.rc);
   printf("timestamped output:             %s\n", my.timestamp?"true":"false");
   printf("comma separated output:         %s\n", my.csv?"true":"false");
@@ -257,6 +360,7 @@ show_config(int EXIT)
   my.auth    = auth_destroy(my.auth);
   my.lurl    = array_destroy(my.lurl);
   my.aurl    = array_destroy(my.aurl);
+  my.asserts = array_destroy(my.asserts);
 
   if (EXIT) exit(0);
   else return 0;
@@ -378,6 +482,12 @@ load_conf(char *filename)
       else
         my.verbose = FALSE;
     } 
+    else if (strmatch(option, "verbose-file")) {
+      if (value != NULL && strlen(value) > 0) {
+        xfree(my.vfile);
+        my.vfile = xstrdup(value);
+      }
+    }
     else if (strmatch(option, "color")) {
       if (strmatch(value, "false") || strmatch(value, "off"))
         my.color = FALSE;
@@ -396,6 +506,12 @@ load_conf(char *filename)
       else
         my.parser = FALSE;
     } 
+    else if (strmatch(option, "parser-cache")) {
+      my.pcache = atoi(value);
+    }
+    else if (strmatch(option, "parser-cache-size")) {
+      my.pcache_size = atoi(value);
+    }
     else if (strmatch(option, "nofollow")) {
       if (value && strlen(value) > 3) {
         my.nomap->line = (char**)realloc(my.nomap->line, sizeof(char *) * (my.nomap->index + 1));
@@ -457,9 +573,94 @@ load_conf(char *filename)
         my.limit = 255;
       }
     }
+    else if (strmatch(option, "procs")) {
+      if (value != NULL) {
+        my.procs = atoi(value);
+      } else {
+        my.procs = 1;
+      }
+    }
+    else if (strmatch(option, "history")) {
+      if (value != NULL && strlen(value) > 0) {
+        xfree(my.history);
+        my.history = xstrdup(value);
+      }
+    }
+    else if (strmatch(option, "url-stats")) {
+      if (value != NULL) {
+        my.urlstats = (strmatch(value, "true")) ? 10 : atoi(value);
+      } else {
+        my.urlstats = 0;
+      }
+    }
+    else if (strmatch(option, "assert")) {
+      if (value != NULL && strlen(value) > 0) {
+        array_push(my.asserts, value);
+      }
+    }
+    else if (strmatch(option, "assert-window")) {
+      if (value != NULL) {
+        my.window = atoi(value);
+      } else {
+        my.window = 0;
+      }
+    }
+    else if (strmatch(option, "profile")) {
+      if (value != NULL && strlen(value) > 0) {
+        xfree(my.profile);
+        my.profile = xstrdup(value);
+      }
+    }
+    else if (strmatch(option, "saturation-cpu")) {
+      if (value != NULL) {
+        my.saturation.cpu = atoi(value);
+      } else {
+        my.saturation.cpu = 90;
+      }
+    }
+    else if (strmatch(option, "saturation-runq")) {
+      if (value != NULL) {
+        my.saturation.runq = atof(value);
+      } else {
+        my.saturation.runq = 5.0;
+      }
+    }
+    else if (strmatch(option, "saturation-lag")) {
+      if (value != NULL) {
+        my.saturation.lag = atof(value);
+      } else {
+        my.saturation.lag = 50.0;
+      }
+    }
+    else if (strmatch(option, "thread-stack")) {
+      if (value != NULL) {
+        my.stack = atoi(value);
+      } else {
+        my.stack = 0;
+      }
+    }
     else if (strmatch(option, "time")) {
       parse_time(value);
     }
+    else if (strmatch(option, "warmup")) {
+      my.warmup = (value != NULL) ? parse_secs(value) : 0;
+    }
+    else if (strmatch(option, "cooldown")) {
+      my.cooldown = (value != NULL) ? parse_secs(value) : 0;
+    }
+    else if (strmatch(option, "stagger")) {
+      my.stagger = (value != NULL) ? parse_secs(value) : 0;
+    }
+    else if (strmatch(option, "grace")) {
+      my.grace = (value != NULL) ? parse_secs(value) : 5;
+    }
+    else if (strmatch(option, "zipf")) {
+      my.zipf = (value != NULL) ? atof(value) : 0.0;
+    }
+    else if (strmatch(option, "scenario")) {
+      xfree(my.scenario);
+      my.scenario = (value != NULL && strlen(value) > 0) ? xstrdup(value) : NULL;
+    }
     else if (strmatch(option, "delay")) {
       if (value != NULL) {
         my.delay = atof(value);
@@ -498,6 +699,24 @@ load_conf(char *filename)
       else
         my.cache = FALSE;
     }
+    else if (strmatch(option, "edge-cache")) {
+      my.edge = atoi(value);
+    }
+    else if (strmatch(option, "sockopt")) {
+      socket_set_options(value);
+    }
+    else if (strmatch(option, "bind")) {
+      socket_set_sources(value);
+    }
+    else if (strmatch(option, "io-backend")) {
+      socket_set_backend(value);
+    }
+    else if (strmatch(option, "cpus")) {
+      cpu_set_list(value);
+    }
+    else if (strmatch(option, "numa")) {
+      cpu_set_numa(value);
+    }
     else if (strmatch( option, "debug")) {
       if (!strncasecmp( value, "true", 4))
         my.debug = TRUE;
@@ -45,16 +45,73 @@
 #include <cookies.h>
 #include <crew.h>
 #include <data.h>
+#include <sock.h>
+#include <cpu.h>
+#include <preflight.h>
+#include <proc.h>
+#include <dist.h>
+#include <profile.h>
+#include <search.h>
+#include <monitor.h>
+#include <gate.h>
+#include <history.h>
+#include <urlstats.h>
+#include <replay.h>
+#include <har.h>
+#include <alias.h>
+#include <class.h>
+#include <fault.h>
+#include <writer.h>
+#include <edge.h>
 #include <version.h>
 #include <memory.h>
 #include <notify.h>
 #include <sys/resource.h>
+#include <math.h>
 #ifdef __CYGWIN__
 # include <getopt.h>
 #else
 # include <joedog/getopt.h>
 #endif 
 
+/**
+ * long options without a short switch; we number them
+ * past the char range so they can't collide
+ */
+enum {
+  OPT_SOCKOPT = 256,
+  OPT_BIND,
+  OPT_IO,
+  OPT_CPUS,
+  OPT_NUMA,
+  OPT_STACK,
+  OPT_PROCS,
+  OPT_AGENT,
+  OPT_LISTEN,
+  OPT_COORDINATOR,
+  OPT_AGENTS,
+  OPT_JOB,
+  OPT_PROFILE,
+  OPT_CAPACITY,
+  OPT_SLO,
+  OPT_VFILE,
+  OPT_HISTORY,
+  OPT_COMPARE,
+  OPT_ASSERT,
+  OPT_WINDOW,
+  OPT_URLSTATS,
+  OPT_WARMUP,
+  OPT_COOLDOWN,
+  OPT_STAGGER,
+  OPT_GRACE,
+  OPT_REPLAY,
+  OPT_FORMAT,
+  OPT_SPEED,
+  OPT_HAR,
+  OPT_ZIPF,
+  OPT_SCENARIO
+};
+
 /**
  * long options, std options struct
  */
@@ -84,6 +141,37 @@ static struct option long_options[] =
   { "user-agent",   required_argument, NULL, 'A' },
   { "content-type", required_argument, NULL, 'T' },
   { "json-output",  no_argument,       NULL, 'j' },
+  { "sockopt",      required_argument, NULL, OPT_SOCKOPT },
+  { "bind",         required_argument, NULL, OPT_BIND },
+  { "io",           required_argument, NULL, OPT_IO },
+  { "cpus",         required_argument, NULL, OPT_CPUS },
+  { "numa",         required_argument, NULL, OPT_NUMA },
+  { "thread-stack", required_argument, NULL, OPT_STACK },
+  { "procs",        required_argument, NULL, OPT_PROCS },
+  { "agent",        no_argument,       NULL, OPT_AGENT },
+  { "listen",       required_argument, NULL, OPT_LISTEN },
+  { "coordinator",  no_argument,       NULL, OPT_COORDINATOR },
+  { "agents",       required_argument, NULL, OPT_AGENTS },
+  { "agent-job",    required_argument, NULL, OPT_JOB },
+  { "profile",      required_argument, NULL, OPT_PROFILE },
+  { "find-capacity", optional_argument, NULL, OPT_CAPACITY },
+  { "slo",          required_argument, NULL, OPT_SLO },
+  { "verbose-file", required_argument, NULL, OPT_VFILE },
+  { "history",      required_argument, NULL, OPT_HISTORY },
+  { "compare",      required_argument, NULL, OPT_COMPARE },
+  { "assert",       required_argument, NULL, OPT_ASSERT },
+  { "assert-window", required_argument, NULL, OPT_WINDOW },
+  { "url-stats",    optional_argument, NULL, OPT_URLSTATS },
+  { "warmup",       required_argument, NULL, OPT_WARMUP },
+  { "cooldown",     required_argument, NULL, OPT_COOLDOWN },
+  { "stagger",      required_argument, NULL, OPT_STAGGER },
+  { "grace",        required_argument, NULL, OPT_GRACE },
+  { "replay",       required_argument, NULL, OPT_REPLAY },
+  { "format",       required_argument, NULL, OPT_FORMAT },
+  { "speed",        required_argument, NULL, OPT_SPEED },
+  { "har",          required_argument, NULL, OPT_HAR },
+  { "zipf",         required_argument, NULL, OPT_ZIPF },
+  { "scenario",     required_argument, NULL, OPT_SCENARIO },
   {0, 0, 0, 0}
 };
 
@@ -138,6 +226,8 @@ display_help()
   puts("  -C, --config              CONFIGURATION, show the current config.");
   puts("  -v, --verbose             VERBOSE, prints notification to screen.");
   puts("  -q, --quiet               QUIET turns verbose off and suppresses output.");
+  puts("      --verbose-file=FILE   VERBOSE FILE, write the verbose or CSV lines to");
+  puts("                            FILE instead of the screen (works with -q)");
   puts("  -g, --get                 GET, pull down HTTP headers and display the");
   puts("                            transaction. Great for application debugging.");
   puts("  -p, --print               PRINT, like GET only it prints the entire page.");
@@ -145,9 +235,16 @@ display_help()
   puts("  -r, --reps=NUM            REPS, number of times to run the test." );
   puts("  -t, --time=NUMm           TIMED testing where \"m\" is modifier S, M, or H");
   puts("                            ex: --time=1H, one hour test." );
+  puts("      --warmup=NUMm         WARM UP, run NUM but leave it out of the statistics");
+  puts("      --cooldown=NUMm       COOL DOWN, leave the last NUM of -t out of them");
+  puts("      --stagger=NUMm        STAGGER, spread the users' starts over NUM");
+  puts("      --grace=NUMm          GRACE, how long requests in flight at the end of");
+  puts("                            a run get to finish (default 5s)");
   puts("  -d, --delay=NUM           Time DELAY, random delay before each request");
   puts("  -b, --benchmark           BENCHMARK: no delays between requests." );
   puts("  -i, --internet            INTERNET user simulation, hits URLs randomly.");
+  puts("      --zipf=NUM            ZIPF, hit the URLs at random, the kth one 1/k^NUM");
+  puts("                            as often as the first, ex: --zipf=1.1");
   puts("  -f, --file=FILE           FILE, select a specific URLS FILE." );
   printf("  -R, --rc=FILE             RC, specify an %src file\n",program_name);
   puts("  -l, --log[=FILE]          LOG to FILE. If FILE is not specified, the");
@@ -160,6 +257,43 @@ display_help()
   puts("  -j, --json-output         JSON OUTPUT, print final stats to stdout as JSON");
   puts("      --no-parser           NO PARSER, turn off the HTML page parser");
   puts("      --no-follow           NO FOLLOW, do not follow HTTP redirects");
+  puts("      --sockopt=LIST        SOCKET OPTIONS, comma separated, ex: nodelay,");
+  puts("                            sndbuf=64K,rcvbuf=64K,linger,quickack,fastopen,");
+  puts("                            congestion=bbr");
+  puts("      --bind=LIST           BIND, rotate connections across local source");
+  puts("                            addresses, ex: 127.0.0.2,127.0.0.3 or 10.0.0.0/24");
+  puts("      --io=NAME             I/O BACKEND, select, epoll or uring");
+  puts("      --cpus=LIST           CPUS, pin browser threads to these CPUs, ex: 2-31");
+  puts("      --numa=POLICY         NUMA, memory policy: local or interleave");
+  puts("      --thread-stack=KB     THREAD STACK, per user stack size, ex: 256");
+  puts("      --procs=NUM           PROCESSES, split the users across NUM worker processes");
+  puts("      --profile=STAGES      PROFILE, change the active users as the run goes,");
+  puts("                            ex: \"ramp 0->200 over 5m; hold 10m; step +50 every 2m until 500\"");
+  puts("      --find-capacity[=SECS] FIND CAPACITY, search for the most users that");
+  puts("                            meet --slo, measuring SECS per level (default 5)");
+  puts("      --scenario=FILE       SCENARIO, run the user classes in FILE together,");
+  puts("                            each with its own URLs, users and pacing");
+  puts("      --har=FILE            HAR, load the pages recorded in FILE, their");
+  puts("                            headers, bodies and order, instead of URLs");
+  puts("      --replay=FILE         REPLAY, send the requests in an access log to the");
+  puts("                            URL's server at the times they were logged");
+  puts("      --format=NAME         FORMAT of the --replay log, combined or json");
+  puts("      --speed=NUM           SPEED, play the log NUM times as fast, ex: 2.0");
+  puts("      --slo=LIST            SLO, comma separated, ex: \"p99<250ms,errors<0.1%\"");
+  puts("      --history=DIR         HISTORY, save a record of the run in DIR");
+  puts("      --compare=FILE        COMPARE, report changes from a run record and");
+  puts("                            flag the ones that are regressions");
+  puts("      --url-stats[=NUM]     URL STATS, show the NUM slowest and most failing");
+  puts("                            URLs and each host (default 10)");
+  puts("      --assert=EXPR         ASSERT, fail the run unless EXPR holds, repeatable,");
+  puts("                            ex: --assert=\"p95<200ms\" --assert=\"errors<0.5%\"");
+  puts("      --assert-window=SECS  ASSERT WINDOW, end the run once an --assert has");
+  puts("                            failed for the last SECS seconds");
+  puts("      --agent               AGENT, run jobs for a coordinator; requires --listen");
+  puts("      --listen=[ADDR:]PORT  LISTEN, where an agent takes jobs, ex: 7070");
+  puts("      --coordinator         COORDINATOR, split the users across --agents and");
+  puts("                            print one report for all of them");
+  puts("      --agents=LIST         AGENTS, comma separated HOST:PORT, ex: 10.0.0.5:7070");
   puts("");
   puts(copyright);
   /**
@@ -302,6 +436,164 @@ parse_cmdline(int argc, char *argv[])
       case 'j':
         my.json_output = TRUE;
         break;
+      case OPT_SOCKOPT:
+        if (socket_set_options(optarg) == FALSE) {
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_BIND:
+        if (socket_set_sources(optarg) == FALSE) {
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_IO:
+        if (socket_set_backend(optarg) == FALSE) {
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_CPUS:
+        if (cpu_set_list(optarg) == FALSE) {
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_NUMA:
+        if (cpu_set_numa(optarg) == FALSE) {
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_PROCS:
+        my.procs = atoi(optarg);
+        if (my.procs < 1) {
+          NOTIFY(ERROR, "--procs requires a number of processes");
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_AGENT:
+        my.agent = TRUE;
+        break;
+      case OPT_LISTEN:
+        if (dist_set_listen(optarg) == FALSE) {
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_COORDINATOR:
+        my.coordinator = TRUE;
+        break;
+      case OPT_AGENTS:
+        if (dist_set_agents(optarg) == FALSE) {
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_JOB:
+        if (dist_set_job(optarg) == FALSE) {
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_PROFILE:
+        xfree(my.profile);
+        my.profile = xstrdup(optarg);
+        break;
+      case OPT_CAPACITY:
+        my.capacity = (optarg == NULL) ? 5 : atoi(optarg);
+        if (my.capacity < 1) {
+          NOTIFY(ERROR, "--find-capacity takes a window in seconds, ex: --find-capacity=10");
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_SLO:
+        xfree(my.slo);
+        my.slo = xstrdup(optarg);
+        break;
+      case OPT_HISTORY:
+        xfree(my.history);
+        my.history = xstrdup(optarg);
+        break;
+      case OPT_COMPARE:
+        xfree(my.compare);
+        my.compare = xstrdup(optarg);
+        break;
+      case OPT_URLSTATS:
+        my.urlstats = (optarg == NULL) ? 10 : atoi(optarg);
+        if (my.urlstats < 1) {
+          NOTIFY(ERROR, "--url-stats takes the number of URLs to show, ex: --url-stats=5");
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_ASSERT:
+        array_push(my.asserts, optarg);
+        break;
+      case OPT_WINDOW:
+        my.window = atoi(optarg);
+        if (my.window < 1) {
+          NOTIFY(ERROR, "--assert-window takes a window in seconds, ex: --assert-window=10");
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_WARMUP:
+        if ((my.warmup = parse_secs(optarg)) < 0) {
+          NOTIFY(ERROR, "--warmup takes a time like -t, ex: --warmup=30s");
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_COOLDOWN:
+        if ((my.cooldown = parse_secs(optarg)) < 0) {
+          NOTIFY(ERROR, "--cooldown takes a time like -t, ex: --cooldown=5s");
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_STAGGER:
+        if ((my.stagger = parse_secs(optarg)) < 0) {
+          NOTIFY(ERROR, "--stagger takes a time like -t, ex: --stagger=10s");
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_GRACE:
+        if ((my.grace = parse_secs(optarg)) < 0) {
+          NOTIFY(ERROR, "--grace takes a time like -t, ex: --grace=2s");
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_HAR:
+        xfree(my.har);
+        my.har = xstrdup(optarg);
+        break;
+      case OPT_SCENARIO:
+        xfree(my.scenario);
+        my.scenario = xstrdup(optarg);
+        break;
+      case OPT_ZIPF:
+        my.zipf = atof(optarg);
+        if (my.zipf <= 0) {
+          NOTIFY(ERROR, "--zipf takes an exponent more than 0, ex: --zipf=1.1");
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_REPLAY:
+        xfree(my.replay);
+        my.replay = xstrdup(optarg);
+        break;
+      case OPT_FORMAT:
+        xfree(my.format);
+        my.format = xstrdup(optarg);
+        break;
+      case OPT_SPEED:
+        my.speed = atof(optarg);
+        if (my.speed <= 0) {
+          NOTIFY(ERROR, "--speed takes a factor more than 0, ex: --speed=2.0");
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case OPT_VFILE:
+        xfree(my.vfile);
+        my.vfile = xstrdup(optarg);
+        break;
+      case OPT_STACK:
+        my.stack = atoi(optarg);
+        if (my.stack < 0) {
+          NOTIFY(ERROR, "--thread-stack requires a size in KB");
+          exit(EXIT_FAILURE);
+        }
+        break;
 
     } /* end of switch( c )           */
   }   /* end of while c = getopt_long */
@@ -346,10 +638,142 @@ __config_setup(int argc, char *argv[])
     show_config(TRUE);    
   }
 
+  /**
+   * A profile starts as many users as it ever has active and
+   * runs as long as its stages unless -t says otherwise. An
+   * agent's -c is already its share.
+   */
+  if (my.profile != NULL) {
+    PROFILE P = new_profile(my.profile);
+    if (P == NULL) {
+      exit(EXIT_FAILURE);
+    }
+    if (! dist_is_job()) {
+      my.cusers = profile_get_users(P);
+    }
+    if (my.secs <= 0) {
+      my.secs = profile_get_secs(P);
+    }
+    P = profile_destroy(P);
+  }
+
+  /**
+   * A capacity search drives the users itself; -c is as far as
+   * it goes and it ends the run when it's done.
+   */
+  if (my.capacity > 0) {
+    SEARCH S;
+    if (my.profile != NULL || my.coordinator || my.get) {
+      NOTIFY(ERROR, "--find-capacity can't be used with --profile, --coordinator or --get");
+      exit(EXIT_FAILURE);
+    }
+    if (my.procs > 1) {
+      NOTIFY(WARNING, "--find-capacity runs in one process; ignoring --procs");
+      my.procs = 1;
+    }
+    if ((S = new_search(my.slo, my.cusers, my.capacity)) == NULL) {
+      exit(EXIT_FAILURE);
+    }
+    if (my.secs <= 0) {
+      my.secs = search_get_secs(S);
+    }
+    S = search_destroy(S);
+  }
+
+  /**
+   * A replay's log says when each user starts and it already
+   * has the page's resources; it plays in one process.
+   */
+  if (my.replay != NULL) {
+    if (my.profile != NULL || my.capacity > 0 || my.coordinator || my.get) {
+      NOTIFY(ERROR, "--replay can't be used with --profile, --find-capacity, --coordinator or --get");
+      exit(EXIT_FAILURE);
+    }
+    if (my.procs > 1) {
+      NOTIFY(WARNING, "--replay runs in one process; ignoring --procs");
+      my.procs = 1;
+    }
+    my.parser = FALSE;
+  }
+
+  /**
+   * A HAR has every request the pages made, redirects and all
+   */
+  if (my.har != NULL) {
+    if (my.replay != NULL || my.get) {
+      NOTIFY(ERROR, "--har can't be used with --replay or --get");
+      exit(EXIT_FAILURE);
+    }
+    my.parser = FALSE;
+    my.follow = FALSE;
+  }
+  if (my.zipf > 0 && my.replay != NULL) {
+    NOTIFY(WARNING, "--replay plays the log in order; ignoring --zipf");
+    my.zipf = 0.0;
+  }
+
+  /**
+   * A scenario's classes say how many users there are; we add
+   * them up here and load the classes again for the run.
+   */
+  if (my.scenario != NULL) {
+    int   n;
+    ARRAY C;
+    ARRAY U = new_array();
+    if (my.har != NULL || my.replay != NULL || my.profile != NULL || my.capacity > 0 || my.coordinator || my.get) {
+      NOTIFY(ERROR, "--scenario can't be used with --har, --replay, --profile, --find-capacity, --coordinator or --get");
+      exit(EXIT_FAILURE);
+    }
+    if ((C = new_classes(my.scenario, U)) == NULL) {
+      exit(EXIT_FAILURE);
+    }
+    if (my.procs > 1) {
+      NOTIFY(WARNING, "--scenario runs in one process; ignoring --procs");
+      my.procs = 1;
+    }
+    if (my.zipf > 0) {
+      NOTIFY(WARNING, "--scenario classes pick their own URLs; ignoring --zipf");
+      my.zipf = 0.0;
+    }
+    my.cusers = 0;
+    for (n = 0; n < (int)array_length(C); n++) {
+      my.cusers += class_get_users((CLASS)array_get(C, n));
+    }
+    C = array_destroyer(C, (void*)class_destroy);
+    U = array_destroyer(U, (void*)url_destroy);
+  }
+
+  /**
+   * The warm-up and cool-down come out of the run so they have
+   * to leave some of it; we only know where the end is with -t.
+   */
+  if (my.warmup < 0 || my.cooldown < 0 || my.stagger < 0 || my.grace < 0) {
+    NOTIFY(ERROR, "warmup, cooldown, stagger and grace take a time like -t, ex: warmup = 30s");
+    exit(EXIT_FAILURE);
+  }
+  if (my.cooldown > 0 && my.secs <= 0) {
+    errno = 0;
+    NOTIFY(WARNING, "--cooldown needs a timed run (-t); ignoring it");
+    my.cooldown = 0;
+  }
+  if (my.secs > 0 && my.warmup + my.cooldown >= my.secs) {
+    NOTIFY(ERROR, "--warmup and --cooldown leave nothing of a %d second run", my.secs);
+    exit(EXIT_FAILURE);
+  }
+
+  /**
+   * We open it here, before --procs forks, so the workers all
+   * append to the same file.
+   */
+  if (my.vfile != NULL && ! my.get && ! my.print && writer_open(my.vfile) == FALSE) {
+    NOTIFY(FATAL, "unable to open %s", my.vfile);
+  }
+
   /** 
    * Let's tap the brakes and make sure the user knows what they're doing...
+   * A coordinator's users run on the agents; they check for themselves.
    */ 
-  if (my.cusers > my.limit) {
+  if (my.cusers > my.limit && ! my.coordinator && ! my.agent) {
     printf("\n");
     printf("================================================================\n");
     printf("WARNING: The number of users is capped at %d.%sTo increase this\n", my.limit, (my.limit>999)?" ":"  ");
@@ -360,6 +784,28 @@ __config_setup(int argc, char *argv[])
     sleep(10);
     my.cusers = my.limit;
   }
+
+  if (my.stack > 0 && my.stack < MIN_STACK) {
+    NOTIFY(WARNING, "thread-stack %d KB is too small; using %d KB", my.stack, MIN_STACK);
+    my.stack = MIN_STACK;
+  }
+
+  /**
+   * Now make sure the host can take that many. If it can't,
+   * we'd find out half way through the ramp when pthread_create
+   * or socket starts to fail; better to say so up front.
+   */
+  if (! my.get && ! my.coordinator && ! my.agent) {
+    int fds = strmatch(socket_get_backend(), "select") ? 1 : 2;
+    int max = preflight(my.cusers, (size_t)my.stack * 1024, fds, my.debug);
+    if (max < 1) {
+      NOTIFY(FATAL, "preflight: this host can't start another user");
+    }
+    if (max < my.cusers) {
+      NOTIFY(WARNING, "preflight: this host can run at most %d users; proceeding with %d", max, max);
+      my.cusers = max;
+    }
+  }
 }
 
 private LINES *
@@ -371,6 +817,10 @@ __urls_setup()
   lines->index   = 0;
   lines->line    = NULL;
 
+  if (my.har != NULL || my.scenario != NULL) {
+    my.length = 0;
+    return lines;
+  }
   if (my.url != NULL) {
     my.length = 1; 
   } else { 
@@ -404,12 +854,726 @@ __save_cookies(char *file, char *text)
   return TRUE; 
 }
 
+/**
+ * Connections per source address; a CIDR pool could be huge
+ * so we only list the addresses we used, up to a point.
+ */
+private void
+__show_sources()
+{
+  int   i;
+  int   shown = 0;
+  int   used  = 0;
+  char *name;
+  unsigned long conns;
+
+  fprintf(stderr, "Source addresses:\t%9d\n", socket_get_sources());
+  for (i = 0; i < socket_get_sources(); i++) {
+    name = socket_get_source(i, &conns);
+    if (conns == 0) continue;
+    used++;
+    if (shown < 32) {
+      fprintf(stderr, "  %-22s%9lu    conns\n", name, conns);
+      shown++;
+    }
+  }
+  if (used > shown) {
+    fprintf(stderr, "  (%d more)\n", used - shown);
+  }
+}
+
+/**
+ * Busy time of each core we ran on, four to a line. A core
+ * near 100% means siege, not the server, set the pace.
+ */
+/**
+ * Hits by agent, in the order they were listed
+ */
+private void
+__show_agents(DIST dist)
+{
+  int          i;
+  char        *name;
+  unsigned int hits;
+
+  fprintf(stderr, "Agents:\t\t\t%9d\n", dist_get_count(dist));
+  for (i = 0; i < dist_get_count(dist); i++) {
+    name = dist_get_agent(dist, i, &hits);
+    fprintf(stderr, "  %-22s%9u    hits\n", name, hits);
+  }
+}
+
+/**
+ * Load times of the --har pages. A user sends a page's requests
+ * one at a time, waves included, so these are serial loads; a
+ * browser's would be shorter. A worker's or an agent's pages
+ * stay with them, so there's nothing to show for those runs.
+ */
+private void
+__show_pages(HAR har)
+{
+  int   i;
+  char *name;
+  float p50, p90, highest;
+  unsigned long loads, failed;
+  unsigned long total = 0;
+
+  for (i = 0; i < har_get_pages(har); i++) {
+    har_get_page(har, i, &loads, &failed, &p50, &p90, &highest);
+    total += loads;
+  }
+  if (total == 0) return;
+
+  fprintf(stderr, "Page loads (serial):\t%9s %9s %9s %9s %9s\n", "p50 ms", "p90 ms", "longest", "loads", "failed");
+  for (i = 0; i < har_get_pages(har); i++) {
+    name = har_get_page(har, i, &loads, &failed, &p50, &p90, &highest);
+    if (loads == 0) continue;
+    fprintf(stderr, "  %11d waves %9.2f %9.2f %9.2f %9lu %9lu\n", har_get_waves(har, i),
+      1000 * p50, 1000 * p90, 1000 * highest, loads, failed
+    );
+    fprintf(stderr, "    %s\n", name);
+  }
+  if (har_get_skipped(har) > 0) {
+    fprintf(stderr, "HAR entries skipped:\t%9lu\n", har_get_skipped(har));
+  }
+}
+
+/**
+ * The class of the user with this index; they're dealt out in
+ * the order of the scenario file
+ */
+private CLASS
+__class(ARRAY classes, int user)
+{
+  int i;
+  CLASS C = NULL;
+
+  for (i = 0; i < (int)array_length(classes); i++) {
+    C = (CLASS)array_get(classes, i);
+    if (user < class_get_users(C)) break;
+    user -= class_get_users(C);
+  }
+  return C;
+}
+
+/**
+ * Each --scenario class next to the others; the numbers above
+ * are all of them together
+ */
+private void
+__show_classes(ARRAY classes)
+{
+  int   i;
+  CLASS C;
+  DATA  D;
+
+  fprintf(stderr, "User classes:\t\t%9s %9s %9s %9s %9s %9s\n", "users", "trans", "trans/sec", "resp ms", "p90 ms", "failed");
+  for (i = 0; i < (int)array_length(classes); i++) {
+    C = (CLASS)array_get(classes, i);
+    D = class_get_data(C);
+    data_get_elapsed(D); /* the rate divides by it */
+    fprintf(stderr, "  %-22.22s%9d %9u %9.2f %9.2f %9.2f %9u\n", class_get_name(C),
+      class_get_users(C), data_get_count(D), data_get_transaction_rate(D),
+      1000 * data_get_response_time(D), 1000 * data_get_percentile(D, 90), data_get_fail(D)
+    );
+  }
+}
+
+/**
+ * The weight=NUM that may lead a line in the URLs file; it moves
+ * line past it. Lines without one weigh 1, a bad one is -1.
+ */
+private double
+__weight(char **line)
+{
+  char  *end;
+  double weight;
+
+  if (strncasecmp(*line, "weight=", 7) != 0) {
+    return 1.0;
+  }
+  weight = strtod(*line + 7, &end);
+  if (end == *line + 7 || !(weight >= 0)) {
+    return -1.0;
+  }
+  while (isspace((unsigned char)*end)) end++;
+  *line = end;
+  return weight;
+}
+
+/**
+ * A URL or, with --har, a page by its index in the alias table
+ */
+private char *
+__hit_name(ARRAY urls, HAR har, int index)
+{
+  float p50, p90, highest;
+  unsigned long loads, failed;
+
+  if (har != NULL) {
+    return har_get_page(har, index, &loads, &failed, &p50, &p90, &highest);
+  }
+  return url_get_absolute((URL)array_get(urls, index));
+}
+
+/**
+ * The URLs with the largest shares next to the share of the hits
+ * they got, and how far all the hits are from the weights: half
+ * the sum of the differences, 0% is a perfect match. We count in
+ * this process so there's nothing to show for workers and agents.
+ */
+private void
+__show_hits(ALIAS alias, ARRAY urls, HAR har)
+{
+  int    i, j, k;
+  int    n   = alias_get_length(alias);
+  int    top = (my.urlstats > 0) ? my.urlstats : 10;
+  int   *idx;
+  double distance = 0.0;
+  unsigned long total = 0;
+
+  for (i = 0; i < n; i++) {
+    total += alias_get_hits(alias, i);
+  }
+  if (total == 0) return;
+
+  for (i = 0; i < n; i++) {
+    distance += fabs(alias_get_share(alias, i) - (double)alias_get_hits(alias, i) / total);
+  }
+  if (top > n) top = n;
+  idx = xcalloc(sizeof(int), top);
+  for (i = 0, k = 0; i < n; i++) {
+    if (k == top && alias_get_share(alias, idx[k-1]) >= alias_get_share(alias, i)) continue;
+    j = (k < top) ? k++ : top - 1;
+    while (j > 0 && alias_get_share(alias, idx[j-1]) < alias_get_share(alias, i)) {
+      idx[j] = idx[j-1];
+      j--;
+    }
+    idx[j] = i;
+  }
+
+  fprintf(stderr, "URL hits:\t\t%9s %9s %9s\n", "weight %", "hits %", "hits");
+  for (i = 0; i < k; i++) {
+    fprintf(stderr, "  %-22s%9.2f %9.2f %9lu\n", "",
+      100 * alias_get_share(alias, idx[i]), 100.0 * alias_get_hits(alias, idx[i]) / total,
+      alias_get_hits(alias, idx[i])
+    );
+    fprintf(stderr, "    %s\n", __hit_name(urls, har, idx[i]));
+  }
+  fprintf(stderr, "Hits off the weights:\t%9.2f %%\n", 50 * distance);
+  xfree(idx);
+}
+
+/**
+ * Hits by load profile stage
+ */
+private void
+__show_stages(PROFILE profile)
+{
+  int           i;
+  int           users;
+  float         secs;
+  char         *label;
+  unsigned long hits;
+
+  fprintf(stderr, "Profile stages:\t\t%9d\n", profile_get_stages(profile));
+  for (i = 0; i <= profile_get_stages(profile); i++) {
+    label = profile_get_stage(profile, i, &users, &hits, &secs);
+    if (i == profile_get_stages(profile) && secs <= 0) break;
+    fprintf(stderr, "  %-34s%6d users%9lu hits%10.2f trans/sec\n",
+      label, users, hits, (secs > 0) ? hits / secs : 0
+    );
+  }
+}
+
+/**
+ * The capacity search's answer and the windows it took to
+ * get there
+ */
+private void
+__show_capacity(SEARCH search)
+{
+  int   i;
+  int   users;
+  float rate;
+  float errors;
+  float pct[3];
+  char *missed;
+
+  fprintf(stderr, "SLO:\t\t\t%s\n", search_get_slo(search));
+  if (search_get_users(search) > 0) {
+    fprintf(stderr, "Capacity:\t\t%9d    users\n", search_get_users(search));
+    fprintf(stderr, "Capacity rate:\t\t%12.2f trans/sec\n", search_get_rate(search));
+  } else {
+    fprintf(stderr, "Capacity:\t\tno level met the SLO\n");
+  }
+  fprintf(stderr, "  %6s %12s %10s %10s %10s %8s\n", "users", "trans/sec", "p50 ms", "p90 ms", "p99 ms", "errors");
+  for (i = 0; i < search_get_steps(search); i++) {
+    users = search_get_step(search, i, &rate, pct, &errors, &missed);
+    fprintf(stderr, "  %6d %12.2f %10.2f %10.2f %10.2f %7.2f%%  %s\n",
+      users, rate, 1000 * pct[0], 1000 * pct[1], 1000 * pct[2], errors, (missed == NULL) ? "met" : missed
+    );
+  }
+}
+
+/**
+ * This run against the --compare run. Each change has a 95%
+ * confidence interval from resampling the two runs' seconds;
+ * a change whose interval misses zero is real.
+ */
+private void
+__show_comparison(HISTORY history, int regressed)
+{
+  int    i;
+  char  *name;
+  char  *verdict;
+  char   label[32];
+  double base;
+  double current;
+  float  change;
+  float  low;
+  float  high;
+
+  fprintf(stderr, "Compared to:\t\t%s\n", my.compare);
+  fprintf(stderr, "  %-9s %12s %12s %9s %21s\n", "", "baseline", "this run", "change", "95% interval");
+  for (i = 0; i < history_get_rows(history); i++) {
+    name  = history_get_row(history, i, &base, &current, &change, &low, &high, &verdict);
+    if (strcmp(name, "rate") == 0) {
+      snprintf(label, sizeof(label), "trans/sec");
+    } else {
+      snprintf(label, sizeof(label), "%s ms", name);
+      base    *= 1000;
+      current *= 1000;
+    }
+    fprintf(stderr, "  %-9s %12.2f %12.2f %+8.2f%% [%+7.2f%%, %+7.2f%%]  %s\n",
+      label, base, current, change, low, high, verdict
+    );
+  }
+  fprintf(stderr, "Regressions:\t\t%9d\n", regressed);
+}
+
+/**
+ * Each --assert against the run, then the one that ended it
+ * early, if one did; siege exits with the code of the first
+ * one that failed.
+ */
+private void
+__show_assertions(GATE gate)
+{
+  int     i;
+  int     secs;
+  int     failed = 0;
+  char   *term;
+  char   *shown;
+  BOOLEAN passed;
+
+  for (i = 0; i < gate_get_terms(gate); i++) {
+    gate_get_term(gate, i, NULL, NULL, &passed);
+    if (! passed) failed++;
+  }
+  fprintf(stderr, "Assertions:\t\t%d of %d failed\n", failed, gate_get_terms(gate));
+  for (i = 0; i < gate_get_terms(gate); i++) {
+    term = gate_get_term(gate, i, NULL, &shown, &passed);
+    fprintf(stderr, "  %-22s %18s  %s\n", term, shown, (passed) ? "pass" : "FAIL");
+  }
+  if ((term = gate_get_abort(gate, &secs, &shown)) != NULL) {
+    fprintf(stderr, "Ended early:\t\t%s was %s over the last %d secs\n", term, shown, secs);
+  }
+}
+
+/**
+ * The worst few URLs, slowest by p90 and most failing, then
+ * every host; a URL's redirects and page resources count
+ * toward it.
+ */
+private void
+__show_urls(URLSTATS urlstats)
+{
+  int     i;
+  int     n;
+  int    *top = xcalloc(sizeof(int), my.urlstats);
+  URLROW *R;
+
+  n = urlstats_rank(urlstats, URLSTATS_SLOWEST, top, my.urlstats);
+  fprintf(stderr, "Slowest URLs:\t\t%9s %9s %9s %9s\n", "p50 ms", "p90 ms", "p99 ms", "hits");
+  for (i = 0; i < n; i++) {
+    R = urlstats_get_url(urlstats, top[i]);
+    fprintf(stderr, "  %21s %9.2f %9.2f %9.2f %9lu\n", "", 1000 * R->p50, 1000 * R->p90, 1000 * R->p99, R->hits);
+    fprintf(stderr, "    %s\n", R->name);
+  }
+  n = urlstats_rank(urlstats, URLSTATS_FAILING, top, my.urlstats);
+  if (n > 0) {
+    fprintf(stderr, "Most failing URLs:\t%9s %9s %9s  %s\n", "errors", "failed", "percent", "cause");
+    for (i = 0; i < n; i++) {
+      R = urlstats_get_url(urlstats, top[i]);
+      fprintf(stderr, "  %21s %9lu %9lu %9.2f  %s\n", "", R->errors, R->failed,
+        100.0 * (R->errors + R->failed) / (R->hits + R->failed), fault_name(R->cause)
+      );
+      fprintf(stderr, "    %s\n", R->name);
+    }
+  }
+  fprintf(stderr, "Hosts:\t\t\t%9s %9s %9s %9s\n", "p90 ms", "hits", "errors", "failed");
+  for (i = 0; i < urlstats_get_hosts(urlstats); i++) {
+    R = urlstats_get_host(urlstats, i);
+    fprintf(stderr, "  %-21s %9.2f %9lu %9lu %9lu\n", R->name, 1000 * R->p90, R->hits, R->errors, R->failed);
+  }
+  xfree(top);
+}
+
+/**
+ * What went wrong, by cause; nothing if nothing did
+ */
+private void
+__show_faults()
+{
+  int i;
+
+  for (i = FAULT_NONE + 1; i < FAULTS; i++) {
+    if (fault_get_count((FAULT)i) == 0) continue;
+    fprintf(stderr, "  %-21s %9lu\n", fault_name((FAULT)i), fault_get_count((FAULT)i));
+  }
+}
+
+private void
+__show_cores()
+{
+  int    i;
+  int    cpu;
+  int    hot = 0;
+  double usage;
+
+  fprintf(stderr, "CPU utilization:\n");
+  for (i = 0; i < cpu_get_cores(); i++) {
+    usage = cpu_get_usage(i, &cpu);
+    if (usage >= 90.0) hot++;
+    fprintf(stderr, "%s cpu%-4d%7.2f %%", (i % 4 == 0) ? " " : "   ", cpu, usage);
+    if (i % 4 == 3 || i == cpu_get_cores() - 1) {
+      fprintf(stderr, "\n");
+    }
+  }
+  if (hot > 0) {
+    fprintf(stderr, "Saturated cores:\t%9d\n", hot);
+  }
+}
+
+private double
+__edge_hit_ratio(EDGE edge)
+{
+  double lookups = (double)edge_get_hits(edge) + edge_get_misses(edge);
+
+  return (lookups == 0) ? 0 : (double)edge_get_hits(edge) / lookups * 100;
+}
+
+/**
+ * The share of requests (or bytes) that the edge kept away
+ * from the origin; everything we actually sent got there.
+ */
+private double
+__edge_offload(EDGE edge, DATA data, BOOLEAN bytes)
+{
+  double served = (bytes) ? (double)edge_get_bytes(edge) : (double)edge_get_hits(edge);
+  double origin = (bytes) ? (double)data_get_bytes(data) : (double)data_get_count(data);
+
+  return (served + origin == 0) ? 0 : served / (served + origin) * 100;
+}
+
+/**
+ * System calls the socket layer made per transaction; it's
+ * how we compare the I/O backends.
+ */
+private double
+__syscall_rate(DATA data)
+{
+  return (data_get_count(data) == 0) ? 0 : (double)socket_get_syscalls() / data_get_count(data);
+}
+
+/**
+ * The comparison for --json-output; low and high bound the change
+ */
+private void
+__json_comparison(HISTORY history, int regressed)
+{
+  int    i;
+  char  *name;
+  char  *verdict;
+  double base;
+  double current;
+  float  change;
+  float  low;
+  float  high;
+
+  printf("\t\"comparison\":\t\t\t{\"baseline\": \"%s\", \"regressions\": %d, \"metrics\": [", my.compare, regressed);
+  for (i = 0; i < history_get_rows(history); i++) {
+    name = history_get_row(history, i, &base, &current, &change, &low, &high, &verdict);
+    printf("%s\n\t\t{\"metric\": \"%s\", \"baseline\": %.6f, \"current\": %.6f, \"change\": %.2f, \"low\": %.2f, \"high\": %.2f, \"verdict\": \"%s\"}",
+      (i > 0) ? "," : "", name, base, current, change, low, high, verdict
+    );
+  }
+  printf("\n\t]},\n");
+}
+
+/**
+ * The --assert terms for --json-output; value is in secs,
+ * trans/sec, percent or a count, whatever the term measured.
+ */
+private void
+__json_assertions(GATE gate, int verdict)
+{
+  int     i;
+  int     secs;
+  char   *term;
+  char   *shown;
+  double  value;
+  BOOLEAN passed;
+
+  term = gate_get_abort(gate, &secs, &shown);
+  printf("\t\"assertions\":\t\t\t{\"exit_code\": %d, \"aborted\": ", verdict);
+  if (term != NULL) {
+    printf("{\"term\": \"%s\", \"window\": %d}", term, secs);
+  } else {
+    printf("null");
+  }
+  printf(", \"terms\": [");
+  for (i = 0; i < gate_get_terms(gate); i++) {
+    term = gate_get_term(gate, i, &value, NULL, &passed);
+    printf("%s\n\t\t{\"term\": \"%s\", \"value\": %.6f, \"passed\": %s}",
+      (i > 0) ? "," : "", term, value, (passed) ? "true" : "false"
+    );
+  }
+  printf("\n\t]},\n");
+}
+
+private void
+__json_row(const char *key, URLROW *R, BOOLEAN last)
+{
+  int i;
+  int n = 0;
+
+  printf("\t\t{\"%s\": \"%s\", \"transactions\": %lu, \"errors\": %lu, \"failed\": %lu, "
+         "\"bytes\": %llu, \"response_time\": %.6f, \"p50\": %.6f, \"p90\": %.6f, \"p99\": %.6f, "
+         "\"longest_transaction\": %.6f, \"codes\": {\"1xx\": %lu, \"2xx\": %lu, \"3xx\": %lu, "
+         "\"4xx\": %lu, \"5xx\": %lu, \"other\": %lu}, \"faults\": {",
+    key, R->name, R->hits, R->errors, R->failed, R->bytes, (R->hits == 0) ? 0 : R->time / R->hits,
+    R->p50, R->p90, R->p99, R->highest, R->codes[1], R->codes[2], R->codes[3], R->codes[4], R->codes[5],
+    R->codes[0]
+  );
+  for (i = FAULT_NONE + 1; i < FAULTS; i++) {
+    if (R->faults[i] == 0) continue;
+    printf("%s\"%s\": %lu", (n++ > 0) ? ", " : "", fault_name((FAULT)i), R->faults[i]);
+  }
+  printf("}}%s\n", (last) ? "" : ",");
+}
+
+/**
+ * Every --har page for --json-output; times are in seconds and
+ * they're serial loads, see __show_pages
+ */
+private void
+__json_pages(HAR har)
+{
+  int   i;
+  char *name;
+  float p50, p90, highest;
+  unsigned long loads, failed;
+
+  printf("\t\"pages\":\t\t\t[\n");
+  for (i = 0; i < har_get_pages(har); i++) {
+    name = har_get_page(har, i, &loads, &failed, &p50, &p90, &highest);
+    printf("\t\t{\"page\": \"%s\", \"requests\": %d, \"waves\": %d, \"loads\": %lu, \"failed\": %lu, "
+           "\"load\": \"serial\", \"p50\": %.6f, \"p90\": %.6f, \"longest_load\": %.6f}%s\n",
+      name, har_get_length(har, i), har_get_waves(har, i), loads, failed, p50, p90, highest,
+      (i == har_get_pages(har) - 1) ? "" : ","
+    );
+  }
+  printf("\t],\n");
+}
+
+/**
+ * Every --scenario class for --json-output; times are in seconds
+ */
+private void
+__json_classes(ARRAY classes)
+{
+  int   i;
+  int   n = (int)array_length(classes);
+  CLASS C;
+  DATA  D;
+
+  printf("\t\"classes\":\t\t\t[\n");
+  for (i = 0; i < n; i++) {
+    C = (CLASS)array_get(classes, i);
+    D = class_get_data(C);
+    data_get_elapsed(D);
+    printf("\t\t{\"class\": \"%s\", \"users\": %d, \"transactions\": %u, \"failed_transactions\": %u, "
+           "\"transaction_rate\": %.2f, \"response_time\": %.6f, \"p90\": %.6f, \"data_transferred\": %.2f}%s\n",
+      class_get_name(C), class_get_users(C), data_get_count(D), data_get_fail(D),
+      data_get_transaction_rate(D), data_get_response_time(D), data_get_percentile(D, 90),
+      data_get_megabytes(D), (i == n - 1) ? "" : ","
+    );
+  }
+  printf("\t],\n");
+}
+
+/**
+ * Every weighted URL or page for --json-output: its share of the
+ * weight and the hits it got
+ */
+private void
+__json_hits(ALIAS alias, ARRAY urls, HAR har)
+{
+  int i;
+  int n = alias_get_length(alias);
+
+  printf("\t\"url_hits\":\t\t\t[\n");
+  for (i = 0; i < n; i++) {
+    printf("\t\t{\"url\": \"%s\", \"share\": %.6f, \"hits\": %lu}%s\n",
+      __hit_name(urls, har, i), alias_get_share(alias, i), alias_get_hits(alias, i),
+      (i == n - 1) ? "" : ","
+    );
+  }
+  printf("\t],\n");
+}
+
+/**
+ * Every URL and host for --json-output; times are in seconds
+ */
+private void
+__json_urls(URLSTATS urlstats)
+{
+  int i;
+  int n;
+
+  n = urlstats_get_urls(urlstats);
+  printf("\t\"urls\":\t\t\t[\n");
+  for (i = 0; i < n; i++) {
+    __json_row("url", urlstats_get_url(urlstats, i), i == n - 1);
+  }
+  printf("\t],\n");
+  n = urlstats_get_hosts(urlstats);
+  printf("\t\"hosts\":\t\t\t[\n");
+  for (i = 0; i < n; i++) {
+    __json_row("host", urlstats_get_host(urlstats, i), i == n - 1);
+  }
+  printf("\t],\n");
+}
+
+/**
+ * What siege cost to run and whether it kept up; status says
+ * "client-saturated" when it was the bottleneck.
+ */
+private void
+__json_client(DATA data)
+{
+  MONSTATS s;
+  char     reasons[256];
+  BOOLEAN  saturated = monitor_saturated(reasons, sizeof(reasons));
+
+  monitor_get_stats(&s);
+  printf("\t\"client_cpu_per_transaction\":\t%12.2f,\n", monitor_cpu_per_trans(data_get_count(data)));
+  printf("\t\"client\":\t\t\t{\"cpu_percent\": %.2f, \"peak_cpu_percent\": %u, \"busiest_thread_percent\": %u, "
+         "\"cpus\": %u, \"run_queue_ms\": %.3f, \"max_lag_ms\": %.2f, \"peak_rss_kb\": %lu, \"peak_fds\": %lu, "
+         "\"saturated_seconds\": %u, \"sampled_seconds\": %u},\n",
+    (s.wall > 0) ? (double)s.cpu / s.wall * 100.0 : 0.0, s.peak, s.hot, s.cpus,
+    (s.slices > 0) ? (double)s.delay / s.slices / 1000.0 : 0.0, s.lag / 1000.0,
+    s.rss, s.fds, s.saturated, s.seconds
+  );
+  if (saturated) {
+    printf("\t\"status\":\t\t\t\"client-saturated\",\n");
+    printf("\t\"saturation\":\t\t\t\"%s\",\n", reasons);
+  } else {
+    printf("\t\"status\":\t\t\t\"ok\",\n");
+  }
+}
+
+private void
+__banner()
+{
+  if (!my.get && !my.quiet) {
+    fprintf(stderr, "** "); 
+    display_version(FALSE);
+    fprintf(stderr, "** Preparing %d concurrent users for battle.\n", my.cusers);
+    fprintf(stderr, "The server is now under siege...");
+    if (my.verbose) { fprintf(stderr, "\n"); }
+  } 
+}
+
+/**
+ * Adds a browser's numbers to data
+ */
+private void
+__tally_browser(DATA data, BROWSER B, BOOLEAN cookies)
+{
+  data_increment_count  (data, browser_get_hits(B));
+  data_increment_bytes  (data, browser_get_bytes(B));
+  data_increment_total  (data, browser_get_time(B));
+  data_increment_code   (data, browser_get_code(B));
+  data_increment_okay   (data, browser_get_okay(B));
+  data_increment_fail   (data, browser_get_fail(B));
+  data_increment_cached (data, browser_get_cached(B));
+  data_set_highest      (data, browser_get_himark(B));
+  data_set_lowest       (data, browser_get_lomark(B));
+  data_increment_hist   (data, browser_get_hist(B));
+  if (cookies) {
+    data_increment_cookies(data, browser_get_cookies(B));
+  }
+}
+
+/**
+ * Adds the first count browsers' numbers to data. Cookies
+ * are only safe to read once the browsers are done.
+ */
+private void
+__tally(DATA data, ARRAY browsers, int count, BOOLEAN cookies)
+{
+  int i;
+
+  for (i = 0; i < count; i++) {
+    __tally_browser(data, (BROWSER)array_get(browsers, i), cookies);
+  }
+}
+
+typedef struct {
+  PROCS  procs;
+  DIST   dist;
+  ARRAY  browsers;
+  PCACHE pcache;
+  EDGE   edge;
+} WORKER;
+
+/**
+ * A worker's running totals go to the parent once a second
+ * so it can watch the failure count and so we don't lose
+ * everything if this process dies; an agent's go to its
+ * coordinator. The browsers are busy while we read them; a
+ * stale count here is fine.
+ */
+private void *
+__publisher(void *arg)
+{
+  WORKER *W = (WORKER *)arg;
+  DATA    D;
+
+  while (TRUE) {
+    dist_sleep(W->dist, 1);
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+    D = new_data();
+    __tally(D, W->browsers, array_length(W->browsers), FALSE);
+    procs_publish(W->procs, D, W->pcache, W->edge, FALSE);
+    dist_publish(W->dist, D, W->pcache, W->edge, FALSE);
+    D = data_destroy(D);
+    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+  }
+  return NULL;
+}
+
 
 int 
 main(int argc, char *argv[])
 {
   int       i, j;
   int       result   = 0;
+  int       first    = 0;
+  int       total    = 0;
   void  *   status   = NULL;
   char      name[]   = "cookies.txt";
   char  *   home     = getenv("HOME");
@@ -420,9 +1584,32 @@ main(int argc, char *argv[])
   DATA      data     = NULL;
   ARRAY     urls     = new_array();
   ARRAY     browsers = new_array();
+  PCACHE    pcache   = NULL;
+  EDGE      edge     = NULL;
+  PROCS     procs    = NULL;
+  DIST      dist     = NULL;
+  PROFILE   profile  = NULL;
+  SEARCH    search   = NULL;
+  HISTORY   history  = NULL;
+  HISTORY   base     = NULL;
+  int       regressed = 0;
+  GATE      gate     = NULL;
+  URLSTATS  urlstats = NULL;
+  REPLAY    replay   = NULL;
+  HAR       har      = NULL;
+  ALIAS     alias    = NULL;
+  ARRAY     classes  = NULL;
+  double *  weights  = NULL;
+  BOOLEAN   weighted = FALSE;
+  int       verdict  = EXIT_SUCCESS;
+  float     end      = 0.0;
+  char      record[4096];
   pthread_t cease; 
   pthread_t timer;  
+  pthread_t publisher;
   pthread_attr_t scope_attr;
+  char      opts[128];
+  char      saturated[256];
 
 
   file = xmalloc(sizeof (char*) * length);
@@ -431,6 +1618,9 @@ main(int argc, char *argv[])
  
   __signal_setup();
   __config_setup(argc, argv);
+  if (my.agent) {
+    dist_serve(argv[0]);
+  }
   lines = __urls_setup();
 
   pthread_attr_init(&scope_attr);
@@ -447,7 +1637,15 @@ main(int argc, char *argv[])
   SSL_thread_setup();
 #endif
 
-  if (my.url != NULL) {
+  if (my.scenario != NULL) {
+    if ((classes = new_classes(my.scenario, urls)) == NULL) {
+      exit(EXIT_FAILURE);
+    }
+  } else if (my.har != NULL) {
+    if ((har = new_har(my.har, urls)) == NULL) {
+      exit(EXIT_FAILURE);
+    }
+  } else if (my.url != NULL) {
     URL tmp = new_url(my.url);
     url_set_ID(tmp, 0);
     if (my.get && url_get_method(tmp) != POST && url_get_method(tmp) != PUT) {
@@ -455,31 +1653,160 @@ main(int argc, char *argv[])
     }
     array_npush(urls, tmp, URLSIZE); // from cmd line
   } else { 
+    weights = xcalloc(sizeof(double), (my.length > 0) ? my.length : 1);
     for (i = 0; i < my.length; i++) {
-      URL tmp = new_url(lines->line[i]);
+      char  *line   = lines->line[i];
+      double weight = __weight(&line);
+      if (weight < 0) {
+        errno = 0;
+        NOTIFY(ERROR, "%s: a weight is a number of 0 or more, ex: weight=2.5 %s", my.file, line);
+        exit(EXIT_FAILURE);
+      }
+      if (line != lines->line[i]) {
+        weighted = TRUE;
+      }
+      URL tmp = new_url(line);
       if (tmp == NULL) {
         // fprintf(stderr, "new_url failed for index %zu\n", i);
         continue;
       }
       url_set_ID(tmp, i);
+      weights[array_length(urls)] = weight;
       array_npush(urls, tmp, URLSIZE);
     }
   } 
 
+  /**
+   * Weighted URLs or --zipf: the browsers pick the URLs, or the
+   * --har pages, at random in proportion to their weights. A zipf
+   * exponent ranks them in file order and trumps the weights.
+   */
+  if ((weighted || my.zipf > 0) && ! my.get && my.replay == NULL) {
+    int n = (har != NULL) ? har_get_pages(har) : (int)array_length(urls);
+    alias = (my.zipf > 0) ? new_alias_zipf(my.zipf, n) : new_alias(weights, n);
+    if (alias == NULL) {
+      errno = 0;
+      NOTIFY(ERROR, "%s: the URL weights add up to nothing", my.file);
+      exit(EXIT_FAILURE);
+    }
+  }
+  xfree(weights);
+
+  if (my.parser == TRUE && my.pcache > 0) {
+    pcache = new_pcache(my.pcache, (size_t)my.pcache_size * 1024 * 1024);
+  }
+
+  if (my.edge > 0) {
+    edge = new_edge(my.edge);
+  }
+
+  /**
+   * The log's requests go to the server of the first URL
+   */
+  if (my.replay != NULL && (replay = new_replay(my.replay, my.format, my.speed, array_get(urls, 0))) == NULL) {
+    exit(EXIT_FAILURE);
+  }
+
+  data  = new_data();
+  total = my.cusers;
+
+  /**
+   * We read the baseline now so a bad one fails before the run
+   */
+  if (my.compare != NULL && ! my.get && (base = history_load(my.compare)) == NULL) {
+    exit(EXIT_FAILURE);
+  }
+  if (array_length(my.asserts) > 0 && ! my.get && (gate = new_gate(my.asserts, my.window)) == NULL) {
+    exit(EXIT_FAILURE);
+  }
+  if ((my.history != NULL || base != NULL || (gate != NULL && my.window > 0)) && ! my.get) {
+    history = new_history();
+  }
+  memset(record, '\0', sizeof(record));
+  if (my.urlstats > 0 && ! my.get) {
+    urlstats = new_urlstats(urls);
+  }
+
+  /**
+   * A coordinator deals the users out to its agents and waits
+   * to add up what they report. A siege that an agent started
+   * for a job runs its share of them like a --procs worker.
+   */
+  if (my.coordinator) {
+    if ((dist = new_dist(my.cusers)) == NULL) {
+      exit(EXIT_FAILURE);
+    }
+    if (dist_start(dist, argc, argv, lines) == FALSE) {
+      NOTIFY(FATAL, "unable to start the agents");
+    }
+    __banner();
+    data_set_start(data);
+    cpu_sample();
+    dist_wait(dist, data, pcache, edge);
+    cpu_sample();
+    goto summary;
+  }
+  if ((dist = dist_join()) != NULL) {
+    if (my.procs > 1) {
+      NOTIFY(WARNING, "agents run their share of the users in one process; ignoring --procs");
+      my.procs = 1;
+    }
+    my.worker = 0;
+    first     = dist_get_first(dist);
+    total     = dist_get_total(dist);
+  }
+
+  /**
+   * With --procs we fork here; each worker runs its slice of
+   * the users through the code below and the parent waits to
+   * add them up. Only the parent gets to the summary.
+   */
+  if (my.procs > 1 && ! my.get && (procs = new_procs(my.procs, my.cusers)) != NULL) {
+    my.worker = procs_start(procs);
+    if (my.worker < 0) {
+      __banner();
+      data_set_start(data);
+      cpu_sample();
+      procs_wait(procs, data, pcache, edge);
+      cpu_sample();
+      goto summary;
+    }
+    first     = procs_get_first(procs);
+    my.cusers = procs_get_users(procs);
+    cpu_set_base(first);
+  }
+
+  if (my.capacity > 0) {
+    search  = new_search(my.slo, my.cusers, my.capacity);
+    profile = new_profile_manual(my.cusers);
+  } else if (my.profile != NULL && ! my.get) {
+    profile = new_profile(my.profile);
+  }
+
   for (i = 0; i < my.cusers; i++) {
-    BROWSER B = new_browser(i+1, file);
+    BROWSER B = new_browser(first+i+1, file);
+    browser_set_pcache(B, pcache);
+    browser_set_edge(B, edge);
+    browser_set_profile(B, profile);
+    browser_set_replay(B, replay);
+    browser_set_har(B, har);
+    browser_set_alias(B, alias);
+    browser_set_urlstats(B, urlstats_fork(urlstats));
 
-    if (my.reps > 0 ) {
+    if (classes != NULL) {
+      browser_set_class(B, __class(classes, first + i));
+    } else if (my.reps > 0 || har != NULL || alias != NULL) {
       browser_set_urls(B, urls);
     } else {
       /**
        * Scenario: -r once/--reps=once 
        */
       int n_urls = array_length(urls);
-      int per_user = n_urls / my.cusers;
-      int remainder = n_urls % my.cusers;
-      int begin_url = i * per_user + ((i < remainder) ? i : remainder);
-      int end_url = (i + 1) * per_user + ((i < remainder) ? (i + 1) : remainder);
+      int user   = first + i;
+      int per_user = n_urls / total;
+      int remainder = n_urls % total;
+      int begin_url = user * per_user + ((user < remainder) ? user : remainder);
+      int end_url = (user + 1) * per_user + ((user < remainder) ? (user + 1) : remainder);
       ARRAY url_slice = new_array();
       for (j = begin_url; j < end_url && j < n_urls; j++) {
         URL u = array_get(urls, j);
@@ -492,10 +1819,18 @@ main(int argc, char *argv[])
     array_npush(browsers, B, BROWSERSIZE);
   }
 
-  if ((crew = new_crew(my.cusers, my.cusers, FALSE)) == NULL) {
+  if ((crew = new_crew(my.cusers, my.cusers, FALSE, preflight_stacksize((size_t)my.stack * 1024))) == NULL) {
     NOTIFY(FATAL, "unable to allocate memory for %d simulated browser", my.cusers);  
   } 
 
+  /**
+   * An agent's job waits here for the coordinator to start
+   * every agent at once; -t starts counting after.
+   */
+  if (dist_ready(dist) == FALSE) {
+    exit(EXIT_FAILURE);
+  }
+
   /**
    * pthread_create retruns an errno (not necessarily a negative) on failure!
    * should keep it != not <.
@@ -513,18 +1848,36 @@ main(int argc, char *argv[])
    * Display information about the siege to the user
    * and prepare for verbose output if necessary.
    */
-  if (!my.get && !my.quiet) {
-    fprintf(stderr, "** "); 
-    display_version(FALSE);
-    fprintf(stderr, "** Preparing %d concurrent users for battle.\n", my.cusers);
-    fprintf(stderr, "The server is now under siege...");
-    if (my.verbose) { fprintf(stderr, "\n"); }
-  } 
+  if (my.worker < 0) {
+    __banner();
+  } else {
+    WORKER W = { procs, dist, browsers, pcache, edge };
+    if ((result = pthread_create(&publisher, NULL, __publisher, (void*)&W)) != 0) {
+      NOTIFY(FATAL, "failed to create publisher: %d\n", result);
+    }
+  }
 
-  data = new_data();
+  profile_start(profile, browsers);
+  search_start(search, profile, browsers);
+  if (my.worker < 0) {
+    history_start(history, browsers);
+    gate_start(gate, history);
+  }
   data_set_start(data);
+  for (i = 0; classes != NULL && i < (int)array_length(classes); i++) {
+    data_set_start(class_get_data((CLASS)array_get(classes, i)));
+  }
+  timer_begin();
+  cpu_sample();
+  monitor_start();
+  if ((my.verbose || my.vfile != NULL) && ! my.get && ! my.print) {
+    writer_start();
+  }
   for (i = 0; i < my.cusers && crew_get_shutdown(crew) != TRUE; i++) {
     BROWSER B = (BROWSER)array_get(browsers, i);
+    if (my.stagger > 0 && i > 0) {
+      pthread_usleep_np((unsigned long)my.stagger * 1000000 / my.cusers);
+    }
     result = crew_add(crew, (void*)start, B);
     if (result == FALSE) { 
       my.verbose = FALSE;
@@ -536,6 +1889,19 @@ main(int argc, char *argv[])
   } 
   crew_join(crew, TRUE, &status);
   data_set_stop(data); 
+  for (i = 0; classes != NULL && i < (int)array_length(classes); i++) {
+    data_set_stop(class_get_data((CLASS)array_get(classes, i)));
+  }
+  timer_stop();
+  monitor_stop();
+  writer_stop();
+  profile_stop(profile);
+  search_stop(search);
+  gate_stop(gate);
+  history_stop(history);
+  cpu_sample();
+  procs_stopped(procs);
+  dist_stopped(dist);
 
   if ((result = pthread_kill(cease, SIGTERM)) != 0 && result != ESRCH) {
     NOTIFY(FATAL, "failed to signal handler thread: %d\n", result);
@@ -557,22 +1923,62 @@ main(int argc, char *argv[])
   SSL_thread_cleanup();
 #endif
 
-  for (i = 0; i < ((crew_get_total(crew) > my.cusers || 
-                    crew_get_total(crew) == 0) ? my.cusers : crew_get_total(crew)); i++) {
+  if (my.worker >= 0) {
+    pthread_cancel(publisher);
+    pthread_join(publisher, NULL);
+  }
+  __tally(data, browsers, (crew_get_total(crew) > my.cusers || 
+                           crew_get_total(crew) == 0) ? my.cusers : crew_get_total(crew), TRUE);
+  for (i = 0; i < (int)array_length(browsers); i++) {
+    data_increment_aborted(data, browser_get_aborted((BROWSER)array_get(browsers, i)));
+  }
+  for (i = 0; classes != NULL && i < (int)array_length(browsers); i++) {
     BROWSER B = (BROWSER)array_get(browsers, i);
-    data_increment_count  (data, browser_get_hits(B));
-    data_increment_bytes  (data, browser_get_bytes(B));
-    data_increment_total  (data, browser_get_time(B));
-    data_increment_code   (data, browser_get_code(B));
-    data_increment_okay   (data, browser_get_okay(B));
-    data_increment_fail   (data, browser_get_fail(B));
-    data_set_highest      (data, browser_get_himark(B));
-    data_set_lowest       (data, browser_get_lomark(B));
-    data_increment_cookies(data, browser_get_cookies(B));
-  } crew_destroy(crew);
+    __tally_browser(class_get_data(browser_get_class(B)), B, FALSE);
+    data_increment_fail(class_get_data(browser_get_class(B)), browser_get_failed(B));
+  }
+  for (i = 0; urlstats != NULL && i < (int)array_length(browsers); i++) {
+    urlstats_merge(urlstats, browser_get_urlstats((BROWSER)array_get(browsers, i)));
+  }
+  urlstats_finish(urlstats);
+  crew_destroy(crew);
+
+  if (my.worker >= 0) {
+    procs_publish(procs, data, pcache, edge, TRUE);
+    dist_publish(dist, data, pcache, edge, TRUE);
+    exit(EXIT_SUCCESS);
+  }
+
+summary:
 
+  /**
+   * We count to the deadline (or the cool-down) and not to when
+   * the last user was done. Requests that finished in the grace
+   * period count, so the window runs to the last of them.
+   */
+  end = (my.secs > 0) ? my.secs - my.cooldown : 0;
+  if (timer_stopped() > 0 && (end <= 0 || timer_stopped() < end)) {
+    end = timer_stopped();
+  }
+  if (end > 0 && timer_landed() > end) {
+    end = timer_landed();
+  }
+  data_set_window(data, my.warmup, end);
+  for (i = 0; classes != NULL && i < (int)array_length(classes); i++) {
+    data_set_window(class_get_data((CLASS)array_get(classes, i)), my.warmup, end);
+  }
   __save_cookies(file, data_get_cookies(data));
 
+  if (history != NULL && my.history != NULL) {
+    if (history_save(history, data, my.history, record, sizeof(record)) == FALSE) {
+      record[0] = '\0';
+    }
+  }
+  if (history != NULL && base != NULL) {
+    regressed = history_compare(history, data, base);
+  }
+  verdict = gate_check(gate, data, regressed);
+
   pthread_usleep_np(10000);
 
   if (! my.quiet && ! my.get) {
@@ -594,11 +2000,98 @@ main(int argc, char *argv[])
     fprintf(stderr, "Successful transactions:%9u\n",        data_get_code(data));
     if (my.debug) {
       fprintf(stderr, "HTTP OK received:\t%9u\n",             data_get_okay(data));
+      fprintf(stderr, "Response time p50:\t%12.2f ms\n",      1000.0f * data_get_percentile(data, 50));
+      fprintf(stderr, "Response time p90:\t%12.2f ms\n",      1000.0f * data_get_percentile(data, 90));
+      fprintf(stderr, "Response time p99:\t%12.2f ms\n",      1000.0f * data_get_percentile(data, 99));
+      if (pcache != NULL) {
+        fprintf(stderr, "Parser cache hits:\t%9lu\n",       pcache_get_hits(pcache));
+        fprintf(stderr, "Parser cache misses:\t%9lu\n",     pcache_get_misses(pcache));
+        fprintf(stderr, "Parser cache evictions:\t%9lu\n",  pcache_get_evictions(pcache));
+      }
     }
     fprintf(stderr, "Failed transactions:\t%9u\n",          my.failed);
+    __show_faults();
+    if (data_get_aborted(data) > 0) {
+      fprintf(stderr, "Aborted at deadline:\t%9u\n",        data_get_aborted(data));
+    }
+    if (replay != NULL) {
+      fprintf(stderr, "Log lines read:\t\t%9lu\n",           replay_get_lines(replay));
+      fprintf(stderr, "Skipped lines:\t\t%9lu\n",            replay_get_skipped(replay));
+      fprintf(stderr, "Replay lag:\t\t%12.2f ms\n",          1000.0f * replay_get_lag(replay));
+      fprintf(stderr, "Longest replay lag:\t%12.2f ms\n",     1000.0f * replay_get_highest(replay));
+    }
     fprintf(stderr, "Longest transaction:\t%12.2f ms\n",        1000.0f * data_get_highest(data));
     fprintf(stderr, "Shortest transaction:\t%12.2f ms\n",       1000.0f * data_get_lowest(data));
+    fprintf(stderr, "Client CPU per trans:\t%12.2f usecs\n",    monitor_cpu_per_trans(data_get_count(data)));
+    if (my.cache || edge != NULL) {
+      fprintf(stderr, "Cache hits:\t\t%9u\n",                data_get_cached(data));
+    }
+    if (socket_get_options(opts, sizeof(opts), SOCKOPT_CONFIGURED) != NULL) {
+      fprintf(stderr, "Socket options:\t\t%s\n", 
+        socket_get_options(opts, sizeof(opts), SOCKOPT_APPLIED) ? opts : "none applied"
+      );
+      if (socket_get_options(opts, sizeof(opts), SOCKOPT_FAILED) != NULL) {
+        fprintf(stderr, "Failed options:\t\t%s\n", opts);
+      }
+    }
+    if (socket_get_exhausted() > 0) {
+      fprintf(stderr, "Port exhaustion:\t%9lu\n",            socket_get_exhausted());
+    }
+    if (socket_get_sources() > 0) {
+      __show_sources();
+    }
+    if (dist_get_count(dist) > 0) {
+      __show_agents(dist);
+    }
+    if (profile_get_stages(profile) > 0) {
+      __show_stages(profile);
+    }
+    if (search != NULL) {
+      __show_capacity(search);
+    }
+    if (urlstats != NULL) {
+      __show_urls(urlstats);
+    }
+    if (har != NULL) {
+      __show_pages(har);
+    }
+    if (alias != NULL) {
+      __show_hits(alias, urls, har);
+    }
+    if (classes != NULL) {
+      __show_classes(classes);
+    }
+    if (base != NULL) {
+      __show_comparison(history, regressed);
+    }
+    if (record[0] != '\0') {
+      fprintf(stderr, "Run record:\t\t%s\n", record);
+    }
+    if (gate != NULL) {
+      __show_assertions(gate);
+    }
+    if (my.debug || strcmp(socket_get_backend(), "select") != 0) {
+      fprintf(stderr, "I/O backend:\t\t%s\n",               socket_get_backend());
+      fprintf(stderr, "Syscalls per trans:\t%12.2f\n",       __syscall_rate(data));
+    }
+    if (cpu_configured() && cpu_get_cores() > 0) {
+      __show_cores();
+    }
+    if (edge != NULL) {
+      fprintf(stderr, "Edge cache hits:\t%9lu\n",            edge_get_hits(edge));
+      fprintf(stderr, "Edge hit ratio:\t\t%12.2f %%\n",       __edge_hit_ratio(edge));
+      fprintf(stderr, "Origin offload:\t\t%12.2f %%\n",       __edge_offload(edge, data, FALSE));
+      fprintf(stderr, "Byte offload:\t\t%12.2f %%\n",         __edge_offload(edge, data, TRUE));
+    }
     fprintf(stderr, " \n");
+    if (monitor_saturated(saturated, sizeof(saturated))) {
+      errno = 0;
+      NOTIFY(WARNING, "siege was the bottleneck (%s); these numbers measure the client, not the server", saturated);
+    }
+    if (replay_get_late(replay) > 0) {
+      errno = 0;
+      NOTIFY(WARNING, "%lu requests went out late; the replay fell behind the log (add users with -c)", replay_get_late(replay));
+    }
   }
 
   if (my.json_output) {
@@ -624,9 +2117,125 @@ main(int argc, char *argv[])
 
     if (my.debug) {
       printf("\t\"http_ok_received\":\t\t%12u,\n", data_get_okay(data));
+      printf("\t\"response_time_p50\":\t\t%12.2f,\n", data_get_percentile(data, 50));
+      printf("\t\"response_time_p90\":\t\t%12.2f,\n", data_get_percentile(data, 90));
+      printf("\t\"response_time_p99\":\t\t%12.2f,\n", data_get_percentile(data, 99));
+      if (pcache != NULL) {
+        printf("\t\"parser_cache_hits\":\t\t%12lu,\n", pcache_get_hits(pcache));
+        printf("\t\"parser_cache_misses\":\t\t%12lu,\n", pcache_get_misses(pcache));
+        printf("\t\"parser_cache_evictions\":\t%12lu,\n", pcache_get_evictions(pcache));
+      }
     }
 
     printf("\t\"failed_transactions\":\t\t%12u,\n", my.failed);
+    printf("\t\"faults\":\t\t\t{");
+    for (i = FAULT_NONE + 1; i < FAULTS; i++) {
+      printf("%s\"%s\": %lu", (i > FAULT_NONE + 1) ? ", " : "", fault_name((FAULT)i), fault_get_count((FAULT)i));
+    }
+    printf("},\n");
+    printf("\t\"aborted_at_deadline\":\t\t%12u,\n", data_get_aborted(data));
+    if (replay != NULL) {
+      printf("\t\"replay\":\t\t\t{\"lines\": %lu, \"skipped\": %lu, \"late\": %lu, \"lag\": %.4f, \"highest_lag\": %.4f},\n",
+        replay_get_lines(replay), replay_get_skipped(replay), replay_get_late(replay),
+        replay_get_lag(replay), replay_get_highest(replay)
+      );
+    }
+    if (my.cache || edge != NULL) {
+      printf("\t\"cache_hits\":\t\t\t%12u,\n", data_get_cached(data));
+    }
+    if (socket_get_exhausted() > 0) {
+      printf("\t\"port_exhaustion\":\t\t%12lu,\n", socket_get_exhausted());
+    }
+    if (socket_get_sources() > 0) {
+      printf("\t\"source_connections\":\t\t{");
+      for (i = 0, j = 0; i < socket_get_sources(); i++) {
+        unsigned long conns;
+        char *name = socket_get_source(i, &conns);
+        if (conns == 0) continue;
+        printf("%s\"%s\": %lu", (j++ > 0) ? ", " : "", name, conns);
+      }
+      printf("},\n");
+    }
+    if (dist_get_count(dist) > 0) {
+      printf("\t\"agents\":\t\t\t{");
+      for (i = 0; i < dist_get_count(dist); i++) {
+        unsigned int hits;
+        char *name = dist_get_agent(dist, i, &hits);
+        printf("%s\"%s\": %u", (i > 0) ? ", " : "", name, hits);
+      }
+      printf("},\n");
+      printf("\t\"intervals\":\t\t\t[");
+      for (i = 0; i < dist_get_ticks(dist); i++) {
+        printf("%s%u", (i > 0) ? ", " : "", dist_get_tick(dist, i));
+      }
+      printf("],\n");
+    }
+    if (search != NULL) {
+      printf("\t\"capacity\":\t\t\t{\"slo\": \"%s\", \"users\": %d, \"rate\": %.2f, \"curve\": [",
+        search_get_slo(search), search_get_users(search), search_get_rate(search)
+      );
+      for (i = 0; i < search_get_steps(search); i++) {
+        int   users;
+        float rate, errors, pct[3];
+        char *missed;
+        users = search_get_step(search, i, &rate, pct, &errors, &missed);
+        printf("%s\n\t\t{\"users\": %d, \"rate\": %.2f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"errors\": %.2f, \"met\": %s}",
+          (i > 0) ? "," : "", users, rate, pct[0], pct[1], pct[2], errors, (missed == NULL) ? "true" : "false"
+        );
+      }
+      printf("\n\t]},\n");
+    }
+    if (profile_get_samples(profile) > 0) {
+      printf("\t\"profile\":\t\t\t[");
+      for (i = 0; i < profile_get_samples(profile); i++) {
+        int           users;
+        unsigned long hits;
+        int           stage = profile_get_sample(profile, i, &users, &hits);
+        printf("%s\n\t\t{\"second\": %d, \"stage\": \"%s\", \"users\": %d, \"transactions\": %lu}",
+          (i > 0) ? "," : "", i+1, profile_get_stage(profile, stage, NULL, NULL, NULL), users, hits
+        );
+      }
+      printf("\n\t],\n");
+    }
+    printf("\t\"io_backend\":\t\t\t\"%s\",\n", socket_get_backend());
+    if (cpu_configured() && cpu_get_cores() > 0) {
+      printf("\t\"cpu_utilization\":\t\t{");
+      for (i = 0; i < cpu_get_cores(); i++) {
+        int    cpu;
+        double usage = cpu_get_usage(i, &cpu);
+        printf("%s\"%d\": %.2f", (i > 0) ? ", " : "", cpu, usage);
+      }
+      printf("},\n");
+    }
+    printf("\t\"syscalls_per_transaction\":\t%12.2f,\n", __syscall_rate(data));
+    __json_client(data);
+    if (urlstats != NULL) {
+      __json_urls(urlstats);
+    }
+    if (har != NULL) {
+      __json_pages(har);
+    }
+    if (alias != NULL) {
+      __json_hits(alias, urls, har);
+    }
+    if (classes != NULL) {
+      __json_classes(classes);
+    }
+    if (base != NULL) {
+      __json_comparison(history, regressed);
+    }
+    if (record[0] != '\0') {
+      printf("\t\"run_record\":\t\t\t\"%s\",\n", record);
+    }
+    if (gate != NULL) {
+      __json_assertions(gate, verdict);
+    }
+    if (edge != NULL) {
+      printf("\t\"edge_cache_hits\":\t\t%12lu,\n", edge_get_hits(edge));
+      printf("\t\"edge_hit_ratio\":\t\t%12.2f,\n", __edge_hit_ratio(edge));
+      printf("\t\"origin_offload\":\t\t%12.2f,\n", __edge_offload(edge, data, FALSE));
+      printf("\t\"byte_offload\":\t\t\t%12.2f,\n", __edge_offload(edge, data, TRUE));
+    }
     printf("\t\"longest_transaction\":\t\t%12.2f,\n", data_get_highest(data));
     printf("\t\"shortest_transaction\":\t\t%12.2f\n", data_get_lowest(data));
     puts("}");
@@ -646,6 +2255,20 @@ main(int argc, char *argv[])
   data       = data_destroy(data);
   urls       = array_destroyer(urls, (void*)url_destroy);
   browsers   = array_destroyer(browsers, (void*)browser_destroy);
+  urlstats   = urlstats_destroy(urlstats);
+  pcache     = pcache_destroy(pcache);
+  edge       = edge_destroy(edge);
+  procs      = procs_destroy(procs);
+  profile    = profile_destroy(profile);
+  replay     = replay_destroy(replay);
+  har        = har_destroy(har);
+  alias      = alias_destroy(alias);
+  classes    = array_destroyer(classes, (void*)class_destroy);
+  search     = search_destroy(search);
+  history    = history_destroy(history);
+  base       = history_destroy(base);
+  gate       = gate_destroy(gate);
+  dist       = dist_destroy(dist);
 
   if (my.url == NULL) {
     for (i = 0; i < my.length; i++)
@@ -657,5 +2280,5 @@ main(int argc, char *argv[])
     xfree(lines);
   }
 
-  exit(EXIT_SUCCESS);  
+  exit(verdict);  
 } /* end of int main **/
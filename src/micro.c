@@ -0,0 +1,698 @@
+/**
+ * siege-micro: micro-benchmarks for the core data structures
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#define  INTERN  1
+
+#ifdef  HAVE_CONFIG_H
+# include <config.h>
+#endif/*HAVE_CONFIG_H*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <setup.h>
+#include <array.h>
+#include <hash.h>
+#include <url.h>
+#include <parser.h>
+#include <cookies.h>
+#include <facts.h>
+#include <http.h>
+#include <page.h>
+#include <date.h>
+#include <response.h>
+#include <memory.h>
+#include <notify.h>
+#include <version.h>
+#ifdef  HAVE_ZLIB
+# include <zlib.h>
+#endif/*HAVE_ZLIB*/
+#ifdef __CYGWIN__
+# include <getopt.h>
+#else
+# include <joedog/getopt.h>
+#endif
+
+/**
+ * siege-micro times the pieces of siege that run once or more
+ * per request: hash and array operations, URL parsing, the html
+ * parser, the cookie header, header parsing and gzip bodies, and
+ * date parsing. Each benchmark is warmed up, calibrated so that
+ * one sample runs for roughly --sample milliseconds, then sampled
+ * --repeat times. We report min, median, mean and deviation in
+ * nanoseconds per operation; --json writes one object per line
+ * so CI can keep the numbers over time.
+ */
+#define KEYS 1024
+#define WORK (KEYS/4)
+
+typedef struct {
+  char  *name;
+  char  *desc;
+  void *(*setup)(void);
+  void  (*run)(void *ctx, long iters);
+  void  (*teardown)(void *ctx);
+} MICRO;
+
+typedef struct {
+  HASH   hash;
+  char  *keys[KEYS];
+} HCTX;
+
+typedef struct {
+  URL    base;
+  CONN  *conn;
+  FACTS  facts;
+  char  *data;
+  size_t len;
+} CCTX;
+
+private volatile size_t __sink;
+
+private char *__dates[] = {
+  "Tue, 20 Mar 2007 14:31:38 GMT",
+  "Tuesday, 20-Mar-07 14:31:38 GMT",
+  "Tue Mar 20 14:31:38 2007"
+};
+
+private char *__locations[] = {
+  "../images/logo.png",
+  "/css/site.css?v=2",
+  "http://cdn.joedog.org/js/app.js",
+  "page2.html#top"
+};
+
+private char __url[] = "http://www.joedog.org:8080/siege/docs/manual.html?lang=en&v=4#options";
+
+private char __headers[] =
+  "HTTP/1.1 200 OK\r\n"
+  "Date: Tue, 20 Mar 2007 14:31:38 GMT\r\n"
+  "Server: Apache/2.4.58 (Unix)\r\n"
+  "Last-Modified: Mon, 19 Mar 2007 09:12:44 GMT\r\n"
+  "ETag: \"5e8-61b2c1a7d1e40\"\r\n"
+  "Accept-Ranges: bytes\r\n"
+  "Content-Length: 1512\r\n"
+  "Cache-Control: max-age=3600\r\n"
+  "Expires: Tue, 20 Mar 2007 15:31:38 GMT\r\n"
+  "Vary: Accept-Encoding\r\n"
+  "Keep-Alive: timeout=5, max=100\r\n"
+  "Connection: Keep-Alive\r\n"
+  "Content-Type: text/html; charset=UTF-8\r\n"
+  "\r\n";
+
+private double
+__now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * Some text that compresses about as well as a real page.
+ */
+private char *
+__text(size_t len)
+{
+  char  *words[] = {
+    "siege", "server", "request", "response", "header", "cookie", "the", "a",
+    "load", "users", "transaction", "concurrency", "of", "and", "to", "latency",
+    "throughput", "benchmark", "connection", "keep-alive", "html", "body"
+  };
+  char        *str  = xmalloc(len+1);
+  size_t       n    = 0;
+  unsigned int seed = 12345;
+
+  while (n < len) {
+    char  *w;
+    size_t wl;
+    seed = seed * 1103515245 + 12345;
+    w    = words[(seed >> 16) % (sizeof(words)/sizeof(char*))];
+    wl   = strlen(w);
+    if (n + wl + 1 > len) break;
+    memcpy(str+n, w, wl);
+    n += wl;
+    str[n++] = ((seed >> 8) % 13 == 0) ? '\n' : ' ';
+  }
+  memset(str+n, ' ', len-n);
+  str[len] = '\0';
+  return str;
+}
+
+/**
+ * hash_add, hash_get
+ */
+private void *
+__hash_setup(void)
+{
+  int   i;
+  HCTX *ctx = xcalloc(1, sizeof(HCTX));
+
+  ctx->hash = new_hash();
+  for (i = 0; i < KEYS; i++) {
+    ctx->keys[i] = xmalloc(32);
+    snprintf(ctx->keys[i], 32, "Set-Cookie-%d-%x", i, i * 2654435761u);
+    hash_add(ctx->hash, ctx->keys[i], ctx->keys[i]);
+  }
+  return ctx;
+}
+
+private void
+__hash_teardown(void *arg)
+{
+  int   i;
+  HCTX *ctx = (HCTX*)arg;
+
+  hash_destroy(ctx->hash);
+  for (i = 0; i < KEYS; i++) {
+    xfree(ctx->keys[i]);
+  }
+  xfree(ctx);
+}
+
+/* an op is one insert into a fresh table; the teardown is amortized */
+private void
+__hash_add(void *arg, long iters)
+{
+  HCTX *ctx = (HCTX*)arg;
+  HASH  H   = NULL;
+  long  i;
+
+  for (i = 0; i < iters; i++) {
+    if (i % WORK == 0) {
+      if (H != NULL) hash_destroy(H);
+      H = new_hash();
+    }
+    hash_add(H, ctx->keys[i % WORK], ctx->keys[i % WORK]);
+  }
+  if (H != NULL) hash_destroy(H);
+}
+
+private void
+__hash_get(void *arg, long iters)
+{
+  HCTX *ctx = (HCTX*)arg;
+  long  i;
+
+  for (i = 0; i < iters; i++) {
+    __sink += (size_t)hash_get(ctx->hash, ctx->keys[i % KEYS]);
+  }
+}
+
+/**
+ * array_npush, an op is one push; the teardown is amortized
+ */
+private void
+__array_npush(void *arg, long iters)
+{
+  ARRAY A = NULL;
+  long  i;
+  char  thing[] = "http://www.joedog.org/images/logo.png";
+
+  (void)arg;
+  for (i = 0; i < iters; i++) {
+    if (i % WORK == 0) {
+      if (A != NULL) array_destroy(A);
+      A = new_array();
+    }
+    array_npush(A, thing, sizeof(thing)-1);
+  }
+  if (A != NULL) array_destroy(A);
+}
+
+/**
+ * new_url, url_normalize and html_parser share a base URL
+ */
+private void *
+__url_setup(void)
+{
+  CCTX  *ctx = xcalloc(1, sizeof(CCTX));
+  char  *text;
+  size_t max = 32*1024;
+  size_t len = 0;
+  int    i;
+
+  ctx->base = new_url(__url);
+  ctx->data = xmalloc(max);
+  text      = __text(max/2);
+  len += snprintf(ctx->data+len, max-len, "<html>\n<head>\n<title>siege</title>\n");
+  for (i = 0; i < 40; i++) {
+    switch (i % 4) {
+      case 0:
+        len += snprintf(ctx->data+len, max-len, "<link rel=\"stylesheet\" href=\"/css/site-%d.css\">\n", i);
+        break;
+      case 1:
+        len += snprintf(ctx->data+len, max-len, "<script src=\"../js/app-%d.js\"></script>\n", i);
+        break;
+      case 2:
+        len += snprintf(ctx->data+len, max-len, "<img src=\"http://cdn.joedog.org/img/%d.png\" alt=\"%d\">\n", i, i);
+        break;
+      default:
+        len += snprintf(ctx->data+len, max-len, "<!-- %d --><a href=\"page-%d.html\">page %d</a>\n", i, i, i);
+        break;
+    }
+  }
+  snprintf(ctx->data+len, max-len, "</head>\n<body>\n%s\n</body>\n</html>\n", text);
+  xfree(text);
+  ctx->len = strlen(ctx->data);
+  return ctx;
+}
+
+private void
+__url_teardown(void *arg)
+{
+  CCTX *ctx = (CCTX*)arg;
+
+  url_destroy(ctx->base);
+  xfree(ctx->data);
+  xfree(ctx);
+}
+
+private void
+__new_url(void *arg, long iters)
+{
+  long i;
+
+  (void)arg;
+  for (i = 0; i < iters; i++) {
+    URL U = new_url(__url);
+    __sink += (size_t)url_get_port(U);
+    url_destroy(U);
+  }
+}
+
+private void
+__url_normalize(void *arg, long iters)
+{
+  CCTX *ctx = (CCTX*)arg;
+  long  i;
+  int   n   = sizeof(__locations)/sizeof(char*);
+
+  char  loc[256];
+
+  /* url_normalize rewrites entities in place; it needs a copy */
+  for (i = 0; i < iters; i++) {
+    URL U;
+    strcpy(loc, __locations[i % n]);
+    U = url_normalize(ctx->base, loc);
+    __sink += (size_t)url_get_port(U);
+    url_destroy(U);
+  }
+}
+
+private void
+__html_parser(void *arg, long iters)
+{
+  CCTX *ctx = (CCTX*)arg;
+  long  i;
+
+  for (i = 0; i < iters; i++) {
+    URL   U;
+    ARRAY parts = new_array();
+    html_parser(parts, ctx->base, ctx->data);
+    __sink += array_length(parts);
+    while ((U = (URL)array_pop(parts)) != NULL) {
+      url_destroy(U);
+    }
+    array_destroy(parts);
+  }
+}
+
+/**
+ * cookies_header over a jar of twenty cookies
+ */
+private void *
+__cookies_setup(void)
+{
+  CCTX *ctx = xcalloc(1, sizeof(CCTX));
+  char  line[256];
+  int   i;
+
+  ctx->base  = new_url(__url);
+  ctx->facts = new_facts(1, "/dev/null");
+  for (i = 0; i < 20; i++) {
+    snprintf(line, sizeof(line), "session%02d=%08x%08x; Path=/; Domain=.joedog.org", i, i * 2654435761u, ~i);
+    set_cookie(ctx->facts, line, url_get_hostname(ctx->base));
+  }
+  return ctx;
+}
+
+private void
+__cookies_teardown(void *arg)
+{
+  CCTX *ctx = (CCTX*)arg;
+
+  url_destroy(ctx->base);
+  facts_destroy(ctx->facts);
+  xfree(ctx);
+}
+
+private void
+__cookies_header(void *arg, long iters)
+{
+  CCTX *ctx = (CCTX*)arg;
+  char  buf[MAX_COOKIE_SIZE+8];
+  long  i;
+
+  for (i = 0; i < iters; i++) {
+    buf[0] = '\0';
+    cookies_header(ctx->facts, ctx->base, buf);
+    __sink += (size_t)buf[8];
+  }
+}
+
+/**
+ * http_read_headers and http_read read from a CONN whose buffer
+ * already holds the whole response, so socket_read never makes
+ * a system call and we time the parsing alone.
+ */
+private void *
+__http_setup(void)
+{
+  CCTX *ctx = xcalloc(1, sizeof(CCTX));
+
+  ctx->base       = new_url(__url);
+  ctx->facts      = new_facts(1, "/dev/null");
+  ctx->conn       = xcalloc(1, sizeof(CONN));
+  ctx->conn->sock = -1;
+  ctx->conn->page = new_page("");
+  ctx->data       = xstrdup(__headers);
+  ctx->len        = strlen(ctx->data);
+  return ctx;
+}
+
+private void *
+__gzip_setup(void)
+{
+  CCTX  *ctx  = __http_setup();
+#ifdef  HAVE_ZLIB
+  size_t size = 16*1024;
+  size_t max  = sizeof(ctx->conn->buffer);
+  char  *body = xmalloc(max);
+  char  *text;
+  int    len;
+  z_stream z;
+
+  /* the largest page whose compressed response fits in the buffer */
+  for (;;) {
+    text = __text(size);
+    memset(&z, 0, sizeof(z));
+    deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 31, 8, Z_DEFAULT_STRATEGY);
+    z.next_in   = (Bytef*)text;
+    z.avail_in  = (uInt)size;
+    z.next_out  = (Bytef*)body;
+    z.avail_out = (uInt)max;
+    deflate(&z, Z_FINISH);
+    len = (int)z.total_out;
+    deflateEnd(&z);
+    xfree(text);
+    if (z.avail_out > 256) break;
+    size -= size / 4;
+  }
+  xfree(ctx->data);
+  ctx->data = xmalloc(max);
+  ctx->len  = (size_t)snprintf(
+    ctx->data, max,
+    "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Encoding: gzip\r\nContent-Length: %d\r\n\r\n", len
+  );
+  memcpy(ctx->data+ctx->len, body, (size_t)len);
+  ctx->len += (size_t)len;
+  xfree(body);
+#endif/*HAVE_ZLIB*/
+  return ctx;
+}
+
+private void
+__http_teardown(void *arg)
+{
+  CCTX *ctx = (CCTX*)arg;
+
+  url_destroy(ctx->base);
+  facts_destroy(ctx->facts);
+  page_destroy(ctx->conn->page);
+  xfree(ctx->conn);
+  xfree(ctx->data);
+  xfree(ctx);
+}
+
+private void
+__fill(CCTX *ctx)
+{
+  memcpy(ctx->conn->buffer, ctx->data, ctx->len);
+  ctx->conn->inbuffer = ctx->len;
+  ctx->conn->pos_ini  = 0;
+}
+
+private void
+__http_read_headers(void *arg, long iters)
+{
+  CCTX    *ctx = (CCTX*)arg;
+  RESPONSE resp;
+  long     i;
+
+  for (i = 0; i < iters; i++) {
+    __fill(ctx);
+    resp = http_read_headers(ctx->conn, ctx->base, ctx->facts);
+    __sink += (size_t)response_get_code(resp);
+    response_destroy(resp);
+  }
+}
+
+private void
+__http_read_gzip(void *arg, long iters)
+{
+  CCTX    *ctx = (CCTX*)arg;
+  RESPONSE resp;
+  long     i;
+
+  for (i = 0; i < iters; i++) {
+    __fill(ctx);
+    resp = http_read_headers(ctx->conn, ctx->base, ctx->facts);
+    __sink += (size_t)http_read(ctx->conn, resp);
+    page_clear(ctx->conn->page);
+    response_destroy(resp);
+  }
+}
+
+/**
+ * new_date over RFC 1123, RFC 850 and asctime dates
+ */
+private void
+__new_date(void *arg, long iters)
+{
+  long i;
+  int  n = sizeof(__dates)/sizeof(char*);
+
+  (void)arg;
+  for (i = 0; i < iters; i++) {
+    DATE D = new_date(__dates[i % n]);
+    __sink += (size_t)date_get_rfc850(D)[0];
+    date_destroy(D);
+  }
+}
+
+private MICRO micros[] = {
+  { "hash_add",          "insert into a fresh table",           __hash_setup,    __hash_add,          __hash_teardown    },
+  { "hash_get",          "lookup in a 1024 entry table",        __hash_setup,    __hash_get,          __hash_teardown    },
+  { "array_npush",       "push a copy of a 38 byte string",     NULL,            __array_npush,       NULL               },
+  { "new_url",           "parse an absolute URL",               NULL,            __new_url,           NULL               },
+  { "url_normalize",     "resolve a location against a base",   __url_setup,     __url_normalize,     __url_teardown     },
+  { "html_parser",       "a 17KB page with 40 resources",       __url_setup,     __html_parser,       __url_teardown     },
+  { "cookies_header",    "a Cookie header from 20 cookies",     __cookies_setup, __cookies_header,    __cookies_teardown },
+  { "http_read_headers", "a 13 line response header",           __http_setup,    __http_read_headers, __http_teardown    },
+  { "http_read_gzip",    "headers plus a gzip body (inflate)",  __gzip_setup,    __http_read_gzip,    __http_teardown    },
+  { "new_date",          "parse RFC 1123, RFC 850 and asctime", NULL,            __new_date,          NULL               }
+};
+#define MICROS (sizeof(micros)/sizeof(MICRO))
+
+private int
+__compare(const void *a, const void *b)
+{
+  double x = *(const double*)a;
+  double y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * Runs M for at least WARMUP ms while it finds the iteration
+ * count that fills a SAMPLE ms sample, then takes REPEAT samples
+ * into NS, in nanoseconds per op. Returns the iteration count.
+ */
+private long
+__measure(MICRO *M, void *ctx, int warmup, int sample, int repeat, double *ns)
+{
+  long   iters = 1;
+  double start = __now();
+  double t;
+  int    i;
+
+  for (;;) {
+    t = __now();
+    M->run(ctx, iters);
+    t = __now() - t;
+    if (t >= sample * 1e6 && __now() - start >= warmup * 1e6) break;
+    if (t < sample * 1e6) {
+      iters = (t < sample * 1e5) ? iters * 10 : (long)(iters * (sample * 1e6 / t) * 1.1) + 1;
+    }
+  }
+  for (i = 0; i < repeat; i++) {
+    t = __now();
+    M->run(ctx, iters);
+    ns[i] = (__now() - t) / iters;
+  }
+  return iters;
+}
+
+private void
+__usage(char *prog)
+{
+  printf("Usage: %s [options] [benchmark...]\n", prog);
+  puts("Options:");
+  puts("  -r, --repeat=NUM     samples per benchmark, default: 10");
+  puts("  -s, --sample=MS      milliseconds per sample, default: 20");
+  puts("  -w, --warmup=MS      milliseconds of warm-up, default: 100");
+  puts("  -j, --json           one JSON object per benchmark per line");
+  puts("  -l, --list           list the benchmarks");
+  puts("  -h, --help           this message");
+  puts("A benchmark argument selects every benchmark it prefixes, e.g. hash.");
+}
+
+/**
+ * setup.h promises these to the modules we link; main.c has
+ * siege's versions.
+ */
+void
+display_version(BOOLEAN b)
+{
+  fprintf(stderr, "siege-micro %s\n", version_string);
+  if (b == TRUE) {
+    exit(EXIT_SUCCESS);
+  }
+}
+
+void
+display_help()
+{
+  __usage("siege-micro");
+  exit(EXIT_SUCCESS);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int     c;
+  int     repeat = 10;
+  int     sample = 20;
+  int     warmup = 100;
+  BOOLEAN json   = FALSE;
+  double *ns;
+  size_t  i;
+  static struct option opts[] = {
+    { "repeat", required_argument, NULL, 'r' },
+    { "sample", required_argument, NULL, 's' },
+    { "warmup", required_argument, NULL, 'w' },
+    { "json",   no_argument,       NULL, 'j' },
+    { "list",   no_argument,       NULL, 'l' },
+    { "help",   no_argument,       NULL, 'h' },
+    { NULL, 0, NULL, 0 }
+  };
+
+  memset(&my, '\0', sizeof(struct CONFIG));
+  my.chunked = TRUE;
+  my.timeout = 1;
+
+  while ((c = getopt_long(argc, argv, "r:s:w:jlh", opts, NULL)) != -1) {
+    switch (c) {
+      case 'r':
+        repeat = atoi(optarg);
+        break;
+      case 's':
+        sample = atoi(optarg);
+        break;
+      case 'w':
+        warmup = atoi(optarg);
+        break;
+      case 'j':
+        json = TRUE;
+        break;
+      case 'l':
+        for (i = 0; i < MICROS; i++) {
+          printf("%-20s %s\n", micros[i].name, micros[i].desc);
+        }
+        exit(EXIT_SUCCESS);
+      case 'h':
+        __usage(argv[0]);
+        exit(EXIT_SUCCESS);
+      default:
+        __usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+  }
+  if (repeat < 1) repeat = 1;
+  if (sample < 1) sample = 1;
+  if (warmup < 0) warmup = 0;
+  ns = xcalloc((size_t)repeat, sizeof(double));
+
+  if (! json) {
+    printf("%-18s %10s %10s %10s %10s %7s\n", "benchmark", "iters", "min ns", "median ns", "mean ns", "rsd %");
+  }
+  for (i = 0; i < MICROS; i++) {
+    MICRO  *M   = &micros[i];
+    void   *ctx = NULL;
+    double  mean = 0.0;
+    double  dev  = 0.0;
+    double  median;
+    long    iters;
+
+    if (optind < argc) {
+      for (c = optind; c < argc && strncmp(M->name, argv[c], strlen(argv[c])) != 0; c++) ;
+      if (c == argc) continue;
+    }
+    if (M->setup != NULL) ctx = M->setup();
+    iters = __measure(M, ctx, warmup, sample, repeat, ns);
+    if (M->teardown != NULL) M->teardown(ctx);
+
+    for (c = 0; c < repeat; c++) mean += ns[c];
+    mean /= repeat;
+    for (c = 0; c < repeat; c++) dev  += (ns[c] - mean) * (ns[c] - mean);
+    dev = (repeat > 1) ? sqrt(dev / (repeat - 1)) : 0.0;
+    qsort(ns, (size_t)repeat, sizeof(double), __compare);
+    median = (repeat % 2) ? ns[repeat/2] : (ns[repeat/2-1] + ns[repeat/2]) / 2;
+
+    if (json) {
+      printf(
+        "{\"benchmark\": \"%s\", \"iterations\": %ld, \"samples\": %d, "
+        "\"ns_per_op\": {\"min\": %.2f, \"median\": %.2f, \"mean\": %.2f, \"stddev\": %.2f}}\n",
+        M->name, iters, repeat, ns[0], median, mean, dev
+      );
+    } else {
+      printf("%-18s %10ld %10.1f %10.1f %10.1f %7.1f\n",
+        M->name, iters, ns[0], median, mean, (mean > 0) ? 100.0 * dev / mean : 0.0
+      );
+    }
+    fflush(stdout);
+  }
+  xfree(ns);
+  exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,477 @@
+/**
+ * Client self-monitoring
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifdef  HAVE_CONFIG_H
+# include <config.h>
+#endif/*HAVE_CONFIG_H*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <monitor.h>
+#include <memory.h>
+#include <setup.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+#ifdef  HAVE_SCHED_H
+# include <sched.h>
+#endif/*HAVE_SCHED_H*/
+
+#ifdef  HAVE_UNISTD_H
+# include <unistd.h>
+#endif/*HAVE_UNISTD_H*/
+
+#define INTERVAL 1000000   /* usecs between samples */
+
+#ifndef MAX
+# define MAX(a,b) (((a) > (b)) ? (a) : (b))
+#endif/*MAX*/
+
+typedef struct
+{
+  long               tid;
+  unsigned long long exec;
+  unsigned long long delay;
+  unsigned long long slices;
+} TASK;
+
+private pthread_t       __sampler_id;
+private pthread_mutex_t __lock    = PTHREAD_MUTEX_INITIALIZER;
+private pthread_cond_t  __cond    = PTHREAD_COND_INITIALIZER;
+private BOOLEAN         __running = FALSE;
+private BOOLEAN         __stopped = FALSE;
+private MONSTATS        __stats;
+private MONSTATS        __added;
+private unsigned long   __start;      /* wall clock, usecs */
+private unsigned long   __cpu0;       /* our CPU at the start, usecs */
+private TASK *          __tasks  = NULL;
+private int             __ntasks = 0;
+
+private void *  __sampler(void *arg);
+private void    __sample(unsigned long *then, unsigned long *cpu, unsigned long lag);
+private int     __read_tasks(TASK **tasks);
+private void    __read_stat(unsigned long *rss);
+private unsigned long __count_fds();
+private unsigned long __now();
+private unsigned long __cputime();
+private unsigned int  __cpus();
+
+/**
+ * Starts the sampler; we watch until monitor_stop
+ */
+void
+monitor_start()
+{
+  pthread_mutex_lock(&__lock);
+  if (__running) {
+    pthread_mutex_unlock(&__lock);
+    return;
+  }
+  memset(&__stats, '\0', sizeof(MONSTATS));
+  __stats.cpus = __cpus();
+  __start      = __now();
+  __cpu0       = __cputime();
+  __stopped    = FALSE;
+  if (pthread_create(&__sampler_id, NULL, __sampler, NULL) == 0) {
+    __running  = TRUE;
+  }
+  pthread_mutex_unlock(&__lock);
+}
+
+void
+monitor_stop()
+{
+  pthread_mutex_lock(&__lock);
+  if (! __running) {
+    pthread_mutex_unlock(&__lock);
+    return;
+  }
+  __stopped = TRUE;
+  pthread_cond_signal(&__cond);
+  pthread_mutex_unlock(&__lock);
+  pthread_join(__sampler_id, NULL);
+
+  pthread_mutex_lock(&__lock);
+  __running    = FALSE;
+  __stats.cpu  = __cputime() - __cpu0;
+  __stats.wall = __now() - __start;
+  xfree(__tasks);
+  __tasks      = NULL;
+  __ntasks     = 0;
+  pthread_mutex_unlock(&__lock);
+}
+
+/**
+ * What we've seen so far plus whatever monitor_add_stats gave
+ * us. CPU and wall time run up to now if we're still watching.
+ */
+void
+monitor_get_stats(MONSTATS *stats)
+{
+  if (stats == NULL) return;
+
+  pthread_mutex_lock(&__lock);
+  *stats = __stats;
+  if (__running) {
+    stats->cpu  = __cputime() - __cpu0;
+    stats->wall = __now() - __start;
+  }
+  stats->cpu       += __added.cpu;
+  stats->delay     += __added.delay;
+  stats->slices    += __added.slices;
+  stats->rss       += __added.rss;
+  stats->fds       += __added.fds;
+  stats->peak      += __added.peak;
+  stats->wall       = MAX(stats->wall,      __added.wall);
+  stats->lag        = MAX(stats->lag,       __added.lag);
+  stats->cpus       = MAX(stats->cpus,      __added.cpus);
+  stats->hot        = MAX(stats->hot,       __added.hot);
+  stats->seconds    = MAX(stats->seconds,   __added.seconds);
+  stats->saturated  = MAX(stats->saturated, __added.saturated);
+  stats->reasons   |= __added.reasons;
+  pthread_mutex_unlock(&__lock);
+}
+
+/**
+ * Adds a worker's stats to ours. CPU, waits, memory and
+ * descriptors add up across processes; the rest is the worst
+ * any of them saw.
+ */
+void
+monitor_add_stats(const MONSTATS *stats)
+{
+  if (stats == NULL) return;
+
+  pthread_mutex_lock(&__lock);
+  __added.cpu       += stats->cpu;
+  __added.delay     += stats->delay;
+  __added.slices    += stats->slices;
+  __added.rss       += stats->rss;
+  __added.fds       += stats->fds;
+  __added.peak      += stats->peak;
+  __added.wall       = MAX(__added.wall,      stats->wall);
+  __added.lag        = MAX(__added.lag,       stats->lag);
+  __added.cpus       = MAX(__added.cpus,      stats->cpus);
+  __added.hot        = MAX(__added.hot,       stats->hot);
+  __added.seconds    = MAX(__added.seconds,   stats->seconds);
+  __added.saturated  = MAX(__added.saturated, stats->saturated);
+  __added.reasons   |= stats->reasons;
+  pthread_mutex_unlock(&__lock);
+}
+
+/**
+ * Returns TRUE if siege was the bottleneck: it spent at least a
+ * tenth of the run, and more than one second, over a threshold,
+ * or its CPU over the whole run was over my.saturation.cpu. BUF
+ * gets a short list of the reasons.
+ */
+BOOLEAN
+monitor_saturated(char *buf, size_t len)
+{
+  MONSTATS s;
+  double   cpu = 0.0;
+  unsigned int reasons = 0;
+
+  monitor_get_stats(&s);
+  if (buf != NULL && len > 0) buf[0] = '\0';
+  if (s.wall == 0 || s.cpus == 0) return FALSE;
+
+  cpu = (double)s.cpu / s.wall * 100.0 / s.cpus;
+  if (s.saturated > 1 && s.saturated * 10 >= s.seconds) {
+    reasons = s.reasons;
+  }
+  if (my.saturation.cpu > 0 && cpu >= my.saturation.cpu) {
+    reasons |= SATURATED_CPU;
+  }
+  if (reasons == 0) return FALSE;
+
+  if (buf != NULL && len > 0) {
+    size_t n = 0;
+    if (reasons & SATURATED_CPU) {
+      n += snprintf(buf+n, len-n, "%sCPU peaked at %u%% of %u core%s", (n > 0) ? ", " : "",
+        s.peak / s.cpus, s.cpus, (s.cpus > 1) ? "s" : ""
+      );
+    }
+    if ((reasons & SATURATED_RUNQ) && n < len) {
+      n += snprintf(buf+n, len-n, "%srun queue %.2f ms", (n > 0) ? ", " : "",
+        (s.slices > 0) ? (double)s.delay / s.slices / 1000.0 : 0.0
+      );
+    }
+    if ((reasons & SATURATED_LAG) && n < len) {
+      snprintf(buf+n, len-n, "%stimer lag %.0f ms", (n > 0) ? ", " : "", s.lag / 1000.0);
+    }
+  }
+  return TRUE;
+}
+
+/**
+ * Microseconds of client CPU per transaction
+ */
+double
+monitor_cpu_per_trans(unsigned int count)
+{
+  MONSTATS s;
+
+  if (count == 0) return 0.0;
+  monitor_get_stats(&s);
+  return (double)s.cpu / count;
+}
+
+private void *
+__sampler(void *arg)
+{
+  struct timespec ts;
+  unsigned long   then = __now();
+  unsigned long   cpu  = __cputime();
+  unsigned long   deadline;
+  unsigned long   woke;
+  int             rc   = 0;
+
+  (void)arg;
+  pthread_mutex_lock(&__lock);
+  __ntasks = __read_tasks(&__tasks);
+  pthread_mutex_unlock(&__lock);
+
+  for (;;) {
+    deadline   = then + INTERVAL;
+    ts.tv_sec  = deadline / 1000000;
+    ts.tv_nsec = (deadline % 1000000) * 1000;
+    pthread_mutex_lock(&__lock);
+    while (! __stopped && rc != ETIMEDOUT) {
+      rc = pthread_cond_timedwait(&__cond, &__lock, &ts);
+    }
+    if (__stopped) {
+      pthread_mutex_unlock(&__lock);
+      break;
+    }
+    pthread_mutex_unlock(&__lock);
+    rc   = 0;
+    woke = __now();
+    __sample(&then, &cpu, (woke > deadline) ? woke - deadline : 0);
+  }
+  return NULL;
+}
+
+/**
+ * One interval's worth: how busy we were, how long threads
+ * waited to run and how late we woke; THEN and CPU move on
+ */
+private void
+__sample(unsigned long *then, unsigned long *cpu, unsigned long lag)
+{
+  int           i;
+  int           j;
+  int           n;
+  TASK         *tasks  = NULL;
+  unsigned long now    = __now();
+  unsigned long used   = __cputime();
+  unsigned long wall   = (now > *then) ? now - *then : 1;
+  unsigned long rss    = 0;
+  unsigned long fds    = __count_fds();
+  unsigned long long delay  = 0;
+  unsigned long long slices = 0;
+  unsigned long long hot    = 0;
+  unsigned int  pct;
+  unsigned int  reasons = 0;
+  BOOLEAN       runq   = (my.saturation.runq > 0);
+
+  __read_stat(&rss);
+  n = (runq) ? __read_tasks(&tasks) : 0;
+
+  pthread_mutex_lock(&__lock);
+  for (i = 0; i < n; i++) {
+    TASK *t = &tasks[i];
+    TASK  p = { t->tid, 0, 0, 0 };
+    for (j = 0; j < __ntasks; j++) {
+      if (__tasks[j].tid == t->tid) { p = __tasks[j]; break; }
+    }
+    if (t->exec   >= p.exec)   hot     = MAX(hot, t->exec - p.exec);
+    if (t->delay  >= p.delay)  delay  += t->delay  - p.delay;
+    if (t->slices >= p.slices) slices += t->slices - p.slices;
+  }
+  if (runq) {
+    xfree(__tasks);
+    __tasks  = tasks;
+    __ntasks = n;
+  }
+
+  pct = (unsigned int)((used - *cpu) * 100 / wall);
+  if (my.saturation.cpu > 0 && __stats.cpus > 0 && pct >= (unsigned)my.saturation.cpu * __stats.cpus) {
+    reasons |= SATURATED_CPU;
+  }
+  if (runq && slices > 0 && (double)delay / slices / 1000000.0 >= my.saturation.runq) {
+    reasons |= SATURATED_RUNQ;
+  }
+  if (my.saturation.lag > 0 && lag / 1000.0 >= my.saturation.lag) {
+    reasons |= SATURATED_LAG;
+  }
+
+  __stats.seconds += 1;
+  __stats.delay   += (unsigned long)(delay / 1000);
+  __stats.slices  += (unsigned long)slices;
+  __stats.lag      = MAX(__stats.lag,  lag);
+  __stats.rss      = MAX(__stats.rss,  rss);
+  __stats.fds      = MAX(__stats.fds,  fds);
+  __stats.peak     = MAX(__stats.peak, pct);
+  __stats.hot      = MAX(__stats.hot,  (unsigned int)(hot / 10 / wall));
+  if (reasons != 0) {
+    __stats.saturated += 1;
+    __stats.reasons   |= reasons;
+  }
+  pthread_mutex_unlock(&__lock);
+
+  *then = now;
+  *cpu  = used;
+}
+
+/**
+ * Reads /proc/self/task/N/schedstat for each of our threads:
+ * nanoseconds on a CPU, nanoseconds waiting for one and the
+ * number of times it got one. Returns how many we read.
+ */
+private int
+__read_tasks(TASK **tasks)
+{
+  DIR           *dir;
+  struct dirent *ent;
+  int            n    = 0;
+  int            size = 0;
+  char           path[300];
+
+  *tasks = NULL;
+  if ((dir = opendir("/proc/self/task")) == NULL) {
+    return 0;
+  }
+  while ((ent = readdir(dir)) != NULL) {
+    FILE *fp;
+    TASK  t;
+
+    if (! isdigit((unsigned char)ent->d_name[0])) continue;
+    snprintf(path, sizeof(path), "/proc/self/task/%s/schedstat", ent->d_name);
+    if ((fp = fopen(path, "r")) == NULL) continue;
+    t.tid = atol(ent->d_name);
+    if (fscanf(fp, "%llu %llu %llu", &t.exec, &t.delay, &t.slices) == 3) {
+      if (n == size) {
+        size   = (size == 0) ? 64 : size * 2;
+        *tasks = xrealloc(*tasks, size * sizeof(TASK));
+      }
+      (*tasks)[n++] = t;
+    }
+    fclose(fp);
+  }
+  closedir(dir);
+  return n;
+}
+
+/**
+ * Resident set in KB from /proc/self/stat; the 24th field, and
+ * the command name in the 2nd may have spaces so we count from
+ * its closing paren.
+ */
+private void
+__read_stat(unsigned long *rss)
+{
+  FILE *fp;
+  char  line[1024];
+  char *ptr;
+  int   i;
+
+  *rss = 0;
+  if ((fp = fopen("/proc/self/stat", "r")) == NULL) {
+    return;
+  }
+  if (fgets(line, sizeof(line), fp) != NULL && (ptr = strrchr(line, ')')) != NULL) {
+    ptr++;
+    for (i = 3; i < 24 && ptr != NULL; i++) {
+      ptr = strchr(ptr+1, ' ');
+    }
+    if (ptr != NULL) {
+#ifdef  _SC_PAGESIZE
+      *rss = strtoul(ptr+1, NULL, 10) * (sysconf(_SC_PAGESIZE) / 1024);
+#else
+      *rss = strtoul(ptr+1, NULL, 10) * 4;
+#endif/*_SC_PAGESIZE*/
+    }
+  }
+  fclose(fp);
+}
+
+private unsigned long
+__count_fds()
+{
+  DIR           *dir;
+  struct dirent *ent;
+  unsigned long  n = 0;
+
+  if ((dir = opendir("/proc/self/fd")) == NULL) {
+    return 0;
+  }
+  while ((ent = readdir(dir)) != NULL) {
+    if (isdigit((unsigned char)ent->d_name[0])) n++;
+  }
+  closedir(dir);
+  return (n > 0) ? n - 1 : 0; /* less the one we're reading with */
+}
+
+private unsigned long
+__now()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (unsigned long)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+private unsigned long
+__cputime()
+{
+  struct rusage ru;
+
+  if (getrusage(RUSAGE_SELF, &ru) != 0) {
+    return 0;
+  }
+  return (unsigned long)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000
+       + ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+}
+
+private unsigned int
+__cpus()
+{
+#if defined(CPU_COUNT) && defined(__linux__)
+  cpu_set_t set;
+
+  if (sched_getaffinity(0, sizeof(set), &set) == 0 && CPU_COUNT(&set) > 0) {
+    return (unsigned int)CPU_COUNT(&set);
+  }
+#endif/*CPU_COUNT*/
+#if defined(_SC_NPROCESSORS_ONLN)
+  return (sysconf(_SC_NPROCESSORS_ONLN) > 0) ? (unsigned int)sysconf(_SC_NPROCESSORS_ONLN) : 1;
+#else
+  return 1;
+#endif
+}
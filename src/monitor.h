@@ -0,0 +1,69 @@
+/**
+ * Client self-monitoring
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifndef __MONITOR_H
+#define __MONITOR_H
+
+#include <stdlib.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+/**
+ * Watches siege itself while it runs. Once a second we sample
+ * our CPU (getrusage), how long each thread waited for a CPU
+ * (/proc/self/task/N/schedstat), resident memory (/proc/self/stat),
+ * open descriptors and how late the sampler itself woke up. A
+ * second over one of the my.saturation thresholds counts against
+ * us; enough of them and the summary says the client, not the
+ * server, set the pace. Like the socket stats these are process
+ * wide and flat, so --procs workers and agents can hand theirs
+ * to whoever adds up the run (tally.c).
+ */
+#define SATURATED_CPU   0x01
+#define SATURATED_RUNQ  0x02
+#define SATURATED_LAG   0x04
+
+typedef struct
+{
+  unsigned long cpu;       /* usecs of user + system CPU            */
+  unsigned long wall;      /* usecs we watched                       */
+  unsigned long delay;     /* usecs threads waited for a CPU         */
+  unsigned long slices;    /* times they got one                     */
+  unsigned long lag;       /* usecs the sampler woke late, at worst  */
+  unsigned long rss;       /* KB resident, at most                   */
+  unsigned long fds;       /* descriptors open, at most              */
+  unsigned int  cpus;      /* CPUs we may run on                     */
+  unsigned int  peak;      /* busiest second, percent of one CPU     */
+  unsigned int  hot;       /* busiest thread, percent of one CPU     */
+  unsigned int  seconds;   /* seconds sampled                        */
+  unsigned int  saturated; /* seconds over a threshold               */
+  unsigned int  reasons;   /* SATURATED_* bits                       */
+} MONSTATS;
+
+void    monitor_start();
+void    monitor_stop();
+void    monitor_get_stats(MONSTATS *stats);
+void    monitor_add_stats(const MONSTATS *stats);
+BOOLEAN monitor_saturated(char *buf, size_t len);
+double  monitor_cpu_per_trans(unsigned int count);
+
+#endif/*__MONITOR_H*/
@@ -32,10 +32,21 @@
 #include <stdarg.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
 #include <notify.h>
 
 #define BUFSIZE 40000
 
+/**
+ * A server that's falling over makes every user say the same
+ * thing at once, and writing it all to stderr slows the run it
+ * describes. So each call site, known by its format string, gets
+ * BURST messages a second; the rest are counted and the next one
+ * that gets through says how many it stands for.
+ */
+#define SITES      128
+#define BURST      5
+
 #define RESET      0
 #define BRIGHT     1
 #define DIM        2
@@ -59,7 +70,17 @@ typedef enum {
   __OUT = 2,
 } METHOD;
 
+typedef struct {
+  const char   *fmt;
+  time_t        second;
+  unsigned int  count;
+  unsigned long dropped;
+} SITE;
+
+static SITE __sites[SITES];
+
 static void __message(METHOD M, LEVEL L, const char *fmt, va_list ap);
+static int  __throttle(const char *fmt, unsigned long *dropped);
 
 void
 OPENLOG(char *program)
@@ -83,14 +104,24 @@ __message(METHOD M, LEVEL L, const char *fmt, va_list ap)
   LEVEL  level = WARNING;
   char   pmode[64];
   char   lmode[64];
+  char   more[64];
+  unsigned long dropped = 0;
   memset(lmode, '\0', 64);
   memset(pmode, '\0', 64);
+  memset(more,  '\0', 64);
+
+  if (M == __OUT && (L == WARNING || L == ERROR) && __throttle(fmt, &dropped)) {
+    return;
+  }
+  if (dropped > 0) {
+    snprintf(more, sizeof more, " (%lu more like it suppressed)", dropped);
+  }
 
   vsprintf(buf, fmt, ap);
   if (errno == 0 || errno == ENOSYS || L == DEBUG) {
-    snprintf(msg, sizeof msg, "%s\n", buf);
+    snprintf(msg, sizeof msg, "%s%s\n", buf, more);
   } else {
-    snprintf(msg, sizeof msg, "%s: %s\n", buf, strerror(errno));
+    snprintf(msg, sizeof msg, "%s: %s%s\n", buf, strerror(errno), more);
   }
 
   switch (L) {
@@ -126,6 +157,40 @@ __message(METHOD M, LEVEL L, const char *fmt, va_list ap)
   return;
 }
 
+/**
+ * Returns 1 if this message is over its site's BURST for the
+ * second; otherwise dropped is what was held back since the
+ * last one. Sites past the table's size aren't throttled.
+ */
+static int
+__throttle(const char *fmt, unsigned long *dropped)
+{
+  int    i;
+  SITE  *S    = NULL;
+  time_t now  = time(NULL);
+  size_t hash = ((size_t)fmt >> 3) % SITES;
+
+  for (i = 0; i < SITES; i++) {
+    SITE *T = &__sites[(hash + i) % SITES];
+    if (T->fmt == fmt || (T->fmt == NULL && __sync_bool_compare_and_swap(&T->fmt, NULL, fmt)) || T->fmt == fmt) {
+      S = T;
+      break;
+    }
+  }
+  if (S == NULL) return 0;
+
+  if (S->second != now) {
+    S->second = now;
+    S->count  = 0;
+  }
+  if (__sync_add_and_fetch(&S->count, 1) > BURST) {
+    __sync_fetch_and_add(&S->dropped, 1);
+    return 1;
+  }
+  *dropped = __sync_lock_test_and_set(&S->dropped, 0);
+  return 0;
+}
+
 void 
 SYSLOG(LEVEL L, const char *fmt, ...)
 {
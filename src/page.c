@@ -93,36 +93,3 @@ __expand(PAGE this, const int len)
   memset(this->buf + (this->size - len), '\0', len); 
   return;
 }
-
-#if 0
-#include <stdio.h>
-#include <stdlib.h>
-
-int
-main (int argc, char *argv[])
-{
-  int     i;
-  FILE    *fp;
-  char    buf[1024];
-  PAGE    page = new_page("");
-  
-  if (argv[1] == NULL || strlen(argv[1]) < 1) {
-    puts("usage: haha <filename>");
-    exit(1);
-  }
-  while (i < 1000) {
-    fp = fopen(argv[1], "r");
-    if (fp == NULL) exit(EXIT_FAILURE);
-
-    while(fgets(buf, sizeof(buf), fp)){
-      page_concat(page,buf,strlen(buf));
-    }
-    printf("%s", page_value(page));
-    page_clear(page);
-    fclose(fp);
-    i++;
-  }
-  exit(EXIT_SUCCESS);
-}
-
-#endif
@@ -0,0 +1,474 @@
+/**
+ * Parsed page cache
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifdef  HAVE_CONFIG_H
+# include <config.h>
+#endif/*HAVE_CONFIG_H*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <pcache.h>
+#include <memory.h>
+#include <util.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+#define P_ETAG 'E'
+#define P_BODY 'B'
+
+struct PARTS_T
+{
+  int       refs;
+  char *    url;
+  int       type;
+  uint64_t  sum;
+  size_t    len;
+  uint64_t  hash;
+  size_t    bytes;
+  int       length;
+  URL *     urls;
+  char *    meta;
+  BOOLEAN   cached;
+  struct PARTS_T *next;
+  struct PARTS_T *newer;
+  struct PARTS_T *older;
+};
+
+struct PCACHE_T
+{
+  int       max;
+  size_t    maxbytes;
+  int       entries;
+  size_t    bytes;
+  int       size;
+  PARTS *   table;
+  PARTS     head;
+  PARTS     tail;
+  unsigned long hits;
+  unsigned long misses;
+  unsigned long evictions;
+  pthread_rwlock_t lock;
+  pthread_mutex_t  lru;
+};
+
+private uint64_t __xxh64(const void *buf, size_t len, uint64_t seed);
+private void     __validator(const char *etag, const char *page, size_t len, int *type, uint64_t *sum);
+private PARTS    __find(PCACHE this, uint64_t hash, const char *url, int type, uint64_t sum, size_t len);
+private void     __unlink(PCACHE this, PARTS P);
+private void     __touch(PCACHE this, PARTS P);
+private void     __evict(PCACHE this, size_t bytes);
+
+PCACHE
+new_pcache(int entries, size_t bytes)
+{
+  PCACHE this;
+
+  this = xcalloc(sizeof(struct PCACHE_T), 1);
+  this->max      = (entries > 0) ? entries : 1;
+  this->maxbytes = bytes;
+  this->size     = 16;
+  while (this->size < this->max * 2) {
+    this->size <<= 1;
+  }
+  this->table    = xcalloc(this->size, sizeof(PARTS));
+  if (pthread_rwlock_init(&this->lock, NULL) != 0) {
+    xfree(this->table);
+    xfree(this);
+    return NULL;
+  }
+  pthread_mutex_init(&this->lru, NULL);
+  return this;
+}
+
+PCACHE
+pcache_destroy(PCACHE this)
+{
+  int   x;
+  PARTS P;
+
+  if (this == NULL) return NULL;
+
+  for (x = 0; x < this->size; x++) {
+    while ((P = this->table[x]) != NULL) {
+      this->table[x] = P->next;
+      P->cached = FALSE;
+      P = parts_release(P);
+    }
+  }
+  pthread_rwlock_destroy(&this->lock);
+  pthread_mutex_destroy(&this->lru);
+  xfree(this->table);
+  xfree(this);
+  return NULL;
+}
+
+/**
+ * Returns a referenced entry for the page or NULL on a
+ * miss. The caller owns the reference and must hand it
+ * back with parts_release()
+ */
+PARTS
+pcache_get(PCACHE this, URL U, const char *etag, const char *page, size_t len)
+{
+  int      type;
+  uint64_t sum;
+  uint64_t hash;
+  PARTS    P;
+  char    *url = url_get_absolute(U);
+
+  if (this == NULL || url == NULL) return NULL;
+
+  __validator(etag, page, len, &type, &sum);
+  hash = __xxh64(url, strlen(url), sum);
+
+  pthread_rwlock_rdlock(&this->lock);
+  P = __find(this, hash, url, type, sum, len);
+  if (P != NULL) {
+    __sync_add_and_fetch(&P->refs, 1);
+    /**
+     * Other readers are in here with us; the LRU
+     * list has its own lock
+     */
+    pthread_mutex_lock(&this->lru);
+    __touch(this, P);
+    pthread_mutex_unlock(&this->lru);
+  }
+  pthread_rwlock_unlock(&this->lock);
+
+  if (P != NULL) {
+    __sync_add_and_fetch(&this->hits, 1);
+  } else {
+    __sync_add_and_fetch(&this->misses, 1);
+  }
+  return P;
+}
+
+/**
+ * Moves the parsed URLs out of the parts array and into a
+ * new entry. The entry is returned with a reference for the
+ * caller even if it was too large to keep in the cache.
+ */
+PARTS
+pcache_put(PCACHE this, URL U, const char *etag, const char *page, size_t len, ARRAY parts, const char *meta)
+{
+  int   i;
+  URL   u;
+  PARTS P;
+  PARTS Q;
+  char *url = url_get_absolute(U);
+
+  P = xcalloc(sizeof(struct PARTS_T), 1);
+  P->refs   = 1;
+  P->url    = xstrdup(url);
+  P->meta   = (meta != NULL) ? xstrdup(meta) : NULL;
+  P->length = (parts != NULL) ? (int)array_length(parts) : 0;
+  P->urls   = xcalloc((P->length > 0) ? P->length : 1, sizeof(URL));
+  P->bytes  = sizeof(struct PARTS_T) + strlen(url) + 1;
+  for (i = P->length - 1; i >= 0 && (u = (URL)array_pop(parts)) != NULL; i--) {
+    P->urls[i] = u;
+    P->bytes  += URLSIZE + (strlen(url_get_absolute(u)) * 2);
+  }
+  __validator(etag, page, len, &P->type, &P->sum);
+  P->len    = len;
+  P->hash   = __xxh64(url, strlen(url), P->sum);
+
+  if (this == NULL || (this->maxbytes > 0 && P->bytes > this->maxbytes)) {
+    return P;
+  }
+
+  pthread_rwlock_wrlock(&this->lock);
+  Q = __find(this, P->hash, P->url, P->type, P->sum, P->len);
+  if (Q != NULL) {
+    /**
+     * Another browser beat us to it; use theirs
+     */
+    __sync_add_and_fetch(&Q->refs, 1);
+    __touch(this, Q);
+    pthread_rwlock_unlock(&this->lock);
+    P = parts_release(P);
+    return Q;
+  }
+  __evict(this, P->bytes);
+  P->refs  += 1;
+  P->cached = TRUE;
+  P->next   = this->table[P->hash & (this->size - 1)];
+  this->table[P->hash & (this->size - 1)] = P;
+  __touch(this, P);
+  this->entries += 1;
+  this->bytes   += P->bytes;
+  pthread_rwlock_unlock(&this->lock);
+  return P;
+}
+
+unsigned long
+pcache_get_hits(PCACHE this)
+{
+  return (this == NULL) ? 0 : this->hits;
+}
+
+unsigned long
+pcache_get_misses(PCACHE this)
+{
+  return (this == NULL) ? 0 : this->misses;
+}
+
+unsigned long
+pcache_get_evictions(PCACHE this)
+{
+  return (this == NULL) ? 0 : this->evictions;
+}
+
+/**
+ * Adds a worker process's counts to ours; see proc.c
+ */
+void
+pcache_add_stats(PCACHE this, unsigned long hits, unsigned long misses, unsigned long evictions)
+{
+  if (this == NULL) return;
+
+  __sync_add_and_fetch(&this->hits,      hits);
+  __sync_add_and_fetch(&this->misses,    misses);
+  __sync_add_and_fetch(&this->evictions, evictions);
+}
+
+/**
+ * Takes another reference for a holder outside the cache
+ */
+PARTS
+parts_retain(PARTS this)
+{
+  if (this == NULL) return NULL;
+
+  __sync_add_and_fetch(&this->refs, 1);
+  return this;
+}
+
+PARTS
+parts_release(PARTS this)
+{
+  int i;
+
+  if (this == NULL) return NULL;
+
+  if (__sync_sub_and_fetch(&this->refs, 1) == 0) {
+    for (i = 0; i < this->length; i++) {
+      this->urls[i] = url_destroy(this->urls[i]);
+    }
+    xfree(this->urls);
+    xfree(this->url);
+    xfree(this->meta);
+    xfree(this);
+  }
+  return NULL;
+}
+
+int
+parts_length(PARTS this)
+{
+  return (this == NULL) ? 0 : this->length;
+}
+
+URL
+parts_get(PARTS this, int index)
+{
+  if (this == NULL || index < 0 || index >= this->length) return NULL;
+  return this->urls[index];
+}
+
+char *
+parts_get_meta(PARTS this)
+{
+  return (this == NULL) ? NULL : this->meta;
+}
+
+private void
+__validator(const char *etag, const char *page, size_t len, int *type, uint64_t *sum)
+{
+  if (etag != NULL && strlen(etag) > 0) {
+    *type = P_ETAG;
+    *sum  = __xxh64(etag, strlen(etag), 0);
+  } else {
+    *type = P_BODY;
+    *sum  = __xxh64(page, (page == NULL) ? 0 : len, 0);
+  }
+}
+
+private PARTS
+__find(PCACHE this, uint64_t hash, const char *url, int type, uint64_t sum, size_t len)
+{
+  PARTS P;
+
+  for (P = this->table[hash & (this->size - 1)]; P != NULL; P = P->next) {
+    if (P->hash == hash && P->type == type && P->sum == sum &&
+       (type == P_ETAG || P->len == len) && strcmp(P->url, url) == 0) {
+      return P;
+    }
+  }
+  return NULL;
+}
+
+private void
+__unlink(PCACHE this, PARTS P)
+{
+  PARTS *ptr = &this->table[P->hash & (this->size - 1)];
+
+  while (*ptr != NULL && *ptr != P) {
+    ptr = &(*ptr)->next;
+  }
+  if (*ptr == P) {
+    *ptr = P->next;
+    if (P->newer != NULL) P->newer->older = P->older;
+    if (P->older != NULL) P->older->newer = P->newer;
+    if (this->head == P) this->head = P->older;
+    if (this->tail == P) this->tail = P->newer;
+    P->next   = NULL;
+    P->newer  = NULL;
+    P->older  = NULL;
+    P->cached = FALSE;
+    this->entries -= 1;
+    this->bytes   -= P->bytes;
+  }
+}
+
+/**
+ * Moves P to the head of the LRU list; the caller holds the
+ * write lock or the read lock and the list lock
+ */
+private void
+__touch(PCACHE this, PARTS P)
+{
+  if (this->head == P) return;
+
+  if (P->newer != NULL) P->newer->older = P->older;
+  if (P->older != NULL) P->older->newer = P->newer;
+  if (this->tail == P) this->tail = P->newer;
+
+  P->newer = NULL;
+  P->older = this->head;
+  if (this->head != NULL) this->head->newer = P;
+  this->head = P;
+  if (this->tail == NULL) this->tail = P;
+}
+
+/**
+ * Called with the write lock held; removes the least recently
+ * used entries until there's room for an entry of 'bytes'
+ */
+private void
+__evict(PCACHE this, size_t bytes)
+{
+  PARTS lru;
+
+  while (this->entries > 0 && (this->entries >= this->max ||
+        (this->maxbytes > 0 && this->bytes + bytes > this->maxbytes))) {
+    if ((lru = this->tail) == NULL) break;
+    __unlink(this, lru);
+    lru = parts_release(lru);
+    this->evictions += 1;
+  }
+}
+
+/**
+ * xxHash64 by Yann Collet; the reference implementation is
+ * BSD licensed. We only need the one-shot variant, reads are
+ * host order since the digests never leave the process.
+ */
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+#define ROTL64(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+private uint64_t
+__xxh64_round(uint64_t acc, uint64_t input)
+{
+  acc += input * PRIME64_2;
+  acc  = ROTL64(acc, 31);
+  return acc * PRIME64_1;
+}
+
+private uint64_t
+__xxh64_merge(uint64_t acc, uint64_t val)
+{
+  acc ^= __xxh64_round(0, val);
+  return acc * PRIME64_1 + PRIME64_4;
+}
+
+private uint64_t
+__xxh64(const void *buf, size_t len, uint64_t seed)
+{
+  const unsigned char *p   = (const unsigned char *)buf;
+  const unsigned char *end = p + len;
+  uint64_t h;
+  uint64_t k;
+  uint32_t w;
+
+  if (len >= 32) {
+    const unsigned char *limit = end - 32;
+    uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+    uint64_t v2 = seed + PRIME64_2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - PRIME64_1;
+    do {
+      memcpy(&k, p, 8); v1 = __xxh64_round(v1, k); p += 8;
+      memcpy(&k, p, 8); v2 = __xxh64_round(v2, k); p += 8;
+      memcpy(&k, p, 8); v3 = __xxh64_round(v3, k); p += 8;
+      memcpy(&k, p, 8); v4 = __xxh64_round(v4, k); p += 8;
+    } while (p <= limit);
+    h = ROTL64(v1, 1) + ROTL64(v2, 7) + ROTL64(v3, 12) + ROTL64(v4, 18);
+    h = __xxh64_merge(h, v1);
+    h = __xxh64_merge(h, v2);
+    h = __xxh64_merge(h, v3);
+    h = __xxh64_merge(h, v4);
+  } else {
+    h = seed + PRIME64_5;
+  }
+  h += (uint64_t)len;
+
+  while (p + 8 <= end) {
+    memcpy(&k, p, 8);
+    h ^= __xxh64_round(0, k);
+    h  = ROTL64(h, 27) * PRIME64_1 + PRIME64_4;
+    p += 8;
+  }
+  if (p + 4 <= end) {
+    memcpy(&w, p, 4);
+    h ^= (uint64_t)w * PRIME64_1;
+    h  = ROTL64(h, 23) * PRIME64_2 + PRIME64_3;
+    p += 4;
+  }
+  while (p < end) {
+    h ^= (*p) * PRIME64_5;
+    h  = ROTL64(h, 11) * PRIME64_1;
+    p++;
+  }
+  h ^= h >> 33;
+  h *= PRIME64_2;
+  h ^= h >> 29;
+  h *= PRIME64_3;
+  h ^= h >> 32;
+  return h;
+}
@@ -0,0 +1,57 @@
+/**
+ * Parsed page cache
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifndef __PCACHE_H
+#define __PCACHE_H
+
+#include <stdlib.h>
+#include <url.h>
+#include <array.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+/**
+ * A process-wide cache of html_parser results. It's keyed
+ * by the page URL plus its ETag or, when the server didn't
+ * send one, a hash of the body. Each entry is an immutable,
+ * reference counted list of sub-resource URLs; the browsers
+ * share them read-only and release them when they're done.
+ */
+typedef struct PCACHE_T *PCACHE;
+typedef struct PARTS_T  *PARTS;
+
+PCACHE   new_pcache(int entries, size_t bytes);
+PCACHE   pcache_destroy(PCACHE this);
+PARTS    pcache_get(PCACHE this, URL U, const char *etag, const char *page, size_t len);
+PARTS    pcache_put(PCACHE this, URL U, const char *etag, const char *page, size_t len, ARRAY parts, const char *meta);
+unsigned long pcache_get_hits(PCACHE this);
+unsigned long pcache_get_misses(PCACHE this);
+unsigned long pcache_get_evictions(PCACHE this);
+void     pcache_add_stats(PCACHE this, unsigned long hits, unsigned long misses, unsigned long evictions);
+
+PARTS    parts_retain(PARTS this);
+PARTS    parts_release(PARTS this);
+int      parts_length(PARTS this);
+URL      parts_get(PARTS this, int index);
+char *   parts_get_meta(PARTS this);
+
+#endif/*__PCACHE_H*/
@@ -0,0 +1,427 @@
+/**
+ * Capacity preflight
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifdef  HAVE_CONFIG_H
+# include <config.h>
+#endif/*HAVE_CONFIG_H*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <preflight.h>
+#include <notify.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+#ifdef  HAVE_UNISTD_H
+# include <unistd.h>
+#endif/*HAVE_UNISTD_H*/
+
+#ifdef  HAVE_SYS_RESOURCE_H
+# include <sys/resource.h>
+#endif/*HAVE_SYS_RESOURCE_H*/
+
+#define UNLIMITED  INT_MAX
+#define RESERVE_FD 64           /* stdio, logs, the URL file, rings...  */
+#define USER_RSS   (64 * 1024)  /* what a browser really touches, give or take */
+
+private int       __nofile(int fds, char *note, size_t len);
+private int       __nproc(char *note, size_t len);
+private int       __threads(char *note, size_t len);
+private int       __maps(char *note, size_t len);
+private int       __vmem(size_t stack, char *note, size_t len);
+private int       __memory(size_t stack, BOOLEAN *estimate, char *note, size_t len);
+private long long __proc_value(const char *file, const char *key);
+private int       __count_lines(const char *file);
+private int       __count_entries(const char *dir);
+private int       __user_tasks();
+private void      __row(const char *name, int max, int users, const char *note);
+
+/**
+ * Returns the stack size our threads get: the one we asked
+ * for, no smaller than MIN_STACK and rounded up to a whole
+ * page, or the library default
+ */
+size_t
+preflight_stacksize(size_t stack)
+{
+  long page;
+  pthread_attr_t attr;
+
+  if (stack > 0) {
+    if (stack < MIN_STACK * 1024) {
+      stack = MIN_STACK * 1024;
+    }
+    if ((page = sysconf(_SC_PAGESIZE)) > 0) {
+      stack = (stack + page - 1) / page * page;
+    }
+    return stack;
+  }
+
+  pthread_attr_init(&attr);
+  pthread_attr_getstacksize(&attr, &stack);
+  pthread_attr_destroy(&attr);
+  return stack;
+}
+
+int
+preflight(int users, size_t stack, int fds, BOOLEAN report)
+{
+  int     i;
+  int     max = UNLIMITED;
+  int     lim[6];
+  char    note[6][64];
+  BOOLEAN estimate = FALSE;
+  const char *names[] = {
+    "open files", "processes", "threads", "memory maps", "address space", "memory"
+  };
+
+  stack = preflight_stacksize(stack);
+  memset(note, '\0', sizeof(note));
+
+  lim[0] = __nofile(fds, note[0], sizeof(note[0]));
+  lim[1] = __nproc(note[1], sizeof(note[1]));
+  lim[2] = __threads(note[2], sizeof(note[2]));
+  lim[3] = __maps(note[3], sizeof(note[3]));
+  lim[4] = __vmem(stack, note[4], sizeof(note[4]));
+  lim[5] = __memory(stack, &estimate, note[5], sizeof(note[5]));
+
+  for (i = 0; i < 6; i++) {
+    /* an estimate shouldn't stop the run; we warn instead */
+    if (lim[i] < max && !(i == 5 && estimate)) max = lim[i];
+  }
+
+  if (report || max < users || lim[5] < users) {
+    fprintf(stderr, "** Preflight for %d users, %lu KB stacks:\n", users, (unsigned long)(stack / 1024));
+    for (i = 0; i < 6; i++) {
+      __row(names[i], lim[i], users, note[i]);
+    }
+  }
+  if (max >= users && lim[5] < users) {
+    NOTIFY(WARNING, "preflight: memory may run out past %d users; try a smaller --thread-stack", lim[5]);
+  }
+  return max;
+}
+
+private void
+__row(const char *name, int max, int users, const char *note)
+{
+  if (max == UNLIMITED) {
+    fprintf(stderr, "   %-16s %12s users  %s\n", name, "unlimited", note);
+  } else {
+    fprintf(stderr, "   %-16s %12d users  %s%s\n", name, max, (max < users) ? "SHORT " : "", note);
+  }
+}
+
+/**
+ * Every browser holds a socket; with epoll or io_uring it also
+ * holds a descriptor for its thread's set or ring.
+ */
+private int
+__nofile(int fds, char *note, size_t len)
+{
+#if defined(RLIMIT_NOFILE)
+  long long open;
+  long long nr_open;
+  struct rlimit rl;
+
+  if (getrlimit(RLIMIT_NOFILE, &rl) < 0) {
+    return UNLIMITED;
+  }
+  if (rl.rlim_cur != RLIM_INFINITY && (rl.rlim_max == RLIM_INFINITY || rl.rlim_cur < rl.rlim_max)) {
+    rlim_t old = rl.rlim_cur;
+    rl.rlim_cur = rl.rlim_max;
+    if (rl.rlim_cur == RLIM_INFINITY && (nr_open = __proc_value("/proc/sys/fs/nr_open", NULL)) > 0) {
+      rl.rlim_cur = (rlim_t)nr_open;
+    }
+    if (setrlimit(RLIMIT_NOFILE, &rl) == 0) {
+      snprintf(note, len, "(raised from %llu)", (unsigned long long)old);
+    } else {
+      rl.rlim_cur = old;
+    }
+  }
+  if (rl.rlim_cur == RLIM_INFINITY) {
+    return UNLIMITED;
+  }
+  if ((open = __count_entries("/proc/self/fd")) < 0) {
+    open = 0;
+  }
+  if (fds < 1) fds = 1;
+  open = ((long long)rl.rlim_cur - open - RESERVE_FD) / fds;
+  return (open < 0) ? 0 : (open > UNLIMITED) ? UNLIMITED : (int)open;
+#else
+  (void)fds; (void)note; (void)len;
+  return UNLIMITED;
+#endif/*RLIMIT_NOFILE*/
+}
+
+/**
+ * RLIMIT_NPROC counts every thread that belongs to our user,
+ * not just ours. root isn't held to it.
+ */
+private int
+__nproc(char *note, size_t len)
+{
+#if defined(RLIMIT_NPROC)
+  long long left;
+  struct rlimit rl;
+
+  if (getuid() == 0 || getrlimit(RLIMIT_NPROC, &rl) < 0) {
+    return UNLIMITED;
+  }
+  if (rl.rlim_cur != RLIM_INFINITY && (rl.rlim_max == RLIM_INFINITY || rl.rlim_cur < rl.rlim_max)) {
+    rlim_t old = rl.rlim_cur;
+    rl.rlim_cur = rl.rlim_max;
+    if (setrlimit(RLIMIT_NPROC, &rl) == 0) {
+      snprintf(note, len, "(raised from %llu)", (unsigned long long)old);
+    } else {
+      rl.rlim_cur = old;
+    }
+  }
+  if (rl.rlim_cur == RLIM_INFINITY) {
+    return UNLIMITED;
+  }
+  left = (long long)rl.rlim_cur - __user_tasks();
+  return (left < 0) ? 0 : (left > UNLIMITED) ? UNLIMITED : (int)left;
+#else
+  (void)note; (void)len;
+  return UNLIMITED;
+#endif/*RLIMIT_NPROC*/
+}
+
+/**
+ * System wide: kernel.threads-max and kernel.pid_max less the
+ * tasks that already exist (the 4th field of /proc/loadavg)
+ */
+private int
+__threads(char *note, size_t len)
+{
+  FILE      *fp;
+  long long  max;
+  long long  pids;
+  long long  tasks = 0;
+  int        running;
+
+  max  = __proc_value("/proc/sys/kernel/threads-max", NULL);
+  pids = __proc_value("/proc/sys/kernel/pid_max", NULL);
+  if (max < 0 && pids < 0) {
+    return UNLIMITED;
+  }
+  if (max < 0 || (pids > 0 && pids < max)) {
+    max = pids;
+    snprintf(note, len, "(pid_max)");
+  }
+  if ((fp = fopen("/proc/loadavg", "r")) != NULL) {
+    if (fscanf(fp, "%*s %*s %*s %d/%lld", &running, &tasks) != 2) {
+      tasks = 0;
+    }
+    fclose(fp);
+  }
+  max -= tasks;
+  return (max < 0) ? 0 : (max > UNLIMITED) ? UNLIMITED : (int)max;
+}
+
+/**
+ * Each thread stack is a mapping plus a guard page
+ */
+private int
+__maps(char *note, size_t len)
+{
+  long long max;
+  int       used;
+
+  (void)note; (void)len;
+  if ((max = __proc_value("/proc/sys/vm/max_map_count", NULL)) < 0) {
+    return UNLIMITED;
+  }
+  if ((used = __count_lines("/proc/self/maps")) < 0) {
+    used = 0;
+  }
+  max = (max - used - 1024) / 2;
+  return (max < 0) ? 0 : (max > UNLIMITED) ? UNLIMITED : (int)max;
+}
+
+/**
+ * RLIMIT_AS has to hold every stack we reserve
+ */
+private int
+__vmem(size_t stack, char *note, size_t len)
+{
+#if defined(RLIMIT_AS)
+  long long size;
+  long long left;
+  struct rlimit rl;
+
+  if (getrlimit(RLIMIT_AS, &rl) < 0) {
+    return UNLIMITED;
+  }
+  if (rl.rlim_cur != RLIM_INFINITY && (rl.rlim_max == RLIM_INFINITY || rl.rlim_cur < rl.rlim_max)) {
+    rlim_t old = rl.rlim_cur;
+    rl.rlim_cur = rl.rlim_max;
+    if (setrlimit(RLIMIT_AS, &rl) == 0) {
+      snprintf(note, len, "(raised from %llu MB)", (unsigned long long)old >> 20);
+    } else {
+      rl.rlim_cur = old;
+    }
+  }
+  if (rl.rlim_cur == RLIM_INFINITY) {
+    return UNLIMITED;
+  }
+  size = __proc_value("/proc/self/status", "VmSize:");
+  size = (size < 0) ? 0 : size * 1024;
+  left = ((long long)rl.rlim_cur - size) / (long long)(stack + USER_RSS);
+  return (left < 0) ? 0 : (left > UNLIMITED) ? UNLIMITED : (int)left;
+#else
+  (void)stack; (void)note; (void)len;
+  return UNLIMITED;
+#endif/*RLIMIT_AS*/
+}
+
+/**
+ * With strict overcommit (vm.overcommit_memory = 2) every stack
+ * is charged in full against the commit limit, so that's a hard
+ * limit. Otherwise stacks are only touched a page or two deep;
+ * we guess from MemAvailable and only warn.
+ */
+private int
+__memory(size_t stack, BOOLEAN *estimate, char *note, size_t len)
+{
+  long long left;
+
+  if (__proc_value("/proc/sys/vm/overcommit_memory", NULL) == 2) {
+    long long limit     = __proc_value("/proc/meminfo", "CommitLimit:");
+    long long committed = __proc_value("/proc/meminfo", "Committed_AS:");
+    if (limit < 0 || committed < 0) return UNLIMITED;
+    snprintf(note, len, "(strict overcommit)");
+    left = (limit - committed) * 1024 / (long long)(stack + USER_RSS);
+  } else {
+    long long avail = __proc_value("/proc/meminfo", "MemAvailable:");
+    if (avail < 0) return UNLIMITED;
+    snprintf(note, len, "(estimate)");
+    *estimate = TRUE;
+    left = avail * 1024 / USER_RSS;
+  }
+  return (left < 0) ? 0 : (left > UNLIMITED) ? UNLIMITED : (int)left;
+}
+
+/**
+ * Returns the first number in file or, if key isn't NULL, the
+ * number that follows key at the start of a line; -1 if we
+ * can't find it.
+ */
+private long long
+__proc_value(const char *file, const char *key)
+{
+  FILE      *fp;
+  char       line[256];
+  long long  val = -1;
+
+  if ((fp = fopen(file, "r")) == NULL) {
+    return -1;
+  }
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    if (key == NULL) {
+      val = strtoll(line, NULL, 10);
+      break;
+    }
+    if (strncmp(line, key, strlen(key)) == 0) {
+      val = strtoll(line + strlen(key), NULL, 10);
+      break;
+    }
+  }
+  fclose(fp);
+  return val;
+}
+
+private int
+__count_lines(const char *file)
+{
+  FILE *fp;
+  int   c;
+  int   n = 0;
+
+  if ((fp = fopen(file, "r")) == NULL) {
+    return -1;
+  }
+  while ((c = fgetc(fp)) != EOF) {
+    if (c == '\n') n++;
+  }
+  fclose(fp);
+  return n;
+}
+
+private int
+__count_entries(const char *path)
+{
+  DIR *dir;
+  int  n = 0;
+  struct dirent *ent;
+
+  if ((dir = opendir(path)) == NULL) {
+    return -1;
+  }
+  while ((ent = readdir(dir)) != NULL) {
+    if (ent->d_name[0] != '.') n++;
+  }
+  closedir(dir);
+  return n;
+}
+
+/**
+ * Adds up the threads of every process that belongs to us
+ */
+private int
+__user_tasks()
+{
+  DIR  *dir;
+  FILE *fp;
+  int   total = 0;
+  char  path[300];
+  char  line[256];
+  unsigned int uid;
+  struct dirent *ent;
+
+  if ((dir = opendir("/proc")) == NULL) {
+    return 0;
+  }
+  while ((ent = readdir(dir)) != NULL) {
+    BOOLEAN mine = FALSE;
+    if (!isdigit((unsigned char)ent->d_name[0])) continue;
+    snprintf(path, sizeof(path), "/proc/%s/status", ent->d_name);
+    if ((fp = fopen(path, "r")) == NULL) continue;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+      if (sscanf(line, "Uid: %u", &uid) == 1) {
+        mine = (uid == getuid()) ? TRUE : FALSE;
+      } else if (mine && strncmp(line, "Threads:", 8) == 0) {
+        total += atoi(line + 8);
+        break;
+      }
+    }
+    fclose(fp);
+  }
+  closedir(dir);
+  return total;
+}
@@ -0,0 +1,43 @@
+/**
+ * Capacity preflight
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifndef __PREFLIGHT_H
+#define __PREFLIGHT_H
+
+#include <stdlib.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+/**
+ * Checks the host's limits against the number of users we're
+ * about to start: open files, processes, threads-max, pid_max,
+ * memory maps, address space and memory. Soft limits that are
+ * below their hard limit get raised. Returns the number of
+ * users the host can take; the caller decides what to do if
+ * that's fewer than it asked for.
+ */
+#define MIN_STACK 128   /* KB; notify.c alone keeps ~80KB on the stack */
+
+int     preflight(int users, size_t stack, int fds, BOOLEAN report);
+size_t  preflight_stacksize(size_t stack);
+
+#endif/*__PREFLIGHT_H*/
@@ -0,0 +1,454 @@
+/**
+ * Worker processes
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifdef  HAVE_CONFIG_H
+# include <config.h>
+#endif/*HAVE_CONFIG_H*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <signal.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <setup.h>
+#include <proc.h>
+#include <tally.h>
+#include <sock.h>
+#include <util.h>
+#include <memory.h>
+#include <notify.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+#ifdef  HAVE_UNISTD_H
+# include <unistd.h>
+#endif/*HAVE_UNISTD_H*/
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+# define MAP_ANONYMOUS MAP_ANON
+#endif
+
+#define RUNNING 0
+#define STOPPED 1
+#define DONE    2
+
+/**
+ * One per worker. seq is odd while the worker is writing so
+ * the parent can tell a torn copy from a good one. conns runs
+ * past the end of the struct, one per --bind source.
+ */
+typedef struct
+{
+  volatile unsigned int seq;
+  volatile int          state;
+  pid_t                 pid;
+  TALLY                 tally;
+  unsigned long         conns[1];
+} SLOT;
+
+struct PROCS_T
+{
+  int      count;
+  int      users;
+  int      worker;
+  int      sources;
+  size_t   stride;
+  size_t   size;
+  char *   map;
+  pid_t *  pids;
+  BOOLEAN *reaped;
+  FILE **  cookies;
+};
+
+private SLOT *       __slot(PROCS this, int index);
+private void         __snapshot(PROCS this, int index, SLOT *copy);
+private void         __merge(PROCS this, int index, SLOT *S, DATA data, PCACHE pcache, EDGE edge);
+private void         __signal(PROCS this, int sig);
+private unsigned int __failed(PROCS this);
+private BOOLEAN      __stopped(PROCS this);
+private int          __find(PROCS this, pid_t pid);
+private void         __lift(BOOLEAN *lifted);
+
+PROCS
+new_procs(int count, int users)
+{
+  PROCS this;
+
+  this = xcalloc(sizeof(struct PROCS_T), 1);
+  this->count   = (count > users) ? users : count;
+  this->users   = users;
+  this->worker  = -1;
+  this->sources = socket_get_sources();
+  this->stride  = offsetof(SLOT, conns) + sizeof(unsigned long) * (this->sources + 1);
+  this->stride  = (this->stride + 63) & ~(size_t)63;
+  this->size    = this->stride * this->count;
+  this->pids    = xcalloc(this->count, sizeof(pid_t));
+  this->reaped  = xcalloc(this->count, sizeof(BOOLEAN));
+  this->cookies = xcalloc(this->count, sizeof(FILE *));
+
+  this->map = mmap(NULL, this->size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0);
+  if (this->map == MAP_FAILED) {
+    NOTIFY(ERROR, "procs: unable to map %lu bytes of shared memory", (unsigned long)this->size);
+    this->map = NULL;
+    return procs_destroy(this);
+  }
+  return this;
+}
+
+PROCS
+procs_destroy(PROCS this)
+{
+  int i;
+
+  if (this == NULL) return NULL;
+
+  for (i = 0; i < this->count; i++) {
+    if (this->cookies[i] != NULL) {
+      fclose(this->cookies[i]);
+    }
+  }
+  if (this->map != NULL) {
+    munmap(this->map, this->size);
+  }
+  xfree(this->cookies);
+  xfree(this->reaped);
+  xfree(this->pids);
+  xfree(this);
+  return NULL;
+}
+
+/**
+ * Forks the workers. Returns the worker's index in the child
+ * and -1 in the parent. Cookies don't fit in a fixed slot so
+ * each worker writes them to its own temp file.
+ */
+int
+procs_start(PROCS this)
+{
+  int   i;
+  int   j;
+  pid_t pid;
+
+  for (i = 0; i < this->count; i++) {
+    if ((this->cookies[i] = tmpfile()) == NULL) {
+      NOTIFY(FATAL, "procs: unable to create a temp file for worker %d", i);
+    }
+  }
+
+  fflush(stdout);
+  fflush(stderr);
+  for (i = 0; i < this->count; i++) {
+    if ((pid = fork()) < 0) {
+      for (j = 0; j < i; j++) {
+        kill(this->pids[j], SIGKILL);
+        waitpid(this->pids[j], NULL, 0);
+      }
+      NOTIFY(FATAL, "procs: unable to fork worker %d", i);
+    }
+    if (pid == 0) {
+      /**
+       * We stop workers with SIGINT; the handler thread
+       * ignores a TERM on runs without -t. A shell puts
+       * background jobs on SIG_IGN for INT; it's blocked so
+       * the default won't kill us, sigwait just gets it.
+       */
+      signal(SIGINT, SIG_DFL);
+      this->worker = i;
+      __slot(this, i)->pid = getpid();
+      return i;
+    }
+    this->pids[i] = pid;
+  }
+  return -1;
+}
+
+/**
+ * Users are dealt out as evenly as they go; the first
+ * users % count workers get one extra.
+ */
+int
+procs_get_first(PROCS this)
+{
+  int i = (this->worker < 0) ? 0 : this->worker;
+
+  return i * (this->users / this->count) + ((i < this->users % this->count) ? i : this->users % this->count);
+}
+
+int
+procs_get_users(PROCS this)
+{
+  int i = (this->worker < 0) ? 0 : this->worker;
+
+  return this->users / this->count + ((i < this->users % this->count) ? 1 : 0);
+}
+
+/**
+ * Called by a worker: copies data and what the modules have
+ * counted into its slot. The final call adds the cookies and
+ * marks the slot done.
+ */
+void
+procs_publish(PROCS this, DATA data, PCACHE pcache, EDGE edge, BOOLEAN final)
+{
+  int   i;
+  SLOT *S;
+
+  if (this == NULL || this->worker < 0) return;
+
+  S = __slot(this, this->worker);
+  __sync_add_and_fetch(&S->seq, 1);
+  __sync_synchronize();
+
+  tally_collect(&S->tally, data, pcache, edge);
+  for (i = 0; i < this->sources; i++) {
+    socket_get_source(i, &S->conns[i]);
+  }
+
+  if (final) {
+    FILE *fp = this->cookies[this->worker];
+    fputs(data_get_cookies(data), fp);
+    fflush(fp);
+    S->state = DONE;
+  }
+
+  __sync_synchronize();
+  __sync_add_and_fetch(&S->seq, 1);
+}
+
+/**
+ * Called by a worker the moment its run ends; the parent
+ * stops the clock when they all have. Tearing down threads
+ * and publishing take a while and don't count.
+ */
+void
+procs_stopped(PROCS this)
+{
+  if (this == NULL || this->worker < 0) return;
+
+  __slot(this, this->worker)->state = STOPPED;
+}
+
+/**
+ * Called by the parent: waits for the workers, forwards HUP,
+ * INT and TERM, stops them all if their failures add up to
+ * my.failures, then merges their slots into data and our own
+ * pcache, edge and socket counters. It stops data's clock.
+ * Returns FALSE if any of them died before it finished.
+ */
+BOOLEAN
+procs_wait(PROCS this, DATA data, PCACHE pcache, EDGE edge)
+{
+  int      i;
+  int      sig;
+  int      status;
+  int      ticks    = 0;
+  int      alive    = this->count;
+  pid_t    pid;
+  BOOLEAN  okay     = TRUE;
+  BOOLEAN  lifted   = FALSE;
+  BOOLEAN  stopping = FALSE;
+  BOOLEAN  stopped  = FALSE;
+  SLOT    *copy;
+  sigset_t sigs;
+  sigset_t pend;
+
+  sigemptyset(&sigs);
+  sigaddset(&sigs, SIGHUP);
+  sigaddset(&sigs, SIGINT);
+  sigaddset(&sigs, SIGTERM);
+
+  while (alive > 0) {
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+      if ((i = __find(this, pid)) < 0) continue;
+      this->reaped[i] = TRUE;
+      alive--;
+      errno = 0;
+      if (WIFSIGNALED(status)) {
+        NOTIFY(WARNING, "procs: worker %d (pid %d) died on signal %d", i, (int)pid, WTERMSIG(status));
+        okay = FALSE;
+      } else if (__slot(this, i)->state != DONE) {
+        NOTIFY(WARNING, "procs: worker %d (pid %d) exited %d before it finished", i, (int)pid, WEXITSTATUS(status));
+        okay = FALSE;
+      }
+      if (my.secs > 0) {
+        __lift(&lifted);
+      }
+    }
+    if (! stopped && __stopped(this)) {
+      data_set_stop(data);
+      stopped = TRUE;
+    }
+    if (alive == 0) break;
+
+    if (sigpending(&pend) == 0 &&
+        (sigismember(&pend, SIGHUP) || sigismember(&pend, SIGINT) || sigismember(&pend, SIGTERM))) {
+      sigwait(&sigs, &sig);
+      __lift(&lifted);
+      __signal(this, SIGINT);
+      stopping = TRUE;
+    }
+
+    if (! stopping && my.failures > 0 && ++ticks % 10 == 0 && __failed(this) >= (unsigned)my.failures) {
+      __signal(this, SIGINT);
+      stopping = TRUE;
+    }
+    pthread_usleep_np(10000);
+  }
+
+  if (! stopped) {
+    data_set_stop(data);
+  }
+
+  my.failed = 0;
+  copy = xmalloc(this->stride);
+  for (i = 0; i < this->count; i++) {
+    __snapshot(this, i, copy);
+    __merge(this, i, copy, data, pcache, edge);
+  }
+  xfree(copy);
+  if (! okay) {
+    errno = 0;
+    NOTIFY(WARNING, "procs: the results only include what the lost workers reported before they died");
+  }
+  return okay;
+}
+
+private SLOT *
+__slot(PROCS this, int index)
+{
+  return (SLOT *)(this->map + (size_t)index * this->stride);
+}
+
+/**
+ * Copies a slot while its worker isn't writing it. A worker
+ * that died mid-write leaves seq odd for good, so we only
+ * wait so long.
+ */
+private void
+__snapshot(PROCS this, int index, SLOT *copy)
+{
+  int          tries;
+  unsigned int seq;
+  SLOT        *S = __slot(this, index);
+
+  for (tries = 0; tries < 100; tries++) {
+    seq = S->seq;
+    __sync_synchronize();
+    memcpy(copy, S, this->stride);
+    __sync_synchronize();
+    if ((seq & 1) == 0 && seq == S->seq) {
+      return;
+    }
+    pthread_usleep_np(1000);
+  }
+}
+
+private void
+__merge(PROCS this, int index, SLOT *S, DATA data, PCACHE pcache, EDGE edge)
+{
+  int   i;
+  long  len;
+  char *text;
+  FILE *fp = this->cookies[index];
+
+  tally_merge(&S->tally, data, pcache, edge);
+  for (i = 0; i < this->sources; i++) {
+    socket_add_conns(i, S->conns[i]);
+  }
+
+  if (fp != NULL && fseek(fp, 0L, SEEK_END) == 0 && (len = ftell(fp)) > 0) {
+    text = xmalloc(len + 1);
+    rewind(fp);
+    len  = fread(text, 1, len, fp);
+    text[len] = '\0';
+    data_increment_cookies(data, text);
+    xfree(text);
+  }
+}
+
+private void
+__signal(PROCS this, int sig)
+{
+  int i;
+
+  for (i = 0; i < this->count; i++) {
+    if (! this->reaped[i] && this->pids[i] > 0) {
+      kill(this->pids[i], sig);
+    }
+  }
+}
+
+/**
+ * What the workers have failed so far; a live read so
+ * a count may be a second stale
+ */
+private unsigned int
+__failed(PROCS this)
+{
+  int          i;
+  unsigned int failed = 0;
+
+  for (i = 0; i < this->count; i++) {
+    failed += __slot(this, i)->tally.failed;
+  }
+  return failed;
+}
+
+private BOOLEAN
+__stopped(PROCS this)
+{
+  int i;
+
+  for (i = 0; i < this->count; i++) {
+    if (! this->reaped[i] && __slot(this, i)->state == RUNNING) return FALSE;
+  }
+  return TRUE;
+}
+
+private int
+__find(PROCS this, pid_t pid)
+{
+  int i;
+
+  for (i = 0; i < this->count; i++) {
+    if (this->pids[i] == pid) return i;
+  }
+  return -1;
+}
+
+/**
+ * The workers keep quiet; we tell the user once
+ */
+private void
+__lift(BOOLEAN *lifted)
+{
+  if (*lifted) return;
+
+  *lifted = TRUE;
+  if (! my.quiet) {
+    fprintf(stderr, "\nLifting the server siege...");
+  }
+}
@@ -0,0 +1,55 @@
+/**
+ * Worker processes
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifndef __PROC_H
+#define __PROC_H
+
+#include <stdlib.h>
+#include <data.h>
+#include <pcache.h>
+#include <edge.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+/**
+ * --procs=N forks N worker processes that each run a slice
+ * of the users with their own allocator, locks and stdout.
+ * Every worker has a slot in an anonymous shared mapping; it
+ * publishes its counters and histogram there once a second
+ * and one last time when it's done. The parent watches the
+ * slots while they run, forwards signals, and adds it all up
+ * at the end so the summary reads as if one process ran it.
+ * A worker that dies takes only its slice with it; we keep
+ * whatever it last published.
+ */
+typedef struct PROCS_T *PROCS;
+
+PROCS   new_procs(int count, int users);
+PROCS   procs_destroy(PROCS this);
+int     procs_start(PROCS this);
+int     procs_get_first(PROCS this);
+int     procs_get_users(PROCS this);
+void    procs_publish(PROCS this, DATA data, PCACHE pcache, EDGE edge, BOOLEAN final);
+void    procs_stopped(PROCS this);
+BOOLEAN procs_wait(PROCS this, DATA data, PCACHE pcache, EDGE edge);
+
+#endif/*__PROC_H*/
@@ -0,0 +1,555 @@
+/**
+ * Load profiles
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifdef  HAVE_CONFIG_H
+# include <config.h>
+#endif/*HAVE_CONFIG_H*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <setup.h>
+#include <profile.h>
+#include <browser.h>
+#include <util.h>
+#include <perl.h>
+#include <memory.h>
+#include <notify.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+#define RAMP 0
+#define HOLD 1
+#define STEP 2
+
+typedef struct
+{
+  int           type;
+  int           from;
+  int           to;
+  int           by;
+  int           every;
+  int           secs;
+  int           start;
+  int           peak;
+  unsigned long hits;
+  float         ran;
+  char          label[96];
+} STAGE;
+
+typedef struct
+{
+  int           stage;
+  int           users;
+  unsigned long hits;
+} SAMPLE;
+
+struct PROFILE_T
+{
+  STAGE *         stages;
+  int             count;
+  STAGE           after;
+  int             users;
+  int             secs;
+  volatile int    active;
+  ARRAY           browsers;
+  BOOLEAN         running;
+  pthread_t       driver;
+  pthread_mutex_t lock;
+  pthread_cond_t  cond;
+  double          start;
+  unsigned long   last;
+  SAMPLE *        samples;
+  int             nsamples;
+  int             size;
+};
+
+private BOOLEAN __parse(PROFILE this, char *text, int *level);
+private int     __duration(const char *str);
+private int     __level(PROFILE this, double t);
+private int     __stage(PROFILE this, double t);
+private STAGE * __at(PROFILE this, int index);
+private void    __set(PROFILE this, int level);
+private void    __sample(PROFILE this, BOOLEAN whole);
+private void *  __driver(void *arg);
+private void    __unlock(void *arg);
+private double  __now(void);
+
+/**
+ * Stages are separated by semicolons:
+ *
+ *   ramp [FROM->]TO over DURATION
+ *   hold DURATION
+ *   step +N|-N every DURATION until LEVEL
+ *
+ * FROM defaults to where the last stage left off, which is 0
+ * for the first one; "to" and "→" work as well as "->". A
+ * DURATION is a number with s, m or h, ex: 90s, 5m, 1h30m.
+ */
+PROFILE
+new_profile(const char *spec)
+{
+  int     level = 0;
+  char   *tmp;
+  char   *tok;
+  char   *save  = NULL;
+  PROFILE this;
+
+  if (spec == NULL) return NULL;
+
+  this = xcalloc(sizeof(struct PROFILE_T), 1);
+  pthread_mutex_init(&this->lock, NULL);
+  pthread_cond_init(&this->cond, NULL);
+  snprintf(this->after.label, sizeof(this->after.label), "after the profile");
+
+  tmp = xstrdup(spec);
+  for (tok = strtok_r(tmp, ";", &save); tok != NULL; tok = strtok_r(NULL, ";", &save)) {
+    tok = trim(tok);
+    if (*tok == '\0') continue;
+    this->stages = xrealloc(this->stages, sizeof(STAGE) * (this->count + 1));
+    memset(&this->stages[this->count], '\0', sizeof(STAGE));
+    if (__parse(this, tok, &level) == FALSE) {
+      NOTIFY(ERROR, "profile: unable to parse '%s'", tok);
+      xfree(tmp);
+      return profile_destroy(this);
+    }
+    this->count++;
+  }
+  xfree(tmp);
+
+  if (this->count == 0 || this->users < 1) {
+    NOTIFY(ERROR, "profile: '%s' never starts a user", spec);
+    return profile_destroy(this);
+  }
+  return this;
+}
+
+PROFILE
+new_profile_manual(int users)
+{
+  PROFILE this;
+
+  this = xcalloc(sizeof(struct PROFILE_T), 1);
+  this->users = users;
+  pthread_mutex_init(&this->lock, NULL);
+  pthread_cond_init(&this->cond, NULL);
+  return this;
+}
+
+PROFILE
+profile_destroy(PROFILE this)
+{
+  if (this == NULL) return NULL;
+
+  profile_stop(this);
+  pthread_mutex_destroy(&this->lock);
+  pthread_cond_destroy(&this->cond);
+  xfree(this->stages);
+  xfree(this->samples);
+  xfree(this);
+  return NULL;
+}
+
+/**
+ * The most users the profile ever has active; that's how
+ * many browsers we start
+ */
+int
+profile_get_users(PROFILE this)
+{
+  return (this == NULL) ? 0 : this->users;
+}
+
+int
+profile_get_secs(PROFILE this)
+{
+  return (this == NULL) ? 0 : this->secs;
+}
+
+/**
+ * Starts the clock and the thread that moves the level along;
+ * browsers is what we count hits from.
+ */
+void
+profile_start(PROFILE this, ARRAY browsers)
+{
+  int res;
+
+  if (this == NULL) return;
+
+  this->browsers = browsers;
+  this->start    = __now();
+  if (this->count == 0) return;
+
+  __set(this, __level(this, 0));
+  if ((res = pthread_create(&this->driver, NULL, __driver, this)) != 0) {
+    NOTIFY(FATAL, "profile: failed to create its thread: %d", res);
+  }
+  this->running = TRUE;
+}
+
+/**
+ * Stops the thread and closes out the stages; each one ran
+ * for no longer than it was scheduled to. A run that outlasts
+ * the profile by a second or more gets the rest in the "after"
+ * bucket; less than that is just the run winding down.
+ */
+void
+profile_stop(PROFILE this)
+{
+  int    i;
+  double t;
+
+  if (this == NULL || ! this->running) return;
+
+  pthread_cancel(this->driver);
+  pthread_join(this->driver, NULL);
+  this->running = FALSE;
+
+  t = __now() - this->start;
+  while (t >= this->nsamples + 1) {
+    __sample(this, TRUE);
+  }
+  __sample(this, FALSE);
+  for (i = 0; i < this->count; i++) {
+    STAGE *S = &this->stages[i];
+    S->ran = (t <= S->start) ? 0 : (float)(t - S->start);
+    if (S->ran > S->secs) {
+      S->ran = S->secs;
+    }
+  }
+  this->after.ran = (t <= this->secs) ? 0 : (float)(t - this->secs);
+  if (this->after.ran < 1) {
+    this->stages[this->count-1].hits += this->after.hits;
+    this->after.hits = 0;
+    this->after.ran  = 0;
+  }
+}
+
+/**
+ * Called by a browser before each URL: parks it until the
+ * profile wants this user active. Users count from 0.
+ */
+void
+profile_gate(PROFILE this, int user)
+{
+  if (this == NULL || user < this->active) return;
+
+  pthread_mutex_lock(&this->lock);
+  pthread_cleanup_push(__unlock, &this->lock);
+  while (user >= this->active) {
+    pthread_cond_wait(&this->cond, &this->lock);
+  }
+  pthread_cleanup_pop(1);
+}
+
+void
+profile_set_users(PROFILE this, int users)
+{
+  if (this == NULL) return;
+
+  __set(this, (users > this->users) ? this->users : users);
+}
+
+int
+profile_get_stages(PROFILE this)
+{
+  return (this == NULL) ? 0 : this->count;
+}
+
+/**
+ * A stage's label, the most users it had active, its hits and
+ * how long it ran. Index profile_get_stages() is the time the
+ * run went on after the profile ended.
+ */
+char *
+profile_get_stage(PROFILE this, int index, int *users, unsigned long *hits, float *secs)
+{
+  STAGE *S;
+
+  if (this == NULL || this->count == 0 || index < 0 || index > this->count) return NULL;
+
+  S = __at(this, index);
+  if (users != NULL) *users = S->peak;
+  if (hits  != NULL) *hits  = S->hits;
+  if (secs  != NULL) *secs  = S->ran;
+  return S->label;
+}
+
+int
+profile_get_samples(PROFILE this)
+{
+  return (this == NULL) ? 0 : this->nsamples;
+}
+
+/**
+ * Second index of the run: the users active at the end of it
+ * and its hits. Returns the stage it belongs to.
+ */
+int
+profile_get_sample(PROFILE this, int index, int *users, unsigned long *hits)
+{
+  if (this == NULL || index < 0 || index >= this->nsamples) return -1;
+
+  if (users != NULL) *users = this->samples[index].users;
+  if (hits  != NULL) *hits  = this->samples[index].hits;
+  return this->samples[index].stage;
+}
+
+private BOOLEAN
+__parse(PROFILE this, char *text, int *level)
+{
+  int    n    = 0;
+  int    i;
+  char  *p;
+  char  *tok;
+  char  *save = NULL;
+  char  *argv[8];
+  char   buf[256];
+  STAGE *S    = &this->stages[this->count];
+
+  /**
+   * Make the arrows their own words: "0→2000" and "0->2000"
+   * both become "0 -> 2000"
+   */
+  memset(buf, '\0', sizeof(buf));
+  for (p = text, i = 0; *p && i < (int)sizeof(buf) - 5; p++) {
+    if (strncmp(p, "\xe2\x86\x92", 3) == 0 || strncmp(p, "->", 2) == 0) {
+      p += (*p == '-') ? 1 : 2;
+      memcpy(buf + i, " -> ", 4);
+      i += 4;
+    } else {
+      buf[i++] = *p;
+    }
+  }
+  for (tok = strtok_r(buf, " \t", &save); tok != NULL && n < 8; tok = strtok_r(NULL, " \t", &save)) {
+    argv[n++] = tok;
+  }
+  if (n == 0 || tok != NULL) return FALSE;
+
+  S->from  = *level;
+  S->start = this->secs;
+  if (strmatch(argv[0], "ramp")) {
+    S->type = RAMP;
+    if (n == 6 && (strmatch(argv[2], "->") || strmatch(argv[2], "to")) && strmatch(argv[4], "over")) {
+      S->from = atoi(argv[1]);
+      S->to   = atoi(argv[3]);
+      S->secs = __duration(argv[5]);
+    } else if (n == 5 && (strmatch(argv[1], "->") || strmatch(argv[1], "to")) && strmatch(argv[3], "over")) {
+      S->to   = atoi(argv[2]);
+      S->secs = __duration(argv[4]);
+    } else if (n == 4 && strmatch(argv[2], "over")) {
+      S->to   = atoi(argv[1]);
+      S->secs = __duration(argv[3]);
+    } else {
+      return FALSE;
+    }
+    if (S->from < 0 || S->to < 0 || S->secs < 1) return FALSE;
+    snprintf(S->label, sizeof(S->label), "ramp %d->%d over %s", S->from, S->to, argv[n-1]);
+  } else if (strmatch(argv[0], "hold")) {
+    if (n != 2 || (S->secs = __duration(argv[1])) < 1) return FALSE;
+    S->type = HOLD;
+    S->to   = S->from;
+    snprintf(S->label, sizeof(S->label), "hold %d for %s", S->from, argv[1]);
+  } else if (strmatch(argv[0], "step")) {
+    if (n != 6 || ! strmatch(argv[2], "every") || ! strmatch(argv[4], "until")) return FALSE;
+    S->type  = STEP;
+    S->by    = atoi(argv[1]);
+    S->every = __duration(argv[3]);
+    S->to    = atoi(argv[5]);
+    if (S->by == 0 || S->every < 1 || S->to < 0) return FALSE;
+    if ((S->by > 0 && S->to <= S->from) || (S->by < 0 && S->to >= S->from)) return FALSE;
+    S->secs  = ((abs(S->to - S->from) + abs(S->by) - 1) / abs(S->by)) * S->every;
+    snprintf(S->label, sizeof(S->label), "step %+d every %s until %d", S->by, argv[3], S->to);
+  } else {
+    return FALSE;
+  }
+
+  this->secs += S->secs;
+  *level      = S->to;
+  if (S->from > this->users) this->users = S->from;
+  if (S->to   > this->users) this->users = S->to;
+  return TRUE;
+}
+
+/**
+ * "90", "90s", "5m", "1h30m"; -1 if it's none of those
+ */
+private int
+__duration(const char *str)
+{
+  int         n;
+  int         secs = 0;
+  const char *p    = str;
+
+  while (*p) {
+    if (! isdigit((int)*p)) return -1;
+    for (n = 0; isdigit((int)*p); p++) {
+      n = n * 10 + (*p - '0');
+    }
+    switch (tolower((int)*p)) {
+      case 'h':  secs += n * 3600; p++; break;
+      case 'm':  secs += n * 60;   p++; break;
+      case 's':  secs += n;        p++; break;
+      case '\0': secs += n;        break;
+      default:   return -1;
+    }
+  }
+  return (p == str) ? -1 : secs;
+}
+
+/**
+ * Users the profile wants active t seconds in; after the last
+ * stage we stay where it left us.
+ */
+private int
+__level(PROFILE this, double t)
+{
+  int    i = __stage(this, t);
+  double x;
+  STAGE *S;
+
+  if (i == this->count) {
+    return this->stages[i-1].to;
+  }
+  S = &this->stages[i];
+  x = t - S->start;
+  if (x >= S->secs) {
+    return S->to;
+  }
+  switch (S->type) {
+    case RAMP:
+      return (int)(S->from + (S->to - S->from) * x / S->secs + 0.5);
+    case STEP:
+      i = S->from + S->by * ((int)(x / S->every) + 1);
+      return (S->by > 0) ? ((i > S->to) ? S->to : i) : ((i < S->to) ? S->to : i);
+    default:
+      return S->from;
+  }
+}
+
+/**
+ * The stage t seconds in; count once the profile is over
+ */
+private int
+__stage(PROFILE this, double t)
+{
+  int i;
+
+  for (i = 0; i < this->count; i++) {
+    if (t < this->stages[i].start + this->stages[i].secs) break;
+  }
+  return i;
+}
+
+private STAGE *
+__at(PROFILE this, int index)
+{
+  return (index == this->count) ? &this->after : &this->stages[index];
+}
+
+private void
+__set(PROFILE this, int level)
+{
+  if (level == this->active) return;
+
+  pthread_mutex_lock(&this->lock);
+  this->active = level;
+  pthread_cond_broadcast(&this->cond);
+  pthread_mutex_unlock(&this->lock);
+}
+
+/**
+ * Adds the hits since the last sample to the stage the second
+ * began in; whole seconds also go in the time series.
+ */
+private void
+__sample(PROFILE this, BOOLEAN whole)
+{
+  int           i;
+  int           stage;
+  unsigned long hits = 0;
+  unsigned long diff;
+
+  for (i = 0; i < (int)array_length(this->browsers); i++) {
+    hits += browser_get_hits((BROWSER)array_get(this->browsers, i));
+  }
+  diff       = hits - this->last;
+  this->last = hits;
+  stage      = __stage(this, this->nsamples);
+
+  __at(this, stage)->hits += diff;
+  if (this->active > __at(this, stage)->peak) {
+    __at(this, stage)->peak = this->active;
+  }
+  if (! whole) return;
+
+  if (this->nsamples == this->size) {
+    this->size    = (this->size == 0) ? 64 : this->size * 2;
+    this->samples = xrealloc(this->samples, sizeof(SAMPLE) * this->size);
+  }
+  this->samples[this->nsamples].stage = stage;
+  this->samples[this->nsamples].users = this->active;
+  this->samples[this->nsamples].hits  = diff;
+  this->nsamples++;
+}
+
+/**
+ * Moves the level along ten times a second and samples once
+ * a second. Cancelled by profile_stop.
+ */
+private void *
+__driver(void *arg)
+{
+  double  t;
+  PROFILE this = (PROFILE)arg;
+
+  while (TRUE) {
+    pthread_usleep_np(100000);
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+    t = __now() - this->start;
+    __set(this, __level(this, t));
+    while (t >= this->nsamples + 1) {
+      __sample(this, TRUE);
+    }
+    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+  }
+  return NULL;
+}
+
+private void
+__unlock(void *arg)
+{
+  pthread_mutex_unlock((pthread_mutex_t *)arg);
+}
+
+private double
+__now(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
@@ -0,0 +1,63 @@
+/**
+ * Load profiles
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifndef __PROFILE_H
+#define __PROFILE_H
+
+#include <stdlib.h>
+#include <array.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+/**
+ * --profile="ramp 0->2000 over 5m; hold 10m; step +500 every 2m until 5000"
+ *
+ * A profile is a list of stages that say how many users are
+ * active at each point in the run. We start as many browsers
+ * as the profile ever needs and park the ones it doesn't need
+ * right now; a parked browser keeps its connection and cookies
+ * so it picks up where it left off. Users are numbered across
+ * --procs workers and agents, so each of them parks its share.
+ *
+ * Once a second we sample the hits and tag them with the stage
+ * we're in; that's the time series the summary reports.
+ *
+ * A manual profile has no stages; whoever made it moves the
+ * level with profile_set_users (see search.c).
+ */
+typedef struct PROFILE_T *PROFILE;
+
+PROFILE new_profile(const char *spec);
+PROFILE new_profile_manual(int users);
+PROFILE profile_destroy(PROFILE this);
+int     profile_get_users(PROFILE this);
+int     profile_get_secs(PROFILE this);
+void    profile_start(PROFILE this, ARRAY browsers);
+void    profile_stop(PROFILE this);
+void    profile_gate(PROFILE this, int user);
+void    profile_set_users(PROFILE this, int users);
+int     profile_get_stages(PROFILE this);
+char *  profile_get_stage(PROFILE this, int index, int *users, unsigned long *hits, float *secs);
+int     profile_get_samples(PROFILE this);
+int     profile_get_sample(PROFILE this, int index, int *users, unsigned long *hits);
+
+#endif/*__PROFILE_H*/
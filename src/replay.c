@@ -0,0 +1,510 @@
+/**
+ * Access log replay
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifdef  HAVE_CONFIG_H
+# include <config.h>
+#endif/*HAVE_CONFIG_H*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <setup.h>
+#include <replay.h>
+#include <util.h>
+#include <date.h>
+#include <memory.h>
+#include <notify.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+#ifdef  HAVE_UNISTD_H
+# include <unistd.h>
+#endif/*HAVE_UNISTD_H*/
+
+#define REPLAY_COMBINED 0
+#define REPLAY_JSON     1
+#define REPLAY_LATE     0.010  /* secs behind the log before a request is late */
+
+typedef struct
+{
+  double  when;       /* secs since the epoch */
+  METHOD  method;
+  char    path[4096];
+  char   *body;
+  size_t  len;
+} ENTRY;
+
+struct REPLAY_T
+{
+  int             format;
+  float           speed;
+  char            *map;
+  size_t          size;
+  size_t          pos;        /* where the next line starts */
+  char            target[1024];
+  double          first;      /* the log's time at its first line, < 0 until we read it */
+  double          last;       /* the latest time in the log so far */
+  double          begin;      /* our time at its first line */
+  unsigned long   lines;
+  unsigned long   skipped;
+  unsigned long   sent;
+  unsigned long   late;
+  double          lag;
+  float           highest;
+  pthread_mutex_t lock;
+};
+
+private BOOLEAN __combined(const char *line, const char *end, ENTRY *E);
+private BOOLEAN __json(const char *line, const char *end, ENTRY *E);
+private METHOD  __method(const char *p, size_t len);
+private BOOLEAN __path(ENTRY *E, const char *p, size_t len);
+private const char * __json_value(const char *line, const char *end, const char *key);
+private char *  __json_string(const char *p, const char *end, size_t *len);
+private double  __now();
+
+REPLAY
+new_replay(const char *file, const char *format, float speed, URL target)
+{
+  int         fd;
+  struct stat st;
+  REPLAY      this;
+
+  if (speed <= 0) {
+    NOTIFY(ERROR, "replay: the speed has to be more than 0, ex: --speed=2.0");
+    return NULL;
+  }
+  if (target == NULL || url_get_hostname(target) == NULL) {
+    NOTIFY(ERROR, "replay: it needs a URL to send the log's requests to");
+    return NULL;
+  }
+
+  this = xcalloc(sizeof(struct REPLAY_T), 1);
+  this->speed = speed;
+  this->first = -1.0;
+  if (format == NULL || strmatch((char *)format, "combined") || strmatch((char *)format, "common")) {
+    this->format = REPLAY_COMBINED;
+  } else if (strmatch((char *)format, "json")) {
+    this->format = REPLAY_JSON;
+  } else {
+    NOTIFY(ERROR, "replay: unknown format '%s'; use combined or json", format);
+    return replay_destroy(this);
+  }
+
+  if ((fd = open(file, O_RDONLY)) < 0) {
+    NOTIFY(ERROR, "replay: unable to open %s", file);
+    return replay_destroy(this);
+  }
+  if (fstat(fd, &st) < 0 || st.st_size == 0) {
+    NOTIFY(ERROR, "replay: %s is empty", file);
+    close(fd);
+    return replay_destroy(this);
+  }
+  this->size = (size_t)st.st_size;
+  this->map  = mmap(NULL, this->size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (this->map == MAP_FAILED) {
+    this->map = NULL;
+    NOTIFY(ERROR, "replay: unable to map %s", file);
+    return replay_destroy(this);
+  }
+#ifdef  MADV_SEQUENTIAL
+  madvise(this->map, this->size, MADV_SEQUENTIAL);
+#endif/*MADV_SEQUENTIAL*/
+
+  snprintf(
+    this->target, sizeof(this->target), "%s://%s:%d",
+    url_get_scheme_name(target), url_get_hostname(target), url_get_port(target)
+  );
+  pthread_mutex_init(&this->lock, NULL);
+  return this;
+}
+
+REPLAY
+replay_destroy(REPLAY this)
+{
+  if (this == NULL) return NULL;
+
+  if (this->map != NULL) {
+    munmap(this->map, this->size);
+    pthread_mutex_destroy(&this->lock);
+  }
+  xfree(this);
+  return NULL;
+}
+
+/**
+ * Returns the next request in the log and sets due to when it
+ * should go out, or NULL at the end of the log; the caller
+ * destroys the URL. We only hold the lock to find and read the
+ * line; the clock starts at the first one. A line that's older
+ * than the one before it goes out right after it.
+ */
+URL
+replay_next(REPLAY this, double *due)
+{
+  ENTRY   E;
+  char   *line;
+  char   *end;
+  char   *str;
+  size_t  len;
+  URL     U;
+  BOOLEAN found = FALSE;
+
+  if (this == NULL) return NULL;
+
+  E.body = NULL;
+  pthread_mutex_lock(&this->lock);
+  while (! found && this->pos < this->size) {
+    line = this->map + this->pos;
+    end  = memchr(line, '\n', this->size - this->pos);
+    if (end == NULL) {
+      end = this->map + this->size;
+    }
+    this->pos = (end - this->map) + 1;
+    if (end > line && *(end-1) == '\r') end--;
+    if (end == line) continue;
+
+    this->lines++;
+    found = (this->format == REPLAY_JSON) ? __json(line, end, &E) : __combined(line, end, &E);
+    if (! found) {
+      this->skipped++;
+    }
+  }
+  if (found) {
+    if (this->first < 0) {
+      this->first = this->last = E.when;
+      this->begin = __now();
+    }
+    if (E.when > this->last) {
+      this->last = E.when;
+    }
+    *due = this->begin + (this->last - this->first) / this->speed;
+  }
+  pthread_mutex_unlock(&this->lock);
+  if (! found) return NULL;
+
+  len = strlen(this->target) + strlen(E.path) + 1;
+  str = xmalloc(len);
+  snprintf(str, len, "%s%s", this->target, E.path);
+  U = new_url(str);
+  xfree(str);
+  url_set_method(U, E.method);
+  if (E.body != NULL) {
+    url_set_postdata(U, E.body, E.len);
+    xfree(E.body);
+  }
+  return U;
+}
+
+/**
+ * Sleeps until the request is due; if it's already past due
+ * we were too busy to send it on time. Returns the lag.
+ */
+float
+replay_wait(REPLAY this, double due)
+{
+  double now;
+  float  lag = 0.0;
+
+  if (this == NULL) return 0.0;
+
+  now = __now();
+  if (due > now) {
+    pthread_usleep_np((unsigned long)((due - now) * 1000000));
+  } else {
+    lag = (float)(now - due);
+  }
+  pthread_mutex_lock(&this->lock);
+  this->sent++;
+  this->lag += lag;
+  if (lag > this->highest) {
+    this->highest = lag;
+  }
+  if (lag > REPLAY_LATE) {
+    this->late++;
+  }
+  pthread_mutex_unlock(&this->lock);
+  return lag;
+}
+
+unsigned long
+replay_get_lines(REPLAY this)
+{
+  return (this == NULL) ? 0 : this->lines;
+}
+
+unsigned long
+replay_get_skipped(REPLAY this)
+{
+  return (this == NULL) ? 0 : this->skipped;
+}
+
+unsigned long
+replay_get_late(REPLAY this)
+{
+  return (this == NULL) ? 0 : this->late;
+}
+
+/**
+ * The average lag in secs across every request we sent
+ */
+float
+replay_get_lag(REPLAY this)
+{
+  return (this == NULL || this->sent == 0) ? 0.0 : (float)(this->lag / this->sent);
+}
+
+float
+replay_get_highest(REPLAY this)
+{
+  return (this == NULL) ? 0.0 : this->highest;
+}
+
+/**
+ * host ident user [10/Oct/2000:13:55:36 -0700] "GET /path HTTP/1.1" ...
+ * The common format is the same up to the request, which is
+ * all we use.
+ */
+private BOOLEAN
+__combined(const char *line, const char *end, ENTRY *E)
+{
+  char        buf[64];
+  size_t      len;
+  const char *p;
+  const char *q;
+
+  if ((p = memchr(line, '[', end - line)) == NULL) return FALSE;
+  len = ((size_t)(end - p) < sizeof(buf)) ? (size_t)(end - p) - 1 : sizeof(buf) - 1;
+  memcpy(buf, p+1, len);
+  buf[len] = '\0';
+  if ((E->when = clftotime(buf)) < 0) return FALSE;
+  if ((p = memchr(p, '"', end - p)) == NULL) return FALSE;
+
+  for (q = ++p; q < end && *q != ' ' && *q != '"'; q++) ;
+  if ((E->method = __method(p, q - p)) == NOMETHOD) return FALSE;
+  if (q >= end || *q != ' ') return FALSE;
+
+  for (p = ++q; q < end && *q != ' ' && *q != '"'; q++) ;
+  E->body = NULL;
+  E->len  = 0;
+  return __path(E, p, q - p);
+}
+
+/**
+ * One object per line: "time" (secs since the epoch or ISO 8601)
+ * or "timestamp", "method" (GET if it's missing), "path" or "url"
+ * and an optional "body".
+ */
+private BOOLEAN
+__json(const char *line, const char *end, ENTRY *E)
+{
+  size_t      len;
+  char       *str;
+  char       *tmp;
+  const char *p;
+  BOOLEAN     okay;
+
+  if ((p = __json_value(line, end, "time")) == NULL && (p = __json_value(line, end, "timestamp")) == NULL) {
+    return FALSE;
+  }
+  if (*p == '"') {
+    if ((str = __json_string(p, end, &len)) == NULL) return FALSE;
+    E->when = isototime(str);
+    xfree(str);
+    if (E->when < 0) return FALSE;
+  } else {
+    E->when = strtod(p, &tmp);
+    if (tmp == p) return FALSE;
+  }
+
+  E->method = GET;
+  if ((p = __json_value(line, end, "method")) != NULL && *p == '"') {
+    if ((str = __json_string(p, end, &len)) == NULL) return FALSE;
+    E->method = __method(str, len);
+    xfree(str);
+    if (E->method == NOMETHOD) return FALSE;
+  }
+
+  if ((p = __json_value(line, end, "path")) == NULL && (p = __json_value(line, end, "url")) == NULL) {
+    return FALSE;
+  }
+  if (*p != '"' || (str = __json_string(p, end, &len)) == NULL) return FALSE;
+  okay = __path(E, str, len);
+  xfree(str);
+  if (! okay) return FALSE;
+
+  E->body = NULL;
+  E->len  = 0;
+  if ((p = __json_value(line, end, "body")) != NULL && *p == '"') {
+    E->body = __json_string(p, end, &E->len);
+  }
+  return TRUE;
+}
+
+private METHOD
+__method(const char *p, size_t len)
+{
+  int i;
+  static const struct {
+    const char *name;
+    METHOD      method;
+  } methods[] = {
+    {"GET", GET}, {"HEAD", HEAD}, {"POST", POST}, {"PUT", PUT},
+    {"DELETE", DELETE}, {"OPTIONS", OPTIONS}, {"PATCH", PATCH}
+  };
+
+  for (i = 0; i < (int)(sizeof(methods) / sizeof(methods[0])); i++) {
+    if (strlen(methods[i].name) == len && strncasecmp(p, methods[i].name, len) == 0) {
+      return methods[i].method;
+    }
+  }
+  return NOMETHOD;
+}
+
+/**
+ * A proxy's log has the whole URL; we only want its path
+ */
+private BOOLEAN
+__path(ENTRY *E, const char *p, size_t len)
+{
+  const char *q;
+
+  if (len > 8 && (strncasecmp(p, "http://", 7) == 0 || strncasecmp(p, "https://", 8) == 0)) {
+    q    = (const char *)memchr(p, ':', len) + 3;
+    len -= q - p;
+    p    = q;
+    if ((q = memchr(p, '/', len)) == NULL) {
+      p   = "/";
+      len = 1;
+    } else {
+      len -= q - p;
+      p    = q;
+    }
+  }
+  if (len == 0 || len + 2 > sizeof(E->path)) return FALSE;
+  if (*p != '/') {
+    E->path[0] = '/';
+    memcpy(E->path + 1, p, len);
+    E->path[len + 1] = '\0';
+  } else {
+    memcpy(E->path, p, len);
+    E->path[len] = '\0';
+  }
+  return TRUE;
+}
+
+/**
+ * Points at the value of "key" in a one line JSON object or
+ * returns NULL. It's not a parser; it's enough for a log.
+ */
+private const char *
+__json_value(const char *line, const char *end, const char *key)
+{
+  size_t      len = strlen(key);
+  const char *p   = line;
+
+  while (p < end && (p = memchr(p, '"', end - p)) != NULL) {
+    if ((size_t)(end - p) > len + 1 && strncmp(p+1, key, len) == 0 && p[len+1] == '"') {
+      p += len + 2;
+      while (p < end && (*p == ' ' || *p == '\t')) p++;
+      if (p < end && *p == ':') {
+        for (p++; p < end && (*p == ' ' || *p == '\t'); p++) ;
+        return (p < end) ? p : NULL;
+      }
+    }
+    /* skip this string, escapes and all */
+    for (p++; p < end && *p != '"'; p++) {
+      if (*p == '\\') p++;
+    }
+    p++;
+  }
+  return NULL;
+}
+
+/**
+ * Decodes the JSON string at p; returns an allocated copy and
+ * sets len, or NULL if it doesn't end on this line.
+ */
+private char *
+__json_string(const char *p, const char *end, size_t *len)
+{
+  char        *str;
+  char        *q;
+  unsigned int u;
+
+  str = xmalloc(end - p + 1);
+  for (q = str, p++; p < end && *p != '"'; p++) {
+    if (*p != '\\') {
+      *q++ = *p;
+      continue;
+    }
+    if (++p >= end) break;
+    switch (*p) {
+      case 'b': *q++ = '\b'; break;
+      case 'f': *q++ = '\f'; break;
+      case 'n': *q++ = '\n'; break;
+      case 'r': *q++ = '\r'; break;
+      case 't': *q++ = '\t'; break;
+      case 'u':
+        if (end - p < 5 || sscanf(p+1, "%4x", &u) != 1) {
+          xfree(str);
+          return NULL;
+        }
+        p += 4;
+        if (u < 0x80) {
+          *q++ = (char)u;
+        } else if (u < 0x800) {
+          *q++ = (char)(0xC0 | (u >> 6));
+          *q++ = (char)(0x80 | (u & 0x3F));
+        } else {
+          *q++ = (char)(0xE0 | (u >> 12));
+          *q++ = (char)(0x80 | ((u >> 6) & 0x3F));
+          *q++ = (char)(0x80 | (u & 0x3F));
+        }
+        break;
+      default:  *q++ = *p; break;
+    }
+  }
+  if (p >= end) {
+    xfree(str);
+    return NULL;
+  }
+  *q   = '\0';
+  *len = q - str;
+  return str;
+}
+
+private double
+__now()
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
@@ -0,0 +1,52 @@
+/**
+ * Access log replay
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifndef __REPLAY_H
+#define __REPLAY_H
+
+#include <stdlib.h>
+#include <url.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+/**
+ * Plays an access log back at the target: each line becomes a
+ * request on the URL siege was given (its scheme, host and port,
+ * the line's method, path and body) sent at the line's time from
+ * the start of the log divided by the speed. The log is mapped,
+ * not read, and the browsers take lines from it in order as they
+ * come free; when they can't keep up a request goes out late and
+ * we keep track of by how much.
+ */
+typedef struct REPLAY_T *REPLAY;
+
+REPLAY   new_replay(const char *file, const char *format, float speed, URL target);
+REPLAY   replay_destroy(REPLAY this);
+URL      replay_next(REPLAY this, double *due);
+float    replay_wait(REPLAY this, double due);
+unsigned long replay_get_lines(REPLAY this);
+unsigned long replay_get_skipped(REPLAY this);
+unsigned long replay_get_late(REPLAY this);
+float    replay_get_lag(REPLAY this);
+float    replay_get_highest(REPLAY this);
+
+#endif/*__REPLAY_H*/
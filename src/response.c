@@ -26,6 +26,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <setup.h>
 #include <url.h>
 #include <auth.h>
@@ -63,6 +64,8 @@ struct RESPONSE_T
 size_t RESPONSESIZE = sizeof(struct RESPONSE_T);
 
 private char *  __parse_pair(char **str);
+private char *  __trim(char *str);
+private int     __age_value(RESPONSE this, char *key);
 private char *  __dequote(char *str);
 private int     __int_value(RESPONSE this, char *key, int def); 
 private BOOLEAN __boolean_value(RESPONSE this, char *key, BOOLEAN def);
@@ -458,6 +461,120 @@ response_get_etag(RESPONSE this)
   return (char*)hash_get(this->headers, ETAG);
 }
 
+BOOLEAN
+response_set_expires(RESPONSE this, char *line)
+{
+  if (strncasecmp(line, EXPIRES, strlen(EXPIRES)) == 0 && strlen(line) > 9) {
+    hash_add(this->headers, EXPIRES, (void*)(line+9));
+    return TRUE;
+  }
+  return FALSE;
+}
+
+char *
+response_get_expires(RESPONSE this)
+{
+  return (char*)hash_get(this->headers, EXPIRES);
+}
+
+/**
+ * Cache-Control: public, max-age=3600, s-maxage=86400, immutable
+ * We keep the directives that matter to a browser or an edge
+ * cache and ignore the rest. The directive values land in the
+ * headers hash so the getters work like everything else here.
+ */
+BOOLEAN
+response_set_cache_control(RESPONSE this, char *line)
+{
+  char *tmp;
+  char *tok;
+  char *val;
+  char *last = NULL;
+
+  if (strncasecmp(line, CACHE_CONTROL, strlen(CACHE_CONTROL)) != 0) {
+    return FALSE;
+  }
+  tmp = xstrdup(line+strlen(CACHE_CONTROL)+1);
+  for (tok = strtok_r(tmp, ",", &last); tok != NULL; tok = strtok_r(NULL, ",", &last)) {
+    tok = __trim(tok);
+    if ((val = strchr(tok, '=')) != NULL) {
+      *val++ = '\0';
+      val = __dequote(__trim(val));
+    }
+    if (!strcasecmp(tok, "max-age") && val != NULL) {
+      hash_add(this->headers, CC_MAX_AGE, val);
+    } else if (!strcasecmp(tok, "s-maxage") && val != NULL) {
+      hash_add(this->headers, CC_S_MAXAGE, val);
+    } else if (!strcasecmp(tok, "no-store")) {
+      hash_add(this->headers, CC_NO_STORE, "true");
+    } else if (!strcasecmp(tok, "no-cache") || !strcasecmp(tok, "must-revalidate")) {
+      hash_add(this->headers, CC_NO_CACHE, "true");
+    } else if (!strcasecmp(tok, "immutable")) {
+      hash_add(this->headers, CC_IMMUTABLE, "true");
+    } else if (!strcasecmp(tok, "private")) {
+      hash_add(this->headers, CC_PRIVATE, "true");
+    }
+  }
+  xfree(tmp);
+  return TRUE;
+}
+
+/**
+ * Returns the freshness lifetime in seconds or -1
+ * if the server didn't send the directive
+ */
+int
+response_get_max_age(RESPONSE this)
+{
+  return __age_value(this, CC_MAX_AGE);
+}
+
+int
+response_get_s_maxage(RESPONSE this)
+{
+  return __age_value(this, CC_S_MAXAGE);
+}
+
+BOOLEAN
+response_get_no_store(RESPONSE this)
+{
+  return __boolean_value(this, CC_NO_STORE, FALSE);
+}
+
+BOOLEAN
+response_get_no_cache(RESPONSE this)
+{
+  return __boolean_value(this, CC_NO_CACHE, FALSE);
+}
+
+BOOLEAN
+response_get_immutable(RESPONSE this)
+{
+  return __boolean_value(this, CC_IMMUTABLE, FALSE);
+}
+
+BOOLEAN
+response_get_private(RESPONSE this)
+{
+  return __boolean_value(this, CC_PRIVATE, FALSE);
+}
+
+BOOLEAN
+response_set_vary(RESPONSE this, char *line)
+{
+  if (strncasecmp(line, VARY, strlen(VARY)) == 0 && strlen(line) > 6) {
+    hash_add(this->headers, VARY, (void*)__trim(line+5));
+    return TRUE;
+  }
+  return FALSE;
+}
+
+char *
+response_get_vary(RESPONSE this)
+{
+  return (char*)hash_get(this->headers, VARY);
+}
+
 BOOLEAN
 response_set_www_authenticate(RESPONSE this, char *line)
 {
@@ -593,6 +710,29 @@ __int_value(RESPONSE this, char *key, int def)
   return (num > 0) ? num : def;
 }
 
+private int
+__age_value(RESPONSE this, char *key)
+{
+  char *val = (char *)hash_get(this->headers, key);
+
+  if (val == NULL || !isdigit((int)*val)) {
+    return -1;
+  }
+  return atoi(val);
+}
+
+private char *
+__trim(char *str)
+{
+  char *end;
+
+  while (ISSPACE((int)*str)) str++;
+  end = str + strlen(str);
+  while (end > str && ISSPACE((int)*(end-1))) end--;
+  *end = '\0';
+  return str;
+}
+
 private BOOLEAN
 __boolean_value(RESPONSE this, char *key, BOOLEAN def)
 {
@@ -71,8 +71,20 @@ typedef enum { // content-encoding
 #define RESPONSE_CODE       "response-code"
 #define SET_COOKIE          "set-cookie"
 #define TRANSFER_ENCODING   "transfer-encoding"
+#define VARY                "vary"
 #define WWW_AUTHENTICATE    "www-authenticate"
 
+/**
+ * cache-control directives; we store them in
+ * the headers hash under these keys
+ */
+#define CC_MAX_AGE          "cc-max-age"
+#define CC_S_MAXAGE         "cc-s-maxage"
+#define CC_NO_STORE         "cc-no-store"
+#define CC_NO_CACHE         "cc-no-cache"
+#define CC_IMMUTABLE        "cc-immutable"
+#define CC_PRIVATE          "cc-private"
+
 /**
  * Response object
  */
@@ -122,6 +134,20 @@ char *    response_get_last_modified(RESPONSE this);
 BOOLEAN   response_set_etag(RESPONSE this, char *line);
 char *    response_get_etag(RESPONSE this);
 
+BOOLEAN   response_set_expires(RESPONSE this, char *line);
+char *    response_get_expires(RESPONSE this);
+
+BOOLEAN   response_set_cache_control(RESPONSE this, char *line);
+int       response_get_max_age(RESPONSE this);
+int       response_get_s_maxage(RESPONSE this);
+BOOLEAN   response_get_no_store(RESPONSE this);
+BOOLEAN   response_get_no_cache(RESPONSE this);
+BOOLEAN   response_get_immutable(RESPONSE this);
+BOOLEAN   response_get_private(RESPONSE this);
+
+BOOLEAN   response_set_vary(RESPONSE this, char *line);
+char *    response_get_vary(RESPONSE this);
+
 BOOLEAN   response_set_content_encoding(RESPONSE this, char *line);
 HTTP_CE   response_get_content_encoding(RESPONSE this);
 
@@ -0,0 +1,717 @@
+/**
+ * io_uring socket I/O
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifdef  HAVE_CONFIG_H
+# include <config.h>
+#endif/*HAVE_CONFIG_H*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <ring.h>
+#include <memory.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+#ifdef  HAVE_UNISTD_H
+# include <unistd.h>
+#endif/*HAVE_UNISTD_H*/
+
+#ifdef  HAVE_SYS_SOCKET_H
+# include <sys/socket.h>
+#endif/*HAVE_SYS_SOCKET_H*/
+
+#if defined(HAVE_LINUX_IO_URING_H)
+# include <signal.h>
+# include <sys/mman.h>
+# include <sys/syscall.h>
+# include <linux/io_uring.h>
+#endif/*HAVE_LINUX_IO_URING_H*/
+
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__NR_io_uring_setup) && defined(IORING_FEAT_EXT_ARG)
+# define HAVE_URING 1
+#endif
+
+#ifdef  HAVE_URING
+
+#define RING_BUFS   8     /* provided buffers per thread, power of two */
+#define RING_BUFSZ  4096  /* the same as CONN->buffer                  */
+#define RING_SLICE  1     /* seconds we block before pthread_testcancel */
+
+/**
+ * The low byte of user_data says what kind of request
+ * completed, the rest is a sequence number so we can tell
+ * our completion from a stale one.
+ */
+#define UD_RECV     1     /* multishot receive     */
+#define UD_ONCE     2     /* single recv or send   */
+#define UD_TIMEOUT  3     /* linked timeout        */
+#define UD_CANCEL   4     /* async cancel          */
+#define UD_CLOSE    5     /* close                 */
+
+typedef struct
+{
+  unsigned short bid;
+  unsigned int   len;
+  unsigned int   off;
+} PENDING;
+
+struct RING_T
+{
+  int       fd;
+  void     *sq_ptr;
+  size_t    sq_len;
+  void     *cq_ptr;
+  size_t    cq_len;
+  struct io_uring_sqe *sqes;
+  size_t    sqe_len;
+  unsigned *sq_head;
+  unsigned *sq_tail;
+  unsigned *sq_array;
+  unsigned  sq_mask;
+  unsigned  sq_entries;
+  unsigned  queued;
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned  cq_mask;
+  struct io_uring_cqe *cqes;
+  unsigned long long   seq;
+  /* provided buffers and the multishot receive that fills them */
+  BOOLEAN   multishot;
+  struct io_uring_buf_ring *br;
+  char     *bufs;
+  size_t    br_len;
+  unsigned short br_tail;
+  int       sock;
+  BOOLEAN   armed;
+  BOOLEAN   eof;
+  int       error;
+  unsigned long long armed_ud;
+  PENDING   pending[RING_BUFS];
+  int       head;
+  int       count;
+  /* the single shot request we're waiting on */
+  unsigned long long once_ud;
+  BOOLEAN   done;
+  int       result;
+  unsigned long syscalls;
+};
+
+private BOOLEAN  __map(RING this, struct io_uring_params *p);
+private BOOLEAN  __buffers(RING this);
+private struct io_uring_sqe * __sqe(RING this);
+private unsigned long long    __ud(RING this, int type);
+private int      __enter(RING this, BOOLEAN wait, time_t deadline);
+private void     __reap(RING this);
+private void     __complete(RING this, struct io_uring_cqe *cqe);
+private void     __recycle(RING this, unsigned short bid);
+private void     __arm(RING this);
+private void     __disarm(RING this);
+private ssize_t  __drain(RING this, void *buf, size_t len);
+private ssize_t  __once(RING this, int op, int sock, void *buf, size_t len, int flags, int timeout);
+
+RING
+new_ring(unsigned int entries)
+{
+  RING this;
+  struct io_uring_params p;
+
+  this = xcalloc(sizeof(struct RING_T), 1);
+  this->sock = -1;
+
+  memset(&p, '\0', sizeof(p));
+#ifdef IORING_SETUP_SINGLE_ISSUER
+  p.flags = IORING_SETUP_SINGLE_ISSUER;
+#endif/*IORING_SETUP_SINGLE_ISSUER*/
+  this->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+  if (this->fd < 0 && errno == EINVAL && p.flags != 0) {
+    /* older than 6.0 */
+    memset(&p, '\0', sizeof(p));
+    this->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+  }
+  if (this->fd < 0) {
+    xfree(this);
+    return NULL;
+  }
+  if (!(p.features & IORING_FEAT_EXT_ARG) || __map(this, &p) == FALSE) {
+    /**
+     * Without EXT_ARG we can't put a timeout on a wait;
+     * 5.11 is new enough.
+     */
+    return ring_destroy(this);
+  }
+  this->multishot = __buffers(this);
+  return this;
+}
+
+RING
+ring_destroy(RING this)
+{
+  if (this == NULL) return NULL;
+
+  if (this->fd >= 0) {
+    close(this->fd);
+  }
+  if (this->sqes != NULL) {
+    munmap(this->sqes, this->sqe_len);
+  }
+  if (this->cq_ptr != NULL && this->cq_ptr != this->sq_ptr) {
+    munmap(this->cq_ptr, this->cq_len);
+  }
+  if (this->sq_ptr != NULL) {
+    munmap(this->sq_ptr, this->sq_len);
+  }
+  if (this->br != NULL) {
+    munmap(this->br, this->br_len);
+  }
+  xfree(this);
+  return NULL;
+}
+
+/**
+ * Reads up to len bytes from sock. Returns the number of bytes,
+ * zero at EOF or -1 with errno set; ETIMEDOUT if nothing arrived
+ * within timeout seconds.
+ */
+ssize_t
+ring_recv(RING this, int sock, void *buf, size_t len, int timeout)
+{
+  time_t deadline;
+
+  if (! this->multishot) {
+    return __once(this, IORING_OP_RECV, sock, buf, len, 0, timeout);
+  }
+
+  if (this->sock != sock) {
+    __disarm(this);
+    this->sock  = sock;
+    this->eof   = FALSE;
+    this->error = 0;
+  }
+
+  deadline = time(NULL) + timeout;
+  for (;;) {
+    __reap(this);
+    if (this->count > 0) {
+      return __drain(this, buf, len);
+    }
+    if (this->eof) {
+      return 0;
+    }
+    if (this->error != 0) {
+      errno = this->error;
+      if (errno == EINVAL) {
+        /**
+         * 5.19 has buffer rings but not multishot receive,
+         * so we learn about it on the first try
+         */
+        this->multishot = FALSE;
+        this->error     = 0;
+        this->sock      = -1;
+        return __once(this, IORING_OP_RECV, sock, buf, len, 0, timeout);
+      }
+      return -1;
+    }
+    if (! this->armed) {
+      __arm(this);
+    }
+    if (__enter(this, TRUE, deadline) < 0) {
+      return -1;
+    }
+  }
+}
+
+/**
+ * Writes all of buf to sock. Each send is linked to a timeout
+ * so the pair goes to the kernel in one io_uring_enter
+ */
+ssize_t
+ring_send(RING this, int sock, const void *buf, size_t len, int timeout)
+{
+  size_t  n = len;
+  ssize_t w;
+  const char *ptr = buf;
+
+  while (n > 0) {
+    if ((w = __once(this, IORING_OP_SEND, sock, (void*)ptr, n, MSG_NOSIGNAL, timeout)) <= 0) {
+      if (w == 0) errno = EPIPE;
+      return -1;
+    }
+    n   -= w;
+    ptr += w;
+  }
+  return len;
+}
+
+/**
+ * Closes sock through the ring. If we were receiving on it,
+ * the cancel goes out in the same io_uring_enter as the close.
+ * We don't wait for either; their completions are reaped the
+ * next time through.
+ */
+int
+ring_close(RING this, int sock)
+{
+  struct io_uring_sqe *sqe;
+
+  if (this->sock == sock) {
+    __disarm(this);
+  }
+  sqe = __sqe(this);
+  sqe->opcode    = IORING_OP_CLOSE;
+  sqe->fd        = sock;
+  sqe->user_data = __ud(this, UD_CLOSE);
+  return __enter(this, FALSE, 0);
+}
+
+BOOLEAN
+ring_get_multishot(RING this)
+{
+  return (this == NULL) ? FALSE : this->multishot;
+}
+
+unsigned long
+ring_get_syscalls(RING this)
+{
+  return (this == NULL) ? 0 : this->syscalls;
+}
+
+private BOOLEAN
+__map(RING this, struct io_uring_params *p)
+{
+  this->sq_len  = p->sq_off.array + p->sq_entries * sizeof(unsigned);
+  this->cq_len  = p->cq_off.cqes  + p->cq_entries * sizeof(struct io_uring_cqe);
+  this->sqe_len = p->sq_entries * sizeof(struct io_uring_sqe);
+  if (p->features & IORING_FEAT_SINGLE_MMAP) {
+    if (this->cq_len > this->sq_len) this->sq_len = this->cq_len;
+    this->cq_len = this->sq_len;
+  }
+
+  this->sq_ptr = mmap(NULL, this->sq_len, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, this->fd, IORING_OFF_SQ_RING);
+  if (this->sq_ptr == MAP_FAILED) {
+    this->sq_ptr = NULL;
+    return FALSE;
+  }
+  if (p->features & IORING_FEAT_SINGLE_MMAP) {
+    this->cq_ptr = this->sq_ptr;
+  } else {
+    this->cq_ptr = mmap(NULL, this->cq_len, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, this->fd, IORING_OFF_CQ_RING);
+    if (this->cq_ptr == MAP_FAILED) {
+      this->cq_ptr = NULL;
+      return FALSE;
+    }
+  }
+  this->sqes = mmap(NULL, this->sqe_len, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, this->fd, IORING_OFF_SQES);
+  if (this->sqes == MAP_FAILED) {
+    this->sqes = NULL;
+    return FALSE;
+  }
+
+  this->sq_head    = (unsigned *)((char *)this->sq_ptr + p->sq_off.head);
+  this->sq_tail    = (unsigned *)((char *)this->sq_ptr + p->sq_off.tail);
+  this->sq_mask    = *(unsigned *)((char *)this->sq_ptr + p->sq_off.ring_mask);
+  this->sq_array   = (unsigned *)((char *)this->sq_ptr + p->sq_off.array);
+  this->sq_entries = p->sq_entries;
+  this->cq_head    = (unsigned *)((char *)this->cq_ptr + p->cq_off.head);
+  this->cq_tail    = (unsigned *)((char *)this->cq_ptr + p->cq_off.tail);
+  this->cq_mask    = *(unsigned *)((char *)this->cq_ptr + p->cq_off.ring_mask);
+  this->cqes       = (struct io_uring_cqe *)((char *)this->cq_ptr + p->cq_off.cqes);
+  return TRUE;
+}
+
+/**
+ * Registers a ring of provided buffers (5.19). If the kernel
+ * says no we fall back to one recv per read into the caller's
+ * buffer.
+ */
+private BOOLEAN
+__buffers(RING this)
+{
+#if defined(IORING_RECV_MULTISHOT)
+  int    i;
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  struct io_uring_buf_reg reg;
+
+  this->br_len = page + RING_BUFS * RING_BUFSZ;
+  this->br     = mmap(NULL, this->br_len, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  if (this->br == MAP_FAILED) {
+    this->br = NULL;
+    return FALSE;
+  }
+  this->bufs = (char *)this->br + page;
+
+  memset(&reg, '\0', sizeof(reg));
+  reg.ring_addr    = (unsigned long)this->br;
+  reg.ring_entries = RING_BUFS;
+  reg.bgid         = 0;
+  if (syscall(__NR_io_uring_register, this->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+    munmap(this->br, this->br_len);
+    this->br = NULL;
+    return FALSE;
+  }
+  for (i = 0; i < RING_BUFS; i++) {
+    __recycle(this, i);
+  }
+  return TRUE;
+#else
+  return FALSE;
+#endif
+}
+
+/**
+ * Returns the next free submission entry. Nothing goes to the
+ * kernel until __enter so several requests share a syscall.
+ */
+private struct io_uring_sqe *
+__sqe(RING this)
+{
+  unsigned idx;
+  struct io_uring_sqe *sqe;
+
+  if (*this->sq_tail + this->queued - __atomic_load_n(this->sq_head, __ATOMIC_ACQUIRE) >= this->sq_entries) {
+    __enter(this, FALSE, 0);
+  }
+  idx = (*this->sq_tail + this->queued) & this->sq_mask;
+  this->sq_array[idx] = idx;
+  sqe = &this->sqes[idx];
+  memset(sqe, '\0', sizeof(struct io_uring_sqe));
+  this->queued += 1;
+  return sqe;
+}
+
+private unsigned long long
+__ud(RING this, int type)
+{
+  this->seq += 1;
+  return (this->seq << 8) | type;
+}
+
+/**
+ * Submits whatever is queued and, if wait is TRUE, blocks until
+ * at least one completion arrives or the deadline passes. We
+ * sleep in slices so a pthread_cancel doesn't have to wait for
+ * the socket timeout; io_uring_enter isn't a cancellation point.
+ */
+private int
+__enter(RING this, BOOLEAN wait, time_t deadline)
+{
+  int      res;
+  unsigned flags = 0;
+  unsigned submit;
+  time_t   now;
+  struct __kernel_timespec ts;
+  struct io_uring_getevents_arg arg;
+
+  if (this->queued > 0) {
+    __atomic_store_n(this->sq_tail, *this->sq_tail + this->queued, __ATOMIC_RELEASE);
+    this->queued = 0;
+  }
+
+  memset(&arg, '\0', sizeof(arg));
+  if (wait) {
+    flags    = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+    arg.ts   = (unsigned long)&ts;
+  }
+
+  for (;;) {
+    submit = *this->sq_tail - __atomic_load_n(this->sq_head, __ATOMIC_ACQUIRE);
+    if (! wait && submit == 0) {
+      return 0;
+    }
+    if (wait) {
+      now = time(NULL);
+      if (now >= deadline) {
+        errno = ETIMEDOUT;
+        return -1;
+      }
+      ts.tv_sec  = (deadline - now > RING_SLICE) ? RING_SLICE : deadline - now;
+      ts.tv_nsec = 0;
+    }
+    res = (int)syscall(__NR_io_uring_enter, this->fd, submit, wait ? 1 : 0, flags, &arg, sizeof(arg));
+    this->syscalls += 1;
+    if (res >= 0) {
+      if (wait && *this->cq_head == __atomic_load_n(this->cq_tail, __ATOMIC_ACQUIRE)) {
+        continue; /* submitted but nothing completed yet */
+      }
+      return res;
+    }
+    if (errno == ETIME || errno == EINTR) {
+      pthread_testcancel();
+      continue;
+    }
+    if (errno == EAGAIN || errno == EBUSY) {
+      /* the completion queue is backed up */
+      __reap(this);
+      continue;
+    }
+    return -1;
+  }
+}
+
+private void
+__reap(RING this)
+{
+  unsigned head = *this->cq_head;
+  unsigned tail = __atomic_load_n(this->cq_tail, __ATOMIC_ACQUIRE);
+
+  while (head != tail) {
+    __complete(this, &this->cqes[head & this->cq_mask]);
+    head++;
+  }
+  __atomic_store_n(this->cq_head, head, __ATOMIC_RELEASE);
+}
+
+private void
+__complete(RING this, struct io_uring_cqe *cqe)
+{
+  int     type   = cqe->user_data & 0xff;
+  BOOLEAN buffer = FALSE;
+  unsigned short bid = 0;
+
+#ifdef IORING_CQE_F_BUFFER
+  if (cqe->flags & IORING_CQE_F_BUFFER) {
+    buffer = TRUE;
+    bid    = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+  }
+#endif/*IORING_CQE_F_BUFFER*/
+
+  switch (type) {
+    case UD_RECV:
+      if (cqe->user_data != this->armed_ud) {
+        /* left over from a socket we've since closed */
+        if (buffer) __recycle(this, bid);
+        break;
+      }
+      if (cqe->res > 0 && buffer) {
+        PENDING *P = &this->pending[(this->head + this->count) % RING_BUFS];
+        P->bid = bid;
+        P->len = cqe->res;
+        P->off = 0;
+        this->count += 1;
+      } else {
+        if (buffer) __recycle(this, bid);
+        if (cqe->res == 0) {
+          this->eof = TRUE;
+        } else if (cqe->res != -ENOBUFS) {
+          this->error = -cqe->res;
+        }
+      }
+#ifdef IORING_CQE_F_MORE
+      if (!(cqe->flags & IORING_CQE_F_MORE)) {
+        this->armed = FALSE;
+      }
+#else
+      this->armed = FALSE;
+#endif/*IORING_CQE_F_MORE*/
+      break;
+    case UD_ONCE:
+      if (cqe->user_data == this->once_ud) {
+        this->result = cqe->res;
+        this->done   = TRUE;
+      }
+      break;
+    default:
+      /* timeouts, cancels and closes; we don't care how they went */
+      break;
+  }
+}
+
+private void
+__recycle(RING this, unsigned short bid)
+{
+  struct io_uring_buf *buf;
+
+  buf = &this->br->bufs[this->br_tail & (RING_BUFS - 1)];
+  buf->addr = (unsigned long)(this->bufs + (size_t)bid * RING_BUFSZ);
+  buf->len  = RING_BUFSZ;
+  buf->bid  = bid;
+  this->br_tail += 1;
+  __atomic_store_n(&this->br->tail, this->br_tail, __ATOMIC_RELEASE);
+}
+
+/**
+ * Queues a multishot receive on the current socket. It stays
+ * armed across keep-alive requests until EOF, an error or we
+ * run out of buffers.
+ */
+private void
+__arm(RING this)
+{
+  struct io_uring_sqe *sqe = __sqe(this);
+
+  sqe->opcode    = IORING_OP_RECV;
+  sqe->fd        = this->sock;
+  sqe->ioprio    = IORING_RECV_MULTISHOT;
+  sqe->flags     = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = 0;
+  sqe->user_data = this->armed_ud = __ud(this, UD_RECV);
+  this->armed    = TRUE;
+}
+
+private void
+__disarm(RING this)
+{
+  struct io_uring_sqe *sqe;
+
+  if (this->armed) {
+    sqe = __sqe(this);
+    sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+    sqe->addr      = this->armed_ud;
+    sqe->user_data = __ud(this, UD_CANCEL);
+  }
+  while (this->count > 0) {
+    __recycle(this, this->pending[this->head].bid);
+    this->head   = (this->head + 1) % RING_BUFS;
+    this->count -= 1;
+  }
+  this->armed    = FALSE;
+  this->armed_ud = 0;
+  this->sock     = -1;
+}
+
+private ssize_t
+__drain(RING this, void *buf, size_t len)
+{
+  PENDING *P = &this->pending[this->head];
+  size_t   n = P->len - P->off;
+
+  if (n > len) n = len;
+  memcpy(buf, this->bufs + (size_t)P->bid * RING_BUFSZ + P->off, n);
+  P->off += n;
+  if (P->off == P->len) {
+    __recycle(this, P->bid);
+    this->head   = (this->head + 1) % RING_BUFS;
+    this->count -= 1;
+  }
+  return n;
+}
+
+/**
+ * One recv or send linked to a timeout. Both go in the same
+ * submission; if the timer fires first the kernel cancels the
+ * I/O and we report ETIMEDOUT.
+ */
+private ssize_t
+__once(RING this, int op, int sock, void *buf, size_t len, int flags, int timeout)
+{
+  time_t deadline;
+  struct __kernel_timespec ts;
+  struct io_uring_sqe *sqe;
+
+  ts.tv_sec  = timeout;
+  ts.tv_nsec = 0;
+
+  sqe = __sqe(this);
+  sqe->opcode    = op;
+  sqe->fd        = sock;
+  sqe->addr      = (unsigned long)buf;
+  sqe->len       = len;
+  sqe->msg_flags = flags;
+  sqe->flags     = IOSQE_IO_LINK;
+  sqe->user_data = this->once_ud = __ud(this, UD_ONCE);
+  this->done     = FALSE;
+
+  sqe = __sqe(this);
+  sqe->opcode    = IORING_OP_LINK_TIMEOUT;
+  sqe->addr      = (unsigned long)&ts;
+  sqe->len       = 1;
+  sqe->user_data = __ud(this, UD_TIMEOUT);
+
+  /* the link timeout ends it; the deadline is a backstop */
+  deadline = time(NULL) + timeout + 1;
+  while (! this->done) {
+    if (__enter(this, TRUE, deadline) < 0) {
+      return -1;
+    }
+    __reap(this);
+  }
+  if (this->result == -ECANCELED) {
+    errno = ETIMEDOUT;
+    return -1;
+  }
+  if (this->result < 0) {
+    errno = -this->result;
+    return -1;
+  }
+  return this->result;
+}
+
+#else
+
+/**
+ * No io_uring on this platform; the socket layer falls back
+ */
+RING
+new_ring(unsigned int entries)
+{
+  (void)entries;
+  return NULL;
+}
+
+RING
+ring_destroy(RING this)
+{
+  (void)this;
+  return NULL;
+}
+
+ssize_t
+ring_recv(RING this, int sock, void *buf, size_t len, int timeout)
+{
+  (void)this; (void)sock; (void)buf; (void)len; (void)timeout;
+  errno = ENOSYS;
+  return -1;
+}
+
+ssize_t
+ring_send(RING this, int sock, const void *buf, size_t len, int timeout)
+{
+  (void)this; (void)sock; (void)buf; (void)len; (void)timeout;
+  errno = ENOSYS;
+  return -1;
+}
+
+int
+ring_close(RING this, int sock)
+{
+  (void)this;
+  return close(sock);
+}
+
+BOOLEAN
+ring_get_multishot(RING this)
+{
+  (void)this;
+  return FALSE;
+}
+
+unsigned long
+ring_get_syscalls(RING this)
+{
+  (void)this;
+  return 0;
+}
+
+#endif/*HAVE_URING*/
@@ -0,0 +1,54 @@
+/**
+ * io_uring socket I/O
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifndef __RING_H
+#define __RING_H
+
+#include <stdlib.h>
+#include <sys/types.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+/**
+ * A per-thread io_uring that replaces select(2) + read(2) in
+ * the socket layer. Receives are multishot into a ring of
+ * provided buffers so a response that arrives in pieces costs
+ * one io_uring_enter(2) or less; sends carry a linked timeout.
+ * We talk to the kernel directly so there's no liburing to
+ * link. new_ring returns NULL when the kernel (or a seccomp
+ * filter) won't give us one and the caller falls back.
+ *
+ * A RING belongs to the thread that created it and it follows
+ * one socket at a time; reading a different socket disarms the
+ * previous one.
+ */
+typedef struct RING_T *RING;
+
+RING    new_ring(unsigned int entries);
+RING    ring_destroy(RING this);
+ssize_t ring_recv(RING this, int sock, void *buf, size_t len, int timeout);
+ssize_t ring_send(RING this, int sock, const void *buf, size_t len, int timeout);
+int     ring_close(RING this, int sock);
+BOOLEAN ring_get_multishot(RING this);
+unsigned long ring_get_syscalls(RING this);
+
+#endif/*__RING_H*/
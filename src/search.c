@@ -0,0 +1,423 @@
+/**
+ * Capacity search
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifdef  HAVE_CONFIG_H
+# include <config.h>
+#endif/*HAVE_CONFIG_H*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <setup.h>
+#include <search.h>
+#include <browser.h>
+#include <hist.h>
+#include <util.h>
+#include <perl.h>
+#include <memory.h>
+#include <notify.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+#ifdef  HAVE_UNISTD_H
+# include <unistd.h>
+#endif/*HAVE_UNISTD_H*/
+
+#define MAX_TERMS 8
+
+/**
+ * pNN < secs or errors < percent
+ */
+typedef struct
+{
+  float   pct;
+  float   limit;
+  BOOLEAN equal;
+} TERM;
+
+typedef struct
+{
+  int   users;
+  float rate;
+  float pct[3];
+  float errors;
+  char  missed[64];
+} STEP;
+
+typedef struct
+{
+  double       when;
+  unsigned long hits;
+  unsigned long fail;
+  unsigned int failed;
+  unsigned int hist[HIST_BUCKETS];
+} SNAP;
+
+struct SEARCH_T
+{
+  char *    slo;
+  TERM      terms[MAX_TERMS];
+  int       count;
+  int       users;
+  int       window;
+  int       warmup;
+  int       best;
+  float     rate;
+  STEP *    steps;
+  int       nsteps;
+  int       size;
+  PROFILE   profile;
+  ARRAY     browsers;
+  HIST      hist;
+  SNAP      snap[2];
+  BOOLEAN   running;
+  pthread_t thread;
+};
+
+private BOOLEAN __term(TERM *T, char *str);
+private BOOLEAN __measure(SEARCH this, int users);
+private void    __snap(SEARCH this, SNAP *S);
+private void *  __searcher(void *arg);
+private double  __now(void);
+
+/**
+ * slo is a comma separated list of terms: pNN<TIME, where TIME
+ * is in ms unless it ends in s, and errors<PERCENT. Any number
+ * of them can be given; a window has to meet them all. window
+ * is how long we measure each level, in seconds.
+ */
+SEARCH
+new_search(const char *slo, int users, int window)
+{
+  char  *tmp;
+  char  *tok;
+  char  *save = NULL;
+  SEARCH this;
+
+  if (slo == NULL || *slo == '\0') {
+    NOTIFY(ERROR, "--find-capacity requires --slo, ex: --slo=\"p99<250ms,errors<0.1%%\"");
+    return NULL;
+  }
+
+  this = xcalloc(sizeof(struct SEARCH_T), 1);
+  this->slo    = xstrdup(slo);
+  this->users  = (users < 1) ? 1 : users;
+  this->window = (window < 1) ? 1 : window;
+  this->warmup = (this->window + 1) / 2;
+  this->hist   = new_hist();
+
+  tmp = xstrdup(slo);
+  for (tok = strtok_r(tmp, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save)) {
+    if (this->count == MAX_TERMS || __term(&this->terms[this->count], trim(tok)) == FALSE) {
+      NOTIFY(ERROR, "slo: unable to parse '%s'", tok);
+      xfree(tmp);
+      return search_destroy(this);
+    }
+    this->count++;
+  }
+  xfree(tmp);
+  if (this->count == 0) {
+    NOTIFY(ERROR, "slo: '%s' has no terms", slo);
+    return search_destroy(this);
+  }
+  return this;
+}
+
+SEARCH
+search_destroy(SEARCH this)
+{
+  if (this == NULL) return NULL;
+
+  search_stop(this);
+  this->hist = hist_destroy(this->hist);
+  xfree(this->steps);
+  xfree(this->slo);
+  xfree(this);
+  return NULL;
+}
+
+/**
+ * The longest the search can take: doubling and bisecting are
+ * each log2(users) windows, plus the first and last
+ */
+int
+search_get_secs(SEARCH this)
+{
+  int n = 0;
+
+  if (this == NULL) return 0;
+
+  while ((1 << n) < this->users) n++;
+  return (2 * n + 3) * (this->warmup + this->window) + 1;
+}
+
+void
+search_start(SEARCH this, PROFILE profile, ARRAY browsers)
+{
+  int res;
+
+  if (this == NULL) return;
+
+  this->profile  = profile;
+  this->browsers = browsers;
+  if ((res = pthread_create(&this->thread, NULL, __searcher, this)) != 0) {
+    NOTIFY(FATAL, "search: failed to create its thread: %d", res);
+  }
+  this->running = TRUE;
+}
+
+void
+search_stop(SEARCH this)
+{
+  if (this == NULL || ! this->running) return;
+
+  pthread_cancel(this->thread);
+  pthread_join(this->thread, NULL);
+  this->running = FALSE;
+}
+
+char *
+search_get_slo(SEARCH this)
+{
+  return (this == NULL) ? NULL : this->slo;
+}
+
+/**
+ * The most users that met the SLO; 0 if even one didn't
+ */
+int
+search_get_users(SEARCH this)
+{
+  return (this == NULL) ? 0 : this->best;
+}
+
+float
+search_get_rate(SEARCH this)
+{
+  return (this == NULL) ? 0 : this->rate;
+}
+
+int
+search_get_steps(SEARCH this)
+{
+  return (this == NULL) ? 0 : this->nsteps;
+}
+
+/**
+ * Window index in the order we ran them: its rate, p50, p90
+ * and p99 in seconds, and errors in percent. missed is NULL if
+ * it met the SLO, else the first term it missed. Returns the
+ * users it ran.
+ */
+int
+search_get_step(SEARCH this, int index, float *rate, float *pct, float *errors, char **missed)
+{
+  STEP *S;
+
+  if (this == NULL || index < 0 || index >= this->nsteps) return 0;
+
+  S = &this->steps[index];
+  if (rate   != NULL) *rate   = S->rate;
+  if (errors != NULL) *errors = S->errors;
+  if (missed != NULL) *missed = (S->missed[0] == '\0') ? NULL : S->missed;
+  if (pct    != NULL) memcpy(pct, S->pct, sizeof(S->pct));
+  return S->users;
+}
+
+private BOOLEAN
+__term(TERM *T, char *str)
+{
+  char *p;
+  char *end;
+  float n;
+
+  if ((p = strchr(str, '<')) == NULL) return FALSE;
+  T->equal = (p[1] == '=');
+  n = strtod(p + (T->equal ? 2 : 1), &end);
+  if (end == p + (T->equal ? 2 : 1) || n < 0) return FALSE;
+  end = trim(end);
+  *p  = '\0';
+  str = trim(str);
+
+  if (strmatch(str, "errors")) {
+    if (*end != '\0' && strcmp(end, "%") != 0) return FALSE;
+    T->pct   = -1;
+    T->limit = n;
+    return TRUE;
+  }
+  if ((*str != 'p' && *str != 'P') || (T->pct = strtod(str + 1, &p)) <= 0 || T->pct > 100 || *p != '\0') {
+    return FALSE;
+  }
+  if (*end == '\0' || strmatch(end, "ms")) {
+    T->limit = n / 1000;
+  } else if (strmatch(end, "s")) {
+    T->limit = n;
+  } else {
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/**
+ * Runs one window at users; TRUE if it met the SLO. Cancel is
+ * only enabled while we sleep.
+ */
+private BOOLEAN
+__measure(SEARCH this, int users)
+{
+  int          i;
+  double       secs;
+  float        value;
+  unsigned int diff[HIST_BUCKETS];
+  unsigned long attempts;
+  unsigned long errors;
+  STEP        *S;
+
+  profile_set_users(this->profile, users);
+  pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+  pthread_sleep_np(this->warmup);
+  pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+  __snap(this, &this->snap[0]);
+  pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+  pthread_sleep_np(this->window);
+  pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+  __snap(this, &this->snap[1]);
+
+  for (i = 0; i < HIST_BUCKETS; i++) {
+    diff[i] = this->snap[1].hist[i] - this->snap[0].hist[i];
+  }
+  hist_reset(this->hist);
+  hist_add_buckets(this->hist, diff);
+
+  if (this->nsteps == this->size) {
+    this->size  = (this->size == 0) ? 16 : this->size * 2;
+    this->steps = xrealloc(this->steps, sizeof(STEP) * this->size);
+  }
+  S = &this->steps[this->nsteps];
+  memset(S, '\0', sizeof(STEP));
+  secs     = this->snap[1].when - this->snap[0].when;
+  attempts = (this->snap[1].hits - this->snap[0].hits) + (this->snap[1].failed - this->snap[0].failed);
+  errors   = (this->snap[1].fail - this->snap[0].fail) + (this->snap[1].failed - this->snap[0].failed);
+  S->users  = users;
+  S->rate   = (secs > 0) ? (this->snap[1].hits - this->snap[0].hits) / secs : 0;
+  S->errors = (attempts > 0) ? 100.0 * errors / attempts : 0;
+  S->pct[0] = hist_get_percentile(this->hist, 50);
+  S->pct[1] = hist_get_percentile(this->hist, 90);
+  S->pct[2] = hist_get_percentile(this->hist, 99);
+
+  if (hist_get_count(this->hist) == 0) {
+    snprintf(S->missed, sizeof(S->missed), "no responses");
+  }
+  for (i = 0; i < this->count && S->missed[0] == '\0'; i++) {
+    TERM *T = &this->terms[i];
+    value = (T->pct < 0) ? S->errors : hist_get_percentile(this->hist, T->pct);
+    if ((T->equal) ? value <= T->limit : value < T->limit) {
+      continue;
+    }
+    if (T->pct < 0) {
+      snprintf(S->missed, sizeof(S->missed), "errors %.2f%%", value);
+    } else {
+      snprintf(S->missed, sizeof(S->missed), "p%g %.2f ms", T->pct, value * 1000);
+    }
+  }
+  this->nsteps++;
+
+  if (S->missed[0] == '\0' && users > this->best) {
+    this->best = users;
+    this->rate = S->rate;
+  }
+  return (S->missed[0] == '\0');
+}
+
+/**
+ * What the browsers have done so far; they're busy while we
+ * read so a count may be off by the request in flight
+ */
+private void
+__snap(SEARCH this, SNAP *S)
+{
+  int          i;
+  int          j;
+  unsigned int tmp[HIST_BUCKETS];
+
+  memset(S, '\0', sizeof(SNAP));
+  S->when   = __now();
+  S->failed = my.failed;
+  for (i = 0; i < (int)array_length(this->browsers); i++) {
+    BROWSER B = (BROWSER)array_get(this->browsers, i);
+    S->hits += browser_get_hits(B);
+    S->fail += browser_get_fail(B);
+    hist_get_buckets(browser_get_hist(B), tmp);
+    for (j = 0; j < HIST_BUCKETS; j++) {
+      S->hist[j] += tmp[j];
+    }
+  }
+}
+
+/**
+ * Doubles until a window misses, then bisects down to within
+ * 5% or one user. When it's done it ends the run the way -t
+ * does.
+ */
+private void *
+__searcher(void *arg)
+{
+  int    good  = 0;
+  int    bad   = 0;
+  int    mid;
+  int    level = 1;
+  SEARCH this  = (SEARCH)arg;
+
+  pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+  while (TRUE) {
+    if (__measure(this, level)) {
+      good = level;
+      if (level >= this->users) break;
+      level = (level * 2 > this->users) ? this->users : level * 2;
+    } else {
+      bad = level;
+      break;
+    }
+  }
+  while (bad > 0 && bad - good > ((good / 20 > 1) ? good / 20 : 1)) {
+    mid = (good + bad) / 2;
+    if (__measure(this, mid)) {
+      good = mid;
+    } else {
+      bad  = mid;
+    }
+  }
+  kill(getpid(), SIGTERM);
+  return NULL;
+}
+
+private double
+__now(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
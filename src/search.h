@@ -0,0 +1,55 @@
+/**
+ * Capacity search
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifndef __SEARCH_H
+#define __SEARCH_H
+
+#include <stdlib.h>
+#include <array.h>
+#include <profile.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+/**
+ * --find-capacity --slo="p99<250ms,errors<0.1%"
+ *
+ * Looks for the most users the server can take while it meets
+ * the SLO. We start with one user and double it until a window
+ * misses, then bisect between the last window that met it and
+ * the one that didn't. Each window lets the new level settle for
+ * a warm-up, then measures the rate, percentiles and errors on
+ * what the browsers did in that window alone. -c is the ceiling.
+ */
+typedef struct SEARCH_T *SEARCH;
+
+SEARCH  new_search(const char *slo, int users, int window);
+SEARCH  search_destroy(SEARCH this);
+int     search_get_secs(SEARCH this);
+void    search_start(SEARCH this, PROFILE profile, ARRAY browsers);
+void    search_stop(SEARCH this);
+char *  search_get_slo(SEARCH this);
+int     search_get_users(SEARCH this);
+float   search_get_rate(SEARCH this);
+int     search_get_steps(SEARCH this);
+int     search_get_step(SEARCH this, int index, float *rate, float *pct, float *errors, char **missed);
+
+#endif/*__SEARCH_H*/
@@ -147,11 +147,42 @@ struct CONFIG
   BOOLEAN logging;       /* boolean, log transactions to log file   */
   BOOLEAN shlog;         /* show log file configuration directive.  */
   int     limit;         /* Limits the thread count to int          */
+  int     stack;         /* thread stack in KB, 0 == system default */
+  int     procs;         /* worker processes, --procs               */
+  int     worker;        /* our index if we're a worker, else -1    */
+  BOOLEAN agent;         /* take jobs from a coordinator, --agent   */
+  BOOLEAN coordinator;   /* run the users on agents, --coordinator  */
+  char    *profile;      /* load profile stages, --profile          */
+  int     capacity;      /* search window in secs, --find-capacity  */
+  char    *slo;          /* what the search has to meet, --slo      */
+  char    *history;      /* directory for run records, --history    */
+  char    *compare;      /* a run record to compare to, --compare   */
+  ARRAY   asserts;       /* pass/fail terms, --assert               */
+  int     window;        /* secs a term may fail before we end early*/
+  int     urlstats;      /* top N URLs in the summary, 0 == off     */
+  int     warmup;        /* secs we run before we count, --warmup   */
+  int     cooldown;      /* secs at the end we don't count          */
+  int     stagger;       /* secs to spread the users' starts over   */
+  int     grace;         /* secs a request in flight gets at the end*/
+  char    *replay;       /* access log to play back, --replay       */
+  char    *format;       /* its format, combined or json, --format  */
+  float   speed;         /* how fast we play it back, --speed       */
+  char    *har;          /* page loads to play, --har               */
+  float   zipf;          /* Zipf exponent over the URLs, 0 == off   */
+  char    *scenario;     /* user classes to run, --scenario         */
+  struct {
+    int   cpu;           /* percent of our CPUs, 0 == don't check   */
+    float runq;          /* ms a thread waits to run, 0 == off      */
+    float lag;           /* ms our sampler wakes late, 0 == off     */
+  } saturation;          /* when siege itself is the bottleneck     */
   char    *url;          /* URL for the single hit invocation.      */
   char    logfile[4096]; /* alternative logfile defined in siegerc  */ 
   BOOLEAN verbose;       /* boolean, verbose output to screen       */
+  char    *vfile;        /* verbose output to a file, --verbose-file*/
   BOOLEAN quiet;         /* boolean, turn off all output to screen  */
   BOOLEAN parser;        /* boolean, turn on/off the HTML parser    */
+  int     pcache;        /* max entries in the shared parser cache  */
+  int     pcache_size;   /* max size of the parser cache in MB      */
   BOOLEAN csv;           /* boolean, display verbose output in CSV  */
   BOOLEAN fullurl;       /* boolean, display full url in verbose    */
   BOOLEAN display;       /* boolean, display the thread id verbose  */
@@ -206,6 +237,16 @@ struct CONFIG
   BOOLEAN zero_ok;       /* boolean, TRUE == zero bytes data is OK. */ 
   BOOLEAN spinner;       /* boolean, TRUE == spin, FALSE not so much*/
   BOOLEAN cache;         /* boolean, TRUE == cache revalidate       */
+  int     edge;          /* entries in the shared edge cache, 0=off */
+  struct {
+    BOOLEAN nodelay;     /* TCP_NODELAY, turns off Nagle            */
+    int     sndbuf;      /* SO_SNDBUF bytes, 0 == system default    */
+    int     rcvbuf;      /* SO_RCVBUF bytes, 0 == system default    */
+    BOOLEAN linger;      /* SO_LINGER zero timeout, close with RST  */
+    BOOLEAN quickack;    /* TCP_QUICKACK, no delayed ACKs           */
+    BOOLEAN fastopen;    /* TCP_FASTOPEN_CONNECT                    */
+    char    congestion[16]; /* TCP_CONGESTION algorithm, ie, bbr    */
+  } sockopt;
   char    rc[256];       /* filename of SIEGERC file                */  
   int     ssl_timeout;   /* SSL session timeout                     */
   char    *ssl_cert;     /* PEM certificate file for client auth    */
@@ -31,6 +31,7 @@
 #include <notify.h>
 #include <joedog/boolean.h>
 #include <joedog/defs.h>
+#include <ring.h>
 #include <pthread.h>
 #include <fcntl.h>
 
@@ -53,17 +54,93 @@
 #ifdef  HAVE_NETINET_IN_H
 # include <netinet/in.h>
 #endif/*HAVE_NETINET_IN_H*/
+
+#ifdef  HAVE_NETINET_TCP_H
+# include <netinet/tcp.h>
+#endif/*HAVE_NETINET_TCP_H*/
  
 #ifdef  HAVE_NETDB_H
 # include <netdb.h>
 #endif/*HAVE_NETDB_H*/
 
+#ifdef  HAVE_SYS_EPOLL_H
+# include <sys/epoll.h>
+#endif/*HAVE_SYS_EPOLL_H*/
+
 #ifdef  HAVE_SSL
 # include <openssl/rand.h>
 #endif/*HAVE_SSL*/
 
 #define MAX_PORT_NO 65535
 
+/**
+ * How long we wait on a socket when the timeout is zero;
+ * "timeout" with no value in .siegerc gets the same
+ */
+#define READ_TIMEOUT 15
+
+/**
+ * Tunable socket options; the position in this
+ * list is the option's bit in the masks below
+ */
+private const char *__optnames[] = {
+  "TCP_NODELAY", "SO_SNDBUF", "SO_RCVBUF", "SO_LINGER", 
+  "TCP_QUICKACK", "TCP_FASTOPEN", "TCP_CONGESTION", NULL
+};
+#define O_NODELAY    0
+#define O_SNDBUF     1
+#define O_RCVBUF     2
+#define O_LINGER     3
+#define O_QUICKACK   4
+#define O_FASTOPEN   5
+#define O_CONGESTION 6
+
+private unsigned int  __applied   = 0;
+private unsigned int  __failed    = 0;
+private unsigned long __exhausted = 0;
+
+/**
+ * Local source addresses from --bind; we rotate through
+ * them so each one gets its own ephemeral port range.
+ */
+#define MAX_SOURCES  65536
+typedef struct
+{
+  struct sockaddr_storage addr;
+  socklen_t     len;
+  int           family;
+  char          name[INET6_ADDRSTRLEN];
+  unsigned long conns;
+} SOURCE;
+
+private SOURCE *      __sources  = NULL;
+private int           __nsources = 0;
+private unsigned int  __nextsrc  = 0;
+
+/**
+ * The I/O backend. Each thread gets its own epoll set or ring
+ * the first time it opens a socket; if the kernel won't give
+ * us one we fall back a step and say so once. We count the
+ * system calls each thread makes in here and add them up when
+ * the thread exits.
+ */
+private const char *__backends[] = { "select", "epoll", "uring", NULL };
+
+typedef struct
+{
+  IOBACKEND     backend;
+  int           epfd;
+  RING          ring;
+  unsigned long syscalls;
+} IOCTX;
+
+private IOBACKEND      __backend  = IO_SELECT;
+private unsigned int   __used     = 0;
+private unsigned int   __warned   = 0;
+private unsigned long  __syscalls = 0;
+private pthread_key_t  __iokey;
+private pthread_once_t __ioonce   = PTHREAD_ONCE_INIT;
+
 /** 
  * local prototypes 
  */
@@ -71,8 +148,24 @@ private int     __socket_block(int socket, BOOLEAN block);
 private ssize_t __socket_write(int sock, const void *vbuf, size_t len);  
 private BOOLEAN __socket_check(CONN *C, SDSET mode);
 private BOOLEAN __socket_select(CONN *C, SDSET mode);
+private int     __socket_timeout();
 private int     __socket_create(CONN *C, int domain);
+private void    __socket_options(int sock);
+private void    __socket_option(int sock, int opt, int level, int name, const void *val, socklen_t len);
+private unsigned int __socket_configured();
+private int     __socket_source(int domain);
+private int     __socket_bind(CONN *C, int domain);
+private BOOLEAN __source_add(int family, const void *addr);
 private void   __hostname_strip(char *hn, int len);
+private IOCTX * __io_context();
+private void    __io_init();
+private void    __io_free(void *data);
+private void    __io_tally(int calls);
+private ssize_t __io_read(CONN *C, void *buf, size_t len);
+private ssize_t __io_write(CONN *C, const void *buf, size_t len);
+#ifdef  HAVE_SYS_EPOLL_H
+private BOOLEAN __epoll_wait(IOCTX *ctx, CONN *C, unsigned int events);
+#endif/*HAVE_SYS_EPOLL_H*/
 #ifdef  HAVE_POLL
 private BOOLEAN __socket_poll(CONN *C, SDSET mode);
 #endif/*HAVE_POLL*/
@@ -155,6 +248,7 @@ new_socket(CONN *C, const char *hostparam, int portparam)
 
     res = getaddrinfo(hn, port_str, &hints, &addr_res);
     if (res != 0) {
+      socket_fault(C, FAULT_DNS);
       NOTIFY(ERROR, "Address resolution failed at %s:%d with the following error:", __FILE__, __LINE__);
       NOTIFY(ERROR, "%s: %s", gai_strerror(res), hn);
       return -1;
@@ -197,6 +291,7 @@ new_socket(CONN *C, const char *hostparam, int portparam)
    * from the name server. Let's notify the user and bail
    */
   if (hp == NULL) {
+    socket_fault(C, FAULT_DNS);
     switch(herrno) {
       case HOST_NOT_FOUND: { NOTIFY(ERROR, "Host not found: %s\n", hostparam);                           break; }
       case NO_ADDRESS:     { NOTIFY(ERROR, "Host does not have an IP address: %s\n", hostparam);         break; }
@@ -232,6 +327,7 @@ new_socket(CONN *C, const char *hostparam, int portparam)
    * readability/writeability of the socket....
    */ 
   conn = connect(C->sock, s_addr, addrlen);
+  __io_tally(1);
   pthread_testcancel();
 #if defined(HAVE_GETADDRINFO)
   /**
@@ -250,6 +346,7 @@ new_socket(CONN *C, const char *hostparam, int portparam)
       }
 
       conn = connect(C->sock, s_addr, addrlen);
+      __io_tally(1);
       pthread_testcancel();
       if (conn == 0) {
         break;
@@ -258,9 +355,13 @@ new_socket(CONN *C, const char *hostparam, int portparam)
   }
 #endif
   if (conn < 0 && errno != EINPROGRESS) {
+    socket_fault(C, fault_from_errno(errno));
     switch (errno) {
       case EACCES:        {NOTIFY(ERROR, "socket: %d EACCES",                  pthread_self()); break;}
-      case EADDRNOTAVAIL: {NOTIFY(ERROR, "socket: %d address is unavailable.", pthread_self()); break;}
+      case EADDRNOTAVAIL: {
+        __sync_add_and_fetch(&__exhausted, 1);
+        NOTIFY(ERROR, "socket: %d address is unavailable.", pthread_self()); break;
+      }
       case ETIMEDOUT:     {NOTIFY(ERROR, "socket: %d connection timed out.",   pthread_self()); break;}
       case ECONNREFUSED:  {NOTIFY(ERROR, "socket: %d connection refused.",     pthread_self()); break;}
       case ENETUNREACH:   {NOTIFY(ERROR, "socket: %d network is unreachable.", pthread_self()); break;}
@@ -270,7 +371,7 @@ new_socket(CONN *C, const char *hostparam, int portparam)
   } else {
     if (__socket_check(C, READ) == FALSE) {
       pthread_testcancel();
-      NOTIFY(WARNING, "socket: read check timed out(%d) %s:%d", my.timeout, __FILE__, __LINE__);
+      NOTIFY(WARNING, "socket: read check timed out(%d) %s:%d", __socket_timeout(), __FILE__, __LINE__);
       socket_close(C);
       return -1; 
     } else { 
@@ -278,7 +379,9 @@ new_socket(CONN *C, const char *hostparam, int portparam)
        * If we reconnect and receive EISCONN, then we have a successful connection
        */
       res = connect(C->sock, s_addr, addrlen);
+      __io_tally(1);
       if((res < 0)&&(errno != EISCONN)){
+        socket_fault(C, fault_from_errno(errno));
         NOTIFY(ERROR, "socket: unable to connect %s:%d", __FILE__, __LINE__);
         socket_close(C);
         return -1; 
@@ -287,11 +390,29 @@ new_socket(CONN *C, const char *hostparam, int portparam)
     }
   } /* end of connect conditional */
 
-  if ((__socket_block(C->sock, TRUE)) < 0) {
+#if defined(TCP_QUICKACK)
+  if (my.sockopt.quickack) {
+    /**
+     * The kernel may fall back into delayed ACKs
+     * so we set it again once we're connected
+     */
+    int opt = 1;
+    __socket_option(C->sock, O_QUICKACK, IPPROTO_TCP, TCP_QUICKACK, &opt, sizeof(opt));
+  }
+#endif/*TCP_QUICKACK*/
+
+  /**
+   * epoll and io_uring never block on the descriptor itself
+   * so we save ourselves the fcntl round trips.
+   */
+  if (C->io.backend == IO_SELECT && (__socket_block(C->sock, TRUE)) < 0) {
     NOTIFY(ERROR, "socket: unable to set socket to non-blocking %s:%d", __FILE__, __LINE__);
     return -1; 
   }
 
+  if (C->source >= 0) {
+    __sync_add_and_fetch(&__sources[C->source].conns, 1);
+  }
   C->connection.status = 1; 
   return(C->sock);
 }
@@ -320,17 +441,24 @@ private BOOLEAN
 __socket_poll(CONN *C, SDSET mode)
 {
   int res;
-  int timo = (my.timeout) ? my.timeout * 1000 : 15000;
+  int timo = __socket_timeout() * 1000;
   __socket_block(C->sock, FALSE);
 
-  C->pfd[0].fd     = C->sock + 1;
-  C->pfd[0].events |= POLLIN;
+  /**
+   * We land here once descriptors pass FD_SETSIZE, i.e., when
+   * the preflight raised RLIMIT_NOFILE for a large run.
+   */
+  C->pfd[0].fd      = C->sock;
+  C->pfd[0].events  = 0;
+  C->pfd[0].revents = 0;
+  if (mode & READ)  C->pfd[0].events |= POLLIN;
+  if (mode & WRITE) C->pfd[0].events |= POLLOUT;
 
   do {
+    __io_tally(1);
     res = poll(C->pfd, 1, timo);
     pthread_testcancel();
-    if (res < 0) puts("LESS THAN ZERO!");
-  } while (res < 0); // && errno == EINTR);
+  } while (res < 0 && errno == EINTR);
 
   if (res == 0) {
     errno = ETIMEDOUT;
@@ -338,9 +466,10 @@ __socket_poll(CONN *C, SDSET mode)
  
   if (res <= 0) {
     C->state = UNDEF;
+    socket_fault(C, fault_from_errno(errno));
     NOTIFY(WARNING, 
       "socket: polled(%d) and discovered it's not ready %s:%d", 
-      (my.timeout)?my.timeout:15, __FILE__, __LINE__
+      __socket_timeout(), __FILE__, __LINE__
     );
     return FALSE;
   } else {
@@ -358,7 +487,7 @@ __socket_select(CONN *C, SDSET mode)
   fd_set rs;
   fd_set ws;
   memset((void *)&timeout, '\0', sizeof(struct timeval));
-  timeout.tv_sec  = (my.timeout > 0)?my.timeout:30;
+  timeout.tv_sec  = __socket_timeout();
   timeout.tv_usec = 0;
 
   if ((C->sock < 0) || (C->sock >= FD_SETSIZE)) {
@@ -371,6 +500,7 @@ __socket_select(CONN *C, SDSET mode)
     FD_ZERO(&ws);
     FD_SET(C->sock, &rs);
     FD_SET(C->sock, &ws);
+    __io_tally(1);
     res = select(C->sock+1, &rs, &ws, NULL, &timeout);
     pthread_testcancel();
   } while (res < 0 && errno == EINTR);
@@ -381,6 +511,7 @@ __socket_select(CONN *C, SDSET mode)
 
   if (res <= 0) {
     C->state = UNDEF;
+    socket_fault(C, fault_from_errno(errno));
     NOTIFY(WARNING, "socket: select and discovered it's not ready %s:%d", __FILE__, __LINE__);
     return FALSE;
   } else {
@@ -389,6 +520,15 @@ __socket_select(CONN *C, SDSET mode)
   }
 }
 
+/**
+ * Seconds we wait for a socket to become ready
+ */
+private int
+__socket_timeout()
+{
+  return (my.timeout > 0) ? my.timeout : READ_TIMEOUT;
+}
+
 /**
  * Create new socket and set socket options.
  * Handle possible error codes.
@@ -397,6 +537,7 @@ private int
 __socket_create(CONN *C, int domain)
 {
   if ((C->sock = socket(domain, SOCK_STREAM, 0)) < 0) {
+    socket_fault(C, fault_from_errno(errno));
     switch (errno) {
       case EPROTONOSUPPORT: { NOTIFY(ERROR, "unsupported protocol %s:%d",  __FILE__, __LINE__); break; }
       case EMFILE:          { NOTIFY(ERROR, "descriptor table full %s:%d", __FILE__, __LINE__); break; }
@@ -406,12 +547,17 @@ __socket_create(CONN *C, int domain)
       default:              { NOTIFY(ERROR, "unknown socket error %s:%d",  __FILE__, __LINE__); break; }
     } socket_close(C); return -1;
   }
+  __io_tally(2);
+  C->io.backend = (C->scheme == HTTP) ? __io_context()->backend : IO_SELECT;
+  C->io.events  = 0;
+  C->io.ready   = FALSE;
   if (fcntl(C->sock, F_SETFD, O_NDELAY) < 0) {
     NOTIFY(ERROR, "unable to set close control %s:%d", __FILE__, __LINE__);
   }
 
   if (C->connection.keepalive) {
     int opt = 1;
+    __io_tally(1);
     if (setsockopt(C->sock,SOL_SOCKET,SO_KEEPALIVE,(char *)&opt,sizeof(opt))<0) {
       switch (errno) {
         case EBADF:       { NOTIFY(ERROR, "invalid descriptor %s:%d",    __FILE__, __LINE__); break; }
@@ -423,6 +569,13 @@ __socket_create(CONN *C, int domain)
     }
   }
 
+  __socket_options(C->sock);
+
+  if (__socket_bind(C, domain) < 0) {
+    socket_close(C);
+    return -1;
+  }
+
   if ((__socket_block(C->sock, FALSE)) < 0) {
     NOTIFY(ERROR, "socket: unable to set socket to non-blocking %s:%d", __FILE__, __LINE__);
     return -1;
@@ -431,6 +584,349 @@ __socket_create(CONN *C, int domain)
   return 0;
 }
 
+/**
+ * Applies the options from siege.conf or --sockopt to a new
+ * socket. Failures aren't fatal; we warn once per option and
+ * report what stuck at the end of the run.
+ */
+private void
+__socket_options(int sock)
+{
+  int opt = 1;
+
+  if (my.sockopt.nodelay) {
+#if defined(TCP_NODELAY)
+    __socket_option(sock, O_NODELAY, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+#else
+    __socket_option(sock, O_NODELAY, IPPROTO_TCP, -1, &opt, sizeof(opt));
+#endif/*TCP_NODELAY*/
+  }
+  if (my.sockopt.sndbuf > 0) {
+    __socket_option(sock, O_SNDBUF, SOL_SOCKET, SO_SNDBUF, &my.sockopt.sndbuf, sizeof(int));
+  }
+  if (my.sockopt.rcvbuf > 0) {
+    __socket_option(sock, O_RCVBUF, SOL_SOCKET, SO_RCVBUF, &my.sockopt.rcvbuf, sizeof(int));
+  }
+  if (my.sockopt.linger) {
+    struct linger lng;
+    lng.l_onoff  = 1;
+    lng.l_linger = 0;
+    __socket_option(sock, O_LINGER, SOL_SOCKET, SO_LINGER, &lng, sizeof(lng));
+  }
+  if (my.sockopt.quickack) {
+#if defined(TCP_QUICKACK)
+    __socket_option(sock, O_QUICKACK, IPPROTO_TCP, TCP_QUICKACK, &opt, sizeof(opt));
+#else
+    __socket_option(sock, O_QUICKACK, IPPROTO_TCP, -1, &opt, sizeof(opt));
+#endif/*TCP_QUICKACK*/
+  }
+  if (my.sockopt.fastopen) {
+#if defined(TCP_FASTOPEN_CONNECT)
+    __socket_option(sock, O_FASTOPEN, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, &opt, sizeof(opt));
+#else
+    __socket_option(sock, O_FASTOPEN, IPPROTO_TCP, -1, &opt, sizeof(opt));
+#endif/*TCP_FASTOPEN_CONNECT*/
+  }
+  if (strlen(my.sockopt.congestion) > 0) {
+#if defined(TCP_CONGESTION)
+    __socket_option(
+      sock, O_CONGESTION, IPPROTO_TCP, TCP_CONGESTION, my.sockopt.congestion, strlen(my.sockopt.congestion)
+    );
+#else
+    __socket_option(sock, O_CONGESTION, IPPROTO_TCP, -1, my.sockopt.congestion, 0);
+#endif/*TCP_CONGESTION*/
+  }
+}
+
+/**
+ * name is -1 if the platform doesn't have the option
+ */
+private void
+__socket_option(int sock, int opt, int level, int name, const void *val, socklen_t len)
+{
+  unsigned int bit = 1 << opt;
+
+  if (name >= 0) __io_tally(1);
+  if (name >= 0 && setsockopt(sock, level, name, val, len) == 0) {
+    __sync_fetch_and_or(&__applied, bit);
+    return;
+  }
+  if ((__sync_fetch_and_or(&__failed, bit) & bit) == 0) {
+    NOTIFY(
+      WARNING, "socket: unable to set %s: %s", __optnames[opt], 
+      (name < 0) ? "not supported on this platform" : strerror(errno)
+    );
+  }
+}
+
+private unsigned int
+__socket_configured()
+{
+  unsigned int mask = 0;
+
+  if (my.sockopt.nodelay)  mask |= 1 << O_NODELAY;
+  if (my.sockopt.sndbuf)   mask |= 1 << O_SNDBUF;
+  if (my.sockopt.rcvbuf)   mask |= 1 << O_RCVBUF;
+  if (my.sockopt.linger)   mask |= 1 << O_LINGER;
+  if (my.sockopt.quickack) mask |= 1 << O_QUICKACK;
+  if (my.sockopt.fastopen) mask |= 1 << O_FASTOPEN;
+  if (strlen(my.sockopt.congestion) > 0) mask |= 1 << O_CONGESTION;
+  return mask;
+}
+
+/**
+ * Parses a comma separated list of socket options into the
+ * config, ie, "nodelay, sndbuf=65536, linger, congestion=bbr"
+ * Sizes take an optional K or M suffix.
+ */
+BOOLEAN
+socket_set_options(const char *spec)
+{
+  char   *tmp;
+  char   *tok;
+  char   *val;
+  char   *end;
+  char   *last = NULL;
+  BOOLEAN res  = TRUE;
+  BOOLEAN on;
+
+  if (spec == NULL) return FALSE;
+
+  tmp = xstrdup(spec);
+  for (tok = strtok_r(tmp, ", ", &last); tok != NULL; tok = strtok_r(NULL, ", ", &last)) {
+    if ((val = strchr(tok, '=')) != NULL) {
+      *val++ = '\0';
+    }
+    on = (val == NULL || strncasecmp(val, "false", 5)) ? TRUE : FALSE;
+    if (strmatch(tok, "nodelay")) {
+      my.sockopt.nodelay  = on;
+    } else if (strmatch(tok, "linger")) {
+      my.sockopt.linger   = on;
+    } else if (strmatch(tok, "quickack")) {
+      my.sockopt.quickack = on;
+    } else if (strmatch(tok, "fastopen")) {
+      my.sockopt.fastopen = on;
+    } else if ((strmatch(tok, "sndbuf") || strmatch(tok, "rcvbuf")) && val != NULL) {
+      long num = strtol(val, &end, 10);
+      if (*end == 'k' || *end == 'K') num *= 1024;
+      if (*end == 'm' || *end == 'M') num *= 1024 * 1024;
+      if (strmatch(tok, "sndbuf")) {
+        my.sockopt.sndbuf = (num > 0) ? (int)num : 0;
+      } else {
+        my.sockopt.rcvbuf = (num > 0) ? (int)num : 0;
+      }
+    } else if (strmatch(tok, "congestion") && val != NULL) {
+      xstrncpy(my.sockopt.congestion, val, sizeof(my.sockopt.congestion));
+    } else {
+      NOTIFY(ERROR, "unknown socket option: %s", tok);
+      res = FALSE;
+    }
+  }
+  xfree(tmp);
+  return res;
+}
+
+/**
+ * Writes the names of the configured, applied or failed 
+ * options into buf; returns NULL if there aren't any.
+ */
+char *
+socket_get_options(char *buf, size_t len, SOCKOPT set)
+{
+  int          i;
+  unsigned int mask;
+
+  switch (set) {
+    case SOCKOPT_APPLIED: mask = __applied;             break;
+    case SOCKOPT_FAILED:  mask = __failed;              break;
+    default:              mask = __socket_configured(); break;
+  }
+  if (mask == 0 || buf == NULL || len < 1) {
+    return NULL;
+  }
+
+  memset(buf, '\0', len);
+  for (i = 0; __optnames[i] != NULL; i++) {
+    if (mask & (1 << i)) {
+      if (strlen(buf) > 0) strncat(buf, " ", len - strlen(buf) - 1);
+      strncat(buf, __optnames[i], len - strlen(buf) - 1);
+    }
+  }
+  return buf;
+}
+
+/**
+ * Binds C to the next source address in the pool. We let the
+ * kernel pick the port at connect time (IP_BIND_ADDRESS_NO_PORT)
+ * otherwise bind would reserve a port without knowing the peer
+ * and we'd run out at the same rate we do now.
+ */
+private int
+__socket_bind(CONN *C, int domain)
+{
+  int opt = 1;
+
+  C->source = __socket_source(domain);
+  if (C->source < 0) {
+    return 0;
+  }
+
+  __io_tally(2);
+#if defined(IP_BIND_ADDRESS_NO_PORT)
+  if (setsockopt(C->sock, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &opt, sizeof(opt)) < 0) {
+    NOTIFY(DEBUG, "socket: IP_BIND_ADDRESS_NO_PORT: %s", strerror(errno));
+  }
+#else
+  (void)opt;
+#endif/*IP_BIND_ADDRESS_NO_PORT*/
+
+  if (bind(C->sock, (struct sockaddr *)&__sources[C->source].addr, __sources[C->source].len) < 0) {
+    socket_fault(C, fault_from_errno(errno));
+    if (errno == EADDRNOTAVAIL || errno == EADDRINUSE) {
+      __sync_add_and_fetch(&__exhausted, 1);
+    }
+    NOTIFY(ERROR, "socket: unable to bind to %s: %s", __sources[C->source].name, strerror(errno));
+    C->source = -1;
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * Round robin over the pool; returns -1 if there's
+ * no source address for this address family.
+ */
+private int
+__socket_source(int domain)
+{
+  int i;
+  int n;
+
+  for (n = 0; n < __nsources; n++) {
+    i = (int)(__sync_fetch_and_add(&__nextsrc, 1) % (unsigned int)__nsources);
+    if (__sources[i].family == domain) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+private BOOLEAN
+__source_add(int family, const void *addr)
+{
+  SOURCE *S;
+
+  if (__nsources >= MAX_SOURCES) {
+    return FALSE;
+  }
+  __sources = xrealloc(__sources, (__nsources + 1) * sizeof(SOURCE));
+  S = &__sources[__nsources];
+  memset(S, '\0', sizeof(SOURCE));
+  S->family = family;
+  if (family == AF_INET6) {
+    struct sockaddr_in6 *sa = (struct sockaddr_in6 *)&S->addr;
+    sa->sin6_family = AF_INET6;
+    memcpy(&sa->sin6_addr, addr, sizeof(struct in6_addr));
+    S->len = sizeof(struct sockaddr_in6);
+  } else {
+    struct sockaddr_in  *sa = (struct sockaddr_in *)&S->addr;
+    sa->sin_family  = AF_INET;
+    memcpy(&sa->sin_addr, addr, sizeof(struct in_addr));
+    S->len = sizeof(struct sockaddr_in);
+  }
+  inet_ntop(family, addr, S->name, sizeof(S->name));
+  __nsources++;
+  return TRUE;
+}
+
+/**
+ * Adds a comma separated list of local addresses to the bind
+ * pool. IPv4 entries may be CIDR blocks, ie, 127.0.0.0/24; we 
+ * skip the network and broadcast addresses of blocks wider than
+ * a /31. IPv6 addresses are taken one at a time.
+ */
+BOOLEAN
+socket_set_sources(const char *spec)
+{
+  char   *tmp;
+  char   *tok;
+  char   *pfx;
+  char   *last = NULL;
+  BOOLEAN res  = TRUE;
+  struct in_addr  in4;
+  struct in6_addr in6;
+
+  if (spec == NULL) return FALSE;
+
+  tmp = xstrdup(spec);
+  for (tok = strtok_r(tmp, ", ", &last); tok != NULL; tok = strtok_r(NULL, ", ", &last)) {
+    if ((pfx = strchr(tok, '/')) != NULL) {
+      *pfx++ = '\0';
+    }
+    if (inet_pton(AF_INET, tok, &in4) == 1) {
+      int bits = (pfx == NULL) ? 32 : atoi(pfx);
+      unsigned long first, last4, ip;
+      if (bits < 1 || bits > 32) {
+        NOTIFY(ERROR, "invalid bind prefix: %s/%s", tok, pfx);
+        res = FALSE;
+        continue;
+      }
+      first = ntohl(in4.s_addr) & (bits == 32 ? 0xFFFFFFFFUL : (0xFFFFFFFFUL << (32 - bits)) & 0xFFFFFFFFUL);
+      last4 = first | ((bits == 32) ? 0 : (0xFFFFFFFFUL >> bits));
+      if (bits < 31) {
+        first += 1;
+        last4 -= 1;
+      }
+      for (ip = first; ip <= last4; ip++) {
+        in4.s_addr = htonl((uint32_t)ip);
+        if (__source_add(AF_INET, &in4) == FALSE) {
+          NOTIFY(WARNING, "bind pool is limited to %d addresses", MAX_SOURCES);
+          break;
+        }
+      }
+    } else if (inet_pton(AF_INET6, tok, &in6) == 1 && (pfx == NULL || atoi(pfx) == 128)) {
+      __source_add(AF_INET6, &in6);
+    } else {
+      NOTIFY(ERROR, "invalid bind address: %s", tok);
+      res = FALSE;
+    }
+  }
+  xfree(tmp);
+  return res;
+}
+
+int
+socket_get_sources()
+{
+  return __nsources;
+}
+
+/**
+ * Returns the address at index and the number of
+ * connections made from it in conns
+ */
+char *
+socket_get_source(int index, unsigned long *conns)
+{
+  if (index < 0 || index >= __nsources) {
+    return NULL;
+  }
+  if (conns != NULL) {
+    *conns = __sources[index].conns;
+  }
+  return __sources[index].name;
+}
+
+/**
+ * The number of connects that failed with EADDRNOTAVAIL;
+ * we ran out of local ports.
+ */
+unsigned long
+socket_get_exhausted()
+{
+  return __exhausted;
+}
+
 /**
  * remove square bracket
  * around IPv6 addresses
@@ -473,6 +969,7 @@ __socket_block(int sock, BOOLEAN block)
   }
 
 #if HAVE_FCNTL_H 
+  __io_tally(2);
   if ((flags = fcntl(sock, F_GETFL, 0)) < 0) {
     switch (errno) {
       case EACCES: { NOTIFY(ERROR, "EACCES %s:%d",                 __FILE__, __LINE__); break; }
@@ -518,6 +1015,7 @@ __socket_write(int sock, const void *vbuf, size_t len)
   buf = vbuf;
   n   = len;
   while (n > 0) {
+    __io_tally(1);
     if ((w = write( sock, buf, n)) <= 0) {
       if (errno == EINTR) {
         w = 0;
@@ -559,12 +1057,15 @@ __ssl_socket_write(CONN *C, const void *vbuf, size_t len)
 			NOTIFY(DEBUG, "SSL_write non-critical error %d", err);
           return 0;
         case SSL_ERROR_SYSCALL:
+          socket_fault(C, FAULT_TLS);
           NOTIFY(ERROR, "SSL_write() failed (syscall)");
           return -1;
         case SSL_ERROR_SSL:
+          socket_fault(C, FAULT_TLS);
           return -1;
         }
       }
+      socket_fault(C, FAULT_TLS);
       NOTIFY(ERROR, "SSL_write() failed.");
       return -1;
     }
@@ -575,32 +1076,36 @@ __ssl_socket_write(CONN *C, const void *vbuf, size_t len)
 }
 #endif/*HAVE_SSL*/
 
+/**
+ * The browsers are cancel deferred from the start and read,
+ * poll and select are cancel points; the hot path doesn't
+ * need to set the type or test for a cancel itself.
+ */
 ssize_t
 socket_read(CONN *C, void *vbuf, size_t len)
 {
-  int type;
   size_t      n;
   ssize_t     r;
   char *buf;
   int ret_eof = 0;
  
-  pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, &type);
- 
   buf = vbuf;
   n   = len;
   if (C->encrypt == TRUE) {
   #ifdef HAVE_SSL
     while (n > 0) {
       if (__socket_check(C, READ) == FALSE) {
-        NOTIFY(WARNING, "socket: read check timed out(%d) %s:%d", (my.timeout)?my.timeout:15, __FILE__, __LINE__);
+        NOTIFY(WARNING, "socket: read check timed out(%d) %s:%d", __socket_timeout(), __FILE__, __LINE__);
 	return -1;
       }
 	  r = SSL_read(C->ssl, buf, n);
       if (r < 0) {
-        if (errno == EINTR || SSL_get_error(C->ssl, r) == SSL_ERROR_WANT_READ)
+        if (errno == EINTR || SSL_get_error(C->ssl, r) == SSL_ERROR_WANT_READ) {
           r = 0;
-        else
+        } else {
+          socket_fault(C, FAULT_TLS);
           return -1;
+        }
       }
       else if (r == 0) break;
       n   -= r;
@@ -609,9 +1114,9 @@ socket_read(CONN *C, void *vbuf, size_t len)
   #endif/*HAVE_SSL*/
   } else { 
     while (n > 0) {
-      if (C->inbuffer < len) {
+      if (C->inbuffer < len && C->io.backend == IO_SELECT) {
         if (__socket_check(C, READ) == FALSE) {
-          NOTIFY(WARNING, "socket: read check timed out(%d) %s:%d", (my.timeout)?my.timeout:15, __FILE__, __LINE__);
+          NOTIFY(WARNING, "socket: read check timed out(%d) %s:%d", __socket_timeout(), __FILE__, __LINE__);
           return -1;
         }
       }
@@ -619,19 +1124,31 @@ socket_read(CONN *C, void *vbuf, size_t len)
         int lidos;
         memmove(C->buffer,&C->buffer[C->pos_ini],C->inbuffer);
         C->pos_ini = 0;
-	if (__socket_check(C, READ) == FALSE) {
-          NOTIFY(WARNING, "socket: read check timed out(%d) %s:%d", (my.timeout)?my.timeout:15, __FILE__, __LINE__);
-	  return -1;
-	}
-        lidos = read(C->sock, &C->buffer[C->inbuffer], sizeof(C->buffer)-C->inbuffer);
+        if (C->io.backend == IO_SELECT) {
+          if (__socket_check(C, READ) == FALSE) {
+            NOTIFY(WARNING, "socket: read check timed out(%d) %s:%d", __socket_timeout(), __FILE__, __LINE__);
+            return -1;
+          }
+          __io_tally(1);
+          lidos = read(C->sock, &C->buffer[C->inbuffer], sizeof(C->buffer)-C->inbuffer);
+        } else {
+          lidos = __io_read(C, &C->buffer[C->inbuffer], sizeof(C->buffer)-C->inbuffer);
+          if (lidos < 0 && errno == ETIMEDOUT) {
+            socket_fault(C, FAULT_TIMEOUT);
+            NOTIFY(WARNING, "socket: read check timed out(%d) %s:%d", __socket_timeout(), __FILE__, __LINE__);
+            return -1;
+          }
+        }
         if (lidos == 0)
           ret_eof = 1;
         if (lidos < 0) {
           if (errno==EINTR || errno==EAGAIN)
             lidos = 0;
           if (errno==EPIPE){
+            socket_fault(C, FAULT_RESET);
             return 0;
           } else {
+            socket_fault(C, fault_from_errno(errno));
             NOTIFY(ERROR, "socket: read error %s %s:%d", strerror(errno), __FILE__, __LINE__);
             return 0; /* was return -1 */
           }
@@ -653,8 +1170,6 @@ socket_read(CONN *C, void *vbuf, size_t len)
     } /* end of while */
   }   /* end of else  */
  
-  pthread_setcanceltype(type,NULL);
-  pthread_testcancel();
   return (len - n);
 }                                                                                                    
 /**
@@ -665,12 +1180,10 @@ socket_read(CONN *C, void *vbuf, size_t len)
 ssize_t
 socket_readline(CONN *C, char *ptr, size_t maxlen)
 {
-  int type;
   int n, len, res;
   char c;
 
   len = maxlen;
-  pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, &type); 
 
   for (n = 1; n < len; n ++) {
     if ((res = socket_read(C, &c, 1)) == 1) {
@@ -689,9 +1202,6 @@ socket_readline(CONN *C, char *ptr, size_t maxlen)
 
   *ptr=0;
   
-  pthread_setcanceltype(type,NULL);
-  pthread_testcancel(); 
-
   return n;
 }
 
@@ -702,11 +1212,8 @@ socket_readline(CONN *C, char *ptr, size_t maxlen)
 int
 socket_write(CONN *C, const void *buf, size_t len)
 {
-  int     type;
   size_t bytes;
 
-  pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, &type); 
-
   if (C->encrypt == TRUE) {
     /* handle HTTPS protocol */
     #ifdef HAVE_SSL
@@ -729,18 +1236,34 @@ socket_write(CONN *C, const void *buf, size_t len)
     #endif/*HAVE_SSL*/
   } else {
     /* assume HTTP */
-    if ((bytes = __socket_write(C->sock, buf, len)) != len) {
+    if (C->io.backend == IO_SELECT) {
+      bytes = __socket_write(C->sock, buf, len);
+    } else {
+      bytes = __io_write(C, buf, len);
+    }
+    if (bytes != len) {
+      socket_fault(C, fault_from_errno(errno));
       NOTIFY(ERROR, "unable to write to socket %s:%d", __FILE__, __LINE__);
       return -1;
     }
   }
 
-  pthread_setcanceltype(type,NULL); 
-  pthread_testcancel(); 
-
   return bytes;
 } 
 
+/**
+ * Marks why C failed; the first cause sticks since whatever
+ * follows it is usually a consequence. The browser clears it
+ * before each request.
+ */
+void
+socket_fault(CONN *C, FAULT fault)
+{
+  if (C != NULL && C->fault == FAULT_NONE) {
+    C->fault = fault;
+  }
+}
+
 /**
  * returns void
  * frees ssl resources if using ssl and
@@ -791,11 +1314,20 @@ socket_close(CONN *C)
   } else {
     if (C->connection.reuse == 0 || C->connection.max == 1) {
       if (C->sock != -1) {
-        if ((__socket_block(C->sock, FALSE)) < 0)
+        if (C->io.backend == IO_SELECT && (__socket_block(C->sock, FALSE)) < 0)
           NOTIFY(ERROR, "unable to set to non-blocking %s:%d", __FILE__, __LINE__);
-        if ((C->connection.status > 1)&&(ret = shutdown(C->sock, 2)) < 0)
-          NOTIFY(ERROR, "unable to shutdown the socket %s:%d", __FILE__, __LINE__);
-        if ((ret = close(C->sock)) < 0)
+        if (C->connection.status > 1) {
+          __io_tally(1);
+          if ((ret = shutdown(C->sock, 2)) < 0)
+            NOTIFY(ERROR, "unable to shutdown the socket %s:%d", __FILE__, __LINE__);
+        }
+        if (C->io.backend == IO_URING) {
+          ret = ring_close(__io_context()->ring, C->sock);
+        } else {
+          __io_tally(1);
+          ret = close(C->sock);
+        }
+        if (ret < 0)
           NOTIFY(ERROR, "unable to close the socket %s:%d",    __FILE__, __LINE__);
       }
       C->sock                 = -1;
@@ -811,4 +1343,254 @@ socket_close(CONN *C)
   return;
 } 
 
+/**
+ * Selects the I/O backend by name: select, epoll or uring.
+ * Threads pick it up when they open their first socket so
+ * this has to happen before the browsers start.
+ */
+BOOLEAN
+socket_set_backend(const char *name)
+{
+  int i;
+
+  for (i = 0; __backends[i] != NULL; i++) {
+    if (strmatch(name, __backends[i])) {
+      __backend = (IOBACKEND)i;
+      return TRUE;
+    }
+  }
+  NOTIFY(ERROR, "socket: unknown I/O backend '%s'; try select, epoll or uring", name);
+  return FALSE;
+}
 
+/**
+ * Returns the backend the threads actually got; if any of
+ * them had to fall back, that's what we report.
+ */
+char *
+socket_get_backend()
+{
+  int i;
+
+  for (i = 0; __backends[i] != NULL; i++) {
+    if (__used & (1 << i)) {
+      return (char *)__backends[i];
+    }
+  }
+  return (char *)__backends[__backend];
+}
+
+/**
+ * The system calls made by the socket layer. Threads add
+ * theirs when they exit so call this after the crew is gone.
+ */
+unsigned long
+socket_get_syscalls()
+{
+  return __syscalls;
+}
+
+void
+socket_get_stats(SOCKSTATS *stats)
+{
+  if (stats == NULL) return;
+
+  stats->applied   = __applied;
+  stats->failed    = __failed;
+  stats->used      = __used;
+  stats->exhausted = __exhausted;
+  stats->syscalls  = __syscalls;
+}
+
+void
+socket_add_stats(const SOCKSTATS *stats)
+{
+  if (stats == NULL) return;
+
+  __sync_fetch_and_or(&__applied, stats->applied);
+  __sync_fetch_and_or(&__failed,  stats->failed);
+  __sync_fetch_and_or(&__used,    stats->used);
+  __sync_add_and_fetch(&__exhausted, stats->exhausted);
+  __sync_add_and_fetch(&__syscalls,  stats->syscalls);
+}
+
+void
+socket_add_conns(int index, unsigned long conns)
+{
+  if (index < 0 || index >= __nsources) {
+    return;
+  }
+  __sync_add_and_fetch(&__sources[index].conns, conns);
+}
+
+private void
+__io_init()
+{
+  pthread_key_create(&__iokey, __io_free);
+}
+
+private IOCTX *
+__io_context()
+{
+  IOCTX *ctx;
+
+  pthread_once(&__ioonce, __io_init);
+  if ((ctx = pthread_getspecific(__iokey)) != NULL) {
+    return ctx;
+  }
+
+  ctx = xcalloc(sizeof(IOCTX), 1);
+  ctx->epfd    = -1;
+  ctx->backend = __backend;
+  if (ctx->backend == IO_URING && (ctx->ring = new_ring(64)) == NULL) {
+    if ((__sync_fetch_and_or(&__warned, 1 << IO_URING) & (1 << IO_URING)) == 0) {
+      NOTIFY(WARNING, "socket: io_uring is unavailable (%s); using epoll", strerror(errno));
+    }
+    ctx->backend = IO_EPOLL;
+  }
+  if (ctx->backend == IO_EPOLL) {
+#ifdef  HAVE_SYS_EPOLL_H
+    ctx->epfd = epoll_create1(EPOLL_CLOEXEC);
+#endif/*HAVE_SYS_EPOLL_H*/
+    if (ctx->epfd < 0) {
+      if ((__sync_fetch_and_or(&__warned, 1 << IO_EPOLL) & (1 << IO_EPOLL)) == 0) {
+        NOTIFY(WARNING, "socket: epoll is unavailable; using select");
+      }
+      ctx->backend = IO_SELECT;
+    }
+  }
+  __sync_fetch_and_or(&__used, 1 << ctx->backend);
+  pthread_setspecific(__iokey, ctx);
+  return ctx;
+}
+
+private void
+__io_free(void *data)
+{
+  IOCTX *ctx = (IOCTX *)data;
+
+  __sync_add_and_fetch(&__syscalls, ctx->syscalls + ring_get_syscalls(ctx->ring));
+  ctx->ring = ring_destroy(ctx->ring);
+  if (ctx->epfd >= 0) {
+    close(ctx->epfd);
+  }
+  xfree(ctx);
+}
+
+private void
+__io_tally(int calls)
+{
+  __io_context()->syscalls += calls;
+}
+
+/**
+ * Reads what's available for C. With epoll we only wait when
+ * the last read drained the socket; if it filled our buffer
+ * there's probably more and we go straight to recv.
+ */
+private ssize_t
+__io_read(CONN *C, void *buf, size_t len)
+{
+  IOCTX  *ctx  = __io_context();
+  int     timo = __socket_timeout();
+  ssize_t r;
+
+  if (C->io.backend == IO_URING) {
+    return ring_recv(ctx->ring, C->sock, buf, len, timo);
+  }
+
+#ifdef  HAVE_SYS_EPOLL_H
+  for (;;) {
+    if (! C->io.ready && __epoll_wait(ctx, C, EPOLLIN) == FALSE) {
+      return -1;
+    }
+    ctx->syscalls += 1;
+    if ((r = recv(C->sock, buf, len, MSG_DONTWAIT)) >= 0) {
+      C->io.ready = ((size_t)r == len) ? TRUE : FALSE;
+      return r;
+    }
+    C->io.ready = FALSE;
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+      return -1;
+    }
+  }
+#else
+  (void)r;
+  errno = ENOSYS;
+  return -1;
+#endif/*HAVE_SYS_EPOLL_H*/
+}
+
+private ssize_t
+__io_write(CONN *C, const void *buf, size_t len)
+{
+  IOCTX  *ctx  = __io_context();
+  int     timo = __socket_timeout();
+  size_t  n    = len;
+  ssize_t w;
+  const char *ptr = buf;
+
+  if (C->io.backend == IO_URING) {
+    return ring_send(ctx->ring, C->sock, buf, len, timo);
+  }
+
+#ifdef  HAVE_SYS_EPOLL_H
+  while (n > 0) {
+    ctx->syscalls += 1;
+    if ((w = send(C->sock, ptr, n, MSG_DONTWAIT|MSG_NOSIGNAL)) < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        if (__epoll_wait(ctx, C, EPOLLIN|EPOLLOUT) == FALSE) {
+          return -1;
+        }
+      } else if (errno != EINTR) {
+        return -1;
+      }
+      continue;
+    }
+    n   -= w;
+    ptr += w;
+  }
+  return len;
+#else
+  (void)timo; (void)n; (void)w; (void)ptr;
+  errno = ENOSYS;
+  return -1;
+#endif/*HAVE_SYS_EPOLL_H*/
+}
+
+#ifdef  HAVE_SYS_EPOLL_H
+/**
+ * The set is edge triggered and we only register once per
+ * connection; we add EPOLLOUT the first time a send backs up
+ * and leave it there.
+ */
+private BOOLEAN
+__epoll_wait(IOCTX *ctx, CONN *C, unsigned int events)
+{
+  int    res;
+  int    timo = __socket_timeout() * 1000;
+  struct epoll_event ev;
+
+  if ((C->io.events & events) != events) {
+    memset(&ev, '\0', sizeof(ev));
+    ev.events  = C->io.events | events | EPOLLRDHUP | EPOLLET;
+    ev.data.fd = C->sock;
+    ctx->syscalls += 1;
+    if (epoll_ctl(ctx->epfd, (C->io.events == 0) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, C->sock, &ev) < 0) {
+      NOTIFY(ERROR, "socket: unable to watch descriptor: %s", strerror(errno));
+      return FALSE;
+    }
+    C->io.events |= events;
+  }
+
+  do {
+    ctx->syscalls += 1;
+    res = epoll_wait(ctx->epfd, &ev, 1, timo);
+  } while (res < 0 && errno == EINTR);
+
+  if (res == 0) {
+    errno = ETIMEDOUT;
+  }
+  return (res > 0) ? TRUE : FALSE;
+}
+#endif/*HAVE_SYS_EPOLL_H*/
@@ -54,6 +54,7 @@
 #include <auth.h>
 #include <page.h>
 #include <cache.h>
+#include <fault.h>
 #include <joedog/boolean.h>
 
 typedef enum
@@ -72,6 +73,20 @@ typedef enum
   RDWR  = 3
 } SDSET;  
 
+typedef enum
+{
+  SOCKOPT_CONFIGURED = 0,
+  SOCKOPT_APPLIED    = 1,
+  SOCKOPT_FAILED     = 2
+} SOCKOPT;
+
+typedef enum
+{
+  IO_SELECT = 0,       /* select(2) or poll(2) then read(2) */
+  IO_EPOLL  = 1,       /* a per-thread epoll set            */
+  IO_URING  = 2        /* a per-thread io_uring, see ring.c */
+} IOBACKEND;
+
 typedef struct
 {
   int      sock;       /* socket file descriptor          */
@@ -122,6 +137,13 @@ typedef struct
   fd_set   *ws;
   fd_set   *rs;
   SDSET    state;  
+  int      source;     /* index in the bind pool or -1    */
+  FAULT    fault;      /* what first went wrong, if any   */
+  struct {
+    IOBACKEND backend; /* how we wait on this socket      */
+    unsigned  events;  /* what the epoll set watches      */
+    BOOLEAN   ready;   /* last read filled our buffer     */
+  } io;
   struct {
     int      code; 
     char     host[64]; /* FTP data host */
@@ -131,12 +153,40 @@ typedef struct
   } ftp;
 } CONN; 
 
+/**
+ * What the socket layer counted in this process; a worker
+ * process ships it to its parent which adds it to its own
+ * (see proc.c). Connections per source are handled apart
+ * since the pool can be large.
+ */
+typedef struct
+{
+  unsigned int  applied;
+  unsigned int  failed;
+  unsigned int  used;
+  unsigned long exhausted;
+  unsigned long syscalls;
+} SOCKSTATS;
+
 int       new_socket     (CONN *conn, const char *hostname, int port);
 BOOLEAN   socket_check   (CONN *C, SDSET test);
 int       socket_write   (CONN *conn, const void *b, size_t n);
 ssize_t   socket_read    (CONN *conn, void *buf, size_t len); 
 ssize_t   socket_readline(CONN *C, char *ptr, size_t maxlen);  
 void      socket_close   (CONN *C);
+void      socket_fault   (CONN *C, FAULT fault);
+BOOLEAN   socket_set_options(const char *spec);
+char *    socket_get_options(char *buf, size_t len, SOCKOPT set);
+unsigned long socket_get_exhausted();
+BOOLEAN   socket_set_sources(const char *spec);
+int       socket_get_sources();
+char *    socket_get_source(int index, unsigned long *conns);
+BOOLEAN   socket_set_backend(const char *name);
+char *    socket_get_backend();
+unsigned long socket_get_syscalls();
+void      socket_get_stats(SOCKSTATS *stats);
+void      socket_add_stats(const SOCKSTATS *stats);
+void      socket_add_conns(int index, unsigned long conns);
 
 #endif /* SOCK_H */
 
@@ -149,6 +149,7 @@ SSL_initialize(CONN *C, const char *servername)
   SSL_set_fd(C->ssl, C->sock);
   serr = SSL_connect(C->ssl);
   if (serr != 1) {
+    socket_fault(C, FAULT_TLS);
     SSL_error_stack();
     NOTIFY(ERROR, "Failed to make an SSL connection: %d", SSL_get_error(C->ssl, serr));
     return FALSE;
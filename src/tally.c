@@ -0,0 +1,225 @@
+/**
+ * Mergeable run totals
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifdef  HAVE_CONFIG_H
+# include <config.h>
+#endif/*HAVE_CONFIG_H*/
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setup.h>
+#include <tally.h>
+#include <memory.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+private void   __put(char **buf, size_t *len, size_t *size, const char *fmt, ...);
+
+/**
+ * Copies what this process has counted into T
+ */
+void
+tally_collect(TALLY *this, DATA data, PCACHE pcache, EDGE edge)
+{
+  this->count     = data_get_count(data);
+  this->code      = data_get_code(data);
+  this->okay      = data_get_okay(data);
+  this->fail      = data_get_fail(data);
+  this->cached    = data_get_cached(data);
+  this->aborted   = data_get_aborted(data);
+  this->failed    = my.failed;
+  this->bytes     = data_get_bytes(data);
+  this->total     = data_get_total(data);
+  this->highest   = data_get_highest(data);
+  this->lowest    = (data_get_code(data) > 0) ? data_get_lowest(data) : -1;
+  this->pcache[0] = pcache_get_hits(pcache);
+  this->pcache[1] = pcache_get_misses(pcache);
+  this->pcache[2] = pcache_get_evictions(pcache);
+  this->edge[0]   = edge_get_hits(edge);
+  this->edge[1]   = edge_get_misses(edge);
+  this->edge[2]   = edge_get_evictions(edge);
+  this->edged     = edge_get_bytes(edge);
+  socket_get_stats(&this->sock);
+  monitor_get_stats(&this->mon);
+  fault_get_counts(this->faults);
+  hist_get_buckets(data_get_hist(data), this->hist);
+}
+
+/**
+ * Adds T to what this process has counted
+ */
+void
+tally_merge(TALLY *this, DATA data, PCACHE pcache, EDGE edge)
+{
+  data_increment_count  (data, this->count);
+  data_increment_bytes  (data, this->bytes);
+  data_increment_total  (data, this->total);
+  data_increment_code   (data, this->code);
+  data_increment_okay   (data, this->okay);
+  data_increment_fail   (data, this->fail);
+  data_increment_cached (data, this->cached);
+  data_increment_aborted(data, this->aborted);
+  data_set_highest      (data, this->highest);
+  data_set_lowest       (data, this->lowest);
+  hist_add_buckets(data_get_hist(data), this->hist);
+  my.failed += this->failed;
+
+  pcache_add_stats(pcache, this->pcache[0], this->pcache[1], this->pcache[2]);
+  edge_add_stats(edge, this->edge[0], this->edge[1], this->edge[2], this->edged);
+  socket_add_stats(&this->sock);
+  monitor_add_stats(&this->mon);
+  fault_add_counts(this->faults);
+}
+
+/**
+ * One "key values" line per field; floats keep all their
+ * digits and the histogram only lists the buckets it uses
+ * as index:count pairs. Returns an allocated string.
+ */
+char *
+tally_encode(TALLY *this)
+{
+  int    i;
+  char * buf  = NULL;
+  size_t len  = 0;
+  size_t size = 0;
+
+  __put(&buf, &len, &size, "count %u\n",   this->count);
+  __put(&buf, &len, &size, "code %u\n",    this->code);
+  __put(&buf, &len, &size, "okay %u\n",    this->okay);
+  __put(&buf, &len, &size, "fail %u\n",    this->fail);
+  __put(&buf, &len, &size, "cached %u\n",  this->cached);
+  __put(&buf, &len, &size, "aborted %u\n", this->aborted);
+  __put(&buf, &len, &size, "failed %u\n",  this->failed);
+  __put(&buf, &len, &size, "bytes %llu\n", this->bytes);
+  __put(&buf, &len, &size, "total %.9g\n", this->total);
+  __put(&buf, &len, &size, "highest %.9g\n", this->highest);
+  __put(&buf, &len, &size, "lowest %.9g\n",  this->lowest);
+  __put(&buf, &len, &size, "pcache %lu %lu %lu\n", this->pcache[0], this->pcache[1], this->pcache[2]);
+  __put(&buf, &len, &size, "edge %lu %lu %lu %llu\n", this->edge[0], this->edge[1], this->edge[2], this->edged);
+  __put(&buf, &len, &size, "sock %u %u %u %lu %lu\n",
+    this->sock.applied, this->sock.failed, this->sock.used, this->sock.exhausted, this->sock.syscalls
+  );
+  __put(&buf, &len, &size, "mon %lu %lu %lu %lu %lu %lu %lu %u %u %u %u %u %u\n",
+    this->mon.cpu, this->mon.wall, this->mon.delay, this->mon.slices, this->mon.lag, this->mon.rss,
+    this->mon.fds, this->mon.cpus, this->mon.peak, this->mon.hot, this->mon.seconds,
+    this->mon.saturated, this->mon.reasons
+  );
+  __put(&buf, &len, &size, "faults");
+  for (i = 0; i < FAULTS; i++) {
+    __put(&buf, &len, &size, " %lu", this->faults[i]);
+  }
+  __put(&buf, &len, &size, "\n");
+  __put(&buf, &len, &size, "hist");
+  for (i = 0; i < HIST_BUCKETS; i++) {
+    if (this->hist[i] > 0) {
+      __put(&buf, &len, &size, " %d:%u", i, this->hist[i]);
+    }
+  }
+  __put(&buf, &len, &size, "\n");
+  return buf;
+}
+
+/**
+ * Reads one line of tally_encode's output into T. Returns
+ * FALSE if it doesn't know the key or can't read the values.
+ */
+BOOLEAN
+tally_decode(TALLY *this, const char *line)
+{
+  int          n;
+  int          i;
+  unsigned int c;
+  const char * p;
+
+  if (strncmp(line, "count ", 6) == 0)
+    return sscanf(line+6, "%u", &this->count) == 1;
+  if (strncmp(line, "code ", 5) == 0)
+    return sscanf(line+5, "%u", &this->code) == 1;
+  if (strncmp(line, "okay ", 5) == 0)
+    return sscanf(line+5, "%u", &this->okay) == 1;
+  if (strncmp(line, "fail ", 5) == 0)
+    return sscanf(line+5, "%u", &this->fail) == 1;
+  if (strncmp(line, "cached ", 7) == 0)
+    return sscanf(line+7, "%u", &this->cached) == 1;
+  if (strncmp(line, "aborted ", 8) == 0)
+    return sscanf(line+8, "%u", &this->aborted) == 1;
+  if (strncmp(line, "failed ", 7) == 0)
+    return sscanf(line+7, "%u", &this->failed) == 1;
+  if (strncmp(line, "bytes ", 6) == 0)
+    return sscanf(line+6, "%llu", &this->bytes) == 1;
+  if (strncmp(line, "total ", 6) == 0)
+    return sscanf(line+6, "%f", &this->total) == 1;
+  if (strncmp(line, "highest ", 8) == 0)
+    return sscanf(line+8, "%f", &this->highest) == 1;
+  if (strncmp(line, "lowest ", 7) == 0)
+    return sscanf(line+7, "%f", &this->lowest) == 1;
+  if (strncmp(line, "pcache ", 7) == 0)
+    return sscanf(line+7, "%lu %lu %lu", &this->pcache[0], &this->pcache[1], &this->pcache[2]) == 3;
+  if (strncmp(line, "edge ", 5) == 0)
+    return sscanf(line+5, "%lu %lu %lu %llu", &this->edge[0], &this->edge[1], &this->edge[2], &this->edged) == 4;
+  if (strncmp(line, "sock ", 5) == 0)
+    return sscanf(line+5, "%u %u %u %lu %lu",
+      &this->sock.applied, &this->sock.failed, &this->sock.used, &this->sock.exhausted, &this->sock.syscalls
+    ) == 5;
+  if (strncmp(line, "mon ", 4) == 0)
+    return sscanf(line+4, "%lu %lu %lu %lu %lu %lu %lu %u %u %u %u %u %u",
+      &this->mon.cpu, &this->mon.wall, &this->mon.delay, &this->mon.slices, &this->mon.lag, &this->mon.rss,
+      &this->mon.fds, &this->mon.cpus, &this->mon.peak, &this->mon.hot, &this->mon.seconds,
+      &this->mon.saturated, &this->mon.reasons
+    ) == 13;
+  if (strncmp(line, "faults", 6) == 0) {
+    memset(this->faults, '\0', sizeof(this->faults));
+    for (i = 0, p = line+6; i < FAULTS && sscanf(p, " %lu%n", &this->faults[i], &n) == 1; i++, p += n) ;
+    return TRUE;
+  }
+  if (strncmp(line, "hist", 4) == 0) {
+    memset(this->hist, '\0', sizeof(this->hist));
+    for (p = line+4; sscanf(p, " %d:%u%n", &i, &c, &n) == 2; p += n) {
+      if (i < 0 || i >= HIST_BUCKETS) return FALSE;
+      this->hist[i] = c;
+    }
+    return TRUE;
+  }
+  return FALSE;
+}
+
+private void
+__put(char **buf, size_t *len, size_t *size, const char *fmt, ...)
+{
+  int     n;
+  va_list ap;
+
+  for (;;) {
+    va_start(ap, fmt);
+    n = vsnprintf(*buf + *len, *size - *len, fmt, ap);
+    va_end(ap);
+    if (n >= 0 && (size_t)n < *size - *len) {
+      *len += n;
+      return;
+    }
+    *size = (*size == 0) ? 1024 : *size * 2;
+    *buf  = xrealloc(*buf, *size);
+  }
+}
@@ -0,0 +1,72 @@
+/**
+ * Mergeable run totals
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifndef __TALLY_H
+#define __TALLY_H
+
+#include <stdlib.h>
+#include <data.h>
+#include <hist.h>
+#include <sock.h>
+#include <pcache.h>
+#include <edge.h>
+#include <monitor.h>
+#include <fault.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+/**
+ * Everything a run counted that the summary needs, in one flat
+ * struct: DATA, my.failed and its causes, the histogram and the parser cache,
+ * edge, socket and monitor counters. It has no pointers so a worker can
+ * put it in shared memory (proc.c), and it has a text form so an
+ * agent can send it over the wire (dist.c). Whoever collects
+ * them adds each into their own with tally_merge.
+ */
+typedef struct
+{
+  unsigned int       count;
+  unsigned int       code;
+  unsigned int       okay;
+  unsigned int       fail;
+  unsigned int       cached;
+  unsigned int       aborted;
+  unsigned int       failed;
+  unsigned long long bytes;
+  float              total;
+  float              highest;
+  float              lowest;
+  unsigned long      pcache[3];
+  unsigned long      edge[3];
+  unsigned long long edged;
+  SOCKSTATS          sock;
+  MONSTATS           mon;
+  unsigned long      faults[FAULTS];
+  unsigned int       hist[HIST_BUCKETS];
+} TALLY;
+
+void    tally_collect(TALLY *this, DATA data, PCACHE pcache, EDGE edge);
+void    tally_merge(TALLY *this, DATA data, PCACHE pcache, EDGE edge);
+char *  tally_encode(TALLY *this);
+BOOLEAN tally_decode(TALLY *this, const char *line);
+
+#endif/*__TALLY_H*/
@@ -24,24 +24,30 @@
 #include <signal.h>
 #include <pthread.h>
 #include <setup.h>
+#include <timer.h>
 #include <notify.h>
 #include <joedog/boolean.h>
 
+private double       __begin    = 0.0;
+private volatile int __stopping = 0;
+private float        __stopped  = 0.0;
+private volatile long __landed = 0;
+
 void
 *siege_timer(void *arg)
 {
   pthread_t handler = *((pthread_t *)arg);
   int err;
-  time_t now;
+  struct timeval  now;
   struct timespec timeout;
   pthread_mutex_t timer_mutex = PTHREAD_MUTEX_INITIALIZER;
   pthread_cond_t  timer_cond  = PTHREAD_COND_INITIALIZER;
 
-  if (time(&now) < 0) { 
+  if (gettimeofday(&now, NULL) < 0) { 
     NOTIFY(FATAL, "unable to set the siege timer!"); 
   }
-  timeout.tv_sec=now + my.secs + 1;
-  timeout.tv_nsec=0;
+  timeout.tv_sec  = now.tv_sec + my.secs;
+  timeout.tv_nsec = now.tv_usec * 1000;
 
   pthread_mutex_lock(&timer_mutex); 
   for (;;) {
@@ -61,4 +67,102 @@ void
   return NULL;
 }
 
+/**
+ * Marks the start of the run; the warm-up and cool-down
+ * windows are measured from here.
+ */
+void
+timer_begin()
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  __begin = tv.tv_sec + tv.tv_usec / 1000000.0;
+}
 
+float
+timer_elapsed()
+{
+  struct timeval tv;
+
+  if (__begin <= 0.0) return 0.0;
+  gettimeofday(&tv, NULL);
+  return (float)(tv.tv_sec + tv.tv_usec / 1000000.0 - __begin);
+}
+
+/**
+ * TRUE between the end of --warmup and the start of --cooldown,
+ * that is while the transactions we start count in the summary.
+ * Without either window it's always TRUE and we skip the clock.
+ */
+BOOLEAN
+timer_steady()
+{
+  float now;
+
+  if (my.warmup <= 0 && (my.cooldown <= 0 || my.secs <= 0)) {
+    return TRUE;
+  }
+  now = timer_elapsed();
+  if (now < my.warmup) {
+    return FALSE;
+  }
+  if (my.cooldown > 0 && my.secs > 0 && now >= my.secs - my.cooldown) {
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/**
+ * Ends the run: the users finish the request they're on and
+ * don't start another. The first call marks when we stopped.
+ */
+void
+timer_stop()
+{
+  float now = timer_elapsed();
+
+  if (__sync_bool_compare_and_swap(&__stopping, 0, 1)) {
+    __stopped = now;
+  }
+}
+
+BOOLEAN
+timer_stopping()
+{
+  return (__stopping) ? TRUE : FALSE;
+}
+
+/**
+ * Seconds from timer_begin to timer_stop, 0 if we haven't
+ * been stopped.
+ */
+float
+timer_stopped()
+{
+  return (__stopping) ? __stopped : 0.0;
+}
+
+/**
+ * A request that counts finished after timer_stop; we keep
+ * the last one in milliseconds so the run's window can cover
+ * the grace period it used.
+ */
+void
+timer_land()
+{
+  long now = (long)(timer_elapsed() * 1000);
+  long was;
+
+  while ((was = __landed) < now && ! __sync_bool_compare_and_swap(&__landed, was, now)) ;
+}
+
+/**
+ * Seconds from timer_begin to the last request that landed
+ * after timer_stop, 0 if none did.
+ */
+float
+timer_landed()
+{
+  return (float)__landed / 1000;
+}
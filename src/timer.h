@@ -24,7 +24,16 @@
 #define  TIMER_H
 
 #include <pthread.h>
+#include <joedog/boolean.h>
 
-void *siege_timer(void *arg);
+void *  siege_timer(void *arg);
+void    timer_begin();
+float   timer_elapsed();
+BOOLEAN timer_steady();
+void    timer_stop();
+BOOLEAN timer_stopping();
+float   timer_stopped();
+void    timer_land();
+float   timer_landed();
  
 #endif/*TIMER_H*/
@@ -37,6 +37,7 @@
 #include <perl.h>
 #include <date.h>
 #include <util.h>
+#include <hash.h>
 #include <memory.h>
 #include <notify.h>
 #include <joedog/boolean.h>
@@ -45,6 +46,7 @@
 struct URL_T
 {
   int       ID;
+  int       key;
   char *    url;
   SCHEME    scheme;
   METHOD    method;
@@ -63,12 +65,25 @@ struct URL_T
   char *    postdata;
   char *    posttemp;
   char *    conttype;
+  char *    headers;
   BOOLEAN   cached;
   BOOLEAN   redir;
 };
 
 size_t URLSIZE = sizeof(struct URL_T);
 
+/**
+ * Interned keys; every distinct absolute URL gets a small dense
+ * integer for the life of the process. The caches index on it
+ * rather than building a string key for each lookup. A replayed
+ * log can have no end of distinct URLs so the table stops at
+ * MAXKEYS; past that a URL gets no key and nothing caches it.
+ */
+#define MAXKEYS 262144
+private HASH             __keys  = NULL;
+private int              __nkeys = 0;
+private pthread_rwlock_t __klock = PTHREAD_RWLOCK_INITIALIZER;
+
 private void    __url_parse(URL this, char *url);
 private void    __parse_post_data(URL this, char *datap);
 private char *  __url_set_absolute(URL this, char *url);
@@ -99,6 +114,7 @@ new_url(char *str)
   }
   this = xmalloc(URLSIZE);
   this->ID        = 0;
+  this->key       = 0;
   this->scheme    = HTTP;
   this->hasparams = FALSE;
   this->params    = NULL;
@@ -119,6 +135,7 @@ new_url(char *str)
   this->postdata  = NULL;
   this->posttemp  = NULL;
   this->conttype  = NULL;
+  this->headers   = NULL;
   this->cached    = FALSE;
   this->redir     = FALSE;
   __url_parse(this, str); 
@@ -141,6 +158,7 @@ url_destroy(URL this)
     xfree(this->frag);
     xfree(this->request);
     xfree(this->conttype);
+    xfree(this->headers);
     xfree(this->postdata);
     xfree(this->posttemp);
     if (this->hasparams==TRUE) {
@@ -231,6 +249,17 @@ url_set_conttype(URL this, char *type) {
   return;
 }
 
+/**
+ * Request headers of this URL's own, CRLF terminated, that go
+ * out after the ones from the config; see har.c
+ */
+void
+url_set_headers(URL this, char *headers)
+{
+  xfree(this->headers);
+  this->headers = xstrdup(headers);
+}
+
 void
 url_set_method(URL this, METHOD method) {
   this->method = method;
@@ -259,6 +288,51 @@ url_get_ID(URL this)
   return this->ID;
 }
 
+/**
+ * Returns the interned key for this URL; keys start at 1
+ * and 0 means it doesn't have one. URLs are shared across
+ * threads (see pcache.c) so the key is read and published
+ * atomically; every thread that races here finds the same
+ * key in the intern table.
+ */
+public int
+url_get_key(URL this)
+{
+  int  *id;
+  int  key;
+  char *str;
+
+  if (this == NULL || (str = url_get_absolute(this)) == NULL) {
+    return 0;
+  }
+  if ((key = __sync_add_and_fetch(&this->key, 0)) > 0) {
+    return key;
+  }
+
+  pthread_rwlock_rdlock(&__klock);
+  id  = (__keys == NULL) ? NULL : (int*)hash_get(__keys, str);
+  key = (id == NULL) ? 0 : *id;
+  pthread_rwlock_unlock(&__klock);
+
+  if (key < 1) {
+    pthread_rwlock_wrlock(&__klock);
+    if (__keys == NULL) {
+      __keys = new_hash();
+    }
+    if ((id = (int*)hash_get(__keys, str)) != NULL) {
+      key = *id;
+    } else if (__nkeys < MAXKEYS) {
+      key = ++__nkeys;
+      hash_nadd(__keys, str, &key, sizeof(int));
+    }
+    pthread_rwlock_unlock(&__klock);
+  }
+  if (key > 0) {
+    __sync_bool_compare_and_swap(&this->key, 0, key);
+  }
+  return key;
+}
+
 public char *
 url_get_absolute(URL this)
 {
@@ -390,6 +464,11 @@ url_get_conttype(URL this) {
   return this->conttype;
 }
 
+public char *
+url_get_headers(URL this) {
+  return (this->headers == NULL) ? "" : this->headers;
+}
+
 public METHOD 
 url_get_method(URL this) {
   return this->method;
@@ -428,6 +507,7 @@ url_set_username(URL this, char *username)
 {
   size_t len = strlen(username);
 
+  xfree(this->username);
   this->username = malloc(len+1);
   memset(this->username, '\0', len+1);
   memcpy(this->username, username, len);
@@ -439,6 +519,7 @@ url_set_password(URL this, char *password)
 {
   size_t len = strlen(password);
 
+  xfree(this->password);
   this->password = malloc(len+1);
   memset(this->password, '\0', len+1);
   memcpy(this->password, password, len);
@@ -75,10 +75,12 @@ void     url_set_scheme(URL this, SCHEME scheme);
 void     url_set_hostname(URL this, char *hostname);
 void     url_set_redirect(URL this, BOOLEAN redir);
 void     url_set_conttype(URL this, char *type);
+void     url_set_headers(URL this, char *headers);
 void     url_set_postdata(URL this, char *postdata, size_t postlen);
 void     url_set_method(URL this, METHOD method);
 
 int      url_get_ID(URL this);
+int      url_get_key(URL this);
 METHOD   url_get_method(URL this);
 char *   url_get_method_name(URL this) ;
 BOOLEAN  url_is_redirect(URL this);
@@ -134,6 +136,7 @@ size_t   url_get_postlen(URL this);
 char *   url_get_postdata(URL this);  
 char *   url_get_posttemp(URL this); 
 char *   url_get_conttype(URL this);  
+char *   url_get_headers(URL this);
 char *   url_get_if_modified_since(URL this);
 char *   url_get_etag(URL this);
 char *   url_get_realm(URL this);
@@ -0,0 +1,365 @@
+/**
+ * Per-URL and per-host statistics
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifdef  HAVE_CONFIG_H
+# include <config.h>
+#endif/*HAVE_CONFIG_H*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <urlstats.h>
+#include <url.h>
+#include <hist.h>
+#include <memory.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+typedef struct
+{
+  unsigned long      hits;
+  unsigned long      errors;
+  unsigned long      failed;
+  unsigned long long bytes;
+  double             time;
+  float              highest;
+  unsigned long      codes[6];
+  unsigned long      faults[FAULTS];
+} SLOT;
+
+struct URLSTATS_T
+{
+  BOOLEAN        fork;       /* a browser's; it owns only slots   */
+  int            size;       /* the highest ID + 1                */
+  SLOT          *slots;      /* a fork's come with its first hit  */
+  unsigned int  *buckets;    /* HIST_BUCKETS per ID, shared       */
+  char         **names;      /* per ID, NULL where there's no URL */
+  char         **hosts;
+  URLROW        *urls;       /* the rows, once we're finished     */
+  int            nurls;
+  URLROW        *hostrows;
+  int            nhosts;
+};
+
+private void  __add(SLOT *this, SLOT *that);
+private void  __fill(URLROW *row, SLOT *slot, HIST hist);
+private float __failing(URLROW *row);
+
+URLSTATS
+new_urlstats(ARRAY urls)
+{
+  int      i;
+  int      id;
+  URL      U;
+  char     buf[4096];
+  URLSTATS this;
+
+  this = xcalloc(sizeof(struct URLSTATS_T), 1);
+  for (i = 0; i < (int)array_length(urls); i++) {
+    U = (URL)array_get(urls, i);
+    if (url_get_ID(U) >= this->size) this->size = url_get_ID(U) + 1;
+  }
+  if (this->size < 1) this->size = 1;
+
+  this->slots   = xcalloc(sizeof(SLOT), this->size);
+  this->buckets = xcalloc(sizeof(unsigned int), (size_t)this->size * HIST_BUCKETS);
+  this->names   = xcalloc(sizeof(char *), this->size);
+  this->hosts   = xcalloc(sizeof(char *), this->size);
+  for (i = 0; i < (int)array_length(urls); i++) {
+    U  = (URL)array_get(urls, i);
+    id = url_get_ID(U);
+    if (id < 0 || this->names[id] != NULL) continue;
+    if (url_get_method(U) == GET) {
+      snprintf(buf, sizeof(buf), "%s", url_get_absolute(U));
+    } else {
+      snprintf(buf, sizeof(buf), "%s %s", url_get_method_name(U), url_get_absolute(U));
+    }
+    this->names[id] = xstrdup(buf);
+    snprintf(buf, sizeof(buf), "%s:%d", url_get_hostname(U), url_get_port(U));
+    this->hosts[id] = xstrdup(buf);
+  }
+  return this;
+}
+
+URLSTATS
+urlstats_destroy(URLSTATS this)
+{
+  int i;
+
+  if (this == NULL) return NULL;
+
+  if (! this->fork) {
+    for (i = 0; i < this->size; i++) {
+      xfree(this->names[i]);
+      xfree(this->hosts[i]);
+    }
+    xfree(this->names);
+    xfree(this->hosts);
+    xfree(this->buckets);
+    xfree(this->urls);
+    xfree(this->hostrows);
+  }
+  xfree(this->slots);
+  xfree(this);
+  return NULL;
+}
+
+/**
+ * A browser's own counters; it shares our names and buckets
+ * so it has to go before we do.
+ */
+URLSTATS
+urlstats_fork(URLSTATS this)
+{
+  URLSTATS that;
+
+  if (this == NULL) return NULL;
+
+  that = xcalloc(sizeof(struct URLSTATS_T), 1);
+  that->fork    = TRUE;
+  that->size    = this->size;
+  that->buckets = this->buckets;
+  that->names   = this->names;
+  that->hosts   = this->hosts;
+  return that;
+}
+
+void
+urlstats_record(URLSTATS this, int id, int code, unsigned long bytes, float etime)
+{
+  SLOT *S;
+
+  if (this == NULL || id < 0 || id >= this->size) return;
+
+  if (this->slots == NULL) {
+    this->slots = xcalloc(sizeof(SLOT), this->size);
+  }
+  S = &this->slots[id];
+  S->hits  += 1;
+  S->bytes += bytes;
+  S->time  += etime;
+  if (etime > S->highest) S->highest = etime;
+  if (code >= 400) S->errors += 1;
+  S->codes[(code >= 100 && code < 600) ? code / 100 : 0] += 1;
+  if (code >= 400) S->faults[fault_from_code(code)] += 1;
+  __sync_fetch_and_add(&this->buckets[(size_t)id * HIST_BUCKETS + hist_bucket(etime)], 1);
+}
+
+void
+urlstats_fail(URLSTATS this, int id, FAULT fault)
+{
+  if (this == NULL || id < 0 || id >= this->size) return;
+
+  if (this->slots == NULL) {
+    this->slots = xcalloc(sizeof(SLOT), this->size);
+  }
+  this->slots[id].failed += 1;
+  this->slots[id].faults[(fault > FAULT_NONE && fault < FAULTS) ? fault : FAULT_OTHER] += 1;
+}
+
+/**
+ * Adds a fork's counters into ours
+ */
+void
+urlstats_merge(URLSTATS this, URLSTATS that)
+{
+  int i;
+
+  if (this == NULL || that == NULL || that->slots == NULL) return;
+
+  for (i = 0; i < this->size && i < that->size; i++) {
+    __add(&this->slots[i], &that->slots[i]);
+  }
+}
+
+/**
+ * Turns the merged counters into rows, one per URL, and rolls
+ * them up into one per host; call it once, after the merges.
+ */
+void
+urlstats_finish(URLSTATS this)
+{
+  int   i;
+  int   j;
+  SLOT  host;
+  HIST  hist;
+  HIST *hists;
+
+  if (this == NULL || this->urls != NULL) return;
+
+  this->urls     = xcalloc(sizeof(URLROW), this->size);
+  this->hostrows = xcalloc(sizeof(URLROW), this->size);
+  hists          = xcalloc(sizeof(HIST), this->size);
+  hist           = new_hist();
+  for (i = 0; i < this->size; i++) {
+    if (this->names[i] == NULL) continue;
+
+    hist_reset(hist);
+    hist_add_buckets(hist, &this->buckets[(size_t)i * HIST_BUCKETS]);
+    this->urls[this->nurls].name = this->names[i];
+    __fill(&this->urls[this->nurls++], &this->slots[i], hist);
+
+    for (j = 0; j < this->nhosts; j++) {
+      if (strcmp(this->hostrows[j].name, this->hosts[i]) == 0) break;
+    }
+    if (j == this->nhosts) {
+      this->hostrows[j].name = this->hosts[i];
+      hists[j] = new_hist();
+      this->nhosts++;
+    }
+    hist_merge(hists[j], hist);
+  }
+  for (j = 0; j < this->nhosts; j++) {
+    memset(&host, '\0', sizeof(SLOT));
+    for (i = 0; i < this->size; i++) {
+      if (this->hosts[i] != NULL && strcmp(this->hosts[i], this->hostrows[j].name) == 0) {
+        __add(&host, &this->slots[i]);
+      }
+    }
+    __fill(&this->hostrows[j], &host, hists[j]);
+    hists[j] = hist_destroy(hists[j]);
+  }
+  xfree(hists);
+  hist = hist_destroy(hist);
+}
+
+int
+urlstats_get_urls(URLSTATS this)
+{
+  return (this == NULL) ? 0 : this->nurls;
+}
+
+URLROW *
+urlstats_get_url(URLSTATS this, int index)
+{
+  if (this == NULL || index < 0 || index >= this->nurls) return NULL;
+  return &this->urls[index];
+}
+
+int
+urlstats_get_hosts(URLSTATS this)
+{
+  return (this == NULL) ? 0 : this->nhosts;
+}
+
+URLROW *
+urlstats_get_host(URLSTATS this, int index)
+{
+  if (this == NULL || index < 0 || index >= this->nhosts) return NULL;
+  return &this->hostrows[index];
+}
+
+/**
+ * Fills top with the indexes of the n worst URLs: the slowest
+ * by p90 or the most failing by their share of errors and
+ * failures. URLs that weren't requested, or never failed, are
+ * left out; returns how many it found.
+ */
+int
+urlstats_rank(URLSTATS this, URLRANK by, int *top, int n)
+{
+  int   i;
+  int   j;
+  int   k;
+  int   found = 0;
+  float best;
+  float score;
+
+  if (this == NULL || top == NULL) return 0;
+
+  for (k = 0; k < n; k++) {
+    best = 0;
+    top[k] = -1;
+    for (i = 0; i < this->nurls; i++) {
+      for (j = 0; j < k && top[j] != i; j++) ;
+      if (j < k) continue;
+      if (by == URLSTATS_SLOWEST) {
+        /**
+         * A fast URL can have a p90 of 0; it still ranks
+         * as long as we requested it
+         */
+        if (this->urls[i].hits == 0) continue;
+        score = this->urls[i].p90;
+      } else if ((score = __failing(&this->urls[i])) <= 0) {
+        continue;
+      }
+      if (top[k] < 0 || score > best) {
+        best   = score;
+        top[k] = i;
+      }
+    }
+    if (top[k] < 0) break;
+    found++;
+  }
+  return found;
+}
+
+private void
+__add(SLOT *this, SLOT *that)
+{
+  int i;
+
+  this->hits   += that->hits;
+  this->errors += that->errors;
+  this->failed += that->failed;
+  this->bytes  += that->bytes;
+  this->time   += that->time;
+  if (that->highest > this->highest) this->highest = that->highest;
+  for (i = 0; i < 6; i++) {
+    this->codes[i] += that->codes[i];
+  }
+  for (i = 0; i < FAULTS; i++) {
+    this->faults[i] += that->faults[i];
+  }
+}
+
+private void
+__fill(URLROW *row, SLOT *slot, HIST hist)
+{
+  int i;
+
+  row->hits    = slot->hits;
+  row->errors  = slot->errors;
+  row->failed  = slot->failed;
+  row->bytes   = slot->bytes;
+  row->time    = slot->time;
+  row->highest = slot->highest;
+  memcpy(row->codes, slot->codes, sizeof(row->codes));
+  memcpy(row->faults, slot->faults, sizeof(row->faults));
+  row->cause   = FAULT_NONE;
+  for (i = FAULT_NONE + 1; i < FAULTS; i++) {
+    if (row->faults[i] > 0 && (row->cause == FAULT_NONE || row->faults[i] > row->faults[row->cause])) {
+      row->cause = (FAULT)i;
+    }
+  }
+  row->p50     = hist_get_percentile(hist, 50);
+  row->p90     = hist_get_percentile(hist, 90);
+  row->p99     = hist_get_percentile(hist, 99);
+}
+
+private float
+__failing(URLROW *row)
+{
+  unsigned long tries = row->hits + row->failed;
+
+  return (tries == 0) ? 0 : (float)(row->errors + row->failed) / tries;
+}
@@ -0,0 +1,81 @@
+/**
+ * Per-URL and per-host statistics
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifndef __URLSTATS_H
+#define __URLSTATS_H
+
+#include <stdlib.h>
+#include <array.h>
+#include <fault.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+/**
+ * Where the time went, URL by URL and host by host. A URL is a
+ * line of urls.txt (its url_get_ID) and everything requested on
+ * its behalf, redirects and parsed resources included, counts
+ * toward it. Each browser counts into its own flat array indexed
+ * by ID, so there's nothing to lock; the latency buckets are one
+ * set per URL that every browser adds to atomically, because a
+ * histogram per URL per browser is more memory than it's worth.
+ * main merges the browsers when they're done, then rolls the URLs
+ * up by host. Unlike the summary's, hits here are every response,
+ * 5xx included, and failed is only the requests that got none.
+ */
+typedef struct URLSTATS_T *URLSTATS;
+
+typedef enum {
+  URLSTATS_SLOWEST,
+  URLSTATS_FAILING
+} URLRANK;
+
+typedef struct
+{
+  char              *name;      /* the URL or host:port           */
+  unsigned long      hits;      /* responses, whatever the code   */
+  unsigned long      errors;    /* a response of 400 or more      */
+  unsigned long      failed;    /* no response at all             */
+  unsigned long long bytes;
+  double             time;      /* response times added up        */
+  float              highest;
+  unsigned long      codes[6];  /* 1xx..5xx by class, [0] others  */
+  unsigned long      faults[FAULTS];
+  FAULT              cause;     /* the most common fault, or none */
+  float              p50;
+  float              p90;
+  float              p99;
+} URLROW;
+
+URLSTATS new_urlstats(ARRAY urls);
+URLSTATS urlstats_destroy(URLSTATS this);
+URLSTATS urlstats_fork(URLSTATS this);
+void     urlstats_record(URLSTATS this, int id, int code, unsigned long bytes, float etime);
+void     urlstats_fail(URLSTATS this, int id, FAULT fault);
+void     urlstats_merge(URLSTATS this, URLSTATS that);
+void     urlstats_finish(URLSTATS this);
+int      urlstats_get_urls(URLSTATS this);
+URLROW * urlstats_get_url(URLSTATS this, int index);
+int      urlstats_get_hosts(URLSTATS this);
+URLROW * urlstats_get_host(URLSTATS this, int index);
+int      urlstats_rank(URLSTATS this, URLRANK by, int *top, int n);
+
+#endif/*__URLSTATS_H*/
@@ -73,6 +73,36 @@ parse_time(char *p)
   return;
 }
 
+/**
+ * Parses a length of time like -t but without setting it: NUM
+ * with an optional s, m or h modifier, seconds if it has none.
+ * Returns the number of seconds or -1 if it can't read it.
+ */
+int
+parse_secs(const char *p)
+{
+  char *end;
+  long  n;
+
+  if (p == NULL || ! ISDIGIT(*p)) return -1;
+  n = strtol(p, &end, 10);
+  switch (TOLOWER(*end)) {
+    case '\0':
+    case 's':
+      break;
+    case 'm':
+      n *= 60;
+      break;
+    case 'h':
+      n *= 3600;
+      break;
+    default:
+      return -1;
+  }
+  if (*end != '\0' && *(end+1) != '\0') return -1;
+  return (int)n;
+}
+
 char *
 substring(char *str, int start, int len)
 {
@@ -361,6 +391,51 @@ pthread_rand_np(unsigned int *ctx)
 #endif
 }
 
+/**
+ * xoshiro256** (Blackman and Vigna): faster and better spread
+ * than rand_r and its state is four words, so each browser can
+ * keep its own. splitmix64 spreads the seed over the state.
+ */
+#define ROTL(x, k) (((x) << (k)) | ((x) >> (64 - (k))))
+
+void
+xoshiro_seed(unsigned long long *state, unsigned long long seed)
+{
+  int i;
+  unsigned long long z;
+
+  for (i = 0; i < 4; i++) {
+    z = (seed += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    state[i] = z ^ (z >> 31);
+  }
+}
+
+unsigned long long
+xoshiro_next(unsigned long long *state)
+{
+  unsigned long long result = ROTL(state[1] * 5, 7) * 9;
+  unsigned long long t      = state[1] << 17;
+
+  state[2] ^= state[0];
+  state[3] ^= state[1];
+  state[1] ^= state[2];
+  state[0] ^= state[3];
+  state[2] ^= t;
+  state[3]  = ROTL(state[3], 45);
+  return result;
+}
+
+/**
+ * Uniform in [0, 1) from the top 53 bits
+ */
+double
+xoshiro_double(unsigned long long *state)
+{
+  return (xoshiro_next(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
 int
 urandom()
 {
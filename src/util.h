@@ -27,11 +27,15 @@
 #include <joedog/boolean.h>
 
 void    parse_time(char *p);
+int     parse_secs(const char *p);
 float   elapsed_time(clock_t time);
 char *  substring(char *str, int start, int len);
 void    pthread_sleep_np(unsigned int seconds); 
 void    pthread_usleep_np(unsigned long usec); 
 int     pthread_rand_np(unsigned int *ctx); 
+void    xoshiro_seed(unsigned long long *state, unsigned long long seed);
+unsigned long long xoshiro_next(unsigned long long *state);
+double  xoshiro_double(unsigned long long *state);
 int     urandom();
 BOOLEAN strmatch(const char *str1, const char *str2);
 BOOLEAN startswith(const char *pre, const char *str);
@@ -0,0 +1,449 @@
+/**
+ * Verbose output writer
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifdef  HAVE_CONFIG_H
+# include <config.h>
+#endif/*HAVE_CONFIG_H*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <writer.h>
+#include <notify.h>
+#include <memory.h>
+#include <util.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+#ifdef  HAVE_UNISTD_H
+# include <unistd.h>
+#endif/*HAVE_UNISTD_H*/
+
+#define RING_SIZE  16384   /* bytes in flight per thread, a power of 2 */
+#define LINE_SIZE  4096    /* most lines fit; longer ones are allocated */
+#define BATCH_SIZE 65536   /* bytes per write(2) */
+#define INTERVAL   50000   /* usecs between drains */
+
+#ifndef MIN
+# define MIN(a,b) (((a) < (b)) ? (a) : (b))
+#endif/*MIN*/
+
+/**
+ * One per thread. The owner only moves head and the writer only
+ * moves tail; both count bytes from the start so head - tail is
+ * what's waiting and head & (RING_SIZE-1) is where it goes.
+ */
+typedef struct SLOT_T
+{
+  char           *ring;
+  volatile unsigned long head;
+  volatile unsigned long tail;
+  BOOLEAN        listed;    /* the writer drains it     */
+  BOOLEAN        dead;      /* its thread is gone       */
+  time_t         second;    /* what clock and stamp say */
+  char           clock[32]; /* 2026-10-19 12:00:00      */
+  char           stamp[48]; /* [Mon, 2026-10-19 12:00:00] */
+  struct SLOT_T *next;
+} SLOT;
+
+private pthread_t       __writer_id;
+private pthread_mutex_t __lock    = PTHREAD_MUTEX_INITIALIZER;
+private pthread_cond_t  __cond    = PTHREAD_COND_INITIALIZER;
+private pthread_once_t  __once    = PTHREAD_ONCE_INIT;
+private pthread_key_t   __key;
+private BOOLEAN         __running = FALSE;
+private BOOLEAN         __stopped = FALSE;
+private BOOLEAN         __color   = TRUE;
+private int             __fd      = STDOUT_FILENO;
+private SLOT *          __slots   = NULL;
+
+private void    __init();
+private void    __release(void *arg);
+private SLOT *  __slot();
+private void    __tick(SLOT *S);
+private void *  __writer(void *arg);
+private void    __drain(char *batch);
+private void    __push(SLOT *S, unsigned long *head, const char *buf, size_t len);
+private void    __write(const char *buf, size_t len);
+
+/**
+ * Sends the lines to FILE rather than stdout. We open it before
+ * --procs forks so the workers share one descriptor; O_APPEND
+ * keeps their batches from landing on top of each other.
+ */
+BOOLEAN
+writer_open(const char *file)
+{
+  int fd;
+
+  if (file == NULL || strlen(file) < 1) {
+    return TRUE;
+  }
+  if ((fd = open(file, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644)) < 0) {
+    return FALSE;
+  }
+  __fd    = fd;
+  __color = FALSE;
+  return TRUE;
+}
+
+/**
+ * Starts the writer; until it's running, and after writer_stop,
+ * writer_print writes its line directly
+ */
+void
+writer_start()
+{
+  pthread_once(&__once, __init);
+  pthread_mutex_lock(&__lock);
+  if (__running) {
+    pthread_mutex_unlock(&__lock);
+    return;
+  }
+  fflush(stdout);
+  __stopped = FALSE;
+  if (pthread_create(&__writer_id, NULL, __writer, NULL) == 0) {
+    __running = TRUE;
+  }
+  pthread_mutex_unlock(&__lock);
+}
+
+/**
+ * Called once the browsers are done; the writer drains what's
+ * left before it exits so nothing is lost at the end of a run.
+ */
+void
+writer_stop()
+{
+  SLOT **P;
+  SLOT  *S;
+
+  pthread_mutex_lock(&__lock);
+  if (! __running) {
+    pthread_mutex_unlock(&__lock);
+    return;
+  }
+  __stopped = TRUE;
+  pthread_cond_signal(&__cond);
+  pthread_mutex_unlock(&__lock);
+  pthread_join(__writer_id, NULL);
+
+  pthread_mutex_lock(&__lock);
+  __running = FALSE;
+  for (P = &__slots; (S = *P) != NULL; ) {
+    if (S->dead) {
+      *P = S->next;
+      xfree(S->ring);
+      xfree(S);
+    } else {
+      P = &S->next;
+    }
+  }
+  pthread_mutex_unlock(&__lock);
+}
+
+void
+writer_print(int color, const char *fmt, ...)
+{
+  va_list ap;
+  char    buf[LINE_SIZE];
+  char   *line = buf;
+  char    esc[32];
+  char    end[16];
+  int     len;
+  size_t  total;
+  unsigned long head;
+  SLOT   *S;
+
+  va_start(ap, fmt);
+  len = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  if (len < 0) {
+    return;
+  }
+  if ((size_t)len >= sizeof(buf)) {
+    line = xmalloc(len+1);
+    va_start(ap, fmt);
+    vsnprintf(line, len+1, fmt, ap);
+    va_end(ap);
+  }
+  if (color == UNCOLOR || ! __color) {
+    esc[0] = '\0';
+  } else {
+    snprintf(esc, sizeof(esc), "%c[%d;%dm", 0x1B, 0, color+30);
+  }
+  snprintf(end, sizeof(end), "%s\n", (esc[0]) ? "\033[0m" : "");
+  total = strlen(esc) + len + strlen(end);
+
+  if (! __running || __stopped) {
+    fflush(stdout);
+    __write(esc, strlen(esc));
+    __write(line, len);
+    __write(end, strlen(end));
+  } else {
+    S = __slot();
+    if (S->ring == NULL) {
+      S->ring = xmalloc(RING_SIZE);
+      pthread_mutex_lock(&__lock);
+      S->next   = __slots;
+      S->listed = TRUE;
+      __slots   = S;
+      pthread_mutex_unlock(&__lock);
+    }
+    /**
+     * The writer only sees whole lines unless one is bigger
+     * than the ring, so wait for room for all of it first.
+     */
+    while (total <= RING_SIZE && RING_SIZE - (S->head - S->tail) < total) {
+      pthread_cond_signal(&__cond);
+      pthread_usleep_np(1000);
+    }
+    head = S->head;
+    __push(S, &head, esc, strlen(esc));
+    __push(S, &head, line, len);
+    __push(S, &head, end, strlen(end));
+    __sync_synchronize();
+    S->head = head;
+    if (S->head - S->tail > RING_SIZE / 2) {
+      pthread_cond_signal(&__cond);
+    }
+  }
+  if (line != buf) {
+    xfree(line);
+  }
+  return;
+}
+
+/**
+ * "%Y-%m-%d %H:%M:%S" for CSV lines; good until this thread's next call
+ */
+const char *
+writer_clock()
+{
+  SLOT *S = __slot();
+  __tick(S);
+  return S->clock;
+}
+
+/**
+ * "[%a, %F %T] " for timestamped lines; good until this thread's next call
+ */
+const char *
+writer_stamp()
+{
+  SLOT *S = __slot();
+  __tick(S);
+  return S->stamp;
+}
+
+private void
+__init()
+{
+  pthread_key_create(&__key, __release);
+}
+
+/**
+ * A thread is done with its slot. If the writer is still running
+ * it frees it once it's drained, otherwise we do it here.
+ */
+private void
+__release(void *arg)
+{
+  SLOT  *S = (SLOT *)arg;
+  SLOT **P;
+
+  pthread_mutex_lock(&__lock);
+  if (S->listed && __running) {
+    S->dead = TRUE;
+    pthread_mutex_unlock(&__lock);
+    return;
+  }
+  for (P = &__slots; *P != NULL; P = &(*P)->next) {
+    if (*P == S) {
+      *P = S->next;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&__lock);
+  xfree(S->ring);
+  xfree(S);
+}
+
+private SLOT *
+__slot()
+{
+  SLOT *S;
+
+  pthread_once(&__once, __init);
+  if ((S = (SLOT *)pthread_getspecific(__key)) == NULL) {
+    S = (SLOT *)xcalloc(1, sizeof(SLOT));
+    S->second = (time_t)-1;
+    pthread_setspecific(__key, S);
+  }
+  return S;
+}
+
+private void
+__tick(SLOT *S)
+{
+  time_t     now = time(NULL);
+  struct tm *tmp;
+#ifdef  HAVE_LOCALTIME_R
+  struct tm  keepsake;
+#endif/*HAVE_LOCALTIME_R*/
+
+  if (now == S->second) {
+    return;
+  }
+  S->second = now;
+#ifdef  HAVE_LOCALTIME_R
+  tmp = (struct tm *)localtime_r(&now, &keepsake);
+#else
+  tmp = localtime(&now);
+#endif/*HAVE_LOCALTIME_R*/
+  if (tmp == NULL || strftime(S->clock, sizeof(S->clock), "%Y-%m-%d %H:%M:%S", tmp) == 0) {
+    snprintf(S->clock, sizeof(S->clock), "n/a");
+  }
+  if (tmp == NULL || strftime(S->stamp, sizeof(S->stamp), "[%a, %F %T] ", tmp) == 0) {
+    S->stamp[0] = '\0';
+  }
+}
+
+private void *
+__writer(void *arg)
+{
+  struct timeval  now;
+  struct timespec ts;
+  char   *batch = xmalloc(BATCH_SIZE);
+  BOOLEAN done  = FALSE;
+
+  (void)arg;
+  while (! done) {
+    gettimeofday(&now, NULL);
+    now.tv_usec += INTERVAL;
+    ts.tv_sec    = now.tv_sec + now.tv_usec / 1000000;
+    ts.tv_nsec   = (now.tv_usec % 1000000) * 1000;
+    pthread_mutex_lock(&__lock);
+    if (! __stopped) {
+      pthread_cond_timedwait(&__cond, &__lock, &ts);
+    }
+    done = __stopped;
+    pthread_mutex_unlock(&__lock);
+    __drain(batch);
+  }
+  xfree(batch);
+  return NULL;
+}
+
+/**
+ * Copies what every thread has published into BATCH and writes
+ * it out; a slot whose thread is gone is freed once it's empty.
+ */
+private void
+__drain(char *batch)
+{
+  SLOT        **P;
+  SLOT         *S;
+  unsigned long head;
+  size_t        at;
+  size_t        len;
+  size_t        used = 0;
+
+  pthread_mutex_lock(&__lock);
+  for (P = &__slots; (S = *P) != NULL; ) {
+    head = S->head;
+    __sync_synchronize();
+    while (S->tail != head) {
+      at  = S->tail & (RING_SIZE-1);
+      len = MIN(head - S->tail, RING_SIZE - at);
+      len = MIN(len, BATCH_SIZE - used);
+      memcpy(batch+used, S->ring+at, len);
+      used += len;
+      __sync_synchronize();
+      S->tail += len;
+      if (used == BATCH_SIZE) {
+        __write(batch, used);
+        used = 0;
+      }
+    }
+    if (S->dead) {
+      *P = S->next;
+      xfree(S->ring);
+      xfree(S);
+    } else {
+      P = &S->next;
+    }
+  }
+  pthread_mutex_unlock(&__lock);
+  if (used > 0) {
+    __write(batch, used);
+  }
+}
+
+/**
+ * Copies LEN bytes into this thread's ring at HEAD; the caller
+ * publishes them. Only a line bigger than the ring fills it, in
+ * which case we publish what we have and wait for the writer.
+ */
+private void
+__push(SLOT *S, unsigned long *head, const char *buf, size_t len)
+{
+  size_t at;
+  size_t n;
+
+  while (len > 0) {
+    while (*head - S->tail >= RING_SIZE) {
+      __sync_synchronize();
+      S->head = *head;
+      pthread_cond_signal(&__cond);
+      pthread_usleep_np(1000);
+    }
+    at = *head & (RING_SIZE-1);
+    n  = MIN(len, RING_SIZE - (*head - S->tail));
+    n  = MIN(n, RING_SIZE - at);
+    memcpy(S->ring+at, buf, n);
+    *head += n;
+    buf   += n;
+    len   -= n;
+  }
+}
+
+private void
+__write(const char *buf, size_t len)
+{
+  ssize_t n;
+
+  while (len > 0) {
+    if ((n = write(__fd, buf, len)) < 0) {
+      if (errno == EINTR) continue;
+      return;
+    }
+    buf += n;
+    len -= n;
+  }
+}
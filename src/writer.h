@@ -0,0 +1,47 @@
+/**
+ * Verbose output writer
+ *
+ * Copyright (C) 2026 by
+ * Jeffrey Fulmer - <jeff@joedog.org>, et al.
+ * This file is distributed as part of Siege
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *--
+ */
+#ifndef __WRITER_H
+#define __WRITER_H
+
+#include <stdlib.h>
+#include <joedog/defs.h>
+#include <joedog/boolean.h>
+
+/**
+ * Verbose and CSV lines used to go straight to printf from every
+ * browser, which put all of them in line for the stdout lock. Now
+ * each thread formats into a ring of its own that only it writes
+ * and only the writer thread reads, so there's nothing to lock;
+ * the writer drains them all a few times a second and hands the
+ * batch to one write(2). Lines from a thread stay in order but a
+ * batch is grouped by thread. The timestamps are formatted once a
+ * second per thread rather than once a line.
+ */
+BOOLEAN     writer_open(const char *file);
+void        writer_start();
+void        writer_stop();
+void        writer_print(int color, const char *fmt, ...);
+const char *writer_clock();
+const char *writer_stamp();
+
+#endif/*__WRITER_H*/